@@ -0,0 +1,507 @@
+/*
+ * audio_encoder_bench.cpp
+ * Host benchmark for the upload audio encoders (WAV PCM, IMA-ADPCM, FLAC)
+ *
+ * Usage:
+ *   audio_encoder_bench [--dump] run1.output.wav [more.wav ...]
+ *   audio_encoder_bench [--dump]        (synthetic 5 s voice-like signal)
+ *
+ * Input is 16-bit PCM WAV (pipeline.py --debug writes run*.output.wav).
+ * For each encoder this reports the encoded size, the ratio against plain
+ * PCM, and the CPU spent per second of audio (wall time and, on x86, TSC
+ * cycles). IMA-ADPCM also reports SNR after decoding; FLAC is decoded
+ * by a subset decoder here (fixed predictors, partitioned Rice, verbatim
+ * and constant subframes, both CRCs) and compared sample for sample, after
+ * a first pass over silence, full-scale noise and a short last frame. A
+ * mismatch exits non-zero. --dump writes <name>.ima.wav and <name>.flac so
+ * they can be checked with `flac -t`, ffprobe or soundfile.
+ */
+
+#include "AudioEncoder.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+static bool loadWav(const std::string& path, std::vector<int16_t>& pcm, uint32_t& rate)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+
+    auto u16 = [&](size_t at) { return (uint32_t)data[at] | (uint32_t)data[at + 1] << 8; };
+    auto u32 = [&](size_t at) { return u16(at) | u16(at + 2) << 16; };
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    uint16_t channels = 0;
+    size_t p = 12;
+    while (p + 8 <= data.size()) {
+        uint32_t len = u32(p + 4);
+        if (memcmp(data.data() + p, "fmt ", 4) == 0 && p + 24 <= data.size()) {
+            if (u16(p + 8) != 1 || u16(p + 22) != 16) {
+                return false;       // PCM 16-bit only
+            }
+            channels = (uint16_t)u16(p + 10);
+            rate = u32(p + 12);
+        } else if (memcmp(data.data() + p, "data", 4) == 0 && channels) {
+            size_t end = len > data.size() - p - 8 ? data.size() : p + 8 + len;
+            for (size_t i = p + 8; i + 2 * channels <= end; i += 2 * channels) {
+                pcm.push_back((int16_t)u16(i));     // First channel
+            }
+            return true;
+        }
+        p += 8 + len + (len & 1);
+    }
+    return false;
+}
+
+// Syllable-like bursts: 120-220 Hz glottal harmonics under an envelope,
+// separated by short pauses, over a low noise floor
+static void synthesize(std::vector<int16_t>& pcm, uint32_t rate, float seconds)
+{
+    uint32_t seed = 12345;
+    auto noise = [&]() {
+        seed = seed * 1103515245 + 12345;
+        return (int32_t)((seed >> 16) & 0x7FFF) - 16384;
+    };
+    size_t n = (size_t)(rate * seconds);
+    pcm.resize(n);
+    double phase = 0;
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / rate;
+        double syllable = fmod(t, 0.35);
+        double env = syllable < 0.25 ? sin(M_PI * syllable / 0.25) : 0.0;
+        double f0 = 170 + 50 * sin(2 * M_PI * 0.7 * t);
+        phase += 2 * M_PI * f0 / rate;
+        double v = 0;
+        for (int h = 1; h <= 12; h++) {
+            v += sin(h * phase) / h * (h < 4 ? 1.0 : 0.5);
+        }
+        pcm[i] = (int16_t)(6000 * env * v + noise() / 256);
+    }
+}
+
+// Reference IMA-ADPCM decoder for the SNR figure
+static void decodeIma(const std::vector<uint8_t>& stream, size_t header, std::vector<int16_t>& out)
+{
+    static const int16_t steps[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+        253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+        1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+        3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+        11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+        32767,
+    };
+    static const int8_t index_step[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+    const size_t block = ImaAdpcmEncoder::BLOCK_ALIGN;
+    for (size_t b = header; b + block <= stream.size(); b += block) {
+        int32_t pred = (int16_t)(stream[b] | stream[b + 1] << 8);
+        int32_t index = stream[b + 2];
+        out.push_back((int16_t)pred);
+        for (size_t i = 4; i < block; i++) {
+            for (int s = 0; s < 2; s++) {
+                uint8_t nib = (stream[b + i] >> (4 * s)) & 0xF;
+                int32_t step = steps[index];
+                int32_t diff = step >> 3;
+                if (nib & 4) diff += step;
+                if (nib & 2) diff += step >> 1;
+                if (nib & 1) diff += step >> 2;
+                pred += (nib & 8) ? -diff : diff;
+                pred = pred > 32767 ? 32767 : pred < -32768 ? -32768 : pred;
+                index += index_step[nib & 7];
+                index = index < 0 ? 0 : index > 88 ? 88 : index;
+                out.push_back((int16_t)pred);
+            }
+        }
+    }
+}
+
+// MSB-first reader; reading past the end sets `overrun` and yields zeros
+struct BitReader {
+    const std::vector<uint8_t>& data;
+    size_t bit;
+    bool overrun;
+
+    uint32_t get(uint8_t bits)
+    {
+        uint32_t v = 0;
+        for (uint8_t i = 0; i < bits; i++) {
+            size_t byte = bit >> 3;
+            if (byte >= data.size()) {
+                overrun = true;
+                return 0;
+            }
+            v = v << 1 | ((data[byte] >> (7 - (bit & 7))) & 1);
+            bit++;
+        }
+        return v;
+    }
+
+    int32_t getSigned(uint8_t bits)
+    {
+        uint32_t v = get(bits);
+        return bits < 32 && (v >> (bits - 1)) ? (int32_t)(v - (1u << bits)) : (int32_t)v;
+    }
+
+    void align() { bit = (bit + 7) & ~(size_t)7; }
+};
+
+struct FlacStats {
+    size_t constant;
+    size_t verbatim;
+    size_t fixed;
+};
+
+// Mono 16-bit FLAC subset decoder for the lossless check. Anything this
+// doesn't cover (LPC subframes, stereo, bad CRCs) fails the decode.
+static bool decodeFlac(const std::vector<uint8_t>& stream, std::vector<int16_t>& out, FlacStats& stats)
+{
+    static const uint16_t fixed_sizes[16] = {0, 192, 576, 1152, 2304, 4608, 0, 0,
+                                             256, 512, 1024, 2048, 4096, 8192, 16384, 32768};
+    auto crc8 = [&](size_t from, size_t to) {
+        uint8_t crc = 0;
+        for (size_t i = from; i < to; i++) {
+            crc ^= stream[i];
+            for (int b = 0; b < 8; b++) {
+                crc = (uint8_t)((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+            }
+        }
+        return crc;
+    };
+    auto crc16 = [&](size_t from, size_t to) {
+        uint16_t crc = 0;
+        for (size_t i = from; i < to; i++) {
+            crc ^= (uint16_t)(stream[i] << 8);
+            for (int b = 0; b < 8; b++) {
+                crc = (uint16_t)((crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1);
+            }
+        }
+        return crc;
+    };
+
+    BitReader in = {stream, 0, false};
+    if (in.get(32) != 0x664C6143) {
+        return false;
+    }
+    bool last = false;
+    while (!last && !in.overrun) {
+        last = in.get(1);
+        in.get(7);
+        in.bit += (size_t)in.get(24) * 8;   // Metadata contents: not needed
+    }
+
+    std::vector<int32_t> x;
+    while (!in.overrun && in.bit / 8 < stream.size()) {
+        size_t frame_start = in.bit / 8;
+        if (in.get(15) != 0x7FFC || in.get(1) != 0) {
+            return false;                   // Sync or variable blocking
+        }
+        uint8_t size_code = (uint8_t)in.get(4);
+        uint8_t rate_code = (uint8_t)in.get(4);
+        uint8_t channels = (uint8_t)in.get(4);
+        uint8_t bits_code = (uint8_t)in.get(3);
+        in.get(1);
+        if (channels != 0 || (bits_code != 0 && bits_code != 4)) {
+            return false;                   // Mono 16-bit only
+        }
+
+        // Frame number, UTF-8 style: one continuation byte per extra lead 1
+        uint32_t lead = in.get(8);
+        int extra = 0;
+        for (uint32_t mask = 0x40; (lead & 0x80) && (lead & mask); mask >>= 1) {
+            extra++;
+        }
+        if ((lead & 0xC0) == 0x80) {
+            return false;
+        }
+        for (int i = 0; i < extra; i++) {
+            in.get(8);
+        }
+        uint32_t count = size_code == 6 ? in.get(8) + 1 : size_code == 7 ? in.get(16) + 1 : fixed_sizes[size_code];
+        if (rate_code == 12) {
+            in.get(8);
+        } else if (rate_code == 13 || rate_code == 14) {
+            in.get(16);
+        }
+        size_t header_end = in.bit / 8;
+        if (count == 0 || in.get(8) != crc8(frame_start, header_end)) {
+            return false;
+        }
+
+        // Subframe: zero pad bit, type, wasted-bits flag
+        if (in.get(1) != 0) {
+            return false;
+        }
+        uint32_t type = in.get(6);
+        if (in.get(1) != 0) {
+            return false;                   // Wasted bits: FlacEncoder never writes them
+        }
+        x.assign(count, 0);
+        if (type == 0) {
+            int32_t v = in.getSigned(16);
+            for (uint32_t i = 0; i < count; i++) {
+                x[i] = v;
+            }
+            stats.constant++;
+        } else if (type == 1) {
+            for (uint32_t i = 0; i < count; i++) {
+                x[i] = in.getSigned(16);
+            }
+            stats.verbatim++;
+        } else if (type >= 8 && type <= 12) {
+            uint32_t order = type - 8;
+            if (count < order) {
+                return false;
+            }
+            for (uint32_t i = 0; i < order; i++) {
+                x[i] = in.getSigned(16);
+            }
+            uint32_t method = in.get(2);
+            if (method > 1) {
+                return false;
+            }
+            uint8_t param_bits = method == 0 ? 4 : 5;
+            uint32_t escape = (1u << param_bits) - 1;
+            uint32_t partition_order = in.get(4);
+            uint32_t parts = 1u << partition_order;
+            if (count % parts != 0 || (count >> partition_order) < order) {
+                return false;
+            }
+            uint32_t i = order;
+            for (uint32_t p = 0; p < parts; p++) {
+                uint32_t n = (count >> partition_order) - (p == 0 ? order : 0);
+                uint32_t k = in.get(param_bits);
+                uint8_t raw_bits = k == escape ? (uint8_t)in.get(5) : 0;
+                for (uint32_t j = 0; j < n && !in.overrun; j++, i++) {
+                    if (k == escape) {
+                        x[i] = raw_bits ? in.getSigned(raw_bits) : 0;
+                        continue;
+                    }
+                    uint32_t q = 0;
+                    while (in.get(1) == 0 && !in.overrun) {
+                        q++;
+                    }
+                    uint32_t u = q << k | in.get((uint8_t)k);
+                    x[i] = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+                }
+            }
+            for (uint32_t j = order; j < count; j++) {
+                switch (order) {
+                case 1: x[j] += x[j - 1]; break;
+                case 2: x[j] += 2 * x[j - 1] - x[j - 2]; break;
+                case 3: x[j] += 3 * x[j - 1] - 3 * x[j - 2] + x[j - 3]; break;
+                case 4: x[j] += 4 * x[j - 1] - 6 * x[j - 2] + 4 * x[j - 3] - x[j - 4]; break;
+                }
+            }
+            stats.fixed++;
+        } else {
+            return false;                   // LPC or reserved
+        }
+
+        in.align();
+        size_t body_end = in.bit / 8;
+        if (in.overrun || in.get(16) != crc16(frame_start, body_end)) {
+            return false;
+        }
+        for (int32_t v : x) {
+            if (v < -32768 || v > 32767) {
+                return false;
+            }
+            out.push_back((int16_t)v);
+        }
+    }
+    return !in.overrun;
+}
+
+struct Result {
+    std::vector<uint8_t> stream;
+    size_t header;
+    double cpu_us_per_s;
+    double cycles_per_s;
+};
+
+// Encode in 480-sample pieces (one SilenceTrimmer frame), as on the device
+static Result run(AudioEncoder& encoder, const std::vector<int16_t>& pcm, uint32_t rate)
+{
+    Result r;
+    r.header = 0;
+    encoder.begin(rate, [&](const uint8_t* data, size_t len) {
+        if (r.header == 0) {
+            r.header = len;
+        }
+        r.stream.insert(r.stream.end(), data, data + len);
+    });
+    for (size_t i = 0; i < pcm.size(); i += 480) {
+        encoder.encode(pcm.data() + i, pcm.size() - i < 480 ? pcm.size() - i : 480);
+    }
+    encoder.finish();
+    encoder.end();
+
+    // Timed passes write nowhere: only the encoder's own work is measured
+    const int iterations = 20;
+    auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (int it = 0; it < iterations; it++) {
+        encoder.begin(rate, [](const uint8_t*, size_t) {});
+        for (size_t i = 0; i < pcm.size(); i += 480) {
+            encoder.encode(pcm.data() + i, pcm.size() - i < 480 ? pcm.size() - i : 480);
+        }
+        encoder.finish();
+        encoder.end();
+    }
+#ifdef HAVE_TSC
+    double cycles = (double)(__rdtsc() - c0);
+#else
+    double cycles = 0;
+#endif
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double audio_secs = (double)pcm.size() / rate * iterations;
+    r.cpu_us_per_s = secs * 1e6 / audio_secs;
+    r.cycles_per_s = cycles / audio_secs;
+    return r;
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f) {
+        fwrite(data.data(), 1, data.size(), f);
+        fclose(f);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool dump = false;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump") == 0) {
+            dump = true;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        files.push_back("");        // Synthetic input
+    }
+
+    // Every subframe type FlacEncoder writes, and a short last frame:
+    // silence (constant), full-scale noise (verbatim), a tone (fixed)
+    {
+        std::vector<int16_t> edge(3 * FlacEncoder::BLOCK_SIZE + 333, 0);
+        uint32_t seed = 1;
+        for (size_t i = FlacEncoder::BLOCK_SIZE; i < 2 * FlacEncoder::BLOCK_SIZE; i++) {
+            seed = seed * 1664525 + 1013904223;
+            edge[i] = (int16_t)(seed >> 16);
+        }
+        for (size_t i = 2 * FlacEncoder::BLOCK_SIZE; i < edge.size(); i++) {
+            edge[i] = (int16_t)(20000 * sin(2 * M_PI * 440 * i / 16000.0));
+        }
+        FlacEncoder flac;
+        std::vector<uint8_t> stream;
+        flac.begin(16000, [&](const uint8_t* data, size_t len) { stream.insert(stream.end(), data, data + len); });
+        flac.encode(edge.data(), edge.size());
+        flac.finish();
+        flac.end();
+        FlacStats stats = {};
+        std::vector<int16_t> decoded;
+        bool same = decodeFlac(stream, decoded, stats) && decoded == edge;
+        bool covered = stats.constant && stats.verbatim && stats.fixed;
+        printf("FLAC decode check: %zu constant, %zu verbatim, %zu fixed subframes, %s\n\n",
+               stats.constant, stats.verbatim, stats.fixed,
+               !same ? "MISMATCH" : covered ? "sample for sample" : "a subframe type not exercised");
+        if (!same || !covered) {
+            return 1;
+        }
+    }
+
+    bool all_lossless = true;
+    printf("%-28s %-10s %9s %7s %8s %10s %12s %s\n",
+           "file", "codec", "bytes", "ratio", "kbit/s", "cpu us/s", "cycles/s", "quality");
+
+    for (const std::string& path : files) {
+        std::vector<int16_t> pcm;
+        uint32_t rate = 16000;
+        std::string name = path;
+        if (path.empty()) {
+            synthesize(pcm, rate, 5.0f);
+            name = "synthetic";
+        } else if (!loadWav(path, pcm, rate)) {
+            fprintf(stderr, "%s: not a 16-bit PCM WAV\n", path.c_str());
+            return 1;
+        }
+        if (pcm.empty()) {
+            continue;
+        }
+        double seconds = (double)pcm.size() / rate;
+
+        PcmWavEncoder pcm_encoder;
+        ImaAdpcmEncoder ima_encoder;
+        FlacEncoder flac_encoder;
+        struct Codec {
+            const char* label;
+            AudioEncoder* encoder;
+            const char* suffix;
+        } codecs[] = {
+            {"pcm-wav", &pcm_encoder, nullptr},
+            {"ima-adpcm", &ima_encoder, ".ima.wav"},
+            {"flac", &flac_encoder, ".flac"},
+        };
+
+        size_t pcm_bytes = 0;
+        for (const Codec& codec : codecs) {
+            Result r = run(*codec.encoder, pcm, rate);
+            if (!pcm_bytes) {
+                pcm_bytes = r.stream.size();
+            }
+
+            char quality[48] = "lossless";
+            if (codec.encoder == &flac_encoder) {
+                FlacStats stats = {};
+                std::vector<int16_t> decoded;
+                bool same = decodeFlac(r.stream, decoded, stats) && decoded == pcm;
+                all_lossless = all_lossless && same;
+                snprintf(quality, sizeof(quality), "%s", same ? "lossless (decoded)" : "MISMATCH");
+            } else if (codec.encoder == &ima_encoder) {
+                std::vector<int16_t> decoded;
+                decodeIma(r.stream, r.header, decoded);
+                double sig = 0, err = 0;
+                for (size_t i = 0; i < pcm.size() && i < decoded.size(); i++) {
+                    double d = (double)pcm[i] - decoded[i];
+                    sig += (double)pcm[i] * pcm[i];
+                    err += d * d;
+                }
+                snprintf(quality, sizeof(quality), "SNR %.1f dB", 10 * log10(sig / (err > 0 ? err : 1)));
+            }
+
+            printf("%-28.28s %-10s %9zu %6.2fx %8.1f %10.0f %12.0f %s\n",
+                   name.c_str(), codec.label, r.stream.size(),
+                   (double)pcm_bytes / r.stream.size(),
+                   r.stream.size() * 8 / seconds / 1000, r.cpu_us_per_s, r.cycles_per_s, quality);
+
+            if (dump && codec.suffix) {
+                writeFile(name + codec.suffix, r.stream);
+            }
+        }
+    }
+    return all_lossless ? 0 : 1;
+}
@@ -0,0 +1,517 @@
+/*
+ * backend_bench.cpp
+ * Fetching stickers from a real HTTP server: polling and buffering the
+ * JSON result, against BackendClient streaming it into the pipeline
+ *
+ * Usage:
+ *   python3 scripts/standin_backend.py &            (from the repo root)
+ *   backend_bench [options]
+ *     --url URL         Backend (http://127.0.0.1:8089)
+ *     --stickers N      Stickers per mode (3)
+ *     --rows N          Height of the stand-in's synthetic sticker (480)
+ *     --baud N          UART and printer baud rate (115200)
+ *     --wait S          Long-poll wait; below the stand-in's --delay to see
+ *                       204 answers and repeated polls (20)
+ *     --verbose         Keep driver INFO logs
+ *
+ * Each sticker is a POST /api/v1/audio followed by fetching the result
+ * into StickerPipeline, with the printer model on the simulated UART.
+ * Simulated time runs at the real rate here, since the server is real.
+ *
+ *   poll+buffer   the original contract: GET /api/v1/job/{id} on a new
+ *                 connection every 500 ms until done, the whole JSON
+ *                 body kept, raster_data decoded, then printed
+ *   json stream   BackendClient, Format::Json: the same document long
+ *                 polled on a kept connection, decoded as it arrives
+ *   pvr1 stream   BackendClient, Format::Pvr1: the chunked binary result
+ *
+ * Reported per mode (averages): time from the POST to the first byte at
+ * the printer, to the end of the download and to the head finishing;
+ * the result bytes the network side held at once; requests and
+ * connections per sticker. The streaming modes must print before their
+ * download ends, on one connection (the stand-in's --idle-timeout must
+ * outlast a print). Then a result cut off halfway and a failed job must
+ * fail cleanly, and the sticker after them print intact. Last, with the
+ * spool tee (BackendClient::setSpool) the spooled and cached copies of a
+ * streamed sticker must decode to the image, and a cut one must leave no
+ * record behind.
+ */
+
+#include "BackendClient.hpp"
+#include "JsonRasterParser.hpp"
+#include "PrintQueue.hpp"
+#include "PrintSpool.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "StickerCache.hpp"
+#include "StickerPipeline.hpp"
+#include "ThermalPrinter.hpp"
+#include "bench_raster.hpp"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr size_t NET_CHUNK = 1460;
+static constexpr uint8_t SPOOL_SUBTYPE = 0x40;      // As in partitions.csv
+
+struct Device {
+    std::unique_ptr<SimPrinter> model;
+    std::unique_ptr<ThermalPrinter> printer;
+    std::unique_ptr<PrintQueue> queue;
+    std::unique_ptr<StickerPipeline> pipeline;
+    SemaphoreHandle_t done;
+    std::atomic<bool> ok;
+    uint32_t baud;
+    
+    Device()
+        : done(xSemaphoreCreateBinary())
+        , ok(false)
+        , baud(0)
+    {
+    }
+    
+    ~Device()
+    {
+        pipeline.reset();
+        queue.reset();
+        printer.reset();
+        model.reset();
+        vSemaphoreDelete(done);
+    }
+};
+
+static bool boot(Device& dev, uint32_t baud)
+{
+    dev.baud = baud;
+    dev.model.reset(new SimPrinter(UART_NUM_1, baud));
+    dev.model->attach();
+    dev.printer.reset(new ThermalPrinter(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18, (int)baud));
+    dev.queue.reset(new PrintQueue(*dev.printer, 4));
+    dev.pipeline.reset(new StickerPipeline(*dev.queue));
+    Device* d = &dev;
+    dev.pipeline->setCallback([d](uint32_t, bool ok) {
+        d->ok = ok;
+        xSemaphoreGive(d->done);
+    });
+    if (!dev.printer->begin() || !dev.queue->begin() || !dev.pipeline->begin()) {
+        return false;
+    }
+    dev.printer->waitTxDone();
+    Sim::sleepUntil(dev.model->getStats().busy_until_us);
+    Sim::uartClearTx(UART_NUM_1);
+    return true;
+}
+
+// A fresh printer model and an empty wire for the next sticker
+static void nextSticker(Device& dev)
+{
+    dev.printer->waitTxDone();
+    Sim::sleepUntil(dev.model->getStats().busy_until_us);
+    dev.model.reset();
+    dev.model.reset(new SimPrinter(UART_NUM_1, dev.baud));
+    dev.model->attach();
+    Sim::uartClearTx(UART_NUM_1);
+}
+
+// POST a short dummy recording; the stand-in ignores the audio
+static std::string postAudio(const std::string& base, const char* simulate)
+{
+    std::string url = base + "/api/v1/audio" + (simulate ? std::string("?simulate=") + simulate : "");
+    esp_http_client_config_t config = {};
+    config.url = url.c_str();
+    config.method = HTTP_METHOD_POST;
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (!client) {
+        return "";
+    }
+    std::vector<char> wav(44 + 3200, 0);
+    memcpy(wav.data(), "RIFF", 4);
+    esp_http_client_set_header(client, "Content-Type", "audio/wav");
+    std::string job_id;
+    if (esp_http_client_open(client, (int)wav.size()) == ESP_OK
+        && esp_http_client_write(client, wav.data(), (int)wav.size()) == (int)wav.size()) {
+        esp_http_client_fetch_headers(client);
+        char body[128];
+        int len = esp_http_client_read(client, body, sizeof(body) - 1);
+        body[len > 0 ? len : 0] = '\0';
+        const char* key = strstr(body, "\"job_id\": \"");
+        if (esp_http_client_get_status_code(client) == 202 && key) {
+            key += 11;
+            const char* end = strchr(key, '"');
+            job_id.assign(key, end ? end - key : 0);
+        }
+    }
+    esp_http_client_cleanup(client);
+    return job_id;
+}
+
+static bool base64Decode(const std::string& text, std::vector<uint8_t>& out)
+{
+    uint32_t quad = 0;
+    int bits = 0;
+    for (char c : text) {
+        int v;
+        if (c >= 'A' && c <= 'Z') {
+            v = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            v = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            v = c - '0' + 52;
+        } else if (c == '+' || c == '/') {
+            v = c == '+' ? 62 : 63;
+        } else if (c == '=') {
+            break;
+        } else {
+            return false;
+        }
+        quad = (quad << 6) | (uint32_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back((uint8_t)(quad >> bits));
+        }
+    }
+    return true;
+}
+
+struct Run {
+    double first_print_ms;
+    double download_ms;
+    double total_ms;
+    size_t held_bytes;          // Result bytes held by the network side
+    uint32_t requests;
+    uint32_t connections;
+    bool ok;
+    bool intact;
+};
+
+// Buffers the JSON result of the original contract and prints it after
+struct PollingFetcher {
+    std::string base;
+    uint32_t requests = 0;
+    uint32_t connections = 0;
+    
+    bool fetch(const std::string& job_id, StickerPipeline& pipeline, Run& run, int64_t start_us)
+    {
+        std::string url = base + "/api/v1/job/" + job_id;
+        std::string body;
+        while (true) {
+            esp_http_client_config_t config = {};
+            config.url = url.c_str();
+            config.method = HTTP_METHOD_GET;
+            esp_http_client_handle_t client = esp_http_client_init(&config);
+            connections++;
+            requests++;
+            body.clear();
+            bool read_ok = false;
+            if (client && esp_http_client_open(client, 0) == ESP_OK) {
+                esp_http_client_fetch_headers(client);
+                char buf[NET_CHUNK];
+                int n;
+                while ((n = esp_http_client_read(client, buf, sizeof(buf))) > 0) {
+                    body.append(buf, n);
+                }
+                read_ok = n == 0 && esp_http_client_is_complete_data_received(client);
+            }
+            esp_http_client_cleanup(client);
+            if (!read_ok) {
+                return false;
+            }
+            if (body.find("\"processing\"") == std::string::npos) {
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(500));
+        }
+        run.download_ms = (Sim::now() - start_us) / 1000.0;
+        
+        size_t key = body.find("\"raster_data\": \"");
+        if (key == std::string::npos) {
+            return false;
+        }
+        key += 16;
+        size_t end = body.find('"', key);
+        std::vector<uint8_t> pvr;
+        if (end == std::string::npos || !base64Decode(body.substr(key, end - key), pvr)) {
+            return false;
+        }
+        run.held_bytes = body.size() + pvr.size();
+        
+        if (!pipeline.open(portMAX_DELAY)) {
+            return false;
+        }
+        bool ok = true;
+        for (size_t pos = 0; pos < pvr.size() && ok; pos += NET_CHUNK) {
+            ok = pipeline.write(pvr.data() + pos, std::min(NET_CHUNK, pvr.size() - pos), portMAX_DELAY);
+        }
+        pipeline.close(ok);
+        return ok;
+    }
+};
+
+static bool waitDone(Device& dev)
+{
+    return xSemaphoreTake(dev.done, pdMS_TO_TICKS(60000)) == pdTRUE && dev.ok;
+}
+
+static void finishRun(Device& dev, Run& run, int64_t start_us, const std::vector<uint8_t>& image)
+{
+    dev.printer->waitTxDone();
+    std::vector<Sim::UartByte> tx = Sim::uartTx(UART_NUM_1);
+    run.first_print_ms = tx.empty() ? 0 : (tx.front().t_us - start_us) / 1000.0;
+    run.total_ms = (dev.model->getStats().busy_until_us - start_us) / 1000.0;
+    run.intact = dev.model->raster() == image;
+}
+
+enum class Mode {
+    Polling,
+    JsonStream,
+    Pvr1Stream,
+};
+
+// Average of `stickers` runs in one mode; a client keeps its connection
+// across them
+static Run runMode(Device& dev, Mode mode, const std::string& base, int stickers, uint32_t wait_s,
+                   const std::vector<uint8_t>& image)
+{
+    BackendClient::Config config = BackendClient::DEFAULT_CONFIG;
+    config.wait_s = wait_s;
+    config.format = mode == Mode::JsonStream ? BackendClient::Format::Json : BackendClient::Format::Pvr1;
+    BackendClient client(base.c_str(), "bench-token", config);
+    PollingFetcher polling;
+    polling.base = base;
+    if (mode != Mode::Polling && !client.begin()) {
+        return Run();
+    }
+    
+    Run sum = {};
+    sum.ok = true;
+    sum.intact = true;
+    for (int i = 0; i < stickers; i++) {
+        Run run = {};
+        std::string job_id = postAudio(base, nullptr);
+        if (job_id.empty()) {
+            sum.ok = false;
+            break;
+        }
+        int64_t start_us = Sim::now();
+        bool fetched;
+        if (mode == Mode::Polling) {
+            fetched = polling.fetch(job_id, *dev.pipeline, run, start_us);
+        } else {
+            fetched = client.fetchSticker(job_id.c_str(), *dev.pipeline);
+            run.download_ms = (Sim::now() - start_us) / 1000.0;
+            run.held_bytes = NET_CHUNK;
+        }
+        run.ok = fetched && waitDone(dev);
+        finishRun(dev, run, start_us, image);
+        nextSticker(dev);
+        
+        sum.first_print_ms += run.first_print_ms / stickers;
+        sum.download_ms += run.download_ms / stickers;
+        sum.total_ms += run.total_ms / stickers;
+        sum.held_bytes = std::max(sum.held_bytes, run.held_bytes);
+        sum.ok = sum.ok && run.ok;
+        sum.intact = sum.intact && run.intact;
+    }
+    if (mode == Mode::Polling) {
+        sum.requests = polling.requests;
+        sum.connections = polling.connections;
+    } else {
+        BackendClient::Stats stats = client.getStats();
+        sum.requests = stats.requests;
+        sum.connections = stats.connections;
+    }
+    return sum;
+}
+
+// A result cut off halfway and a failed job, in both formats, then a
+// sticker that must print intact
+static bool failures(Device& dev, const std::string& base, const std::vector<uint8_t>& image)
+{
+    bool ok = true;
+    for (BackendClient::Format format : {BackendClient::Format::Pvr1, BackendClient::Format::Json}) {
+        BackendClient::Config config = BackendClient::DEFAULT_CONFIG;
+        config.format = format;
+        BackendClient client(base.c_str(), "bench-token", config);
+        client.begin();
+        const char* name = format == BackendClient::Format::Pvr1 ? "pvr1" : "json";
+        
+        std::string job_id = postAudio(base, "cut");
+        bool cut_failed = !client.fetchSticker(job_id.c_str(), *dev.pipeline);
+        // The sticker had started: the pipeline reports it failed
+        bool reported = xSemaphoreTake(dev.done, pdMS_TO_TICKS(20000)) == pdTRUE && !dev.ok;
+        printf("%s %-22s %s (%s)\n", name, "result cut halfway",
+               cut_failed && reported ? "failed, ok" : "NOT FAILED", client.lastError());
+        nextSticker(dev);
+        
+        job_id = postAudio(base, "error");
+        bool error_failed = !client.fetchSticker(job_id.c_str(), *dev.pipeline);
+        printf("%s %-22s %s (%s)\n", name, "job failed", error_failed ? "failed, ok" : "NOT FAILED",
+               client.lastError());
+        
+        job_id = postAudio(base, nullptr);
+        bool next_ok = client.fetchSticker(job_id.c_str(), *dev.pipeline) && waitDone(dev);
+        dev.printer->waitTxDone();
+        bool intact = dev.model->raster() == image;
+        printf("%s %-22s %s, %u connections\n", name, "next sticker",
+               next_ok && intact ? "printed intact, ok" : "BROKEN", (unsigned)client.getStats().connections);
+        nextSticker(dev);
+        ok = ok && cut_failed && reported && error_failed && next_ok && intact;
+    }
+    return ok;
+}
+
+static bool decodesTo(RasterSource& source, uint16_t width_bytes, const std::vector<uint8_t>& image)
+{
+    std::vector<uint8_t> rows;
+    std::vector<uint8_t> row(width_bytes);
+    while (source.readRow(row.data())) {
+        rows.insert(rows.end(), row.begin(), row.end());
+    }
+    return width_bytes == WIDTH_BYTES && rows == image;
+}
+
+// The spool tee: a streamed sticker is committed whole before the pipeline
+// closes and cached from the record, as main.cpp's onStickerStreamed(); a
+// cut one is aborted
+static bool spoolTee(Device& dev, const std::string& base, const std::vector<uint8_t>& image)
+{
+    PrintSpool spool;
+    StickerCache cache;
+    if (!spool.begin() || !cache.begin()) {
+        printf("spool tee: no spool partition\n");
+        return false;
+    }
+    BackendClient client(base.c_str(), "bench-token");
+    client.begin();
+    uint64_t key = StickerCache::key("a sticker");
+    bool spooled_intact = false;
+    bool before_close = false;
+    client.setSpool(&spool, [&](const PrintSpool::Record& record) {
+        SpoolSource source(spool, record);
+        spooled_intact = source.begin() && decodesTo(source, source.widthBytes(), image);
+        SpoolReader bytes(spool, record);
+        cache.put(key, bytes, record.length);
+        // The raster's END_OK is still to come
+        before_close = xSemaphoreTake(dev.done, 0) == pdFALSE;
+        spool.markDone(record.id);
+    });
+    
+    std::string job_id = postAudio(base, nullptr);
+    bool printed = client.fetchSticker(job_id.c_str(), *dev.pipeline) && waitDone(dev);
+    dev.printer->waitTxDone();
+    printed = printed && dev.model->raster() == image;
+    bool cached_intact;
+    {
+        StickerCache::Source cached(cache);
+        cached_intact = cached.open(key) && decodesTo(cached, cached.widthBytes(), image);
+    }
+    nextSticker(dev);
+    
+    job_id = postAudio(base, "cut");
+    bool cut_failed = !client.fetchSticker(job_id.c_str(), *dev.pipeline);
+    xSemaphoreTake(dev.done, pdMS_TO_TICKS(20000));
+    nextSticker(dev);
+    PrintSpool::Record left[4];
+    bool none_left = spool.pending(left, 4) == 0 && spool.getStats().records == 1;
+    
+    BackendClient::Stats stats = client.getStats();
+    bool ok = printed && spooled_intact && before_close && cached_intact && cut_failed && none_left
+              && stats.spooled == 1 && stats.spool_failures == 0;
+    printf("%-27s %s (printed %s, spooled %s, cached %s, cut one %s)\n", "spool tee", ok ? "ok" : "BROKEN",
+           printed ? "ok" : "BROKEN", spooled_intact && before_close ? "ok" : "BROKEN",
+           cached_intact ? "ok" : "BROKEN", cut_failed && none_left ? "aborted" : "LEFT BEHIND");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::string base = "http://127.0.0.1:8089";
+    int stickers = 3;
+    uint16_t height = 480;
+    uint32_t baud = 115200;
+    uint32_t wait_s = BackendClient::DEFAULT_CONFIG.wait_s;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--url" && has_value) {
+            base = argv[++i];
+        } else if (arg == "--stickers" && has_value) {
+            stickers = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--rows" && has_value) {
+            height = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--baud" && has_value) {
+            baud = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--wait" && has_value) {
+            wait_s = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--url URL] [--stickers N] [--rows N] [--baud N] [--wait S] "
+                    "[--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_NONE);
+    }
+    Sim::setTimeScale(1);
+    Sim::flashAddPartition("spool", SPOOL_SUBTYPE, 256 * 1024);
+    
+    if (postAudio(base, nullptr).empty()) {
+        fprintf(stderr, "No backend at %s (start scripts/standin_backend.py)\n", base.c_str());
+        return 1;
+    }
+    std::vector<uint8_t> image = noisyImage(height);
+    Device dev;
+    if (!boot(dev, baud)) {
+        fprintf(stderr, "Boot failed\n");
+        return 1;
+    }
+    printf("%s, %u rows, %d stickers per mode, %u baud\n", base.c_str(), (unsigned)height, stickers,
+           (unsigned)baud);
+    printf("%-12s %9s %9s %9s %9s %6s %6s %s\n", "mode", "1st print", "download", "total",
+           "held B", "req", "conns", "raster");
+    
+    bool ok = true;
+    const struct {
+        Mode mode;
+        const char* name;
+    } MODES[] = {
+        {Mode::Polling, "poll+buffer"},
+        {Mode::JsonStream, "json stream"},
+        {Mode::Pvr1Stream, "pvr1 stream"},
+    };
+    for (const auto& m : MODES) {
+        Run run = runMode(dev, m.mode, base, stickers, wait_s, image);
+        printf("%-12s %9.0f %9.0f %9.0f %9u %6.1f %6.1f %s\n", m.name, run.first_print_ms,
+               run.download_ms, run.total_ms, (unsigned)run.held_bytes, (double)run.requests / stickers,
+               (double)run.connections / stickers, run.ok && run.intact ? "ok" : "MISMATCH");
+        ok = ok && run.ok && run.intact;
+        if (m.mode != Mode::Polling) {
+            // Printing starts before the download ends, all on one connection
+            bool overlapped = run.first_print_ms < run.download_ms;
+            ok = ok && overlapped && run.connections == 1;
+            if (!overlapped) {
+                printf("  %s: first print after the download ended\n", m.name);
+            }
+        }
+    }
+    printf("(times in ms from the POST; held: result bytes in RAM at once on the network side, "
+           "streaming = one receive buffer)\n");
+    
+    ok = failures(dev, base, image) && ok;
+    ok = spoolTee(dev, base, image) && ok;
+    printf("%s\n", ok ? "Streaming prints during the download on one connection" : "BACKEND CLIENT PROBLEMS");
+    return ok ? 0 : 1;
+}
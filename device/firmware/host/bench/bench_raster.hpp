@@ -0,0 +1,114 @@
+/*
+ * bench_raster.hpp
+ * Test images and a PVR1 encoder shared by the host benches
+ *
+ * Images are 1-bit rows WIDTH_BYTES wide (384 dots, the printer's width),
+ * MSB first. encodePvr() is encode_pvr_rows() from scripts/pipeline.py, so
+ * a bench feeds the firmware the same bytes the backend would send.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static constexpr uint16_t WIDTH_BYTES = 48;
+
+// Ordered-dithered radial gradient, as in printer_bench; `seed` shifts it
+inline std::vector<uint8_t> syntheticImage(uint16_t height, int seed)
+{
+    static const uint8_t BAYER[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+    std::vector<uint8_t> rows((size_t)height * WIDTH_BYTES, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < WIDTH_BYTES * 8; x++) {
+            int dx = x - WIDTH_BYTES * 4 + seed * 17 % 64;
+            int dy = y - height / 2;
+            int d2 = dx * dx + dy * dy;
+            int level = d2 > 180 * 180 ? 0 : 16 - d2 * 16 / (180 * 180);
+            if (level > BAYER[y & 3][x & 3]) {
+                rows[(size_t)y * WIDTH_BYTES + x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+    return rows;
+}
+
+// Gradient dithered against a hashed threshold: few repeated rows or runs.
+// Same image as noisy_image() in scripts/standin_backend.py
+inline std::vector<uint8_t> noisyImage(uint16_t height)
+{
+    std::vector<uint8_t> rows((size_t)height * WIDTH_BYTES, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < WIDTH_BYTES * 8; x++) {
+            uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u;
+            h ^= h >> 13;
+            h *= 0x5bd1e995;
+            h ^= h >> 15;
+            int level = 255 - x * 255 / (WIDTH_BYTES * 8 - 1);
+            if ((int)(h & 0xFF) < level) {
+                rows[(size_t)y * WIDTH_BYTES + x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+    return rows;
+}
+
+// PackBits as _packbits() in scripts/pipeline.py: runs of 3+ repeat
+inline void packBits(const uint8_t* row, size_t len, std::vector<uint8_t>& out)
+{
+    size_t i = 0;
+    while (i < len) {
+        size_t run = 1;
+        while (i + run < len && run < 128 && row[i + run] == row[i]) {
+            run++;
+        }
+        if (run >= 3) {
+            out.push_back((uint8_t)(257 - run));
+            out.push_back(row[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i;
+        while (i < len && i - start < 128) {
+            if (i + 2 < len && row[i] == row[i + 1] && row[i] == row[i + 2]) {
+                break;
+            }
+            i++;
+        }
+        out.push_back((uint8_t)(i - start - 1));
+        out.insert(out.end(), row + start, row + i);
+    }
+}
+
+// encode_pvr_rows() from scripts/pipeline.py
+inline std::vector<uint8_t> encodePvr(const std::vector<uint8_t>& rows, uint16_t height)
+{
+    std::vector<uint8_t> out = {'P', 'V', 'R', '1', WIDTH_BYTES, 0,
+                                (uint8_t)(height & 0xFF), (uint8_t)(height >> 8)};
+    std::vector<uint8_t> blank(WIDTH_BYTES, 0);
+    const uint8_t* prev = blank.data();
+    auto row = [&](int y) { return rows.data() + (size_t)y * WIDTH_BYTES; };
+    int y = 0;
+    while (y < height) {
+        int n = 1;
+        if (memcmp(row(y), blank.data(), WIDTH_BYTES) == 0) {
+            while (n < 64 && y + n < height && memcmp(row(y + n), blank.data(), WIDTH_BYTES) == 0) {
+                n++;
+            }
+            out.push_back((uint8_t)(0x40 + n - 1));
+            prev = blank.data();
+        } else if (memcmp(row(y), prev, WIDTH_BYTES) == 0) {
+            while (n < 128 && y + n < height && memcmp(row(y + n), prev, WIDTH_BYTES) == 0) {
+                n++;
+            }
+            out.push_back((uint8_t)(0x80 + n - 1));
+        } else {
+            out.push_back(0x00);
+            packBits(row(y), WIDTH_BYTES, out);
+            prev = row(y);
+        }
+        y += n;
+    }
+    return out;
+}
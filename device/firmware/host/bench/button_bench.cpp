@@ -0,0 +1,118 @@
+/*
+ * button_bench.cpp
+ * Button gesture decoding and edge-to-callback latency on the simulated GPIO
+ *
+ * Usage:
+ *   button_bench [--rounds N] [--bounces N] [--scale S]
+ *
+ * Each round plays a click, a double press and a long press into GPIO 12
+ * with contact bounce on every edge (bounces at 0.1-2 ms spacing), then
+ * checks that Button reported exactly the expected events and prints the
+ * latency histogram from the ISR timestamp to the callback. Latency is in
+ * simulated time, so keep --scale at 1 when measuring it.
+ */
+
+#include "Button.hpp"
+#include "Sim.hpp"
+#include "esp_log.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static constexpr gpio_num_t PIN = GPIO_NUM_12;
+
+static std::atomic<uint32_t> counts[5];
+
+static void onEvent(Button::Event event, void* ctx)
+{
+    (void)ctx;
+    counts[(int)event].fetch_add(1);
+}
+
+static void buttonTask(void* arg)
+{
+    static_cast<Button*>(arg)->task();
+}
+
+// Active-low contact: bounce around the new level, then settle on it
+static void edge(int level, int bounces)
+{
+    for (int i = 0; i < bounces; i++) {
+        Sim::gpioDrive(PIN, level);
+        Sim::sleepUntil(Sim::now() + 100 + rand() % 1900);
+        Sim::gpioDrive(PIN, !level);
+        Sim::sleepUntil(Sim::now() + 100 + rand() % 900);
+    }
+    Sim::gpioDrive(PIN, level);
+}
+
+static void press(int64_t hold_us, int bounces)
+{
+    edge(0, bounces);
+    Sim::sleepUntil(Sim::now() + hold_us);
+    edge(1, bounces);
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = 3;
+    int bounces = 3;
+    double scale = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--rounds" && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (arg == "--bounces" && i + 1 < argc) {
+            bounces = atoi(argv[++i]);
+        } else if (arg == "--scale" && i + 1 < argc) {
+            scale = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--rounds N] [--bounces N] [--scale S]\n", argv[0]);
+            return 1;
+        }
+    }
+    esp_log_level_set("*", ESP_LOG_WARN);
+    Sim::setTimeScale(scale);
+    srand(1);
+    
+    Button button(PIN, 50);
+    if (!button.begin()) {
+        return 1;
+    }
+    button.setCallback(onEvent, nullptr);
+    xTaskCreate(buttonTask, "button", 2048, &button, 10, nullptr);
+    Sim::sleepUntil(Sim::now() + 10000);
+    
+    const ButtonGesture::Config& config = ButtonGesture::DEFAULT_CONFIG;
+    int64_t settle_us = config.double_press_us + 200000;
+    for (int r = 0; r < rounds; r++) {
+        press(120000, bounces);                             // Click
+        Sim::sleepUntil(Sim::now() + settle_us);
+        press(80000, bounces);                              // Double press
+        Sim::sleepUntil(Sim::now() + config.double_press_us / 2);
+        press(80000, bounces);
+        Sim::sleepUntil(Sim::now() + settle_us);
+        press(config.long_press_us + 200000, bounces);      // Long press
+        Sim::sleepUntil(Sim::now() + settle_us);
+    }
+    
+    static const char* NAMES[] = {"press", "release", "click", "double", "long"};
+    // Per round: 4 presses/releases, 1 click, 1 double, 1 long
+    const uint32_t expected[] = {4u * rounds, 4u * rounds, (uint32_t)rounds, (uint32_t)rounds, (uint32_t)rounds};
+    bool ok = true;
+    printf("%-8s %8s %8s\n", "event", "count", "expected");
+    for (int i = 0; i < 5; i++) {
+        uint32_t n = counts[i].load();
+        ok = ok && n == expected[i];
+        printf("%-8s %8u %8u\n", NAMES[i], (unsigned)n, (unsigned)expected[i]);
+    }
+    
+    const LatencyHistogram& latency = button.getLatency();
+    printf("\nlatency (us): n=%u min=%u mean=%u p50<=%u p99<=%u max=%u, dropped edges %u\n",
+           (unsigned)latency.count(), (unsigned)latency.minUs(), (unsigned)latency.meanUs(),
+           (unsigned)latency.percentileUs(50), (unsigned)latency.percentileUs(99),
+           (unsigned)latency.maxUs(), (unsigned)button.getDroppedEdges());
+    printf("%s\n", ok ? "gestures ok" : "GESTURE MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,278 @@
+/*
+ * cache_bench.cpp
+ * Sticker cache: hit rates, spills and footprint under a repeat-heavy
+ * prompt mix, on the simulated PSRAM and flash
+ *
+ * Usage:
+ *   cache_bench [options]
+ *     --prompts N       Distinct prompts (60)
+ *     --requests N      Stickers asked for (600)
+ *     --zipf S          Popularity skew, prompt i weighs 1/(i+1)^S (1.0)
+ *     --ram-kb N        RAM tier budget (128)
+ *     --flash-kb N      Flash tier budget (224)
+ *     --cache-kb N      Cache partition size (448)
+ *     --seed N          Request order (1)
+ *     --verbose         Keep driver INFO logs
+ *
+ * Each request looks its prompt up first; a hit decodes the cached
+ * sticker and checks it row for row against the image it was made from,
+ * a miss "generates" it and puts it in the cache. The run is repeated
+ * after a reboot (flash tier only survives) and on a module without
+ * PSRAM. Budgets must hold in every phase and no hit may decode wrong.
+ */
+
+#include "PrintSpool.hpp"
+#include "Sim.hpp"
+#include "StickerCache.hpp"
+#include "bench_raster.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr uint8_t CACHE_SUBTYPE = 0x41;      // As in partitions.csv
+
+struct Prompt {
+    std::string text;
+    uint64_t key;
+    std::vector<uint8_t> image;
+    std::vector<uint8_t> pvr;
+};
+
+// What the backend would make for each prompt; heights vary the sizes
+static std::vector<Prompt> makePrompts(int count)
+{
+    std::vector<Prompt> prompts(count);
+    for (int i = 0; i < count; i++) {
+        char text[48];
+        snprintf(text, sizeof(text), "a happy %s number %d", i % 2 ? "Dragon" : "cat", i);
+        uint16_t height = (uint16_t)(200 + i * 37 % 400);
+        prompts[i].text = text;
+        prompts[i].key = StickerCache::key(text);
+        prompts[i].image = syntheticImage(height, i);
+        prompts[i].pvr = encodePvr(prompts[i].image, height);
+    }
+    return prompts;
+}
+
+static bool decodeMatches(StickerCache::Source& source, const std::vector<uint8_t>& image)
+{
+    std::vector<uint8_t> row(source.widthBytes());
+    size_t pos = 0;
+    while (source.readRow(row.data())) {
+        if (pos + row.size() > image.size() || memcmp(row.data(), image.data() + pos, row.size()) != 0) {
+            return false;
+        }
+        pos += row.size();
+    }
+    return pos == image.size();
+}
+
+struct Run {
+    uint32_t requests = 0;
+    uint32_t hits = 0;
+    uint32_t wrong = 0;
+    bool budgets_held = true;
+};
+
+static Run runRequests(StickerCache& cache, const std::vector<Prompt>& prompts,
+                       const std::vector<int>& order)
+{
+    Run run;
+    for (int i : order) {
+        const Prompt& p = prompts[i];
+        run.requests++;
+        StickerCache::Source source(cache);
+        if (source.open(p.key)) {
+            run.hits++;
+            if (!decodeMatches(source, p.image)) {
+                run.wrong++;
+            }
+        } else {
+            cache.put(p.key, p.pvr.data(), p.pvr.size());
+        }
+        StickerCache::Metrics m = cache.getMetrics();
+        if (m.ram_bytes > m.ram_budget || m.flash_bytes > m.flash_budget) {
+            run.budgets_held = false;
+        }
+    }
+    return run;
+}
+
+static void printMetrics(const char* phase, const Run& run, const StickerCache::Metrics& m)
+{
+    size_t psram_used = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    printf("%-14s %5u %6.1f%% %6u %6u %6u %7u %7u %9s %7s\n", phase, (unsigned)run.requests,
+           run.requests ? 100.0 * run.hits / run.requests : 0.0, (unsigned)m.ram_hits,
+           (unsigned)m.flash_hits, (unsigned)m.misses, (unsigned)m.spills, (unsigned)m.evictions,
+           (std::to_string(m.ram_bytes / 1024) + "/" + std::to_string(m.ram_budget / 1024)).c_str(),
+           (std::to_string(m.flash_bytes / 1024) + "/" + std::to_string(m.flash_budget / 1024)).c_str());
+    printf("%-14s ram %u entries (%s, heap shows %zu KB), flash %u entries, index %zu B, "
+           "spill failures %u\n", "", (unsigned)m.ram_entries, m.psram ? "PSRAM" : "internal",
+           (m.psram ? psram_used : m.ram_bytes) / 1024, (unsigned)m.flash_entries, m.index_bytes,
+           (unsigned)m.spill_failures);
+}
+
+int main(int argc, char** argv)
+{
+    int prompt_count = 60;
+    int request_count = 600;
+    double zipf = 1.0;
+    size_t ram_kb = 128;
+    size_t flash_kb = 224;
+    size_t cache_kb = 448;
+    unsigned seed = 1;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--prompts" && has_value) {
+            prompt_count = atoi(argv[++i]);
+        } else if (arg == "--requests" && has_value) {
+            request_count = atoi(argv[++i]);
+        } else if (arg == "--zipf" && has_value) {
+            zipf = atof(argv[++i]);
+        } else if (arg == "--ram-kb" && has_value) {
+            ram_kb = (size_t)atoi(argv[++i]);
+        } else if (arg == "--flash-kb" && has_value) {
+            flash_kb = (size_t)atoi(argv[++i]);
+        } else if (arg == "--cache-kb" && has_value) {
+            cache_kb = (size_t)atoi(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            seed = (unsigned)atoi(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--prompts N] [--requests N] [--zipf S] [--ram-kb N] "
+                    "[--flash-kb N] [--cache-kb N] [--seed N] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_WARN);
+    }
+    // Flash timing is modeled but not what this bench measures
+    Sim::setTimeScale(1000);
+    Sim::flashAddPartition("cache", CACHE_SUBTYPE, cache_kb * 1024);
+    
+    std::vector<Prompt> prompts = makePrompts(prompt_count);
+    size_t total = 0;
+    for (const Prompt& p : prompts) {
+        total += p.pvr.size();
+    }
+    std::vector<double> weights(prompt_count);
+    for (int i = 0; i < prompt_count; i++) {
+        weights[i] = 1.0 / pow(i + 1, zipf);
+    }
+    std::mt19937 rng(seed);
+    std::discrete_distribution<int> pick(weights.begin(), weights.end());
+    std::vector<int> order(request_count);
+    for (int& i : order) {
+        i = pick(rng);
+    }
+    
+    bool all_ok = true;
+    StickerCache::Config config = {ram_kb * 1024, flash_kb * 1024};
+    printf("%d prompts (%zu KB of PVR1, avg %zu B), %d requests, zipf %.2f; "
+           "RAM %zu KB, flash %zu KB of a %zu KB partition\n\n",
+           prompt_count, total / 1024, total / (prompt_count ? prompt_count : 1), request_count,
+           zipf, ram_kb, flash_kb, cache_kb);
+    printf("%-14s %5s %7s %6s %6s %6s %7s %7s %9s %7s\n", "phase", "reqs", "hit", "ram", "flash",
+           "miss", "spills", "evicts", "ramKB", "flashKB");
+    
+    // Cold start, then the same traffic again after a reboot: RAM is
+    // gone, the flash tier is rebuilt from the partition
+    uint32_t flash_before = 0;
+    for (int boot = 0; boot < 2; boot++) {
+        std::unique_ptr<PrintSpool> spool(new PrintSpool());
+        std::unique_ptr<StickerCache> cache;
+        if (!spool->begin("cache")) {
+            fprintf(stderr, "No cache partition\n");
+            return 1;
+        }
+        cache.reset(new StickerCache(spool.get()));
+        cache->begin(config);
+        uint32_t restored = cache->getMetrics().flash_entries;
+        Run run = runRequests(*cache, prompts, order);
+        StickerCache::Metrics m = cache->getMetrics();
+        printMetrics(boot ? "after reboot" : "cold", run, m);
+        bool ok = run.wrong == 0 && run.budgets_held && (boot == 0 || restored == flash_before);
+        if (boot) {
+            printf("%-14s %u stickers restored from flash (%u before the reboot)\n", "",
+                   (unsigned)restored, (unsigned)flash_before);
+        }
+        if (!ok) {
+            printf("%-14s FAILED: %u wrong decodes, budgets %s\n", "", (unsigned)run.wrong,
+                   run.budgets_held ? "held" : "EXCEEDED");
+        }
+        all_ok = all_ok && ok;
+        flash_before = m.flash_entries;
+        // Spool tasks apply the queued done marks before the "power" goes
+        vTaskDelay(pdMS_TO_TICKS(200));
+        cache.reset();
+    }
+    
+    // Module without PSRAM: the RAM tier drops to its internal budget
+    {
+        Sim::heapSetSize(320 * 1024, 0);
+        std::unique_ptr<PrintSpool> spool(new PrintSpool());
+        spool->begin("cache");
+        StickerCache cache(spool.get());
+        cache.begin(config);
+        Run run = runRequests(cache, prompts, order);
+        StickerCache::Metrics m = cache.getMetrics();
+        printMetrics("no PSRAM", run, m);
+        bool ok = run.wrong == 0 && run.budgets_held && !m.psram
+                  && m.ram_budget == StickerCache::INTERNAL_RAM_BUDGET;
+        if (!ok) {
+            printf("%-14s FAILED\n", "");
+        }
+        all_ok = all_ok && ok;
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+    
+    // A reprint in progress pins its sticker: flooding the cache with new
+    // ones must not evict it under the reader
+    {
+        Sim::heapSetSize(320 * 1024, 2 * 1024 * 1024);
+        StickerCache cache(nullptr);
+        cache.begin(config);
+        cache.put(prompts[0].key, prompts[0].pvr.data(), prompts[0].pvr.size());
+        std::optional<StickerCache::Source> reading;
+        reading.emplace(cache);
+        bool opened = reading->open(prompts[0].key);
+        for (int i = 1; i < prompt_count; i++) {
+            cache.put(prompts[i].key, prompts[i].pvr.data(), prompts[i].pvr.size());
+        }
+        bool intact = opened && decodeMatches(*reading, prompts[0].image);
+        bool kept = cache.contains(prompts[0].key);
+        reading.reset();
+        cache.put(prompts[1].key, prompts[1].pvr.data(), prompts[1].pvr.size());
+        for (int i = 2; i < prompt_count; i++) {
+            cache.put(prompts[i].key, prompts[i].pvr.data(), prompts[i].pvr.size());
+        }
+        bool released = !cache.contains(prompts[0].key);
+        bool last = cache.lastKey() == prompts[prompt_count - 1].key;
+        bool ok = intact && kept && released && last;
+        all_ok = all_ok && ok;
+        printf("\nPinned reprint during a flood of %d new stickers: %s, %s once released, "
+               "last key %s -> %s\n", prompt_count - 1, intact && kept ? "intact" : "LOST",
+               released ? "evicted" : "still held", last ? "ok" : "WRONG", ok ? "ok" : "FAILED");
+    }
+    
+    // Same prompt, different spelling: one cache entry
+    bool same = StickerCache::key("  A happy CAT\n") == StickerCache::key("a happy   cat");
+    bool differ = StickerCache::key("a happy cat") != StickerCache::key("a happy bat");
+    printf("Key normalization (case, whitespace) -> %s\n", same && differ ? "ok" : "FAILED");
+    all_ok = all_ok && same && differ;
+    
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,475 @@
+/*
+ * caption_bench.cpp
+ * Captions: UTF-8 decoding, CaptionRenderer against a plain per-dot blit
+ * of the FontAtlas, and a captioned sticker printed as one raster job
+ *
+ * Usage:
+ *   caption_bench [options]
+ *     --baud N          UART and printer baud rate (115200)
+ *     --rows N          Sticker height for the printing run (240)
+ *     --scale S         Simulated time runs S times faster than real (10)
+ *     --verbose         Keep driver INFO logs
+ *
+ * First the decoder on well-formed, truncated, overlong and surrogate
+ * sequences, and JsonRasterParser's caption field fed in pieces of every
+ * size (escapes, surrogate pairs, a caption too long for its buffer).
+ *
+ * Then Spanish captions laid out and drawn at two widths: every row must
+ * match a reference that wraps the words greedily and sets each glyph's
+ * dots one by one from the atlas. Reported per caption: lines, rows,
+ * glyphs replaced or dropped, and glyphs unpacked from flash by a fresh
+ * renderer; then the renderer's cost per row on the host, against the
+ * reference, and its cache's hit rate over repeated captions.
+ *
+ * Last, a sticker downloads into StickerPipeline and closes with a
+ * caption. The printer model must receive the sticker's rows followed by
+ * the reference caption, all as raster (no text lines), with the gap
+ * above the caption fed rather than sent. Its time is compared with the
+ * same sticker without a caption.
+ */
+
+#include "CaptionRenderer.hpp"
+#include "FontAtlas.hpp"
+#include "JsonRasterParser.hpp"
+#include "PrintQueue.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "StickerPipeline.hpp"
+#include "ThermalPrinter.hpp"
+#include "bench_raster.hpp"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr size_t NET_CHUNK = 1460;
+
+static const char* const CAPTIONS[] = {
+    "¡Hola, señor pingüino!",
+    "¿Dónde está el ñandú? Él come piñas y azúcar morena.",
+    "Un gato astronauta flotando entre estrellas de colores, con un casco redondo y una "
+    "bandera que dice PegaVox sobre la luna llena de agosto",
+    "Línea uno\nLínea dos",
+    "€ 5 · 20°C «hola» — “sí” …",
+    "caf\xC3 \xE2\x82 ok \xF0\x9F\x98\x80 \xC0\xAF fin",
+};
+
+// ----- Decoding -----
+
+static std::vector<uint32_t> decodeAll(const char* text)
+{
+    std::vector<uint32_t> cps;
+    uint32_t cp;
+    while ((cp = CaptionRenderer::nextCodepoint(text)) != 0) {
+        cps.push_back(cp);
+    }
+    return cps;
+}
+
+static bool decoderCases()
+{
+    static const struct {
+        const char* name;
+        const char* text;
+        std::vector<uint32_t> expected;
+    } CASES[] = {
+        {"ascii", "Ab 1", {'A', 'b', ' ', '1'}},
+        {"two-byte", "ñÁ", {0xF1, 0xC1}},
+        {"three-byte", "€…", {0x20AC, 0x2026}},
+        {"four-byte", "\xF0\x9F\x98\x80", {0x1F600}},
+        {"truncated", "\xC3" "a", {0xFFFD, 'a'}},
+        {"cut at the end", "a\xE2\x82", {'a', 0xFFFD, 0xFFFD}},
+        {"stray continuation", "\x80" "b", {0xFFFD, 'b'}},
+        {"overlong", "\xC0\xAF", {0xFFFD, 0xFFFD}},
+        {"surrogate", "\xED\xA0\x80", {0xFFFD, 0xFFFD, 0xFFFD}},
+        {"past U+10FFFF", "\xF4\x90\x80\x80", {0xFFFD, 0xFFFD, 0xFFFD, 0xFFFD}},
+    };
+    bool ok = true;
+    for (const auto& c : CASES) {
+        bool match = decodeAll(c.text) == c.expected;
+        if (!match) {
+            printf("  decode %-20s MISMATCH\n", c.name);
+        }
+        ok = ok && match;
+    }
+    printf("%-34s %s\n", "UTF-8 decoder", ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+// The caption field of `doc` fed `piece` bytes at a time
+static std::string parseCaption(const std::string& doc, size_t piece, bool& well_formed)
+{
+    JsonRasterParser parser;
+    parser.begin([](const uint8_t*, size_t) { return true; });
+    for (size_t pos = 0; pos < doc.size(); pos += piece) {
+        parser.feed(doc.data() + pos, std::min(piece, doc.size() - pos));
+    }
+    well_formed = parser.finish();
+    return parser.caption();
+}
+
+static bool parserCases()
+{
+    std::string long_caption;
+    while (long_caption.size() < 126) {
+        long_caption += "a";
+    }
+    static const struct {
+        const char* name;
+        std::string doc;
+        std::string expected;
+    } CASES[] = {
+        {"plain UTF-8", "{\"status\": \"done\", \"caption\": \"¡Olé!\", \"raster_data\": \"\"}", "¡Olé!"},
+        {"escapes", "{\"caption\": \"\\u00bfQu\\u00E9 tal?\\n\\\"s\\u00ed\\\"\"}", "¿Qué tal?\n\"sí\""},
+        {"surrogate pair", "{\"caption\": \"ok \\ud83d\\ude00\"}", "ok \xF0\x9F\x98\x80"},
+        {"lone surrogate", "{\"caption\": \"a\\ud83db\"}", "a\xEF\xBF\xBD" "b"},
+        {"cut on a character", "{\"caption\": \"" + long_caption + "\\u00f1\\u00f1\"}", long_caption},
+        {"nested, no caption", "{\"meta\": {\"caption\": \"no\"}, \"status\": \"done\"}", ""},
+    };
+    bool ok = true;
+    for (const auto& c : CASES) {
+        for (size_t piece = 1; piece <= c.doc.size(); piece++) {
+            bool well_formed = false;
+            std::string caption = parseCaption(c.doc, piece, well_formed);
+            if (!well_formed || caption != c.expected) {
+                printf("  parse %-21s MISMATCH in %u-byte pieces: \"%s\"\n", c.name, (unsigned)piece,
+                       caption.c_str());
+                ok = false;
+                break;
+            }
+        }
+    }
+    printf("%-34s %s\n", "JSON caption field, all splits", ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+// ----- Reference drawing -----
+
+// Greedy word wrap by whole words, each dot set from the atlas
+static std::vector<uint8_t> referenceCaption(const char* text, uint16_t width_bytes)
+{
+    int replacement = FontAtlas::find(FontAtlas::REPLACEMENT);
+    std::vector<std::vector<std::vector<int>>> paragraphs(1);
+    std::vector<int> word;
+    auto endWord = [&]() {
+        if (!word.empty()) {
+            paragraphs.back().push_back(word);
+            word.clear();
+        }
+    };
+    for (uint32_t cp : decodeAll(text)) {
+        if (cp == '\n') {
+            endWord();
+            paragraphs.emplace_back();
+        } else if (cp == ' ') {
+            endWord();
+        } else {
+            int index = FontAtlas::find(cp);
+            word.push_back(index < 0 ? replacement : index);
+        }
+    }
+    endWord();
+    
+    int space = FontAtlas::find(' ');
+    auto advance = [](int index) { return (int)FontAtlas::GLYPHS[index].advance; };
+    int width = width_bytes * 8;
+    int avail = width - 2 * CaptionRenderer::MARGIN_DOTS;
+    std::vector<std::vector<int>> lines;
+    for (const auto& words : paragraphs) {
+        std::vector<int> line;
+        int used = 0;
+        for (const auto& w : words) {
+            int w_width = 0;
+            for (int g : w) {
+                w_width += advance(g);
+            }
+            int needed = line.empty() ? w_width : used + advance(space) + w_width;
+            if (!line.empty() && needed > avail) {
+                lines.push_back(line);
+                line.clear();
+                needed = w_width;
+            }
+            if (!line.empty()) {
+                line.push_back(space);
+            }
+            line.insert(line.end(), w.begin(), w.end());
+            used = needed;
+        }
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+    if (lines.size() > CaptionRenderer::MAX_LINES) {
+        lines.resize(CaptionRenderer::MAX_LINES);
+    }
+    if (lines.empty()) {
+        return {};
+    }
+    
+    int pitch = FontAtlas::HEIGHT + CaptionRenderer::LINE_GAP;
+    int height = CaptionRenderer::GAP_ROWS + (int)lines.size() * pitch - CaptionRenderer::LINE_GAP;
+    std::vector<uint8_t> rows((size_t)height * width_bytes, 0);
+    for (size_t l = 0; l < lines.size(); l++) {
+        int line_width = 0;
+        for (int g : lines[l]) {
+            line_width += advance(g);
+        }
+        int x = (width - line_width) / 2;
+        int y0 = CaptionRenderer::GAP_ROWS + (int)l * pitch;
+        for (int g : lines[l]) {
+            const FontAtlas::Glyph& glyph = FontAtlas::GLYPHS[g];
+            for (int r = 0; r < glyph.rows; r++) {
+                for (int c = 0; c < glyph.width; c++) {
+                    const uint8_t* bits = FontAtlas::BITS + glyph.offset + r * glyph.stride();
+                    int dx = x + glyph.left + c;
+                    if ((bits[c / 8] & (0x80 >> (c % 8))) && dx >= 0 && dx < width) {
+                        rows[(size_t)(y0 + glyph.top + r) * width_bytes + dx / 8] |= 0x80 >> (dx % 8);
+                    }
+                }
+            }
+            x += glyph.advance;
+        }
+    }
+    return rows;
+}
+
+static std::vector<uint8_t> drawCaption(CaptionRenderer& renderer, const char* text, uint16_t width_bytes)
+{
+    uint16_t height = renderer.begin(text, width_bytes);
+    std::vector<uint8_t> rows((size_t)height * width_bytes);
+    for (uint16_t y = 0; y < height; y++) {
+        renderer.readRow(&rows[(size_t)y * width_bytes]);
+    }
+    uint8_t extra[RasterDecoder::MAX_WIDTH_BYTES];
+    if (renderer.readRow(extra)) {
+        rows.clear();       // More rows than height()
+    }
+    return rows;
+}
+
+static bool renderCases()
+{
+    printf("\n%-6s %-34s %5s %5s %8s %7s %8s %s\n", "width", "caption", "lines", "rows", "replaced",
+           "dropped", "unpacked", "rows");
+    bool ok = true;
+    for (uint16_t width_bytes : {WIDTH_BYTES, (uint16_t)32}) {
+        for (const char* text : CAPTIONS) {
+            CaptionRenderer renderer;
+            std::vector<uint8_t> rows = drawCaption(renderer, text, width_bytes);
+            bool match = rows == referenceCaption(text, width_bytes) && !rows.empty();
+            CaptionRenderer::Stats stats = renderer.getStats();
+            
+            // Printable name: the first line, cut short
+            std::string name(text, strcspn(text, "\n"));
+            std::vector<uint32_t> cps = decodeAll(name.c_str());
+            if (cps.size() > 30) {
+                const char* p = name.c_str();
+                for (int i = 0; i < 29; i++) {
+                    CaptionRenderer::nextCodepoint(p);
+                }
+                name.resize(p - name.c_str());
+                name += "…";
+            }
+            // Pad by characters, not bytes
+            size_t chars = std::min(decodeAll(name.c_str()).size(), (size_t)34);
+            name.append(34 - chars, ' ');
+            printf("%-6u %s %5u %5u %8u %7u %8u %s\n", (unsigned)(width_bytes * 8), name.c_str(),
+                   (unsigned)renderer.lines(), (unsigned)renderer.height(), (unsigned)stats.replaced,
+                   (unsigned)stats.dropped, (unsigned)stats.misses, match ? "ok" : "MISMATCH");
+            ok = ok && match;
+        }
+    }
+    
+    CaptionRenderer renderer;
+    bool empty = renderer.begin("", WIDTH_BYTES) == 0 && renderer.begin("  \n ", WIDTH_BYTES) == 0 &&
+                 renderer.begin(nullptr, WIDTH_BYTES) == 0;
+    printf("%-34s %s\n", "empty captions draw nothing", empty ? "ok" : "DREW ROWS");
+    return ok && empty;
+}
+
+static void renderCost()
+{
+    const char* text = CAPTIONS[1];
+    CaptionRenderer renderer;
+    uint8_t row[WIDTH_BYTES];
+    uint32_t sink = 0;
+    int passes = 2000;
+    uint32_t rows = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        renderer.begin(text, WIDTH_BYTES);
+        while (renderer.readRow(row)) {
+            sink += row[pass % WIDTH_BYTES];
+            rows++;
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / rows;
+    
+    int ref_passes = passes / 10;
+    auto t1 = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < ref_passes; pass++) {
+        sink += referenceCaption(text, WIDTH_BYTES)[pass];
+    }
+    double ref_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t1).count()
+                    / ((double)ref_passes * rows / passes);
+    CaptionRenderer::Stats stats = renderer.getStats();
+    printf("(unpacked: glyphs a fresh renderer took from flash, once each)\n");
+    printf("render cost on the host: %.0f ns per row (reference %.0f ns), warm cache %.2f%% hits (%u)\n\n",
+           ns, ref_ns, 100.0 * stats.hits / ((double)stats.hits + stats.misses), (unsigned)(sink & 1));
+}
+
+// ----- Printing -----
+
+struct Device {
+    std::unique_ptr<SimPrinter> model;
+    std::unique_ptr<ThermalPrinter> printer;
+    std::unique_ptr<PrintQueue> queue;
+    std::unique_ptr<StickerPipeline> pipeline;
+    SemaphoreHandle_t done;
+    std::atomic<bool> ok;
+    
+    Device()
+        : done(xSemaphoreCreateBinary())
+        , ok(false)
+    {
+    }
+    
+    ~Device()
+    {
+        pipeline.reset();
+        queue.reset();
+        printer.reset();
+        model.reset();
+        vSemaphoreDelete(done);
+    }
+};
+
+static bool boot(Device& dev, uint32_t baud)
+{
+    dev.model.reset(new SimPrinter(UART_NUM_1, baud));
+    dev.model->attach();
+    dev.printer.reset(new ThermalPrinter(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18, (int)baud));
+    dev.queue.reset(new PrintQueue(*dev.printer, 4));
+    dev.pipeline.reset(new StickerPipeline(*dev.queue));
+    Device* d = &dev;
+    dev.pipeline->setCallback([d](uint32_t, bool ok) {
+        d->ok = ok;
+        xSemaphoreGive(d->done);
+    });
+    if (!dev.printer->begin() || !dev.queue->begin() || !dev.pipeline->begin()) {
+        return false;
+    }
+    dev.printer->waitTxDone();
+    Sim::sleepUntil(dev.model->getStats().busy_until_us);
+    Sim::uartClearTx(UART_NUM_1);
+    return true;
+}
+
+struct Run {
+    bool ok;
+    bool intact;
+    double total_ms;
+    SimPrinter::Stats stats;
+};
+
+static Run printSticker(uint32_t baud, const std::vector<uint8_t>& pvr, const std::vector<uint8_t>& expected,
+                        const char* caption)
+{
+    Run run = {};
+    Device dev;
+    if (!boot(dev, baud)) {
+        return run;
+    }
+    int64_t start_us = Sim::now();
+    bool written = dev.pipeline->open(portMAX_DELAY);
+    for (size_t pos = 0; written && pos < pvr.size(); pos += NET_CHUNK) {
+        written = dev.pipeline->write(pvr.data() + pos, std::min(NET_CHUNK, pvr.size() - pos), portMAX_DELAY);
+    }
+    dev.pipeline->close(written, caption);
+    run.ok = written && xSemaphoreTake(dev.done, pdMS_TO_TICKS(60000)) == pdTRUE && dev.ok;
+    dev.printer->waitTxDone();
+    run.stats = dev.model->getStats();
+    run.total_ms = (run.stats.busy_until_us - start_us) / 1000.0;
+    run.intact = dev.model->raster() == expected;
+    Sim::sleepUntil(run.stats.busy_until_us);
+    return run;
+}
+
+static bool printing(uint32_t baud, uint16_t height)
+{
+    std::vector<uint8_t> image = noisyImage(height);
+    std::vector<uint8_t> pvr = encodePvr(image, height);
+    const char* caption = CAPTIONS[1];
+    std::vector<uint8_t> captioned = image;
+    std::vector<uint8_t> caption_rows = referenceCaption(caption, WIDTH_BYTES);
+    captioned.insert(captioned.end(), caption_rows.begin(), caption_rows.end());
+    
+    Run plain = printSticker(baud, pvr, image, nullptr);
+    Run with = printSticker(baud, pvr, captioned, caption);
+    
+    printf("%-14s %6s %6s %6s %9s %9s %s\n", "sticker", "rows", "bands", "text", "fed dots", "total ms",
+           "raster");
+    printf("%-14s %6u %6u %6u %9u %9.1f %s\n", "no caption", (unsigned)plain.stats.raster_rows,
+           (unsigned)plain.stats.bands, (unsigned)plain.stats.text_lines, (unsigned)plain.stats.feed_dots,
+           plain.total_ms, plain.ok && plain.intact ? "ok" : "MISMATCH");
+    printf("%-14s %6u %6u %6u %9u %9.1f %s\n", "with caption", (unsigned)with.stats.raster_rows,
+           (unsigned)with.stats.bands, (unsigned)with.stats.text_lines, (unsigned)with.stats.feed_dots,
+           with.total_ms, with.ok && with.intact ? "ok" : "MISMATCH");
+    printf("caption: %u rows for %+.1f ms\n", (unsigned)(caption_rows.size() / WIDTH_BYTES),
+           with.total_ms - plain.total_ms);
+    
+    // The gap between sticker and caption goes out as a feed
+    bool fed = with.stats.feed_dots >= plain.stats.feed_dots + CaptionRenderer::GAP_ROWS;
+    bool ok = plain.ok && plain.intact && with.ok && with.intact && with.stats.text_lines == 0 && fed;
+    if (!fed) {
+        printf("caption gap was SENT, not fed\n");
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = 115200;
+    uint16_t height = 240;
+    double scale = 10;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--baud" && has_value) {
+            baud = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--rows" && has_value) {
+            height = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--scale" && has_value) {
+            scale = atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--baud N] [--rows N] [--scale S] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_ERROR);
+    }
+    Sim::setTimeScale(scale);
+    
+    printf("Font atlas: %u glyphs, %u-dot cell; renderer %u bytes, cache %u glyphs\n",
+           (unsigned)FontAtlas::GLYPH_COUNT, (unsigned)FontAtlas::HEIGHT, (unsigned)sizeof(CaptionRenderer),
+           (unsigned)CaptionRenderer::CACHE_SLOTS);
+    bool ok = decoderCases();
+    ok = parserCases() && ok;
+    ok = renderCases() && ok;
+    renderCost();
+    ok = printing(baud, height) && ok;
+    printf("%s\n", ok ? "Captions print as drawn, in the sticker's raster" : "CAPTION PROBLEMS");
+    return ok ? 0 : 1;
+}
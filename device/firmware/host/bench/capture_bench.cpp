@@ -0,0 +1,289 @@
+/*
+ * capture_bench.cpp
+ * Microphone capture while the upload stalls: does any audio get lost?
+ *
+ * Usage:
+ *   capture_bench [options]
+ *     --seconds S       Length of each recording (4)
+ *     --stalls A,B,...  Upload stalls in ms, one run each (0,500,1500,3000)
+ *     --encoder NAME    pcm, adpcm or flac (pcm)
+ *     --scale S         Simulated time per wall-clock time (4)
+ *     --verbose         Keep driver INFO logs
+ *
+ * AudioCapture reads the simulated INMP441 (I2S DMA at 16 kHz, a voice-like
+ * signal with short pauses) into its ring, and AudioUploader streams the
+ * trimmed recording as it is made to POST /api/v1/audio on a small HTTP
+ * server in this process. One second into each recording the upload's
+ * writes stall (Sim::httpStallWrites) for the run's time, as a Wi-Fi link
+ * that stops moving: the upload task blocks, and the reader task must
+ * keep draining the DMA into the ring.
+ *
+ * Reported per run: AudioCapture's dropped samples and ring high-water
+ * mark, frames the I2S DMA lost, the body the server received and the
+ * time from stop() to the job id. A stall the ring covers (2 s at 16 kHz)
+ * must lose nothing; a longer one drops the samples that no longer fit,
+ * counted, and the upload must still complete.
+ */
+
+#include "AudioCapture.hpp"
+#include "AudioEncoder.hpp"
+#include "AudioUploader.hpp"
+#include "Sim.hpp"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static constexpr uint32_t SAMPLE_RATE = 16000;
+static constexpr size_t RING_SAMPLES = 32768;
+static constexpr int64_t STALL_AT_US = 1000000;
+
+// Voice-like: a 200 Hz buzz with harmonics in 250 ms syllables, 100 ms
+// pauses, over a -60 dBFS hiss. INMP441 slots: 24 bits, left-justified.
+static int32_t microphone(uint64_t frame)
+{
+    double t = (double)frame / SAMPLE_RATE;
+    double syllable = fmod(t, 0.35);
+    double envelope = syllable < 0.25 ? sin(M_PI * syllable / 0.25) : 0;
+    double voice = 0;
+    for (int k = 1; k <= 4; k++) {
+        voice += sin(2 * M_PI * 200 * k * t) / k;
+    }
+    uint32_t h = (uint32_t)frame * 2654435761u;
+    double hiss = ((double)(h >> 16) / 65536 - 0.5) * 0.002;
+    double x = 0.15 * envelope * voice + hiss;
+    int32_t sample24 = (int32_t)(x * 8388607);
+    return sample24 * 256;
+}
+
+// POST /api/v1/audio only: reads the chunked body, answers 202 with a job id
+class UploadServer {
+public:
+    bool start()
+    {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (fd_ < 0 || bind(fd_, (sockaddr*)&addr, len) != 0 || listen(fd_, 4) != 0
+            || getsockname(fd_, (sockaddr*)&addr, &len) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        std::thread([this] { serve(); }).detach();
+        return true;
+    }
+    
+    int port() const { return port_; }
+    size_t lastBody() const { return last_body_.load(); }
+    
+private:
+    int fd_ = -1;
+    int port_ = 0;
+    std::atomic<size_t> last_body_{0};
+    int jobs_ = 0;
+    
+    // Buffered reads off one connection
+    struct Reader {
+        int fd;
+        char buf[4096];
+        size_t pos = 0;
+        size_t len = 0;
+        
+        bool byte(char* c)
+        {
+            if (pos == len) {
+                ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) {
+                    return false;
+                }
+                pos = 0;
+                len = (size_t)n;
+            }
+            *c = buf[pos++];
+            return true;
+        }
+        
+        bool line(std::string& out)
+        {
+            out.clear();
+            char c;
+            while (byte(&c)) {
+                if (c == '\n') {
+                    if (!out.empty() && out.back() == '\r') {
+                        out.pop_back();
+                    }
+                    return true;
+                }
+                out += c;
+            }
+            return false;
+        }
+    };
+    
+    void serve()
+    {
+        int conn;
+        while ((conn = accept(fd_, nullptr, nullptr)) >= 0) {
+            Reader in;
+            in.fd = conn;
+            std::string line;
+            while (in.line(line) && !line.empty()) {
+            }
+            // <hex length>\r\n<data>\r\n ... 0\r\n\r\n
+            size_t body = 0;
+            bool ok = false;
+            while (in.line(line)) {
+                size_t n = strtoul(line.c_str(), nullptr, 16);
+                char c;
+                for (size_t i = 0; i < n + 2 && in.byte(&c); i++) {
+                }
+                if (n == 0) {
+                    ok = true;
+                    break;
+                }
+                body += n;
+            }
+            last_body_ = body;
+            char reply[160];
+            char json[48];
+            int json_len = snprintf(json, sizeof(json), "{\"job_id\": \"capture-%d\"}", ++jobs_);
+            int len = snprintf(reply, sizeof(reply),
+                               "HTTP/1.1 %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n"
+                               "Connection: close\r\n\r\n%s", ok ? "202 Accepted" : "400 Bad Request",
+                               json_len, json);
+            send(conn, reply, len, MSG_NOSIGNAL);
+            close(conn);
+        }
+    }
+};
+
+struct Run {
+    uint32_t dropped;
+    size_t high_water;
+    uint64_t dma_lost;
+    size_t body;
+    double finish_ms;           // stop() to the job id
+    bool uploaded;
+};
+
+int main(int argc, char** argv)
+{
+    double seconds = 4;
+    std::vector<int> stalls = {0, 500, 1500, 3000};
+    std::string encoder_name = "pcm";
+    double scale = 4;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--seconds" && has_value) {
+            seconds = atof(argv[++i]);
+        } else if (arg == "--stalls" && has_value) {
+            stalls.clear();
+            for (const char* p = argv[++i]; *p; p++) {
+                stalls.push_back(atoi(p));
+                while (p[1] && *p != ',') {
+                    p++;
+                }
+            }
+        } else if (arg == "--encoder" && has_value) {
+            encoder_name = argv[++i];
+        } else if (arg == "--scale" && has_value) {
+            scale = atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--seconds S] [--stalls A,B,...] [--encoder pcm|adpcm|flac] "
+                    "[--scale S] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_NONE);
+    }
+    Sim::setTimeScale(scale);
+    
+    UploadServer server;
+    if (!server.start()) {
+        fprintf(stderr, "Can't listen on 127.0.0.1\n");
+        return 1;
+    }
+    char base_url[48];
+    snprintf(base_url, sizeof(base_url), "http://127.0.0.1:%d", server.port());
+    
+    Sim::i2sSetSource(I2S_NUM_0, microphone);
+    AudioCapture capture(GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6, SAMPLE_RATE, RING_SAMPLES);
+    AudioUploader uploader(capture, base_url, "bench-token");
+    ImaAdpcmEncoder adpcm;
+    FlacEncoder flac;
+    uploader.setEncoder(encoder_name == "adpcm" ? (AudioEncoder*)&adpcm
+                        : encoder_name == "flac" ? (AudioEncoder*)&flac : nullptr);
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    std::atomic<bool> uploaded(false);
+    uploader.setCallback([&](bool ok, const char*) {
+        uploaded = ok;
+        xSemaphoreGive(done);
+    });
+    if (!capture.begin() || !uploader.begin()) {
+        fprintf(stderr, "Capture or uploader failed to start\n");
+        return 1;
+    }
+    
+    double ring_ms = RING_SAMPLES * 1000.0 / SAMPLE_RATE;
+    printf("%.1f s recordings, %s body, ring %.0f ms, stall from %.1f s\n", seconds, encoder_name.c_str(),
+           ring_ms, STALL_AT_US / 1e6);
+    printf("%8s %8s %10s %9s %9s %10s %s\n", "stall ms", "dropped", "ring peak", "DMA lost", "body B",
+           "finish ms", "upload");
+    bool all_ok = true;
+    for (int stall_ms : stalls) {
+        Run run = {};
+        uint64_t dma_before = Sim::i2sOverflowedFrames(I2S_NUM_0);
+        Sim::httpStallWrites(0);
+        int64_t t0 = Sim::now();
+        if (!capture.start() || !uploader.startUpload()) {
+            fprintf(stderr, "Recording failed to start\n");
+            return 1;
+        }
+        if (stall_ms > 0) {
+            Sim::sleepUntil(t0 + STALL_AT_US);
+            Sim::httpStallWrites(Sim::now() + (int64_t)stall_ms * 1000);
+        }
+        Sim::sleepUntil(t0 + (int64_t)(seconds * 1e6));
+        capture.stop();
+        int64_t stopped = Sim::now();
+        
+        // The stall may outlast the recording: the upload catches up after it
+        bool finished = xSemaphoreTake(done, pdMS_TO_TICKS(30000)) == pdTRUE;
+        run.finish_ms = (Sim::now() - stopped) / 1000.0;
+        run.uploaded = finished && uploaded;
+        run.dropped = capture.getDroppedSamples();
+        run.high_water = capture.getRingHighWater();
+        run.dma_lost = Sim::i2sOverflowedFrames(I2S_NUM_0) - dma_before;
+        run.body = server.lastBody();
+        
+        // Losing samples is only allowed once the ring itself overflows
+        bool covered = stall_ms < ring_ms - 100;
+        bool ok = run.uploaded && run.dma_lost == 0 && (!covered || run.dropped == 0);
+        all_ok = all_ok && ok;
+        printf("%8d %8u %10zu %9llu %9zu %10.0f %s\n", stall_ms, (unsigned)run.dropped, run.high_water,
+               (unsigned long long)run.dma_lost, run.body, run.finish_ms,
+               !run.uploaded ? "FAILED" : !ok ? "LOST AUDIO" : run.dropped ? "ok, drops counted" : "ok");
+    }
+    
+    printf("\n%s\n", all_ok ? "No audio lost while the ring covered the stall, uploads complete"
+                            : "CAPTURE PROBLEMS");
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/*
+ * link_bench.cpp
+ * Boot-time printer link detection: the auto-baud probe and the settings
+ * it saves in NVS
+ *
+ * Usage:
+ *   link_bench [--scale S]
+ *     --scale S         Simulated time runs S times faster than real (1)
+ *
+ * For printers set to each rate in ThermalPrinter::BAUDS, with normal
+ * and inverted lines, it boots the driver with AUTO_BAUD on an erased
+ * NVS, then again as after a reboot. Each boot reports the settings it
+ * ended up on, how long begin() took, whether a test line reached the
+ * printer and how long a 96-row raster takes to print at that rate.
+ * Then it covers a printer that changed rate since the last boot, a
+ * printer that doesn't answer, and a board without the printer TX wired.
+ */
+
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "ThermalPrinter.hpp"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr uint16_t WIDTH_BYTES = 48;
+static constexpr uint16_t RASTER_ROWS = 96;
+
+struct Boot {
+    int baud;
+    bool inverted;
+    bool status;
+    double begin_ms;
+    bool printed;
+    double raster_ms;
+};
+
+// Power up the board: fresh driver, UART registers back to normal polarity
+static Boot boot(SimPrinter& model, int rx_pin)
+{
+    Boot result = {};
+    uart_set_line_inverse(UART_NUM_1, 0);
+    std::unique_ptr<ThermalPrinter> printer(new ThermalPrinter(UART_NUM_1, GPIO_NUM_17, rx_pin,
+                                                               ThermalPrinter::AUTO_BAUD));
+    int64_t start_us = Sim::now();
+    if (!printer->begin()) {
+        return result;
+    }
+    result.begin_ms = (Sim::now() - start_us) / 1000.0;
+    result.baud = printer->getBaudRate();
+    result.inverted = printer->isInverted();
+    result.status = printer->hasStatus();
+    
+    size_t lines = model.textLines().size();
+    printer->printLine("link ok");
+    printer->waitTxDone();
+    std::vector<std::string> text = model.textLines();
+    result.printed = text.size() > lines && text.back() == "link ok";
+    
+    // A dithered band pattern, so the time includes real head work
+    std::vector<uint8_t> rows((size_t)RASTER_ROWS * WIDTH_BYTES);
+    for (size_t i = 0; i < rows.size(); i++) {
+        rows[i] = (i / WIDTH_BYTES) % 2 ? 0xAA : 0x55;
+    }
+    Sim::sleepUntil(model.getStats().busy_until_us);
+    start_us = Sim::now();
+    BitmapSource source(rows.data(), WIDTH_BYTES, RASTER_ROWS);
+    printer->printRaster(source, WIDTH_BYTES);
+    printer->waitTxDone();
+    if (result.printed) {
+        result.raster_ms = (model.getStats().busy_until_us - start_us) / 1000.0;
+    }
+    Sim::sleepUntil(model.getStats().busy_until_us);
+    return result;
+}
+
+static bool report(const char* label, const Boot& b, int want_baud, bool want_inverted, bool want_printed)
+{
+    bool ok = b.baud == want_baud && b.inverted == want_inverted && b.printed == want_printed;
+    char raster[16] = "-";
+    if (b.printed) {
+        snprintf(raster, sizeof(raster), "%.1f", b.raster_ms);
+    }
+    printf("%-26s %7d %-8s %-6s %9.1f %-7s %9s %s\n", label, b.baud, b.inverted ? "inverted" : "normal",
+           b.status ? "yes" : "no", b.begin_ms, b.printed ? "yes" : "no", raster, ok ? "ok" : "WRONG");
+    return ok;
+}
+
+static std::unique_ptr<SimPrinter> printerAt(uint32_t baud, uint32_t inverse)
+{
+    std::unique_ptr<SimPrinter> model(new SimPrinter(UART_NUM_1, baud));
+    model->setInverse(inverse);
+    model->attach();
+    return model;
+}
+
+int main(int argc, char** argv)
+{
+    double scale = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--scale" && i + 1 < argc) {
+            scale = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--scale S]\n", argv[0]);
+            return 1;
+        }
+    }
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    Sim::setTimeScale(scale);
+    nvs_flash_init();
+    
+    printf("%-26s %7s %-8s %-6s %9s %-7s %9s\n", "boot", "baud", "polarity", "status", "begin ms",
+           "printed", "raster ms");
+    bool ok = true;
+    char label[64];
+    
+    // First boot probes; the next one reuses the saved settings
+    for (uint32_t baud : ThermalPrinter::BAUDS) {
+        for (uint32_t inverse : {0u, (uint32_t)ThermalPrinter::INVERTED}) {
+            nvs_flash_erase();
+            std::unique_ptr<SimPrinter> model = printerAt(baud, inverse);
+            snprintf(label, sizeof(label), "%u%s first boot", (unsigned)baud, inverse ? " inv" : "");
+            ok = report(label, boot(*model, GPIO_NUM_18), (int)baud, inverse != 0, true) && ok;
+            snprintf(label, sizeof(label), "%u%s reboot", (unsigned)baud, inverse ? " inv" : "");
+            ok = report(label, boot(*model, GPIO_NUM_18), (int)baud, inverse != 0, true) && ok;
+        }
+    }
+    
+    // Saved 115200, but the printer was swapped for a 9600 one
+    nvs_flash_erase();
+    {
+        std::unique_ptr<SimPrinter> model = printerAt(115200, 0);
+        boot(*model, GPIO_NUM_18);
+    }
+    {
+        std::unique_ptr<SimPrinter> model = printerAt(9600, 0);
+        ok = report("printer changed to 9600", boot(*model, GPIO_NUM_18), 9600, false, true) && ok;
+    }
+    
+    // Printer off: nothing is probed successfully or saved; the saved
+    // settings (9600 from the last boot) still apply
+    {
+        std::unique_ptr<SimPrinter> model = printerAt(9600, 0);
+        model->setStatusReplies(false);
+        ok = report("no reply, saved 9600", boot(*model, GPIO_NUM_18), 9600, false, true) && ok;
+    }
+    nvs_flash_erase();
+    {
+        std::unique_ptr<SimPrinter> model = printerAt(57600, 0);
+        model->setStatusReplies(false);
+        ok = report("no reply, nothing saved", boot(*model, GPIO_NUM_18), ThermalPrinter::FALLBACK_BAUD,
+                    false, false) && ok;
+    }
+    
+    // Printer TX not wired: no probe possible, so the fallback rate
+    {
+        std::unique_ptr<SimPrinter> model = printerAt(9600, 0);
+        ok = report("no RX pin", boot(*model, -1), ThermalPrinter::FALLBACK_BAUD, false, true) && ok;
+    }
+    
+    printf("%s\n", ok ? "All boots found the printer as expected" : "SOME BOOTS WENT WRONG");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,473 @@
+/*
+ * memory_bench.cpp
+ * Heap traffic per job with and without the per-job arenas, and the
+ * boot-time memory budget report
+ *
+ * Usage:
+ *   memory_bench [options]
+ *     --jobs N          Jobs per case (50)
+ *     --seconds S       Recording length per audio job (4)
+ *     --verbose         Keep driver INFO logs
+ *
+ * Every operator new is counted. An audio job runs a recording through
+ * SilenceTrimmer and FlacEncoder as AudioUploader does; a raster job
+ * runs a 512x512 grayscale image through RasterPipeline (LANCZOS to 384
+ * dots, pixelated). Each is run with its buffers on the heap and from an
+ * Arena that is reset after the job; the output must be identical and
+ * the arena runs must not touch the heap after the first job. Then the
+ * print path boots with static tasks and queues, and jobs go through it
+ * as main.cpp builds them: a test print, and a new sticker put in the
+ * cache and reprinted from it, its source in the job's arena. Building
+ * and submitting them must not touch the heap either (counted on the
+ * building task only: the simulated UART and printer record every byte
+ * the printer task sends on the host heap). Last, MemoryBudget prints its report (the
+ * simulation's own threads and queues do use the host heap).
+ */
+
+#include "Arena.hpp"
+#include "AudioEncoder.hpp"
+#include "AudioFrontEnd.hpp"
+#include "MemoryBudget.hpp"
+#include "PrintJob.hpp"
+#include "PrintQueue.hpp"
+#include "RasterPipeline.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "StickerCache.hpp"
+#include "StickerPipeline.hpp"
+#include "ThermalPrinter.hpp"
+#include "bench_raster.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// ===== Counting allocator =====
+
+static std::atomic<uint64_t> heap_allocs(0);
+static std::atomic<uint64_t> heap_bytes(0);
+static thread_local uint64_t thread_allocs = 0;     // This thread's share of heap_allocs
+
+void* operator new(size_t size)
+{
+    heap_allocs++;
+    thread_allocs++;
+    heap_bytes += size;
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    heap_allocs++;
+    thread_allocs++;
+    heap_bytes += size;
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+// Every operator new above is malloc underneath; GCC sees only the new
+// expression when it inlines one into a caller
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+#pragma GCC diagnostic pop
+
+// Heap calls and bytes from here on
+struct HeapCounter {
+    uint64_t allocs;
+    uint64_t bytes;
+    
+    HeapCounter()
+        : allocs(heap_allocs)
+        , bytes(heap_bytes)
+    {
+    }
+    
+    uint64_t allocsSince() const { return heap_allocs - allocs; }
+    uint64_t bytesSince() const { return heap_bytes - bytes; }
+};
+
+// ===== Jobs =====
+
+// Two utterances with a long pause between them, over a noise floor
+static std::vector<int16_t> recording(uint32_t rate, float seconds)
+{
+    uint32_t seed = 12345;
+    std::vector<int16_t> pcm((size_t)(rate * seconds));
+    double phase = 0;
+    for (size_t i = 0; i < pcm.size(); i++) {
+        double t = (double)i / rate;
+        double voiced = (t > 0.5 && t < 1.8) || (t > 2.6 && t < seconds - 0.4) ? 1.0 : 0.0;
+        double env = voiced * (0.6 + 0.4 * sin(2 * M_PI * 3.0 * t));
+        phase += 2 * M_PI * (170 + 40 * sin(2 * M_PI * 0.7 * t)) / rate;
+        double v = 0;
+        for (int h = 1; h <= 8; h++) {
+            v += sin(h * phase) / h;
+        }
+        seed = seed * 1103515245 + 12345;
+        pcm[i] = (int16_t)(6000 * env * v + (int32_t)((seed >> 16) & 0x7FFF) / 128 - 128);
+    }
+    return pcm;
+}
+
+// One upload's worth of work into `body`
+static void audioJob(const std::vector<int16_t>& pcm, uint32_t rate, SilenceTrimmer& trimmer,
+                     FlacEncoder& encoder, std::vector<uint8_t>& body)
+{
+    body.clear();
+    encoder.begin(rate, [&body](const uint8_t* data, size_t len) {
+        body.insert(body.end(), data, data + len);
+    });
+    SilenceTrimmer::Config trim = SilenceTrimmer::DEFAULT_CONFIG;
+    trim.sample_rate = rate;
+    trim.max_gap_ms = 600;
+    trimmer.begin(trim, [&encoder](const int16_t* samples, size_t count) {
+        encoder.encode(samples, count);
+    });
+    for (size_t pos = 0; pos < pcm.size(); pos += 512) {
+        trimmer.process(pcm.data() + pos, std::min<size_t>(512, pcm.size() - pos));
+    }
+    trimmer.finish();
+    encoder.finish();
+    trimmer.end();
+    encoder.end();
+}
+
+class GradientSource : public GraySource {
+public:
+    GradientSource(uint16_t width, uint16_t height)
+        : width_(width)
+        , height_(height)
+        , y_(0)
+    {
+    }
+    
+    bool readRow(uint8_t* row) override
+    {
+        if (y_ == height_) {
+            return false;
+        }
+        for (uint16_t x = 0; x < width_; x++) {
+            int dx = x - width_ / 2;
+            int dy = y_ - height_ / 2;
+            row[x] = (uint8_t)((dx * dx + dy * dy) * 255 / (width_ * width_ / 2) & 0xFF);
+        }
+        y_++;
+        return true;
+    }
+    
+private:
+    uint16_t width_;
+    uint16_t height_;
+    uint16_t y_;
+};
+
+static constexpr uint16_t IMAGE_SIZE = 512;
+
+static uint64_t rasterJob(RasterPipeline& pipeline, std::vector<uint8_t>& row)
+{
+    GradientSource source(IMAGE_SIZE, IMAGE_SIZE);
+    RasterPipeline::Config config = {
+        RasterPipeline::Resample::Lanczos, IMAGE_SIZE, IMAGE_SIZE, 384, 0, 96, 1,
+        RasterPipeline::Dither::FloydSteinberg,
+    };
+    if (!pipeline.begin(source, config)) {
+        return 0;
+    }
+    // FNV-1a over the packed rows
+    uint64_t hash = 1469598103934665603ull;
+    row.resize(pipeline.widthBytes());
+    while (pipeline.readRow(row.data())) {
+        for (uint8_t b : row) {
+            hash = (hash ^ b) * 1099511628211ull;
+        }
+    }
+    pipeline.end();
+    return hash;
+}
+
+// Printer task: the job's outcome for the thread waiting on it
+struct JobWait {
+    SemaphoreHandle_t done;
+    std::atomic<bool> ok;
+};
+
+static void onJobDone(uint32_t, bool ok, void* ctx)
+{
+    JobWait* wait = static_cast<JobWait*>(ctx);
+    wait->ok = ok;
+    xSemaphoreGive(wait->done);
+}
+
+// Submit and wait; false if the queue refused it or it failed
+static bool printJob(PrintQueue& queue, PrintJob* job, JobWait& wait)
+{
+    job->onDone(onJobDone, &wait);
+    return queue.submit(job) != 0 && xSemaphoreTake(wait.done, portMAX_DELAY) == pdTRUE && wait.ok;
+}
+
+// The click handler's test print, then printCached() on a sticker put
+// in the cache just before, as a download would
+static bool printJobs(PrintQueue& queue, StickerCache& cache, uint64_t key, const std::vector<uint8_t>& pvr,
+                      JobWait& wait)
+{
+    PrintJob* job = queue.acquire();
+    if (!job) {
+        return false;
+    }
+    job->reset()
+        .line("Hello world")
+        .line("PegaVox Test Print")
+        .feed(3)
+        .cut();
+    if (!printJob(queue, job, wait) || !cache.put(key, pvr.data(), pvr.size())) {
+        return false;
+    }
+    
+    job = queue.acquire();
+    StickerCache::Source* source = job ? job->make<StickerCache::Source>(cache) : nullptr;
+    if (!source || !source->open(key)) {
+        if (job) {
+            queue.release(job);
+        }
+        return false;
+    }
+    job->reset()
+        .raster(source, source->widthBytes())
+        .feed(3)
+        .cut();
+    return printJob(queue, job, wait);
+}
+
+struct Result {
+    double allocs_per_job;      // Jobs after the first
+    double bytes_per_job;
+    bool same_output;
+};
+
+static void printResult(const char* name, const char* mode, const Result& r, const Arena* arena)
+{
+    printf("%-14s %-6s %9.1f %11.0f", name, mode, r.allocs_per_job, r.bytes_per_job);
+    if (arena) {
+        printf(" %9u %9u", (unsigned)arena->capacity(), (unsigned)arena->highWater());
+    } else {
+        printf(" %9s %9s", "-", "-");
+    }
+    printf(" %s\n", r.same_output ? "ok" : "DIFFERENT");
+}
+
+int main(int argc, char** argv)
+{
+    int jobs = 50;
+    float seconds = 4.0f;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--jobs" && has_value) {
+            jobs = atoi(argv[++i]);
+        } else if (arg == "--seconds" && has_value) {
+            seconds = (float)atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--jobs N] [--seconds S] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (jobs < 2 || seconds < 3.0f) {
+        fprintf(stderr, "Need at least 2 jobs and 3 s of audio\n");
+        return 1;
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_WARN);
+    }
+    bool all_ok = true;
+    
+    // Arenas are reserved once, as AudioUploader does at begin()
+    const uint32_t rate = 16000;
+    Arena audio_arena;
+    audio_arena.init(MemoryBudget::reserve("audio arena", 40 * 1024, true), 40 * 1024);
+    MemoryBudget::addArena("audio", &audio_arena);
+    Arena raster_arena;
+    raster_arena.init(MemoryBudget::reserve("raster arena", 64 * 1024, true), 64 * 1024);
+    MemoryBudget::addArena("raster", &raster_arena);
+    
+    printf("%d jobs per case; heap calls and bytes per job after the first\n\n", jobs);
+    printf("%-14s %-6s %9s %11s %9s %9s\n", "job", "memory", "allocs", "bytes", "arena", "arena hw");
+    
+    // Audio
+    std::vector<int16_t> pcm = recording(rate, seconds);
+    std::vector<uint8_t> body;
+    body.reserve(pcm.size() * 2 + 1024);
+    std::vector<uint8_t> reference;
+    for (int pass = 0; pass < 2; pass++) {
+        Arena* arena = pass ? &audio_arena : nullptr;
+        SilenceTrimmer trimmer;
+        FlacEncoder encoder;
+        trimmer.setArena(arena);
+        encoder.setArena(arena);
+        Result r = {0, 0, true};
+        HeapCounter counter;
+        for (int j = 0; j < jobs; j++) {
+            if (j == 1) {
+                counter = HeapCounter();
+            }
+            audioJob(pcm, rate, trimmer, encoder, body);
+            if (arena) {
+                arena->reset();
+            }
+            if (reference.empty()) {
+                reference = body;
+            }
+            r.same_output = r.same_output && body == reference;
+        }
+        r.allocs_per_job = (double)counter.allocsSince() / (jobs - 1);
+        r.bytes_per_job = (double)counter.bytesSince() / (jobs - 1);
+        printResult("trim + flac", arena ? "arena" : "heap", r, arena);
+        all_ok = all_ok && r.same_output && !reference.empty()
+                 && (!arena || (counter.allocsSince() == 0 && audio_arena.failures() == 0));
+    }
+    
+    // Raster
+    std::vector<uint8_t> row;
+    row.reserve(64);
+    uint64_t raster_reference = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        Arena* arena = pass ? &raster_arena : nullptr;
+        RasterPipeline pipeline;
+        pipeline.setArena(arena);
+        Result r = {0, 0, true};
+        HeapCounter counter;
+        for (int j = 0; j < jobs; j++) {
+            if (j == 1) {
+                counter = HeapCounter();
+            }
+            uint64_t hash = rasterJob(pipeline, row);
+            if (arena) {
+                arena->reset();
+            }
+            if (raster_reference == 0) {
+                raster_reference = hash;
+            }
+            r.same_output = r.same_output && hash == raster_reference;
+        }
+        r.allocs_per_job = (double)counter.allocsSince() / (jobs - 1);
+        r.bytes_per_job = (double)counter.bytesSince() / (jobs - 1);
+        printResult("raster 512px", arena ? "arena" : "heap", r, arena);
+        all_ok = all_ok && r.same_output && raster_reference != 0
+                 && (!arena || (counter.allocsSince() == 0 && raster_arena.failures() == 0));
+    }
+    
+    // Arena reset cost
+    {
+        const int resets = 1000000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < resets; i++) {
+            audio_arena.allocate<int16_t>(480);
+            audio_arena.reset();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("\nArena allocate + reset: %.1f ns\n", ns / resets);
+    }
+    
+    // The print path on static tasks and queues, jobs through it, then the
+    // report. Printing time isn't what's measured here.
+    Sim::setTimeScale(100);
+    SimPrinter model(UART_NUM_1, 115200);
+    model.attach();
+    {
+        static ThermalPrinter printer(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18, 115200);
+        static PrintQueue queue(printer, 4);
+        static StickerPipeline pipeline(queue);
+        static StickerCache cache;
+        bool booted = printer.begin() && queue.begin() && pipeline.begin()
+                      && cache.begin(StickerCache::Config{64 * 1024, 0});
+        printf("Print path boot on static tasks, queues and buffers: %s\n", booted ? "ok" : "FAILED");
+        all_ok = all_ok && booted;
+        MemoryBudget::addStatic("printer", sizeof(printer));
+        MemoryBudget::addStatic("print_queue", sizeof(queue));
+        MemoryBudget::addStatic("pipeline", sizeof(pipeline));
+        MemoryBudget::addStatic("sticker_cache", sizeof(cache));
+        MemoryBudget::addArena("print job", &queue.jobArena());
+        MemoryBudget::bootDone();
+        
+        // Stickers of different sizes, so the cache's block fills, spills
+        // and gets compacted along the way
+        std::vector<std::vector<uint8_t>> stickers;
+        for (int i = 0; i < 8; i++) {
+            uint16_t height = (uint16_t)(120 + i * 53 % 200);
+            stickers.push_back(encodePvr(noisyImage(height), height));
+        }
+        JobWait wait;
+        wait.done = xSemaphoreCreateBinary();
+        bool printed = booted;
+        uint64_t allocs = 0;
+        for (int j = 0; j < jobs && printed; j++) {
+            if (j == 1) {
+                allocs = thread_allocs;
+            }
+            printed = printJobs(queue, cache, (uint64_t)j + 1, stickers[j % stickers.size()], wait);
+        }
+        allocs = thread_allocs - allocs;
+        const Arena& arena = queue.jobArena();
+        StickerCache::Metrics m = cache.getMetrics();
+        printf("Print + reprint, %d of each: %.1f heap calls per pair after the first, job arena %u, "
+               "peak %u used; cache %u spills, %u compactions -> %s\n", jobs, (double)allocs / (jobs - 1),
+               (unsigned)arena.capacity(), (unsigned)arena.highWater(), (unsigned)m.spills,
+               (unsigned)m.compactions, printed ? "ok" : "FAILED");
+        all_ok = all_ok && printed && allocs == 0 && arena.failures() == 0;
+        printer.waitTxDone();
+    }
+    printf("\nMemoryBudget report (stack peaks are not modeled on the host):\n");
+    fflush(stdout);
+    esp_log_level_set("MemoryBudget", ESP_LOG_INFO);
+    MemoryBudget::log();
+    
+    printf("\n%s\n", all_ok ? "Arena jobs identical to heap jobs, no heap use after the first, no arena overflow"
+                             : "FAILED");
+    fflush(stdout);
+    // Tasks still run; skip static destructors
+    _Exit(all_ok ? 0 : 1);
+}
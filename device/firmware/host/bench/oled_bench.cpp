@@ -0,0 +1,216 @@
+/*
+ * oled_bench.cpp
+ * SSD1327 partial-update cost on the simulated I2C bus
+ *
+ * Usage:
+ *   oled_bench [--freq HZ] [--iterations N]
+ *
+ * A panel model at 0x3C keeps its own GDDRAM from the column/row windows
+ * and data the driver sends. The bench times a full refresh, a few typical
+ * partial updates and a random drawing workload, and checks after every
+ * flush that the panel matches the framebuffer. Last, a bus reset is
+ * requested while a full refresh is still queued: it must run between
+ * transactions, with none failing.
+ */
+
+#include "I2CManager.hpp"
+#include "Sim.hpp"
+#include "SSD1327.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// GDDRAM model: 128 rows x 64 bytes, written through the current window
+class PanelModel : public SimI2CDevice {
+public:
+    PanelModel() : control_(-1), col_start_(0), col_end_(63), row_start_(0), row_end_(127),
+                   col_(0), row_(0), arg_count_(0), args_needed_(0)
+    {
+        memset(ram_, 0, sizeof(ram_));
+    }
+    
+    const uint8_t* ram() const { return ram_; }
+    
+    void start(bool read) override
+    {
+        (void)read;
+        control_ = -1;
+    }
+    
+    bool write(uint8_t byte) override
+    {
+        if (control_ < 0) {
+            control_ = byte;
+            return byte == 0x00 || byte == 0x40;
+        }
+        if (control_ == 0x40) {
+            ram_[row_ * 64 + col_] = byte;
+            if (++col_ > col_end_) {
+                col_ = col_start_;
+                if (++row_ > row_end_) {
+                    row_ = row_start_;
+                }
+            }
+            return true;
+        }
+        command(byte);
+        return true;
+    }
+    
+private:
+    uint8_t ram_[128 * 64];
+    int control_;
+    int col_start_, col_end_, row_start_, row_end_;
+    int col_, row_;
+    uint8_t cmd_[4];
+    int arg_count_;
+    int args_needed_;
+    
+    static int argCount(uint8_t cmd)
+    {
+        switch (cmd) {
+        case 0x15: case 0x75: return 2;
+        case 0x81: case 0xA0: case 0xA1: case 0xA2: case 0xA8: case 0xAB: case 0xB1:
+        case 0xB3: case 0xB6: case 0xBC: case 0xBE: case 0xD5: case 0xFD: return 1;
+        default: return 0;
+        }
+    }
+    
+    void command(uint8_t byte)
+    {
+        if (args_needed_ == 0) {
+            cmd_[0] = byte;
+            arg_count_ = 0;
+            args_needed_ = argCount(byte);
+        } else {
+            cmd_[1 + arg_count_++] = byte;
+            args_needed_--;
+        }
+        if (args_needed_ > 0) {
+            return;
+        }
+        if (cmd_[0] == 0x15 && arg_count_ == 2) {
+            col_start_ = col_ = cmd_[1];
+            col_end_ = cmd_[2];
+        } else if (cmd_[0] == 0x75 && arg_count_ == 2) {
+            row_start_ = row_ = cmd_[1];
+            row_end_ = cmd_[2];
+        }
+    }
+};
+
+struct Sample {
+    uint64_t bus_us;
+    uint64_t bytes;
+    int64_t call_us;       // display() returns
+    int64_t flush_us;      // Last byte on the bus
+};
+
+static Sample flush(SSD1327& oled)
+{
+    uint64_t bus0 = Sim::i2cBusTimeUs(I2C_NUM_0);
+    uint64_t bytes0 = Sim::i2cBytes(I2C_NUM_0);
+    int64_t t0 = Sim::now();
+    oled.display();
+    int64_t t1 = Sim::now();
+    while (oled.isFlushing()) {
+        Sim::sleepUntil(Sim::now() + 100);
+    }
+    return {Sim::i2cBusTimeUs(I2C_NUM_0) - bus0, Sim::i2cBytes(I2C_NUM_0) - bytes0, t1 - t0, Sim::now() - t0};
+}
+
+static void report(const char* name, const Sample& s)
+{
+    printf("%-22s %7llu %9.2f %9.2f %9.2f\n", name, (unsigned long long)s.bytes,
+           s.bus_us / 1000.0, s.call_us / 1000.0, s.flush_us / 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t freq = 400000;
+    int iterations = 300;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--freq" && i + 1 < argc) {
+            freq = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--freq HZ] [--iterations N]\n", argv[0]);
+            return 1;
+        }
+    }
+    esp_log_level_set("*", ESP_LOG_WARN);
+    
+    PanelModel panel;
+    Sim::i2cAttach(I2C_NUM_0, SSD1327::DEFAULT_ADDRESS, &panel);
+    I2CManager i2c(GPIO_NUM_41, GPIO_NUM_42, freq);
+    if (!i2c.begin()) {
+        return 1;
+    }
+    SSD1327 oled(i2c);
+    if (!oled.begin()) {
+        fprintf(stderr, "Panel init failed\n");
+        return 1;
+    }
+    while (oled.isFlushing()) {
+        Sim::sleepUntil(Sim::now() + 100);
+    }
+    
+    printf("I2C %u Hz\n%-22s %7s %9s %9s %9s\n", (unsigned)freq, "update", "bytes", "bus ms",
+           "call ms", "done ms");
+    oled.clear(3);
+    report("full refresh", flush(oled));
+    oled.fillRect(120, 0, 8, 8, 15);
+    report("8x8 status icon", flush(oled));
+    oled.fillRect(10, 10, 16, 16, 15);
+    report("16x16 icon", flush(oled));
+    oled.fillRect(0, 100, 128, 16, 0);
+    report("128x16 text line", flush(oled));
+    oled.setPixel(5, 5, 15);
+    oled.setPixel(122, 5, 15);
+    oled.setPixel(5, 122, 15);
+    oled.setPixel(122, 122, 15);
+    report("4 corner pixels", flush(oled));
+    
+    // Random workload; the panel must match the framebuffer after each flush
+    srand(1);
+    uint64_t bytes = 0;
+    uint64_t bus_us = 0;
+    int flushes = 0;
+    bool ok = memcmp(panel.ram(), oled.buffer(), 128 * 64) == 0;
+    for (int it = 0; it < iterations && ok; it++) {
+        int shapes = 1 + rand() % 3;
+        for (int k = 0; k < shapes; k++) {
+            oled.fillRect(rand() % 140 - 6, rand() % 140 - 6, rand() % 24, rand() % 24, rand() % 16);
+        }
+        Sample s = flush(oled);
+        bytes += s.bytes;
+        bus_us += s.bus_us;
+        flushes++;
+        ok = memcmp(panel.ram(), oled.buffer(), 128 * 64) == 0;
+    }
+    
+    // Bus reset from another task while a flush is on the queue
+    uint32_t errors_before = i2c.getStats().errors;
+    oled.clear(7);
+    oled.display();
+    bool reset_ok = i2c.bus_reset();
+    while (oled.isFlushing()) {
+        Sim::sleepUntil(Sim::now() + 100);
+    }
+    uint32_t reset_errors = i2c.getStats().errors - errors_before;
+    bool after_reset = i2c.probe(SSD1327::DEFAULT_ADDRESS) && memcmp(panel.ram(), oled.buffer(), 128 * 64) == 0;
+    
+    I2CManager::Stats stats = i2c.getStats();
+    printf("\nrandom: %d flushes, %.0f bytes and %.2f ms of bus each; %u transactions in %u bus writes, "
+           "queue high-water %u\n", flushes, flushes ? (double)bytes / flushes : 0.0,
+           flushes ? bus_us / 1000.0 / flushes : 0.0, (unsigned)stats.transactions,
+           (unsigned)stats.bus_writes, (unsigned)stats.queue_high_water);
+    printf("bus reset under a queued refresh: %s, %u failed transactions, panel %s\n",
+           reset_ok ? "ok" : "FAILED", (unsigned)reset_errors, after_reset ? "matches" : "MISMATCH");
+    ok = ok && reset_ok && reset_errors == 0 && after_reset;
+    printf("%s\n", ok ? "panel matches framebuffer" : "PANEL MISMATCH");
+    return ok ? 0 : 1;
+}
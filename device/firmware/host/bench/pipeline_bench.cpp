@@ -0,0 +1,312 @@
+/*
+ * pipeline_bench.cpp
+ * Download, decode and print overlapped through StickerPipeline, against
+ * doing them one after another
+ *
+ * Usage:
+ *   pipeline_bench [options]
+ *     --baud N          UART and printer baud rate (115200)
+ *     --rates A,B       Download rates in kbit/s (128,512,2048)
+ *     --rows N          Synthetic image height (480)
+ *     --scale S         Simulated time runs S times faster than real (10)
+ *     --verbose         Keep driver INFO logs
+ *
+ * The sticker is a noise-dithered gradient, which PVR1 compresses
+ * poorly, so the download is a real share of the time. For each rate the
+ * sequential run downloads the whole PVR1 into RAM, then decodes and
+ * prints it (the PrintQueue job reads a RasterDecoder over the buffer).
+ * The pipelined run writes each TCP segment into StickerPipeline as it
+ * arrives, with the decode and printer tasks on core 1 as in TaskLayout.
+ * Both report when the first byte reached the printer, when the head
+ * finished, and the buffer depths; the printer model must receive the
+ * image intact. Then a download cut off halfway and a stream that isn't
+ * PVR1 must fail cleanly and leave the pipeline ready for the next one.
+ */
+
+#include "PrintQueue.hpp"
+#include "RasterDecoder.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "StickerPipeline.hpp"
+#include "TaskLayout.hpp"
+#include "ThermalPrinter.hpp"
+#include "bench_raster.hpp"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr size_t NET_CHUNK = 1460;           // One TCP segment per write()
+
+struct Device {
+    std::unique_ptr<SimPrinter> model;
+    std::unique_ptr<ThermalPrinter> printer;
+    std::unique_ptr<PrintQueue> queue;
+    std::unique_ptr<StickerPipeline> pipeline;
+    SemaphoreHandle_t done;
+    std::atomic<bool> ok;
+    
+    Device()
+        : done(xSemaphoreCreateBinary())
+        , ok(false)
+    {
+    }
+    
+    ~Device()
+    {
+        pipeline.reset();
+        queue.reset();
+        printer.reset();
+        model.reset();
+        vSemaphoreDelete(done);
+    }
+};
+
+static bool boot(Device& dev, uint32_t baud)
+{
+    dev.model.reset(new SimPrinter(UART_NUM_1, baud));
+    dev.model->attach();
+    dev.printer.reset(new ThermalPrinter(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18, (int)baud));
+    dev.queue.reset(new PrintQueue(*dev.printer, 4));
+    dev.pipeline.reset(new StickerPipeline(*dev.queue));
+    Device* d = &dev;
+    dev.pipeline->setCallback([d](uint32_t, bool ok) {
+        d->ok = ok;
+        xSemaphoreGive(d->done);
+    });
+    if (!dev.printer->begin() || !dev.queue->begin() || !dev.pipeline->begin()) {
+        return false;
+    }
+    // Start from an idle wire, without the setup commands
+    dev.printer->waitTxDone();
+    Sim::sleepUntil(dev.model->getStats().busy_until_us);
+    Sim::uartClearTx(UART_NUM_1);
+    return true;
+}
+
+// The network side: TCP segments arrive at `kbps` once the receiver has
+// taken the previous one, up to `stop_at` bytes
+static bool download(StickerPipeline& pipeline, const std::vector<uint8_t>& pvr, double kbps,
+                     size_t stop_at)
+{
+    double byte_us = 8000.0 / kbps;
+    int64_t arrival = Sim::now();
+    for (size_t pos = 0; pos < pvr.size() && pos < stop_at; pos += NET_CHUNK) {
+        size_t n = std::min(NET_CHUNK, pvr.size() - pos);
+        arrival = std::max(arrival, Sim::now()) + (int64_t)(n * byte_us);
+        Sim::sleepUntil(arrival);
+        if (!pipeline.write(pvr.data() + pos, n, portMAX_DELAY)) {
+            return false;
+        }
+    }
+    return stop_at >= pvr.size();
+}
+
+struct Run {
+    double download_ms;
+    double first_ms;        // First byte to the printer
+    double total_ms;        // Head finished
+    bool ok;
+    bool intact;
+    StickerPipeline::Depths depths;
+};
+
+static bool waitDone(Device& dev)
+{
+    return xSemaphoreTake(dev.done, pdMS_TO_TICKS(60000)) == pdTRUE && dev.ok;
+}
+
+static void finishRun(Device& dev, Run& run, int64_t start_us, const std::vector<uint8_t>& image)
+{
+    dev.printer->waitTxDone();
+    std::vector<Sim::UartByte> tx = Sim::uartTx(UART_NUM_1);
+    int64_t head_us = dev.model->getStats().busy_until_us;
+    run.first_ms = tx.empty() ? 0 : (tx.front().t_us - start_us) / 1000.0;
+    run.total_ms = (head_us - start_us) / 1000.0;
+    run.intact = dev.model->raster() == image;
+    Sim::sleepUntil(head_us);
+}
+
+static Run sequential(uint32_t baud, const std::vector<uint8_t>& image, const std::vector<uint8_t>& pvr,
+                      double kbps)
+{
+    Run run = {};
+    Device dev;
+    if (!boot(dev, baud)) {
+        return run;
+    }
+    int64_t start_us = Sim::now();
+    Sim::sleepUntil(start_us + (int64_t)(pvr.size() * 8000.0 / kbps));
+    run.download_ms = (Sim::now() - start_us) / 1000.0;
+    
+    struct BufferedSource : RasterSource {
+        MemoryByteSource bytes;
+        RasterDecoder decoder;
+        
+        BufferedSource(const std::vector<uint8_t>& pvr)
+            : bytes(pvr.data(), pvr.size())
+        {
+        }
+        
+        bool readRow(uint8_t* row) override { return decoder.readRow(row); }
+    };
+    PrintJob* job = dev.queue->acquire();
+    BufferedSource* source = job ? job->make<BufferedSource>(pvr) : nullptr;
+    if (!source || !source->decoder.begin(source->bytes)) {
+        if (job) {
+            dev.queue->release(job);
+        }
+        return run;
+    }
+    job->reset()
+        .raster(source, WIDTH_BYTES)
+        .feed(3)
+        .cut();
+    job->onDone([](uint32_t, bool ok, void* ctx) {
+        Device* d = static_cast<Device*>(ctx);
+        d->ok = ok;
+        xSemaphoreGive(d->done);
+    }, &dev);
+    run.ok = dev.queue->submit(job) != 0 && waitDone(dev);
+    finishRun(dev, run, start_us, image);
+    return run;
+}
+
+static Run pipelined(uint32_t baud, const std::vector<uint8_t>& image, const std::vector<uint8_t>& pvr,
+                     double kbps)
+{
+    Run run = {};
+    Device dev;
+    if (!boot(dev, baud)) {
+        return run;
+    }
+    int64_t start_us = Sim::now();
+    bool downloaded = dev.pipeline->open(portMAX_DELAY) && download(*dev.pipeline, pvr, kbps, pvr.size());
+    run.download_ms = (Sim::now() - start_us) / 1000.0;
+    dev.pipeline->close(downloaded);
+    run.ok = downloaded && waitDone(dev);
+    finishRun(dev, run, start_us, image);
+    run.depths = dev.pipeline->getDepths();
+    return run;
+}
+
+// A cut-off download and a stream that isn't PVR1 both fail; the sticker
+// after each still prints
+static bool failures(uint32_t baud, const std::vector<uint8_t>& image, const std::vector<uint8_t>& pvr)
+{
+    Device dev;
+    if (!boot(dev, baud)) {
+        return false;
+    }
+    bool ok = true;
+    
+    dev.pipeline->open(portMAX_DELAY);
+    download(*dev.pipeline, pvr, 512, pvr.size() / 2);
+    dev.pipeline->close(false);
+    bool cut_failed = !waitDone(dev);
+    printf("%-28s %s\n", "download cut halfway", cut_failed ? "failed, ok" : "REPORTED SUCCESS");
+    ok = ok && cut_failed;
+    
+    std::vector<uint8_t> junk(4096, 0x5A);
+    dev.pipeline->open(portMAX_DELAY);
+    bool refused = !download(*dev.pipeline, junk, 2048, junk.size());
+    dev.pipeline->close(!refused);
+    bool junk_failed = !waitDone(dev);
+    printf("%-28s %s%s\n", "not a PVR1 stream", junk_failed ? "failed, ok" : "REPORTED SUCCESS",
+           refused ? ", writes refused" : "");
+    ok = ok && junk_failed;
+    
+    // The next sticker prints in full after both
+    dev.printer->waitTxDone();
+    Sim::sleepUntil(dev.model->getStats().busy_until_us);
+    dev.model.reset();
+    dev.model.reset(new SimPrinter(UART_NUM_1, baud));
+    dev.model->attach();
+    bool opened = dev.pipeline->open(pdMS_TO_TICKS(1000));
+    bool downloaded = opened && download(*dev.pipeline, pvr, 2048, pvr.size());
+    dev.pipeline->close(downloaded);
+    bool next_ok = downloaded && waitDone(dev);
+    dev.printer->waitTxDone();
+    bool intact = dev.model->raster() == image;
+    printf("%-28s %s\n", "next sticker", next_ok && intact ? "printed intact, ok" : "BROKEN");
+    Sim::sleepUntil(dev.model->getStats().busy_until_us);
+    return ok && next_ok && intact;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = 115200;
+    std::vector<double> rates = {128, 512, 2048};
+    uint16_t height = 480;
+    double scale = 10;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--baud" && has_value) {
+            baud = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--rates" && has_value) {
+            rates.clear();
+            for (char* p = strtok(argv[++i], ","); p; p = strtok(nullptr, ",")) {
+                rates.push_back(atof(p));
+            }
+        } else if (arg == "--rows" && has_value) {
+            height = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--scale" && has_value) {
+            scale = atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--baud N] [--rates A,B] [--rows N] [--scale S] [--verbose]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_ERROR);
+    }
+    Sim::setTimeScale(scale);
+    
+    std::vector<uint8_t> image = noisyImage(height);
+    std::vector<uint8_t> pvr = encodePvr(image, height);
+    printf("%u rows, PVR1 %u bytes, %u baud, stream buffer %u B, row buffer %u rows\n",
+           (unsigned)height, (unsigned)pvr.size(), (unsigned)baud, (unsigned)StickerPipeline::STREAM_BYTES,
+           (unsigned)StickerPipeline::ROW_SLOTS);
+    printf("%6s %-10s %8s %8s %8s %7s %11s %9s %6s %s\n", "kbit/s", "mode", "net ms", "first ms",
+           "total ms", "saved", "stream pk", "rows pk", "waits", "raster");
+    
+    bool ok = true;
+    for (double kbps : rates) {
+        Run seq = sequential(baud, image, pvr, kbps);
+        Run pipe = pipelined(baud, image, pvr, kbps);
+        printf("%6.0f %-10s %8.1f %8.1f %8.1f %7s %11s %9s %6s %s\n", kbps, "sequential",
+               seq.download_ms, seq.first_ms, seq.total_ms, "", "", "", "",
+               seq.ok && seq.intact ? "ok" : "MISMATCH");
+        char stream[24];
+        char rows[24];
+        char waits[24];
+        snprintf(stream, sizeof(stream), "%u/%u", (unsigned)pipe.depths.stream_peak,
+                 (unsigned)pipe.depths.stream_capacity);
+        snprintf(rows, sizeof(rows), "%u/%u", (unsigned)pipe.depths.row_peak,
+                 (unsigned)pipe.depths.row_capacity);
+        snprintf(waits, sizeof(waits), "%u/%u", (unsigned)pipe.depths.network_waits,
+                 (unsigned)pipe.depths.decode_waits);
+        printf("%6.0f %-10s %8.1f %8.1f %8.1f %6.1f%% %11s %9s %6s %s\n", kbps, "pipelined",
+               pipe.download_ms, pipe.first_ms, pipe.total_ms,
+               100.0 * (seq.total_ms - pipe.total_ms) / seq.total_ms, stream, rows, waits,
+               pipe.ok && pipe.intact ? "ok" : "MISMATCH");
+        ok = ok && seq.ok && seq.intact && pipe.ok && pipe.intact && pipe.total_ms < seq.total_ms;
+    }
+    printf("(waits: network writes that found the stream full / rows that found the row buffer full)\n");
+    
+    ok = failures(baud, image, pvr) && ok;
+    printf("%s\n", ok ? "Pipelined prints intact and sooner" : "PIPELINE PROBLEMS");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,445 @@
+/*
+ * preview_bench.cpp
+ * Live OLED preview: PreviewScaler against a plain 3x3 count, and
+ * PrintPreview on the simulated I2C panel while stickers print
+ *
+ * Usage:
+ *   preview_bench [options]
+ *     --baud N          UART and printer baud rate (115200)
+ *     --freq HZ         I2C clock (400000)
+ *     --rows A,B        Sticker heights for the printing runs (300,900)
+ *     --scale S         Simulated time runs S times faster than real (10)
+ *     --verbose         Keep driver INFO logs
+ *
+ * First the scaler alone: random rasters of several widths (cropped,
+ * exact and centered) and heights (whole and partial last cells), both
+ * polarities, must match a reference that counts every cell's dots one
+ * by one. Its cost per printer row and per 24-row band is timed on the
+ * host.
+ *
+ * Then whole stickers through StickerPipeline, once without and once
+ * with PrintPreview attached, with a panel model at 0x3C that keeps its
+ * GDDRAM and start line from what the driver sends. The printer must get
+ * the raster intact and finish no later with the preview; afterwards the
+ * panel must match the framebuffer, and what it shows (GDDRAM from the
+ * start line) must be the reference preview of the sticker's last 384
+ * rows. Reported: when the head finished, preview lines, pushes to the
+ * panel and the ones put off while the bus was busy, and I2C bus time.
+ */
+
+#include "I2CManager.hpp"
+#include "PreviewScaler.hpp"
+#include "PrintPreview.hpp"
+#include "PrintQueue.hpp"
+#include "SSD1327.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "StickerPipeline.hpp"
+#include "ThermalPrinter.hpp"
+#include "bench_raster.hpp"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr size_t NET_CHUNK = 1460;
+
+// GDDRAM model: 128 rows x 64 bytes through the current window, and the
+// display start line
+class PanelModel : public SimI2CDevice {
+public:
+    PanelModel() : control_(-1), col_start_(0), col_end_(63), row_start_(0), row_end_(127),
+                   col_(0), row_(0), start_line_(0), arg_count_(0), args_needed_(0)
+    {
+        memset(ram_, 0, sizeof(ram_));
+    }
+    
+    const uint8_t* ram() const { return ram_; }
+    int startLine() const { return start_line_; }
+    
+    void start(bool read) override
+    {
+        (void)read;
+        control_ = -1;
+    }
+    
+    bool write(uint8_t byte) override
+    {
+        if (control_ < 0) {
+            control_ = byte;
+            return byte == 0x00 || byte == 0x40;
+        }
+        if (control_ == 0x40) {
+            ram_[row_ * 64 + col_] = byte;
+            if (++col_ > col_end_) {
+                col_ = col_start_;
+                if (++row_ > row_end_) {
+                    row_ = row_start_;
+                }
+            }
+            return true;
+        }
+        command(byte);
+        return true;
+    }
+
+private:
+    uint8_t ram_[128 * 64];
+    int control_;
+    int col_start_, col_end_, row_start_, row_end_;
+    int col_, row_;
+    int start_line_;
+    uint8_t cmd_[4];
+    int arg_count_;
+    int args_needed_;
+    
+    static int argCount(uint8_t cmd)
+    {
+        switch (cmd) {
+        case 0x15: case 0x75: return 2;
+        case 0x81: case 0xA0: case 0xA1: case 0xA2: case 0xA8: case 0xAB: case 0xB1:
+        case 0xB3: case 0xB6: case 0xBC: case 0xBE: case 0xD5: case 0xFD: return 1;
+        default: return 0;
+        }
+    }
+    
+    void command(uint8_t byte)
+    {
+        if (args_needed_ == 0) {
+            cmd_[0] = byte;
+            arg_count_ = 0;
+            args_needed_ = argCount(byte);
+        } else {
+            cmd_[1 + arg_count_++] = byte;
+            args_needed_--;
+        }
+        if (args_needed_ > 0) {
+            return;
+        }
+        if (cmd_[0] == 0x15 && arg_count_ == 2) {
+            col_start_ = col_ = cmd_[1];
+            col_end_ = cmd_[2];
+        } else if (cmd_[0] == 0x75 && arg_count_ == 2) {
+            row_start_ = row_ = cmd_[1];
+            row_end_ = cmd_[2];
+        } else if (cmd_[0] == 0xA1 && arg_count_ == 1) {
+            start_line_ = cmd_[1] & 0x7F;
+        }
+    }
+};
+
+// Dots set with probability density/256, from a seeded generator
+static std::vector<uint8_t> randomImage(uint16_t width_bytes, uint16_t height, int density, uint32_t seed)
+{
+    std::vector<uint8_t> rows((size_t)width_bytes * height, 0);
+    uint32_t state = seed * 2654435761u + 1;
+    for (size_t i = 0; i < rows.size() * 8; i++) {
+        state = state * 1664525u + 1013904223u;
+        if ((int)(state >> 24) < density) {
+            rows[i / 8] |= 0x80 >> (i & 7);
+        }
+    }
+    return rows;
+}
+
+// The preview counted dot by dot: 128 pixels per line, 4 bpp packed.
+// Whole 3-byte groups only; the middle 16 of them, or all centered.
+static std::vector<uint8_t> referencePreview(const std::vector<uint8_t>& image, uint16_t width_bytes,
+                                             uint16_t height, bool ink_lit)
+{
+    int groups = width_bytes / 3;
+    int first_dot = 0;
+    int first_px = 0;
+    if (groups > 16) {
+        first_dot = (groups - 16) / 2 * 24;
+        groups = 16;
+    } else {
+        first_px = (16 - groups) * 4;
+    }
+    int lines = (height + 2) / 3;
+    std::vector<uint8_t> out((size_t)lines * 64, 0);
+    for (int py = 0; py < lines; py++) {
+        for (int px = 0; px < 128; px++) {
+            int gray = 0;
+            int cell = px - first_px;
+            if (cell >= 0 && cell < groups * 8) {
+                int count = 0;
+                for (int dy = 0; dy < 3; dy++) {
+                    int y = py * 3 + dy;
+                    for (int dx = 0; dx < 3 && y < height; dx++) {
+                        int x = first_dot + cell * 3 + dx;
+                        count += (image[(size_t)y * width_bytes + x / 8] >> (7 - x % 8)) & 1;
+                    }
+                }
+                gray = (count * 15 + 4) / 9;
+            }
+            if (!ink_lit) {
+                gray = 15 - gray;
+            }
+            out[(size_t)py * 64 + px / 2] |= (uint8_t)(px & 1 ? gray : gray << 4);
+        }
+    }
+    return out;
+}
+
+static std::vector<uint8_t> scale(PreviewScaler& scaler, const std::vector<uint8_t>& image,
+                                  uint16_t width_bytes, uint16_t height, bool ink_lit)
+{
+    std::vector<uint8_t> out;
+    uint8_t line[PreviewScaler::ROW_BYTES];
+    scaler.begin(width_bytes, ink_lit);
+    for (uint16_t y = 0; y < height; y++) {
+        if (scaler.addRow(&image[(size_t)y * width_bytes], line)) {
+            out.insert(out.end(), line, line + sizeof(line));
+        }
+    }
+    if (scaler.flush(line)) {
+        out.insert(out.end(), line, line + sizeof(line));
+    }
+    return out;
+}
+
+static bool scalerChecks()
+{
+    const struct {
+        uint16_t width_bytes;
+        const char* note;
+    } WIDTHS[] = {
+        {48, "384 dots, exact"},
+        {72, "576 dots, cropped"},
+        {30, "240 dots, centered"},
+        {47, "376 dots, partial group"},
+    };
+    const uint16_t HEIGHTS[] = {384, 385, 386, 1};
+    const int DENSITIES[] = {0, 40, 128, 220, 256};
+    PreviewScaler scaler;
+    bool ok = true;
+    uint32_t seed = 1;
+    for (const auto& w : WIDTHS) {
+        int cases = 0;
+        int bad = 0;
+        for (uint16_t height : HEIGHTS) {
+            for (int density : DENSITIES) {
+                for (bool ink_lit : {true, false}) {
+                    std::vector<uint8_t> image = randomImage(w.width_bytes, height, density, seed++);
+                    bool match = scale(scaler, image, w.width_bytes, height, ink_lit)
+                                 == referencePreview(image, w.width_bytes, height, ink_lit);
+                    cases++;
+                    bad += match ? 0 : 1;
+                }
+            }
+        }
+        printf("scaler %-24s %3d cases %s\n", w.note, cases, bad ? "MISMATCH" : "match reference");
+        ok = ok && bad == 0;
+    }
+    
+    // Cost per printer row on this machine
+    std::vector<uint8_t> image = noisyImage(384);
+    uint8_t line[PreviewScaler::ROW_BYTES];
+    const int passes = 2000;
+    uint32_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        scaler.begin(WIDTH_BYTES);
+        for (int y = 0; y < 384; y++) {
+            if (scaler.addRow(&image[(size_t)y * WIDTH_BYTES], line)) {
+                sink += line[pass & 63];
+            }
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count()
+                / ((double)passes * 384);
+    printf("scaler cost on the host: %.0f ns per printer row, %.2f us per 24-row band (%u)\n\n", ns,
+           ns * 24 / 1000.0, (unsigned)(sink & 1));
+    return ok;
+}
+
+// A noisy 384-dot sticker printed through the pipeline, with or without
+// the preview on the panel
+struct Device {
+    std::unique_ptr<SimPrinter> model;
+    std::unique_ptr<ThermalPrinter> printer;
+    std::unique_ptr<PrintQueue> queue;
+    std::unique_ptr<StickerPipeline> pipeline;
+    SemaphoreHandle_t done;
+    std::atomic<bool> ok;
+    
+    Device()
+        : done(xSemaphoreCreateBinary())
+        , ok(false)
+    {
+    }
+    
+    ~Device()
+    {
+        pipeline.reset();
+        queue.reset();
+        printer.reset();
+        model.reset();
+        vSemaphoreDelete(done);
+    }
+};
+
+static bool boot(Device& dev, uint32_t baud, PrintPreview* preview)
+{
+    dev.model.reset(new SimPrinter(UART_NUM_1, baud));
+    dev.model->attach();
+    dev.printer.reset(new ThermalPrinter(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18, (int)baud));
+    dev.queue.reset(new PrintQueue(*dev.printer, 4));
+    dev.pipeline.reset(new StickerPipeline(*dev.queue));
+    Device* d = &dev;
+    dev.pipeline->setCallback([d](uint32_t, bool ok) {
+        d->ok = ok;
+        xSemaphoreGive(d->done);
+    });
+    dev.pipeline->setObserver(preview);
+    if (!dev.printer->begin() || !dev.queue->begin() || !dev.pipeline->begin()) {
+        return false;
+    }
+    dev.printer->waitTxDone();
+    Sim::sleepUntil(dev.model->getStats().busy_until_us);
+    Sim::uartClearTx(UART_NUM_1);
+    return true;
+}
+
+struct Run {
+    double total_ms;        // Head finished, from open()
+    bool ok;
+    bool intact;
+    uint64_t bus_us;
+};
+
+static Run printSticker(uint32_t baud, const std::vector<uint8_t>& image, uint16_t height,
+                        PrintPreview* preview)
+{
+    Run run = {};
+    Device dev;
+    if (!boot(dev, baud, preview)) {
+        return run;
+    }
+    std::vector<uint8_t> pvr = encodePvr(image, height);
+    uint64_t bus0 = Sim::i2cBusTimeUs(I2C_NUM_0);
+    int64_t start_us = Sim::now();
+    bool written = dev.pipeline->open(portMAX_DELAY);
+    for (size_t pos = 0; written && pos < pvr.size(); pos += NET_CHUNK) {
+        written = dev.pipeline->write(pvr.data() + pos, std::min(NET_CHUNK, pvr.size() - pos), portMAX_DELAY);
+    }
+    dev.pipeline->close(written);
+    run.ok = written && xSemaphoreTake(dev.done, pdMS_TO_TICKS(60000)) == pdTRUE && dev.ok;
+    dev.printer->waitTxDone();
+    int64_t head_us = dev.model->getStats().busy_until_us;
+    run.total_ms = (head_us - start_us) / 1000.0;
+    run.intact = dev.model->raster() == image;
+    Sim::sleepUntil(head_us);
+    run.bus_us = Sim::i2cBusTimeUs(I2C_NUM_0) - bus0;
+    return run;
+}
+
+// What the panel shows, top row first: GDDRAM from the start line
+static std::vector<uint8_t> shown(const PanelModel& panel)
+{
+    std::vector<uint8_t> rows(128 * 64);
+    for (int r = 0; r < 128; r++) {
+        memcpy(&rows[r * 64], panel.ram() + ((panel.startLine() + r) & 127) * 64, 64);
+    }
+    return rows;
+}
+
+// The reference preview's last 128 lines, drawn top down on a dark panel
+static std::vector<uint8_t> expectedPanel(const std::vector<uint8_t>& image, uint16_t height)
+{
+    std::vector<uint8_t> lines = referencePreview(image, WIDTH_BYTES, height, true);
+    size_t count = lines.size() / 64;
+    size_t first = count > 128 ? count - 128 : 0;
+    std::vector<uint8_t> rows(128 * 64, 0);
+    std::copy(lines.begin() + first * 64, lines.end(), rows.begin());
+    return rows;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = 115200;
+    uint32_t freq = 400000;
+    std::vector<uint16_t> heights = {300, 900};
+    double time_scale = 10;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--baud" && has_value) {
+            baud = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--freq" && has_value) {
+            freq = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--rows" && has_value) {
+            heights.clear();
+            for (char* p = strtok(argv[++i], ","); p; p = strtok(nullptr, ",")) {
+                heights.push_back((uint16_t)atoi(p));
+            }
+        } else if (arg == "--scale" && has_value) {
+            time_scale = atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--baud N] [--freq HZ] [--rows A,B] [--scale S] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_ERROR);
+    }
+    Sim::setTimeScale(time_scale);
+    
+    bool ok = scalerChecks();
+    
+    PanelModel panel;
+    Sim::i2cAttach(I2C_NUM_0, SSD1327::DEFAULT_ADDRESS, &panel);
+    I2CManager i2c(GPIO_NUM_41, GPIO_NUM_42, freq);
+    SSD1327 oled(i2c);
+    if (!i2c.begin() || !oled.begin()) {
+        fprintf(stderr, "Panel init failed\n");
+        return 1;
+    }
+    
+    printf("%u baud, I2C %u Hz, push every %u lines\n", (unsigned)baud, (unsigned)freq,
+           (unsigned)PrintPreview::DEFAULT_CONFIG.push_lines);
+    printf("%6s %-9s %9s %6s %6s %8s %8s %7s %s\n", "rows", "preview", "total ms", "lines", "pushes",
+           "put off", "bus ms", "raster", "panel");
+    for (uint16_t height : heights) {
+        std::vector<uint8_t> image = noisyImage(height);
+        Run plain = printSticker(baud, image, height, nullptr);
+        printf("%6u %-9s %9.1f %6s %6s %8s %8s %7s\n", (unsigned)height, "off", plain.total_ms, "", "", "",
+               "", plain.ok && plain.intact ? "ok" : "BROKEN");
+        
+        PrintPreview preview(oled);
+        Run live = printSticker(baud, image, height, &preview);
+        while (oled.isFlushing()) {
+            Sim::sleepUntil(Sim::now() + 100);
+        }
+        bool synced = memcmp(panel.ram(), oled.buffer(), SSD1327::BUFFER_SIZE) == 0
+                      && panel.startLine() == oled.startLine();
+        bool correct = shown(panel) == expectedPanel(image, height);
+        const PrintPreview::Stats& stats = preview.getStats();
+        printf("%6u %-9s %9.1f %6u %6u %8u %8.1f %7s %s\n", (unsigned)height, "on", live.total_ms,
+               (unsigned)stats.lines, (unsigned)stats.pushes, (unsigned)stats.skipped, live.bus_us / 1000.0,
+               live.ok && live.intact ? "ok" : "BROKEN",
+               synced && correct ? "matches" : synced ? "WRONG IMAGE" : "OUT OF SYNC");
+        
+        // The head must not wait on the preview (1% for scheduling noise)
+        bool slower = live.total_ms > plain.total_ms * 1.01;
+        if (slower) {
+            printf("  preview slowed the print by %.1f ms\n", live.total_ms - plain.total_ms);
+        }
+        ok = ok && plain.ok && plain.intact && live.ok && live.intact && synced && correct && !slower;
+    }
+    printf("(put off: pushes skipped while the previous one was still on the bus)\n");
+    printf("%s\n", ok ? "Preview matches the reference and leaves the printer alone" : "PREVIEW PROBLEMS");
+    return ok ? 0 : 1;
+}
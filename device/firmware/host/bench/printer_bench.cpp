@@ -0,0 +1,249 @@
+/*
+ * printer_bench.cpp
+ * Raster print throughput and pacing through ThermalPrinter + PrintQueue
+ * on the simulated UART
+ *
+ * Usage:
+ *   printer_bench [options] [run1.final.bitmap.bin ...]
+ *     --baud N          UART and printer baud rate (9600)
+ *     --band-rows A,B   Band sizes to compare (8,16,24,32)
+ *     --rows N          Synthetic image height when no file is given (480)
+ *     --scale S         Simulated time runs S times faster than real (10);
+ *                       host scheduling delays are magnified by S too
+ *     --no-status       Printer TX not wired: pacing runs on the model only
+ *     --no-blank-feeds  Send blank rows as raster instead of ESC J feeds
+ *     --dump FILE       Write the last run's UART byte stream to FILE
+ *     --verbose         Keep driver INFO logs
+ *     --trace           Print the Chrome trace at the end (needs a
+ *                       -DPEGAVOX_TRACE=ON build; see scripts/trace_extract.py)
+ *
+ * Each run prints one raster job (plus feed and cut) and reports the bytes
+ * sent, the blank rows fed instead and the wire time that saved, how busy
+ * the wire was between the first and last byte, idle gaps, the printer's
+ * peak input buffer use and overflow, when the paper would be finished,
+ * and whether the printer model received the image intact.
+ */
+
+#include "PrintQueue.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "ThermalPrinter.hpp"
+#include "Trace.hpp"
+#include "freertos/semphr.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr uint16_t WIDTH_BYTES = 48;
+
+struct Image {
+    std::string name;
+    std::vector<uint8_t> rows;
+    uint16_t height;
+};
+
+static bool loadBitmap(const std::string& path, Image& image)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    image.rows.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        image.rows.insert(image.rows.end(), buf, buf + n);
+    }
+    fclose(f);
+    image.name = path.substr(path.find_last_of('/') + 1);
+    image.height = (uint16_t)(image.rows.size() / WIDTH_BYTES);
+    image.rows.resize((size_t)image.height * WIDTH_BYTES);
+    return image.height > 0;
+}
+
+// Ordered-dithered radial gradient: busy rows with some white space
+static Image syntheticImage(uint16_t height)
+{
+    static const uint8_t BAYER[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+    Image image;
+    image.name = "synthetic";
+    image.height = height;
+    image.rows.assign((size_t)height * WIDTH_BYTES, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < WIDTH_BYTES * 8; x++) {
+            int dx = x - WIDTH_BYTES * 4;
+            int dy = y - height / 2;
+            int d2 = dx * dx + dy * dy;
+            int level = d2 > 180 * 180 ? 0 : 16 - d2 * 16 / (180 * 180);
+            if (level > BAYER[y & 3][x & 3]) {
+                image.rows[(size_t)y * WIDTH_BYTES + x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+    return image;
+}
+
+static void jobDone(uint32_t, bool, void* done)
+{
+    xSemaphoreGive(static_cast<SemaphoreHandle_t>(done));
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = 9600;
+    std::vector<uint16_t> band_rows = {8, 16, 24, 32};
+    uint16_t synthetic_rows = 480;
+    double scale = 10;
+    bool status = true;
+    bool blank_feeds = true;
+    bool verbose = false;
+    bool trace = false;
+    const char* dump_path = nullptr;
+    std::vector<Image> images;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--baud" && has_value) {
+            baud = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--band-rows" && has_value) {
+            band_rows.clear();
+            for (char* p = strtok(argv[++i], ","); p; p = strtok(nullptr, ",")) {
+                band_rows.push_back((uint16_t)atoi(p));
+            }
+        } else if (arg == "--rows" && has_value) {
+            synthetic_rows = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--scale" && has_value) {
+            scale = atof(argv[++i]);
+        } else if (arg == "--dump" && has_value) {
+            dump_path = argv[++i];
+        } else if (arg == "--no-status") {
+            status = false;
+        } else if (arg == "--no-blank-feeds") {
+            blank_feeds = false;
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--trace") {
+            trace = true;
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "Usage: %s [--baud N] [--band-rows A,B] [--rows N] [--scale S] "
+                    "[--no-status] [--no-blank-feeds] [--dump FILE] [--verbose] [--trace] "
+                    "[bitmap.bin ...]\n", argv[0]);
+            return 1;
+        } else {
+            Image image;
+            if (!loadBitmap(arg, image)) {
+                fprintf(stderr, "Cannot read %s\n", arg.c_str());
+                return 1;
+            }
+            images.push_back(image);
+        }
+    }
+    if (images.empty()) {
+        images.push_back(syntheticImage(synthetic_rows));
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_WARN);
+    }
+    Sim::setTimeScale(scale);
+    
+    std::unique_ptr<SimPrinter> model(new SimPrinter(UART_NUM_1, baud));
+    model->setStatusReplies(status);
+    model->attach();
+    
+    ThermalPrinter printer(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18, (int)baud);
+    PrintQueue queue(printer, 4);
+    if (!printer.begin() || !queue.begin()) {
+        fprintf(stderr, "Printer setup failed\n");
+        return 1;
+    }
+    printer.setBlankFeeds(blank_feeds);
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    double byte_us = Sim::uartByteUs(UART_NUM_1);
+    
+    printf("%u baud (%.0f us/byte), status replies %s, time x%.0f\n",
+           (unsigned)baud, byte_us, printer.hasStatus() ? "on" : "off", scale);
+    printf("%-20s %5s %5s %7s %5s %8s %8s %9s %6s %5s %8s %6s %6s %9s %s\n",
+           "image", "rows", "band", "bytes", "fed", "saved ms", "wire ms", "span ms", "busy%", "gaps",
+           "gap ms", "buf", "ovfl", "paper ms", "raster");
+    
+    for (const Image& image : images) {
+        for (uint16_t rows_per_band : band_rows) {
+            // Start each run with the wire and the mechanism idle and a
+            // fresh printer model
+            printer.waitTxDone();
+            Sim::sleepUntil(model->getStats().busy_until_us);
+            Sim::uartClearTx(UART_NUM_1);
+            model.reset();
+            model.reset(new SimPrinter(UART_NUM_1, baud));
+            model->setStatusReplies(status);
+            model->attach();
+            
+            printer.setBandRows(rows_per_band);
+            PrintJob* job = queue.acquire();
+            if (!job) {
+                fprintf(stderr, "No free job\n");
+                return 1;
+            }
+            job->raster(job->make<BitmapSource>(image.rows.data(), WIDTH_BYTES, image.height), WIDTH_BYTES)
+                .feed(3)
+                .cut();
+            job->onDone(jobDone, done);
+            
+            int64_t submit_us = Sim::now();
+            if (queue.submit(job) == 0) {
+                fprintf(stderr, "Submit failed\n");
+                return 1;
+            }
+            xSemaphoreTake(done, portMAX_DELAY);
+            
+            std::vector<Sim::UartByte> tx = Sim::uartTx(UART_NUM_1);
+            SimPrinter::Stats stats = model->getStats();
+            std::vector<uint8_t> raster = model->raster();
+            if (tx.empty()) {
+                fprintf(stderr, "Nothing was sent\n");
+                return 1;
+            }
+            
+            // Idle time on the wire between the first and last byte
+            uint32_t gaps = 0;
+            double max_gap_us = 0;
+            for (size_t i = 1; i < tx.size(); i++) {
+                double gap = (double)(tx[i].t_us - tx[i - 1].t_us) - byte_us;
+                if (gap > byte_us) {
+                    gaps++;
+                    max_gap_us = gap > max_gap_us ? gap : max_gap_us;
+                }
+            }
+            double wire_us = (double)tx.size() * byte_us;
+            double span_us = (double)(tx.back().t_us - tx.front().t_us) + byte_us;
+            
+            bool intact = raster == image.rows;
+            const ThermalPrinter::RasterStats& raster_stats = printer.getRasterStats();
+            
+            printf("%-20.20s %5u %5u %7zu %5u %8.1f %8.1f %9.1f %6.1f %5u %8.1f %6u %6u %9.1f %s\n",
+                   image.name.c_str(), (unsigned)image.height, (unsigned)rows_per_band, tx.size(),
+                   (unsigned)raster_stats.blank_rows, raster_stats.saved_us / 1000.0, wire_us / 1000,
+                   span_us / 1000, 100 * wire_us / span_us, (unsigned)gaps, max_gap_us / 1000,
+                   (unsigned)stats.max_buffered, (unsigned)stats.overflowed,
+                   (stats.busy_until_us - submit_us) / 1000.0, intact ? "ok" : "MISMATCH");
+            
+            if (dump_path) {
+                FILE* f = fopen(dump_path, "wb");
+                if (f) {
+                    for (const Sim::UartByte& b : tx) {
+                        fputc(b.value, f);
+                    }
+                    fclose(f);
+                }
+            }
+        }
+    }
+    if (trace) {
+        Trace::dump();
+    }
+    return 0;
+}
@@ -0,0 +1,309 @@
+/*
+ * profile_bench.cpp
+ * Print time per heating-profile policy and baud rate, and the
+ * throughput model checked against the simulated printer
+ *
+ * Usage:
+ *   profile_bench [options] [run1.final.bitmap.bin ...]
+ *     --bauds A,B       Baud rates to compare (115200,230400,460800)
+ *     --band-rows N     Rows per band (ThermalPrinter::DEFAULT_BAND_ROWS)
+ *     --rows N          Synthetic image height when no file is given (480)
+ *     --scale S         Simulated time runs S times faster than real (10)
+ *
+ * Without files it prints four synthetic images: sparse line art, the
+ * dithered gradient of printer_bench, a mostly solid image and a mixed
+ * one (line art over a solid block). Each image goes through
+ * ThermalPrinter once per baud rate and policy (power-on settings, a
+ * fixed profile, or per-band selection) and reports the profile
+ * changes, the highest per-line load (PrintProfile::load, limit
+ * LOAD_LIMIT_DOTS), the print time the ThroughputModel predicts, the
+ * print time the simulated printer took, the model's error and whether
+ * the printer model received the image intact.
+ */
+
+#include "PrintProfile.hpp"
+#include "RasterSource.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "ThermalPrinter.hpp"
+#include "esp_log.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr uint16_t WIDTH_BYTES = 48;
+static constexpr int WIDTH_DOTS = WIDTH_BYTES * 8;
+static constexpr uint32_t TX_RING_BYTES = 1024;     // ThermalPrinter::UART_BUF_SIZE
+static constexpr uint32_t TICK_US = 1000000 / configTICK_RATE_HZ;
+
+struct Image {
+    std::string name;
+    std::vector<uint8_t> rows;
+    uint16_t height;
+    
+    void set(int x, int y)
+    {
+        if (x >= 0 && x < WIDTH_DOTS && y >= 0 && y < height) {
+            rows[(size_t)y * WIDTH_BYTES + x / 8] |= 0x80 >> (x & 7);
+        }
+    }
+};
+
+struct Policy {
+    const char* name;
+    const PrintProfile* profile;    // nullptr = per band
+};
+
+static bool loadBitmap(const std::string& path, Image& image)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    image.rows.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        image.rows.insert(image.rows.end(), buf, buf + n);
+    }
+    fclose(f);
+    image.name = path.substr(path.find_last_of('/') + 1);
+    image.height = (uint16_t)(image.rows.size() / WIDTH_BYTES);
+    image.rows.resize((size_t)image.height * WIDTH_BYTES);
+    return image.height > 0;
+}
+
+static Image blankImage(const char* name, uint16_t height)
+{
+    Image image;
+    image.name = name;
+    image.height = height;
+    image.rows.assign((size_t)height * WIDTH_BYTES, 0);
+    return image;
+}
+
+// Outlines two dots wide: circles, a frame and a few diagonals, the way
+// a coloring-book sticker prints
+static void drawLineArt(Image& image, int top, int height)
+{
+    for (int y = top; y < top + height; y++) {
+        for (int x = 0; x < WIDTH_DOTS; x++) {
+            int ly = y - top;
+            bool frame = x < 2 || x >= WIDTH_DOTS - 2 || ly < 2 || ly >= height - 2;
+            bool diagonal = std::abs((x - ly) % 97) < 2;
+            bool ring = false;
+            for (int c = 0; c < 3; c++) {
+                int dx = x - (70 + c * 120);
+                int dy = ly - height / 2;
+                int r = 40 + c * 10;
+                int d2 = dx * dx + dy * dy;
+                ring = ring || (d2 >= (r - 1) * (r - 1) && d2 <= (r + 1) * (r + 1));
+            }
+            if (frame || diagonal || ring) {
+                image.set(x, y);
+            }
+        }
+    }
+}
+
+static Image lineArtImage(uint16_t height)
+{
+    Image image = blankImage("line-art", height);
+    drawLineArt(image, 0, height);
+    return image;
+}
+
+// Ordered-dithered radial gradient, as printer_bench
+static Image gradientImage(uint16_t height)
+{
+    static const uint8_t BAYER[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+    Image image = blankImage("gradient", height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < WIDTH_DOTS; x++) {
+            int dx = x - WIDTH_DOTS / 2;
+            int dy = y - height / 2;
+            int d2 = dx * dx + dy * dy;
+            int level = d2 > 180 * 180 ? 0 : 16 - d2 * 16 / (180 * 180);
+            if (level > BAYER[y & 3][x & 3]) {
+                image.set(x, y);
+            }
+        }
+    }
+    return image;
+}
+
+// Black silhouette filling most of the width with a white border
+static void drawSolid(Image& image, int top, int height)
+{
+    for (int y = top + 8; y < top + height - 8; y++) {
+        for (int x = 8; x < WIDTH_DOTS - 8; x++) {
+            int dx = (x - WIDTH_DOTS / 2) / 2;
+            int dy = y - top - height / 2;
+            if (dx * dx + dy * dy < (height / 2 - 8) * (height / 2 - 8) || (y / 16) % 4 == 0) {
+                image.set(x, y);
+            }
+        }
+    }
+}
+
+static Image solidImage(uint16_t height)
+{
+    Image image = blankImage("solid", height);
+    drawSolid(image, 0, height);
+    return image;
+}
+
+static Image mixedImage(uint16_t height)
+{
+    Image image = blankImage("mixed", height);
+    drawLineArt(image, 0, height * 2 / 3);
+    drawSolid(image, height * 2 / 3, height - height * 2 / 3);
+    return image;
+}
+
+static ThroughputModel::Result predict(const Image& image, uint32_t baud, uint16_t band_rows,
+                                       const PrintProfile* profile)
+{
+    ThroughputModel::Config config = {
+        baud,
+        band_rows,
+        ThermalPrinter::DEFAULT_TIMING.feed_dot_us,
+        ThermalPrinter::DEFAULT_TIMING.max_ahead_us,
+        ThermalPrinter::DEFAULT_TIMING.buffer_bytes,
+        TX_RING_BYTES,
+        TICK_US,
+    };
+    ThroughputModel model(config, profile);
+    for (uint16_t y = 0; y < image.height; y++) {
+        model.addRow(image.rows.data() + (size_t)y * WIDTH_BYTES, WIDTH_BYTES);
+    }
+    return model.finish();
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<uint32_t> bauds = {115200, 230400, 460800};
+    uint16_t band_rows = ThermalPrinter::DEFAULT_BAND_ROWS;
+    uint16_t synthetic_rows = 480;
+    double scale = 10;
+    std::vector<Image> images;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--bauds" && has_value) {
+            bauds.clear();
+            for (char* p = strtok(argv[++i], ","); p; p = strtok(nullptr, ",")) {
+                bauds.push_back((uint32_t)atoi(p));
+            }
+        } else if (arg == "--band-rows" && has_value) {
+            band_rows = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--rows" && has_value) {
+            synthetic_rows = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--scale" && has_value) {
+            scale = atof(argv[++i]);
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "Usage: %s [--bauds A,B] [--band-rows N] [--rows N] [--scale S] "
+                    "[bitmap.bin ...]\n", argv[0]);
+            return 1;
+        } else {
+            Image image;
+            if (!loadBitmap(arg, image)) {
+                fprintf(stderr, "Cannot read %s\n", arg.c_str());
+                return 1;
+            }
+            images.push_back(image);
+        }
+    }
+    if (images.empty()) {
+        images.push_back(lineArtImage(synthetic_rows));
+        images.push_back(gradientImage(synthetic_rows));
+        images.push_back(solidImage(synthetic_rows));
+        images.push_back(mixedImage(synthetic_rows));
+    }
+    esp_log_level_set("*", ESP_LOG_WARN);
+    Sim::setTimeScale(scale);
+    
+    const Policy policies[] = {
+        {"power-on", &PrintProfiles::POWER_ON},
+        {"normal", &PrintProfiles::NORMAL},
+        {"dense", &PrintProfiles::DENSE},
+        {"auto", nullptr},
+    };
+    
+    printf("%u-row bands, time x%.0f, load limit %u dots\n",
+           (unsigned)band_rows, scale, (unsigned)PrintProfile::LOAD_LIMIT_DOTS);
+    printf("%-12s %7s %-9s %5s %7s %5s %9s %9s %9s %6s %s\n",
+           "image", "baud", "policy", "rows", "changes", "load", "head ms", "model ms",
+           "sim ms", "err%", "raster");
+    
+    bool ok = true;
+    double worst_error = 0;
+    for (uint32_t baud : bauds) {
+        std::unique_ptr<SimPrinter> model(new SimPrinter(UART_NUM_1, baud));
+        model->attach();
+        std::unique_ptr<ThermalPrinter> printer(new ThermalPrinter(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18,
+                                                                   (int)baud));
+        if (!printer->begin()) {
+            fprintf(stderr, "Printer setup failed\n");
+            return 1;
+        }
+        printer->setBandRows(band_rows);
+        
+        for (const Image& image : images) {
+            for (const Policy& policy : policies) {
+                // Both sides back at power-on settings, the wire and the
+                // mechanism idle, and a fresh printer model
+                printer->reset();
+                printer->waitTxDone();
+                Sim::sleepUntil(model->getStats().busy_until_us);
+                Sim::uartClearTx(UART_NUM_1);
+                model.reset();
+                model.reset(new SimPrinter(UART_NUM_1, baud));
+                model->attach();
+                
+                printer->setProfile(policy.profile);
+                BitmapSource source(image.rows.data(), WIDTH_BYTES, image.height);
+                if (!printer->printRaster(source, WIDTH_BYTES)) {
+                    fprintf(stderr, "Print failed\n");
+                    return 1;
+                }
+                printer->waitTxDone();
+                
+                std::vector<Sim::UartByte> tx = Sim::uartTx(UART_NUM_1);
+                SimPrinter::Stats stats = model->getStats();
+                if (tx.empty()) {
+                    fprintf(stderr, "Nothing was sent\n");
+                    return 1;
+                }
+                ThroughputModel::Result predicted = predict(image, baud, band_rows, policy.profile);
+                double sim_us = (double)(stats.busy_until_us - tx.front().t_us);
+                double error = 100.0 * (predicted.total_us - sim_us) / sim_us;
+                bool intact = model->raster() == image.rows;
+                bool safe = predicted.peak_load <= PrintProfile::LOAD_LIMIT_DOTS;
+                
+                printf("%-12.12s %7u %-9s %5u %7u %5u %9.1f %9.1f %9.1f %6.1f %s%s\n",
+                       image.name.c_str(), (unsigned)baud, policy.name, (unsigned)predicted.rows,
+                       (unsigned)printer->getRasterStats().profile_changes, (unsigned)predicted.peak_load,
+                       stats.raster_head_us / 1000.0, predicted.total_us / 1000.0, sim_us / 1000.0,
+                       error, intact ? "ok" : "MISMATCH", safe ? "" : " OVERLOAD");
+                
+                worst_error = std::fabs(error) > worst_error ? std::fabs(error) : worst_error;
+                ok = ok && intact && stats.overflowed == 0
+                     && predicted.bytes == printer->getRasterStats().bytes
+                     && predicted.head_us == stats.raster_head_us
+                     && (policy.profile || safe);
+            }
+        }
+        printer.reset();
+        model.reset();
+    }
+    
+    printf("Worst model error %.1f%%\n", worst_error);
+    printf("%s\n", ok ? "All runs consistent" : "INCONSISTENT RUNS");
+    return ok ? 0 : 1;
+}
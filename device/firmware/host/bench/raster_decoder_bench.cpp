@@ -0,0 +1,105 @@
+/*
+ * raster_decoder_bench.cpp
+ * Host benchmark for the PVR1 streaming raster decoder
+ *
+ * Usage:
+ *   raster_decoder_bench run1.final.pvr.bin [more.pvr.bin ...]
+ *
+ * Decodes each file repeatedly through RasterDecoder and reports rows/s and
+ * output MB/s. If the matching .final.bitmap.bin sits next to the file
+ * (scripts/raster_codec_bench.py writes both), the output is verified too.
+ */
+
+#include "RasterDecoder.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static bool loadFile(const std::string& path, std::vector<uint8_t>& out)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s file.pvr.bin [...]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-40s %6s %8s %8s %10s %9s %s\n",
+           "file", "rows", "pvr B", "raw B", "rows/s", "MB/s", "verify");
+
+    for (int i = 1; i < argc; i++) {
+        std::string path = argv[i];
+        std::vector<uint8_t> pvr;
+        if (!loadFile(path, pvr)) {
+            fprintf(stderr, "%s: cannot read\n", path.c_str());
+            return 1;
+        }
+
+        MemoryByteSource probe_src(pvr.data(), pvr.size());
+        RasterDecoder probe;
+        if (!probe.begin(probe_src)) {
+            fprintf(stderr, "%s: not a PVR1 stream\n", path.c_str());
+            return 1;
+        }
+        const uint16_t bpr = probe.widthBytes();
+        const uint16_t height = probe.height();
+
+        // Decode once into memory for verification
+        std::vector<uint8_t> decoded((size_t)bpr * height);
+        uint16_t rows = 0;
+        while (rows < height && probe.readRow(decoded.data() + (size_t)rows * bpr)) {
+            rows++;
+        }
+        if (rows != height) {
+            fprintf(stderr, "%s: stream ended after %u of %u rows\n", path.c_str(), rows, height);
+            return 1;
+        }
+
+        const char* verify = "-";
+        std::string bitmap_path = path;
+        size_t pos = bitmap_path.rfind(".pvr.bin");
+        if (pos != std::string::npos) {
+            std::vector<uint8_t> bitmap;
+            bitmap_path.replace(pos, 8, ".bitmap.bin");
+            if (loadFile(bitmap_path, bitmap)) {
+                bitmap.resize(decoded.size());
+                verify = bitmap == decoded ? "ok" : "MISMATCH";
+            }
+        }
+
+        // Timed decode: rows go to a single band-sized scratch row, as on
+        // the device
+        const int iterations = 200;
+        uint8_t row[RasterDecoder::MAX_WIDTH_BYTES];
+        auto t0 = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            MemoryByteSource src(pvr.data(), pvr.size());
+            RasterDecoder decoder;
+            decoder.begin(src);
+            while (decoder.readRow(row)) {
+            }
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        double total_rows = (double)height * iterations;
+
+        printf("%-40.40s %6u %8zu %8zu %10.0f %9.1f %s\n",
+               path.c_str(), height, pvr.size(), decoded.size(),
+               total_rows / secs, total_rows * bpr / secs / 1e6, verify);
+    }
+    return 0;
+}
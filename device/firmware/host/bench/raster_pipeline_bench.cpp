@@ -0,0 +1,253 @@
+/*
+ * raster_pipeline_bench.cpp
+ * RasterPipeline's gray stream against the files scripts/pipeline.py writes
+ *
+ * Usage:
+ *   python ../../../scripts/bench_fixtures.py gray
+ *   raster_pipeline_bench [options] RUN...
+ *     --printer-width N   As pipeline.py (384)
+ *     --pixelate-width N  As pipeline.py, 0 disables (96)
+ *
+ * A RUN is a prefix such as ../../../scripts/output/fixtures/gray_1024 or
+ * any file of the run (<run>.final.bitmap.bin, ...), so a shell glob over
+ * either directory works. Each run has pipeline.py's printer bitmap,
+ * <run>.final.bitmap.bin, and the rows the device must produce from:
+ *
+ *   - <run>.final.gray.bin, the small pixelated gray image, through the
+ *     Nearest path (what the device gets from the backend)
+ *   - <run>.source.pgm when present (bench_fixtures.py writes one), the
+ *     whole 8-bit image through LANCZOS, pixelate and dither
+ *
+ * Both go through a GraySource one row at a time, as on the device, with
+ * Floyd-Steinberg; every packed row must match the bitmap byte for byte.
+ * Reported: rows, host time per image, and the first differing row.
+ */
+
+#include "RasterPipeline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Rows straight from a buffer, as a network or flash reader would hand them
+class BufferSource : public GraySource {
+public:
+    BufferSource(const std::vector<uint8_t>& pixels, uint16_t width, uint16_t height)
+        : pixels_(pixels)
+        , width_(width)
+        , height_(height)
+        , y_(0)
+    {
+    }
+    
+    bool readRow(uint8_t* row) override
+    {
+        if (y_ == height_) {
+            return false;
+        }
+        memcpy(row, pixels_.data() + (size_t)y_ * width_, width_);
+        y_++;
+        return true;
+    }
+    
+private:
+    const std::vector<uint8_t>& pixels_;
+    uint16_t width_;
+    uint16_t height_;
+    uint16_t y_;
+};
+
+static bool loadFile(const std::string& path, std::vector<uint8_t>& out)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Binary PGM as bench_fixtures.py writes it: "P5\n<w> <h>\n255\n" + pixels
+static bool loadPgm(const std::string& path, std::vector<uint8_t>& pixels, uint16_t* width, uint16_t* height)
+{
+    std::vector<uint8_t> data;
+    if (!loadFile(path, data)) {
+        return false;
+    }
+    unsigned w = 0;
+    unsigned h = 0;
+    unsigned max = 0;
+    int header = 0;
+    std::string text(data.begin(), data.begin() + std::min<size_t>(data.size(), 32));
+    if (sscanf(text.c_str(), "P5 %u %u %u%n", &w, &h, &max, &header) != 3 || max != 255
+        || w == 0 || h == 0 || w > 0xFFFF || h > 0xFFFF) {
+        return false;
+    }
+    header++;   // The single whitespace after maxval
+    if (data.size() < (size_t)header + (size_t)w * h) {
+        return false;
+    }
+    pixels.assign(data.begin() + header, data.begin() + header + (size_t)w * h);
+    *width = (uint16_t)w;
+    *height = (uint16_t)h;
+    return true;
+}
+
+// Run prefix from any of the run's files
+static std::string runPrefix(std::string arg)
+{
+    static const char* const SUFFIXES[] = {
+        ".final.bitmap.bin", ".final.gray.bin", ".final.escpos.bin", ".source.pgm", ".generated.png",
+    };
+    for (const char* suffix : SUFFIXES) {
+        size_t len = strlen(suffix);
+        if (arg.size() > len && arg.compare(arg.size() - len, len, suffix) == 0) {
+            return arg.substr(0, arg.size() - len);
+        }
+    }
+    return arg;
+}
+
+struct Result {
+    bool ran;
+    bool ok;
+    uint16_t rows;
+    int first_diff;         // Row, -1 if none
+    double ms;
+};
+
+static Result render(GraySource& source, const RasterPipeline::Config& config, const std::vector<uint8_t>& bitmap)
+{
+    Result result = {true, false, 0, -1, 0};
+    RasterPipeline pipeline;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!pipeline.begin(source, config)) {
+        return result;
+    }
+    size_t bpr = pipeline.widthBytes();
+    std::vector<uint8_t> row(bpr);
+    std::vector<uint8_t> out;
+    out.reserve(bitmap.size());
+    while (pipeline.readRow(row.data())) {
+        out.insert(out.end(), row.begin(), row.end());
+    }
+    pipeline.end();
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    result.rows = (uint16_t)(out.size() / bpr);
+    for (size_t y = 0; y * bpr < std::min(out.size(), bitmap.size()); y++) {
+        if (memcmp(out.data() + y * bpr, bitmap.data() + y * bpr, bpr) != 0) {
+            result.first_diff = (int)y;
+            break;
+        }
+    }
+    if (result.first_diff < 0 && out.size() != bitmap.size()) {
+        result.first_diff = (int)(std::min(out.size(), bitmap.size()) / bpr);
+    }
+    result.ok = result.first_diff < 0;
+    return result;
+}
+
+static std::string describe(const Result& r)
+{
+    if (!r.ran) {
+        return "-";
+    }
+    char buf[64];
+    if (r.ok) {
+        snprintf(buf, sizeof(buf), "ok %.2f ms", r.ms);
+    } else if (r.rows == 0) {
+        snprintf(buf, sizeof(buf), "BEGIN FAILED");
+    } else {
+        snprintf(buf, sizeof(buf), "DIFFERS at row %d", r.first_diff);
+    }
+    return buf;
+}
+
+int main(int argc, char** argv)
+{
+    uint16_t printer_width = 384;
+    uint16_t pixelate_width = 96;
+    std::vector<std::string> runs;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--printer-width" && has_value) {
+            printer_width = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--pixelate-width" && has_value) {
+            pixelate_width = (uint16_t)atoi(argv[++i]);
+        } else if (arg[0] != '-') {
+            std::string run = runPrefix(arg);
+            if (runs.empty() || runs.back() != run) {
+                runs.push_back(run);
+            }
+        } else {
+            runs.clear();
+            break;
+        }
+    }
+    if (runs.empty() || printer_width == 0) {
+        fprintf(stderr, "Usage: %s [--printer-width N] [--pixelate-width N] RUN...\n"
+                "Write runs with: python scripts/bench_fixtures.py gray\n", argv[0]);
+        return 1;
+    }
+    
+    // pixelate_small_gray() keeps the resized image when pixelate is off
+    uint16_t small_width = pixelate_width > 0 && pixelate_width < printer_width ? pixelate_width : printer_width;
+    size_t bpr = (printer_width + 7) / 8;
+    bool all_ok = true;
+    int checked = 0;
+    printf("%-28s %11s %5s  %-22s %s\n", "run", "source", "rows", "nearest (gray.bin)", "lanczos (source.pgm)");
+    for (const std::string& run : runs) {
+        std::string name = run.substr(run.find_last_of('/') + 1);
+        std::vector<uint8_t> bitmap;
+        std::vector<uint8_t> small;
+        if (!loadFile(run + ".final.bitmap.bin", bitmap) || bitmap.empty() || bitmap.size() % bpr != 0
+            || !loadFile(run + ".final.gray.bin", small) || small.empty() || small.size() % small_width != 0) {
+            printf("%-28s missing or mis-sized .final.bitmap.bin / .final.gray.bin\n", name.c_str());
+            all_ok = false;
+            continue;
+        }
+        uint16_t out_height = (uint16_t)(bitmap.size() / bpr);
+        
+        uint16_t small_height = (uint16_t)(small.size() / small_width);
+        BufferSource small_source(small, small_width, small_height);
+        RasterPipeline::Config nearest = {
+            RasterPipeline::Resample::Nearest, small_width, small_height, printer_width, out_height, 0, 1,
+            RasterPipeline::Dither::FloydSteinberg,
+        };
+        Result near = render(small_source, nearest, bitmap);
+        
+        Result full = {false, true, 0, -1, 0};
+        std::vector<uint8_t> pixels;
+        uint16_t width = 0;
+        uint16_t height = 0;
+        char source_size[16] = "-";
+        if (loadPgm(run + ".source.pgm", pixels, &width, &height)) {
+            BufferSource source(pixels, width, height);
+            RasterPipeline::Config lanczos = {
+                RasterPipeline::Resample::Lanczos, width, height, printer_width, 0, pixelate_width, 1,
+                RasterPipeline::Dither::FloydSteinberg,
+            };
+            full = render(source, lanczos, bitmap);
+            snprintf(source_size, sizeof(source_size), "%ux%u", (unsigned)width, (unsigned)height);
+        }
+        
+        all_ok = all_ok && near.ok && full.ok;
+        checked++;
+        printf("%-28s %11s %5u  %-22s %s\n", name.c_str(), source_size, (unsigned)out_height,
+               describe(near).c_str(), describe(full).c_str());
+    }
+    
+    printf("\n%d of %zu runs checked -> %s\n", checked, runs.size(), all_ok ? "ok" : "MISMATCH");
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+/*
+ * spool_bench.cpp
+ * Flash print spool: power cuts mid-print and mid-write, ring wear and
+ * printing while the network side writes, on simulated flash and UART
+ *
+ * Usage:
+ *   spool_bench [options]
+ *     --baud N          UART and printer baud rate (115200)
+ *     --rows N          Synthetic image height (480)
+ *     --cuts A,B        Power cut points in % of the uncut raster time (20,50,80)
+ *     --spool-kb N      Spool partition size (256)
+ *     --laps N          Ring laps for the wear test (3)
+ *     --scale S         Simulated time runs S times faster than real (10)
+ *     --verbose         Keep driver INFO logs
+ *
+ * Resume runs spool a PVR1 sticker, start printing it, cut the power
+ * (flash, printer and tasks all stop at that instant), reboot, and check
+ * that the job resumes at or before the last row the printer model had
+ * finished and that the rest arrives intact. Rows between the resume
+ * point and the cut are printed twice; none may be missing.
+ */
+
+#include "PrintQueue.hpp"
+#include "PrintSpool.hpp"
+#include "Sim.hpp"
+#include "SimPrinter.hpp"
+#include "ThermalPrinter.hpp"
+#include "bench_raster.hpp"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr uint8_t SPOOL_SUBTYPE = 0x40;      // As in partitions.csv
+static constexpr size_t NET_CHUNK = 1460;           // One TCP segment per write()
+
+// Writes a record the way a network fetch would: one segment at a time
+static uint32_t spoolRecord(PrintSpool& spool, const std::vector<uint8_t>& pvr)
+{
+    if (!spool.open()) {
+        return 0;
+    }
+    for (size_t pos = 0; pos < pvr.size(); pos += NET_CHUNK) {
+        size_t n = std::min(NET_CHUNK, pvr.size() - pos);
+        if (!spool.write(pvr.data() + pos, n)) {
+            spool.abort();
+            return 0;
+        }
+    }
+    return spool.commit();
+}
+
+// Everything that a power cut takes down
+struct Device {
+    std::unique_ptr<SimPrinter> model;
+    std::unique_ptr<ThermalPrinter> printer;
+    std::unique_ptr<PrintQueue> queue;
+    std::unique_ptr<PrintSpool> spool;
+    SemaphoreHandle_t done;
+    std::atomic<int64_t> mark_max_us;
+    
+    Device()
+        : done(xSemaphoreCreateBinary())
+        , mark_max_us(0)
+    {
+    }
+};
+
+static bool boot(Device& dev, uint32_t baud)
+{
+    dev.model.reset(new SimPrinter(UART_NUM_1, baud));
+    dev.model->attach();
+    dev.spool.reset(new PrintSpool());
+    dev.printer.reset(new ThermalPrinter(UART_NUM_1, GPIO_NUM_17, GPIO_NUM_18, (int)baud));
+    dev.queue.reset(new PrintQueue(*dev.printer, 4));
+    return dev.spool->begin() && dev.printer->begin() && dev.queue->begin();
+}
+
+// Stop everything where it stands: no flash write completes after this
+static void powerCut(Device& dev)
+{
+    Sim::flashCutAfter(0);
+    dev.queue.reset();
+    dev.printer.reset();
+    dev.spool.reset();
+    dev.model->detach();
+    Sim::flashRestore();
+}
+
+// What the job's callbacks need, in the job's arena next to its source
+struct SpooledJob {
+    Device* dev;
+    const SpoolSource* source;
+};
+
+static void onSpooledRows(uint32_t rows, void* ctx)
+{
+    const SpooledJob* sj = static_cast<const SpooledJob*>(ctx);
+    int64_t t0 = esp_timer_get_time();
+    sj->dev->spool->markPrinted(sj->source->record().id, sj->source->firstRow() + rows);
+    int64_t us = esp_timer_get_time() - t0;
+    if (us > sj->dev->mark_max_us.load()) {
+        sj->dev->mark_max_us.store(us);
+    }
+}
+
+static void onSpooledDone(uint32_t, bool ok, void* ctx)
+{
+    const SpooledJob* sj = static_cast<const SpooledJob*>(ctx);
+    if (ok) {
+        sj->dev->spool->markDone(sj->source->record().id);
+    }
+    xSemaphoreGive(sj->dev->done);
+}
+
+// Same job as submitSpooled() in src/main.cpp
+static bool submitSpooled(Device& dev, const PrintSpool::Record& record)
+{
+    PrintJob* job = dev.queue->acquire();
+    SpoolSource* source = job ? job->make<SpoolSource>(*dev.spool, record) : nullptr;
+    SpooledJob* sj = source && source->begin() ? job->make<SpooledJob>(SpooledJob{&dev, source}) : nullptr;
+    if (!sj) {
+        if (job) {
+            dev.queue->release(job);
+        }
+        return false;
+    }
+    job->reset()
+        .raster(source, source->widthBytes(), onSpooledRows, sj)
+        .feed(3)
+        .cut();
+    job->onDone(onSpooledDone, sj);
+    return dev.queue->submit(job) != 0;
+}
+
+// The spool task applies marks asynchronously
+static bool waitDrained(PrintSpool& spool)
+{
+    PrintSpool::Record record;
+    for (int i = 0; i < 200; i++) {
+        if (spool.pending(&record, 1) == 0) {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = 115200;
+    uint16_t height = 480;
+    std::vector<int> cuts = {20, 50, 80};
+    size_t spool_kb = 256;
+    int laps = 3;
+    double scale = 10;
+    bool verbose = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--baud" && has_value) {
+            baud = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--rows" && has_value) {
+            height = (uint16_t)atoi(argv[++i]);
+        } else if (arg == "--cuts" && has_value) {
+            cuts.clear();
+            for (char* p = strtok(argv[++i], ","); p; p = strtok(nullptr, ",")) {
+                cuts.push_back(atoi(p));
+            }
+        } else if (arg == "--spool-kb" && has_value) {
+            spool_kb = (size_t)atoi(argv[++i]);
+        } else if (arg == "--laps" && has_value) {
+            laps = atoi(argv[++i]);
+        } else if (arg == "--scale" && has_value) {
+            scale = atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--baud N] [--rows N] [--cuts A,B] [--spool-kb N] "
+                    "[--laps N] [--scale S] [--verbose]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_WARN);
+    }
+    Sim::setTimeScale(scale);
+    Sim::flashAddPartition("spool", SPOOL_SUBTYPE, spool_kb * 1024);
+    
+    std::vector<uint8_t> image = syntheticImage(height, 0);
+    std::vector<uint8_t> pvr = encodePvr(image, height);
+    bool all_ok = true;
+    printf("%u baud, %u rows (%zu B raw, %zu B PVR1), %zu KB spool, time x%.0f\n\n",
+           (unsigned)baud, (unsigned)height, image.size(), pvr.size(), spool_kb, scale);
+    
+    // Uncut run: raster time reference, and printing while the network
+    // side spools the next sticker. Cuts are placed on the head's time for
+    // the raster rows alone: the trailing feed and cut, and ESC J feeds
+    // for blank rows, would otherwise push late cuts past the last row.
+    int64_t raster_us;
+    {
+        Device dev;
+        if (!boot(dev, baud)) {
+            fprintf(stderr, "Boot failed\n");
+            return 1;
+        }
+        PrintSpool::Record record;
+        uint32_t id = spoolRecord(*dev.spool, pvr);
+        if (!id || dev.spool->pending(&record, 1) != 1) {
+            fprintf(stderr, "Spooling failed\n");
+            return 1;
+        }
+        dev.printer->waitTxDone();
+        Sim::uartClearTx(UART_NUM_1);
+        int64_t start = Sim::now();
+        submitSpooled(dev, record);
+        uint32_t next = spoolRecord(*dev.spool, encodePvr(syntheticImage(height, 1), height));
+        xSemaphoreTake(dev.done, portMAX_DELAY);
+        int64_t print_us = dev.model->getStats().busy_until_us - start;
+        raster_us = dev.model->rowDoneUs(height - 1) - start;
+        
+        std::vector<Sim::UartByte> tx = Sim::uartTx(UART_NUM_1);
+        double byte_us = Sim::uartByteUs(UART_NUM_1);
+        double span_us = (double)(tx.back().t_us - tx.front().t_us) + byte_us;
+        bool intact = dev.model->raster() == image;
+        dev.spool->markDone(next);
+        bool drained = waitDrained(*dev.spool);
+        all_ok = all_ok && intact && next && drained;
+        printf("Print while spooling the next sticker: %.0f ms (raster %.0f ms), "
+               "wire busy %.1f%%, longest mark call %lld us, raster %s\n\n",
+               print_us / 1000.0, raster_us / 1000.0, 100 * tx.size() * byte_us / span_us,
+               (long long)dev.mark_max_us.load(), intact && next && drained ? "ok" : "FAILED");
+    }
+    
+    // Power cut while printing, then resume
+    printf("%5s %9s %7s %7s %9s %s\n", "cut%", "printed", "resume", "twice", "resumed", "result");
+    for (int cut : cuts) {
+        Device dev;
+        if (!boot(dev, baud)) {
+            fprintf(stderr, "Boot failed\n");
+            return 1;
+        }
+        PrintSpool::Record record;
+        uint32_t id = spoolRecord(*dev.spool, pvr);
+        dev.spool->pending(&record, 1);
+        int64_t start = Sim::now();
+        submitSpooled(dev, record);
+        int64_t cut_us = start + raster_us * cut / 100;
+        Sim::sleepUntil(cut_us);
+        powerCut(dev);
+        uint32_t printed = dev.model->rowsPrintedBy(cut_us);
+        
+        Device after;
+        PrintSpool::Record resumed;
+        if (!boot(after, baud) || after.spool->pending(&resumed, 1) != 1 || resumed.id != id) {
+            printf("%5d %9u %7s %7s %9s %s\n", cut, (unsigned)printed, "-", "-", "-", "NOT FOUND");
+            all_ok = false;
+            continue;
+        }
+        submitSpooled(after, resumed);
+        xSemaphoreTake(after.done, portMAX_DELAY);
+        
+        std::vector<uint8_t> rest(image.begin() + (size_t)resumed.resume_row * WIDTH_BYTES, image.end());
+        bool intact = after.model->raster() == rest;
+        bool lost = resumed.resume_row > printed;
+        bool drained = waitDrained(*after.spool);
+        bool ok = intact && !lost && drained;
+        all_ok = all_ok && ok;
+        printf("%5d %9u %7u %7u %9u %s\n", cut, (unsigned)printed, (unsigned)resumed.resume_row,
+               lost ? 0 : (unsigned)(printed - resumed.resume_row),
+               (unsigned)(after.model->raster().size() / WIDTH_BYTES),
+               ok ? "ok" : (lost ? "ROWS LOST" : (intact ? "NOT DONE" : "MISMATCH")));
+    }
+    
+    // Power cut in the middle of spooling: the torn record must vanish
+    {
+        Device dev;
+        boot(dev, baud);
+        Sim::flashCutAfter(pvr.size() / 2);
+        uint32_t id = spoolRecord(*dev.spool, pvr);
+        powerCut(dev);
+        
+        Device after;
+        boot(after, baud);
+        PrintSpool::Record record;
+        size_t pending = after.spool->pending(&record, 1);
+        uint32_t discarded = after.spool->getStats().discarded;
+        uint32_t again = spoolRecord(*after.spool, pvr);
+        bool ok = id == 0 && pending == 0 && discarded >= 1 && again != 0;
+        if (again) {
+            after.spool->markDone(again);
+            ok = waitDrained(*after.spool) && ok;
+        }
+        all_ok = all_ok && ok;
+        printf("\nCut while spooling: %zu pending, %u discarded, next record %s -> %s\n",
+               pending, (unsigned)discarded, again ? "written" : "FAILED", ok ? "ok" : "FAILED");
+    }
+    
+    // Ring laps: print-and-release keeps the ring turning; erases spread evenly
+    {
+        Device dev;
+        boot(dev, baud);
+        std::vector<uint32_t> before = Sim::flashEraseCounts("spool");
+        size_t written = 0;
+        size_t target = spool_kb * 1024 * laps;
+        int records = 0;
+        int64_t spool_us = 0;
+        while (written < target) {
+            int64_t t0 = Sim::now();
+            uint32_t id = spoolRecord(*dev.spool, pvr);
+            spool_us += Sim::now() - t0;
+            if (!id) {
+                fprintf(stderr, "Ring write failed after %d records\n", records);
+                all_ok = false;
+                break;
+            }
+            dev.spool->markDone(id);
+            waitDrained(*dev.spool);
+            written += pvr.size();
+            records++;
+        }
+        std::vector<uint32_t> after = Sim::flashEraseCounts("spool");
+        uint32_t lo = UINT32_MAX;
+        uint32_t hi = 0;
+        for (size_t s = 0; s < after.size(); s++) {
+            uint32_t n = after[s] - before[s];
+            lo = std::min(lo, n);
+            hi = std::max(hi, n);
+        }
+        
+        // Nothing printed: writes must stop before the oldest record
+        int held = 0;
+        while (spoolRecord(*dev.spool, pvr)) {
+            held++;
+        }
+        PrintSpool::Record records_left[PrintSpool::MAX_RECORDS];
+        size_t pending = dev.spool->pending(records_left, PrintSpool::MAX_RECORDS);
+        bool intact = true;
+        std::vector<uint8_t> back(pvr.size());
+        for (size_t i = 0; i < pending; i++) {
+            intact = intact && dev.spool->read(records_left[i], 0, back.data(), back.size()) && back == pvr;
+        }
+        bool ok = hi - lo <= 1 && (size_t)held == pending && intact && held > 0;
+        all_ok = all_ok && ok;
+        printf("Ring: %d records over %d laps, %.1f ms each to spool, sector erases %u..%u; "
+               "full after %d unprinted, all readable -> %s\n",
+               records, laps, spool_us / 1000.0 / (records ? records : 1), (unsigned)lo,
+               (unsigned)hi, held, ok ? "ok" : "FAILED");
+    }
+    
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/*
+ * trim_bench.cpp
+ * SilenceTrimmer against trim_silence_pcm16() in scripts/pipeline.py
+ *
+ * Usage:
+ *   python ../../../scripts/bench_fixtures.py pcm
+ *   trim_bench [options] RUN...
+ *     --rate N          Sample rate of the recordings (16000)
+ *     --chunk N         Samples per process() call (512, AudioUploader's)
+ *
+ * A RUN is <run>.pcm (16-bit little-endian mono) or its prefix, next to
+ * <run>.trimmed.pcm, what the Python function returned for it with
+ * pipeline.py's defaults. Each recording is streamed through the trimmer
+ * three ways:
+ *
+ *   - hold all: hold_ms covers the whole recording, so the output must be
+ *     the Python output sample for sample
+ *   - default: DEFAULT_CONFIG's 600 ms hold. With voice, the Python output
+ *     must be a prefix of it (a longer tail goes out as silence); with no
+ *     voice it must be the recording's last samples
+ *   - uploader: max_gap_ms as AudioUploader sets it; pauses are cut, so
+ *     only the length is reported
+ */
+
+#include "AudioFrontEnd.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static bool loadPcm(const std::string& path, std::vector<int16_t>& out)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    out.clear();
+    uint8_t buf[2];
+    while (fread(buf, 1, 2, f) == 2) {
+        out.push_back((int16_t)(buf[0] | buf[1] << 8));
+    }
+    fclose(f);
+    return true;
+}
+
+static std::vector<int16_t> trim(const std::vector<int16_t>& pcm, const SilenceTrimmer::Config& config,
+                                 size_t chunk, bool* voiced)
+{
+    std::vector<int16_t> out;
+    SilenceTrimmer trimmer;
+    trimmer.begin(config, [&out](const int16_t* samples, size_t count) {
+        out.insert(out.end(), samples, samples + count);
+    });
+    for (size_t pos = 0; pos < pcm.size(); pos += chunk) {
+        trimmer.process(pcm.data() + pos, std::min(chunk, pcm.size() - pos));
+    }
+    trimmer.finish();
+    *voiced = trimmer.voiceDetected();
+    trimmer.end();
+    return out;
+}
+
+static bool startsWith(const std::vector<int16_t>& a, const std::vector<int16_t>& prefix)
+{
+    return a.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), a.begin());
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t rate = 16000;
+    size_t chunk = 512;
+    std::vector<std::string> runs;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--rate" && has_value) {
+            rate = (uint32_t)atoi(argv[++i]);
+        } else if (arg == "--chunk" && has_value) {
+            chunk = (size_t)atoi(argv[++i]);
+        } else if (arg[0] != '-') {
+            if (arg.size() > 12 && arg.compare(arg.size() - 12, 12, ".trimmed.pcm") == 0) {
+                continue;   // Globbed along with the recordings
+            }
+            if (arg.size() > 4 && arg.compare(arg.size() - 4, 4, ".pcm") == 0) {
+                arg.resize(arg.size() - 4);
+            }
+            runs.push_back(arg);
+        } else {
+            runs.clear();
+            break;
+        }
+    }
+    if (runs.empty() || rate == 0 || chunk == 0) {
+        fprintf(stderr, "Usage: %s [--rate N] [--chunk N] RUN...\n"
+                "Write runs with: python scripts/bench_fixtures.py pcm\n", argv[0]);
+        return 1;
+    }
+    
+    auto ms = [rate](size_t samples) { return (double)samples * 1000 / rate; };
+    bool all_ok = true;
+    printf("%-16s %8s %8s  %-10s %-20s %s\n", "run", "in ms", "python", "hold all", "default (600 ms)", "uploader");
+    for (const std::string& run : runs) {
+        std::string name = run.substr(run.find_last_of('/') + 1);
+        std::vector<int16_t> pcm;
+        std::vector<int16_t> expected;
+        if (!loadPcm(run + ".pcm", pcm) || !loadPcm(run + ".trimmed.pcm", expected)) {
+            printf("%-16s missing .pcm / .trimmed.pcm\n", name.c_str());
+            all_ok = false;
+            continue;
+        }
+        
+        bool voiced;
+        SilenceTrimmer::Config config = SilenceTrimmer::DEFAULT_CONFIG;
+        config.sample_rate = rate;
+        config.hold_ms = (uint32_t)ms(pcm.size()) + config.frame_ms;
+        bool exact = trim(pcm, config, chunk, &voiced) == expected;
+        
+        config = SilenceTrimmer::DEFAULT_CONFIG;
+        config.sample_rate = rate;
+        std::vector<int16_t> held = trim(pcm, config, chunk, &voiced);
+        bool prefix = voiced ? startsWith(held, expected)
+                             : held.size() <= pcm.size() && std::equal(held.begin(), held.end(),
+                                                                      pcm.end() - held.size());
+        char extra[32];
+        if (voiced) {
+            snprintf(extra, sizeof(extra), "%s +%.0f ms", prefix ? "ok" : "DIFFERS",
+                     ms(held.size()) - ms(expected.size()));
+        } else {
+            snprintf(extra, sizeof(extra), "%s, last %.0f ms", prefix ? "ok" : "DIFFERS", ms(held.size()));
+        }
+        
+        config.max_gap_ms = 600;
+        std::vector<int16_t> cut = trim(pcm, config, chunk, &voiced);
+        
+        all_ok = all_ok && exact && prefix;
+        printf("%-16s %8.0f %8.0f  %-10s %-20s %.0f ms\n", name.c_str(), ms(pcm.size()), ms(expected.size()),
+               exact ? "ok" : "DIFFERS", extra, ms(cut.size()));
+    }
+    
+    printf("\n%zu runs -> %s\n", runs.size(), all_ok ? "ok" : "MISMATCH");
+    return all_ok ? 0 : 1;
+}
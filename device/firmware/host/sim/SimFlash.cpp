@@ -0,0 +1,193 @@
+/*
+ * SimFlash.cpp
+ * RAM-backed SPI flash partitions for the host simulation
+ */
+
+#include "Sim.hpp"
+#include "SimKernel.hpp"
+#include "esp_partition.h"
+#include <cstring>
+#include <list>
+#include <string>
+
+namespace {
+
+constexpr size_t SECTOR_SIZE = 4096;
+constexpr size_t PAGE_SIZE = 256;
+constexpr int64_t SECTOR_ERASE_US = 45000;     // Typical 4 KB erase
+constexpr int64_t PAGE_PROGRAM_US = 700;       // Typical 256 B page program
+
+struct Partition {
+    esp_partition_t info;
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> erases;   // Per sector
+};
+
+// Stable addresses: drivers keep the esp_partition_t pointer
+std::list<Partition> partitions;
+uint32_t next_address = 0x290000;
+
+// One flash operation at a time, like the SPI flash lock on the device
+std::mutex chip;
+bool cut = false;
+int64_t cut_budget = -1;        // Bytes left to program before the cut
+
+Partition* find(const esp_partition_t* info)
+{
+    for (Partition& p : partitions) {
+        if (&p.info == info) {
+            return &p;
+        }
+    }
+    return nullptr;
+}
+
+bool inRange(const Partition& p, size_t offset, size_t size)
+{
+    return offset <= p.data.size() && size <= p.data.size() - offset;
+}
+
+}  // namespace
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char* label)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    for (Partition& p : partitions) {
+        if ((type == ESP_PARTITION_TYPE_ANY || p.info.type == type)
+            && (subtype == ESP_PARTITION_SUBTYPE_ANY || p.info.subtype == subtype)
+            && (!label || strcmp(p.info.label, label) == 0)) {
+            return &p.info;
+        }
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset,
+                             void* dst, size_t size)
+{
+    std::lock_guard<std::mutex> op(chip);
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Partition* p = find(partition);
+    if (!p || !dst) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!inRange(*p, src_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, p->data.data() + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset,
+                              const void* src, size_t size)
+{
+    std::lock_guard<std::mutex> op(chip);
+    int64_t busy_us;
+    esp_err_t result = ESP_OK;
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        Partition* p = find(partition);
+        if (!p || !src) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (!inRange(*p, dst_offset, size)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (cut) {
+            return ESP_FAIL;
+        }
+
+        size_t len = size;
+        if (cut_budget >= 0 && (int64_t)len > cut_budget) {
+            len = (size_t)cut_budget;
+            cut = true;
+            result = ESP_FAIL;
+        }
+        if (cut_budget >= 0) {
+            cut_budget -= (int64_t)len;
+        }
+        // NOR programming can only clear bits
+        const uint8_t* in = static_cast<const uint8_t*>(src);
+        for (size_t i = 0; i < len; i++) {
+            p->data[dst_offset + i] &= in[i];
+        }
+        size_t pages = size ? (dst_offset + size - 1) / PAGE_SIZE - dst_offset / PAGE_SIZE + 1 : 0;
+        busy_us = (int64_t)pages * PAGE_PROGRAM_US;
+    }
+    SimKernel::sleepUntil(SimKernel::now() + busy_us);
+    return result;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size)
+{
+    std::lock_guard<std::mutex> op(chip);
+    int64_t busy_us;
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        Partition* p = find(partition);
+        if (!p) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (offset % SECTOR_SIZE || size % SECTOR_SIZE) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (!inRange(*p, offset, size)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (cut) {
+            return ESP_FAIL;
+        }
+        memset(p->data.data() + offset, 0xFF, size);
+        for (size_t s = offset / SECTOR_SIZE; s < (offset + size) / SECTOR_SIZE; s++) {
+            p->erases[s]++;
+        }
+        busy_us = (int64_t)(size / SECTOR_SIZE) * SECTOR_ERASE_US;
+    }
+    SimKernel::sleepUntil(SimKernel::now() + busy_us);
+    return ESP_OK;
+}
+
+void Sim::flashAddPartition(const char* label, uint8_t subtype, size_t size)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    size = (size + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+    partitions.emplace_back();
+    Partition& p = partitions.back();
+    p.info = {};
+    p.info.type = ESP_PARTITION_TYPE_DATA;
+    p.info.subtype = (esp_partition_subtype_t)subtype;
+    p.info.address = next_address;
+    p.info.size = (uint32_t)size;
+    strncpy(p.info.label, label, sizeof(p.info.label) - 1);
+    // Fresh chips ship erased
+    p.data.assign(size, 0xFF);
+    p.erases.assign(size / SECTOR_SIZE, 0);
+    next_address += (uint32_t)size;
+}
+
+void Sim::flashCutAfter(size_t bytes)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    cut = bytes == 0;
+    cut_budget = (int64_t)bytes;
+}
+
+void Sim::flashRestore()
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    cut = false;
+    cut_budget = -1;
+}
+
+std::vector<uint32_t> Sim::flashEraseCounts(const char* label)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    for (const Partition& p : partitions) {
+        if (strcmp(p.info.label, label) == 0) {
+            return p.erases;
+        }
+    }
+    return {};
+}
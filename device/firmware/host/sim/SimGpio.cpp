@@ -0,0 +1,228 @@
+/*
+ * SimGpio.cpp
+ * GPIO levels and edge interrupts for the host simulation
+ */
+
+#include "Sim.hpp"
+#include "SimKernel.hpp"
+
+namespace {
+
+struct Pin {
+    gpio_mode_t mode;
+    bool pull_up;
+    bool pull_down;
+    uint8_t output;
+    bool driven;            // Level forced from outside (Sim::gpioDrive)
+    uint8_t driven_level;
+    gpio_int_type_t intr_type;
+    gpio_isr_t handler;
+    void* arg;
+};
+
+Pin pins[GPIO_NUM_MAX];
+bool isr_service = false;
+
+bool validPin(gpio_num_t pin)
+{
+    return pin >= 0 && pin < GPIO_NUM_MAX;
+}
+
+// Lock held. Open-drain outputs only pull low; an undriven input floats
+// to its pull resistor (low if none).
+int level(const Pin& p)
+{
+    bool output = p.mode & GPIO_MODE_OUTPUT;
+    bool open_drain = (p.mode & GPIO_MODE_OUTPUT_OD) == GPIO_MODE_OUTPUT_OD;
+    if (output && !open_drain) {
+        return p.output;
+    }
+    int in = p.driven ? p.driven_level : (p.pull_up ? 1 : 0);
+    if (output && open_drain && !p.output) {
+        return 0;
+    }
+    return in;
+}
+
+bool triggers(gpio_int_type_t type, int before, int after)
+{
+    switch (type) {
+    case GPIO_INTR_POSEDGE: return !before && after;
+    case GPIO_INTR_NEGEDGE: return before && !after;
+    case GPIO_INTR_ANYEDGE: return before != after;
+    case GPIO_INTR_LOW_LEVEL: return !after;
+    case GPIO_INTR_HIGH_LEVEL: return after;
+    default: return false;
+    }
+}
+
+// Apply `change` to a pin and run its handler, as an ISR, if that fired it
+template <typename Change>
+void update(gpio_num_t pin, Change change)
+{
+    gpio_isr_t handler = nullptr;
+    void* arg = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        Pin& p = pins[pin];
+        int before = level(p);
+        change(p);
+        if (isr_service && p.handler && triggers(p.intr_type, before, level(p))) {
+            handler = p.handler;
+            arg = p.arg;
+        }
+    }
+    if (handler) {
+        SimKernel::setIsrContext(true);
+        handler(arg);
+        SimKernel::setIsrContext(false);
+    }
+}
+
+}  // namespace
+
+esp_err_t gpio_config(const gpio_config_t* config)
+{
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < GPIO_NUM_MAX; i++) {
+        if (config->pin_bit_mask & (1ULL << i)) {
+            update((gpio_num_t)i, [config](Pin& p) {
+                p.mode = config->mode;
+                p.pull_up = config->pull_up_en == GPIO_PULLUP_ENABLE;
+                p.pull_down = config->pull_down_en == GPIO_PULLDOWN_ENABLE;
+                p.intr_type = config->intr_type;
+            });
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t pin)
+{
+    if (!validPin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    update(pin, [](Pin& p) {
+        p.mode = GPIO_MODE_INPUT;
+        p.pull_up = true;
+        p.pull_down = false;
+        p.intr_type = GPIO_INTR_DISABLE;
+    });
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode)
+{
+    if (!validPin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    update(pin, [mode](Pin& p) { p.mode = mode; });
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t pin, int pull)
+{
+    if (!validPin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // GPIO_PULLUP_ONLY = 0, PULLDOWN_ONLY = 1, PULLUP_PULLDOWN = 2, FLOATING = 3
+    update(pin, [pull](Pin& p) {
+        p.pull_up = pull == 0 || pull == 2;
+        p.pull_down = pull == 1 || pull == 2;
+    });
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t value)
+{
+    if (!validPin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    update(pin, [value](Pin& p) { p.output = value ? 1 : 0; });
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    if (!validPin(pin)) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return level(pins[pin]);
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type)
+{
+    if (!validPin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    pins[pin].intr_type = type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    (void)intr_alloc_flags;
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    isr_service = true;
+    return ESP_OK;
+}
+
+void gpio_uninstall_isr_service(void)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    isr_service = false;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void* arg)
+{
+    if (!validPin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (!isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pins[pin].handler = handler;
+    pins[pin].arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t pin)
+{
+    if (!validPin(pin)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    pins[pin].handler = nullptr;
+    pins[pin].arg = nullptr;
+    return ESP_OK;
+}
+
+void Sim::gpioDrive(gpio_num_t pin, int value)
+{
+    if (validPin(pin)) {
+        update(pin, [value](Pin& p) {
+            p.driven = true;
+            p.driven_level = value ? 1 : 0;
+        });
+    }
+}
+
+void Sim::gpioRelease(gpio_num_t pin)
+{
+    if (validPin(pin)) {
+        update(pin, [](Pin& p) { p.driven = false; });
+    }
+}
+
+int Sim::gpioOutput(gpio_num_t pin)
+{
+    return gpio_get_level(pin);
+}
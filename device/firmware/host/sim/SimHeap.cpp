@@ -0,0 +1,119 @@
+/*
+ * SimHeap.cpp
+ * Capped internal RAM and PSRAM heaps for the host simulation
+ */
+
+#include "Sim.hpp"
+#include "SimKernel.hpp"
+#include "esp_heap_caps.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+struct Region {
+    size_t total;
+    size_t used;
+    size_t peak;
+};
+
+// A module with PSRAM; Sim::heapSetSize() to model another one
+Region internal_ram = {320 * 1024, 0, 0};
+Region psram = {2 * 1024 * 1024, 0, 0};
+
+// In front of every block, keeps the returned pointer 16-byte aligned
+struct alignas(16) Block {
+    size_t size;
+    Region* region;
+};
+
+Region* pick(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? &psram : &internal_ram;
+}
+
+}  // namespace
+
+void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+    Region* region = pick(caps);
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        if (size > region->total - region->used) {
+            return nullptr;
+        }
+        region->used += size;
+        if (region->used > region->peak) {
+            region->peak = region->used;
+        }
+    }
+    Block* block = static_cast<Block*>(malloc(sizeof(Block) + size));
+    if (!block) {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        region->used -= size;
+        return nullptr;
+    }
+    block->size = size;
+    block->region = region;
+    return block + 1;
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    if (size && n > SIZE_MAX / size) {
+        return nullptr;
+    }
+    void* ptr = heap_caps_malloc(n * size, caps);
+    if (ptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+void heap_caps_free(void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    Block* block = static_cast<Block*>(ptr) - 1;
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        block->region->used -= block->size;
+    }
+    free(block);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return pick(caps)->total;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Region* region = pick(caps);
+    return region->total - region->used;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Region* region = pick(caps);
+    return region->total - region->peak;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    // No fragmentation in the model
+    return heap_caps_get_free_size(caps);
+}
+
+void Sim::heapSetSize(size_t internal_bytes, size_t psram_bytes)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    internal_ram.total = internal_bytes;
+    psram.total = psram_bytes;
+    internal_ram.peak = internal_ram.used;
+    psram.peak = psram.used;
+}
@@ -0,0 +1,525 @@
+/*
+ * SimHttpClient.cpp
+ * ESP-IDF HTTP client over POSIX sockets for the host simulation
+ */
+
+#include "Sim.hpp"
+#include "SimKernel.hpp"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+static constexpr const char* TAG = "HTTP_CLIENT";
+
+// Writes block until then (Sim::httpStallWrites)
+static std::atomic<int64_t> stall_until_us(0);
+
+struct esp_http_client {
+    // Request
+    bool tls;
+    std::string host;
+    int port;
+    std::string path;
+    esp_http_client_method_t method;
+    int timeout_ms;
+    bool keep_alive;
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    // Connection
+    int fd;
+    std::vector<char> rx;
+    size_t rx_pos;
+    size_t rx_len;
+
+    // Response
+    int status;
+    int64_t content_length;
+    bool chunked;
+    bool until_close;           // No length: the body ends with the connection
+    bool close_after;           // Connection: close
+    int64_t remaining;          // Of the body or of the current chunk
+    bool complete;
+};
+
+namespace {
+
+const char* METHOD_NAMES[] = {"GET", "POST", "PUT", "PATCH", "DELETE", "HEAD"};
+
+bool parseUrl(esp_http_client* c, const char* url)
+{
+    std::string s = url ? url : "";
+    size_t rest;
+    if (s.compare(0, 7, "http://") == 0) {
+        c->tls = false;
+        rest = 7;
+    } else if (s.compare(0, 8, "https://") == 0) {
+        c->tls = true;
+        rest = 8;
+    } else {
+        return false;
+    }
+    size_t slash = s.find('/', rest);
+    std::string authority = s.substr(rest, slash == std::string::npos ? std::string::npos : slash - rest);
+    std::string path = slash == std::string::npos ? "/" : s.substr(slash);
+    int port = c->tls ? 443 : 80;
+    size_t colon = authority.find(':');
+    if (colon != std::string::npos) {
+        port = atoi(authority.c_str() + colon + 1);
+        authority.resize(colon);
+    }
+    if (authority.empty() || port <= 0 || port > 65535) {
+        return false;
+    }
+    // Another server: the connection can't be reused
+    if (c->fd >= 0 && (authority != c->host || port != c->port)) {
+        esp_http_client_close(c);
+    }
+    c->host = authority;
+    c->port = port;
+    c->path = path;
+    return true;
+}
+
+void resetResponse(esp_http_client* c)
+{
+    c->status = 0;
+    c->content_length = -1;
+    c->chunked = false;
+    c->until_close = false;
+    c->close_after = false;
+    c->remaining = 0;
+    c->complete = false;
+}
+
+bool connectTo(esp_http_client* c)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", c->port);
+    if (getaddrinfo(c->host.c_str(), port, &hints, &found) != 0) {
+        ESP_LOGE(TAG, "Unknown host %s", c->host.c_str());
+        return false;
+    }
+    timeval tv;
+    tv.tv_sec = c->timeout_ms / 1000;
+    tv.tv_usec = (c->timeout_ms % 1000) * 1000;
+    int one = 1;
+    for (addrinfo* ai = found; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (c->keep_alive) {
+            setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            c->fd = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(found);
+    if (c->fd < 0) {
+        ESP_LOGE(TAG, "Connection to %s:%d failed", c->host.c_str(), c->port);
+        return false;
+    }
+    c->rx_pos = 0;
+    c->rx_len = 0;
+    return true;
+}
+
+bool sendAll(esp_http_client* c, const char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(c->fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Refills the receive buffer: > 0 bytes, 0 at EOF, < 0 on an error
+int fill(esp_http_client* c)
+{
+    if (c->rx_pos < c->rx_len) {
+        return (int)(c->rx_len - c->rx_pos);
+    }
+    ssize_t n = recv(c->fd, c->rx.data(), c->rx.size(), 0);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? -ESP_ERR_HTTP_EAGAIN : ESP_FAIL;
+    }
+    c->rx_pos = 0;
+    c->rx_len = (size_t)n;
+    return (int)n;
+}
+
+// One CRLF-terminated line, without the CRLF
+bool readLine(esp_http_client* c, std::string& line)
+{
+    line.clear();
+    while (true) {
+        if (fill(c) <= 0) {
+            return false;
+        }
+        char ch = c->rx[c->rx_pos++];
+        if (ch == '\n') {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return true;
+        }
+        if (line.size() > 8192) {
+            return false;
+        }
+        line.push_back(ch);
+    }
+}
+
+// The body is over: drop a connection the server won't reuse
+void bodyDone(esp_http_client* c)
+{
+    c->complete = true;
+    if (c->close_after || c->until_close) {
+        esp_http_client_close(c);
+    }
+}
+
+// Next chunk's size line; the last chunk's trailers are skipped
+bool nextChunk(esp_http_client* c)
+{
+    std::string line;
+    if (!readLine(c, line)) {
+        return false;
+    }
+    char* end = nullptr;
+    long long size = strtoll(line.c_str(), &end, 16);
+    if (end == line.c_str() || size < 0) {
+        return false;
+    }
+    if (size == 0) {
+        do {
+            if (!readLine(c, line)) {
+                return false;
+            }
+        } while (!line.empty());
+        bodyDone(c);
+        return true;
+    }
+    c->remaining = size;
+    return true;
+}
+
+}  // namespace
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t* config)
+{
+    if (!config) {
+        return nullptr;
+    }
+    esp_http_client* c = new esp_http_client();
+    c->fd = -1;
+    c->method = config->method;
+    c->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : 5000;
+    c->keep_alive = config->keep_alive_enable;
+    c->rx.resize(config->buffer_size > 0 ? config->buffer_size : 512);
+    c->rx_pos = 0;
+    c->rx_len = 0;
+    resetResponse(c);
+    if (!parseUrl(c, config->url)) {
+        ESP_LOGE(TAG, "Bad URL %s", config->url ? config->url : "(null)");
+        delete c;
+        return nullptr;
+    }
+    return c;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    if (!client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_http_client_close(client);
+    delete client;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char* key, const char* value)
+{
+    if (!client || !key || !value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (auto& header : client->headers) {
+        if (strcasecmp(header.first.c_str(), key) == 0) {
+            header.second = value;
+            return ESP_OK;
+        }
+    }
+    client->headers.emplace_back(key, value);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char* url)
+{
+    if (!client || !parseUrl(client, url)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+    if (!client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    client->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    if (!client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client->tls) {
+        ESP_LOGE(TAG, "https:// is not simulated");
+        return ESP_ERR_HTTP_INVALID_TRANSPORT;
+    }
+    // A response left unread would be taken for the next one's
+    if (client->fd >= 0 && client->status != 0 && !client->complete) {
+        esp_http_client_close(client);
+    }
+    resetResponse(client);
+    if (client->fd < 0 && !connectTo(client)) {
+        return ESP_ERR_HTTP_CONNECT;
+    }
+
+    std::string head = METHOD_NAMES[client->method];
+    head += " " + client->path + " HTTP/1.1\r\nHost: " + client->host;
+    if (client->port != 80) {
+        head += ":" + std::to_string(client->port);
+    }
+    head += "\r\nUser-Agent: ESP32 HTTP Client/1.0\r\n";
+    for (const auto& header : client->headers) {
+        head += header.first + ": " + header.second + "\r\n";
+    }
+    if (write_len < 0) {
+        head += "Transfer-Encoding: chunked\r\n";
+    } else if (write_len > 0 || client->method == HTTP_METHOD_POST || client->method == HTTP_METHOD_PUT) {
+        head += "Content-Length: " + std::to_string(write_len) + "\r\n";
+    }
+    head += "\r\n";
+    if (!sendAll(client, head.data(), head.size())) {
+        esp_http_client_close(client);
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    return ESP_OK;
+}
+
+int esp_http_client_write(esp_http_client_handle_t client, const char* buffer, int len)
+{
+    if (!client || client->fd < 0 || len < 0) {
+        return -1;
+    }
+    int64_t stall = stall_until_us.load();
+    if (stall > SimKernel::now()) {
+        SimKernel::sleepUntil(stall);
+    }
+    return sendAll(client, buffer, (size_t)len) ? len : -1;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    if (!client || client->fd < 0) {
+        return ESP_FAIL;
+    }
+    std::string line;
+    // Interim 1xx responses (100 Continue) come ahead of the real one
+    do {
+        if (!readLine(client, line) || line.compare(0, 5, "HTTP/") != 0) {
+            ESP_LOGD(TAG, "No response head");
+            client->status = 0;
+            return ESP_FAIL;
+        }
+        size_t space = line.find(' ');
+        client->status = space == std::string::npos ? 0 : atoi(line.c_str() + space + 1);
+        bool http10 = line.compare(0, 8, "HTTP/1.0") == 0;
+        client->close_after = http10;
+        while (true) {
+            if (!readLine(client, line)) {
+                client->status = 0;
+                return ESP_FAIL;
+            }
+            if (line.empty()) {
+                break;
+            }
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string key = line.substr(0, colon);
+            const char* value = line.c_str() + colon + 1;
+            while (*value == ' ' || *value == '\t') {
+                value++;
+            }
+            if (strcasecmp(key.c_str(), "Content-Length") == 0) {
+                client->content_length = strtoll(value, nullptr, 10);
+            } else if (strcasecmp(key.c_str(), "Transfer-Encoding") == 0) {
+                client->chunked = strcasestr(value, "chunked") != nullptr;
+            } else if (strcasecmp(key.c_str(), "Connection") == 0) {
+                if (strcasestr(value, "close")) {
+                    client->close_after = true;
+                } else if (strcasestr(value, "keep-alive")) {
+                    client->close_after = false;
+                }
+            }
+        }
+    } while (client->status >= 100 && client->status < 200);
+
+    if (client->method == HTTP_METHOD_HEAD || client->status == 204 || client->status == 304) {
+        client->content_length = 0;
+        client->chunked = false;
+    }
+    if (client->chunked) {
+        client->content_length = -1;
+        client->remaining = 0;
+    } else if (client->content_length >= 0) {
+        client->remaining = client->content_length;
+        if (client->remaining == 0) {
+            bodyDone(client);
+        }
+    } else {
+        client->until_close = true;
+    }
+    return client->content_length;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client ? client->status : -1;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return client ? client->content_length : -1;
+}
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+    return client && client->chunked;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char* buffer, int len)
+{
+    if (!client || len < 0) {
+        return ESP_FAIL;
+    }
+    int total = 0;
+    while (total < len && !client->complete && client->fd >= 0) {
+        if (client->chunked && client->remaining == 0) {
+            // Data ahead of the next size line is returned first, so a
+            // reader gets each chunk as soon as it arrives
+            if (total > 0 && client->rx_pos == client->rx_len) {
+                break;
+            }
+            if (!nextChunk(client)) {
+                esp_http_client_close(client);
+                return total > 0 ? total : 0;
+            }
+            continue;
+        }
+        int avail = fill(client);
+        if (avail == 0) {
+            // Connection closed: the end of a body without a length,
+            // a cut-off download otherwise
+            if (client->until_close) {
+                bodyDone(client);
+            } else {
+                esp_http_client_close(client);
+            }
+            break;
+        }
+        if (avail < 0) {
+            if (total > 0) {
+                break;
+            }
+            ESP_LOGW(TAG, "Read failed: %s", avail == -ESP_ERR_HTTP_EAGAIN ? "timeout" : strerror(errno));
+            return avail;
+        }
+        size_t n = (size_t)avail;
+        if (n > (size_t)(len - total)) {
+            n = (size_t)(len - total);
+        }
+        if (!client->until_close && (int64_t)n > client->remaining) {
+            n = (size_t)client->remaining;
+        }
+        memcpy(buffer + total, client->rx.data() + client->rx_pos, n);
+        client->rx_pos += n;
+        total += (int)n;
+        if (!client->until_close) {
+            client->remaining -= (int64_t)n;
+            if (client->remaining == 0) {
+                if (client->chunked) {
+                    std::string crlf;
+                    if (!readLine(client, crlf)) {
+                        esp_http_client_close(client);
+                        break;
+                    }
+                } else {
+                    bodyDone(client);
+                }
+            }
+        }
+        // Return what the socket had rather than wait for more
+        if (client->rx_pos == client->rx_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+    return client && client->complete;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    if (!client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client->fd >= 0) {
+        ::close(client->fd);
+        client->fd = -1;
+    }
+    client->rx_pos = 0;
+    client->rx_len = 0;
+    return ESP_OK;
+}
+
+void Sim::httpStallWrites(int64_t until_us)
+{
+    stall_until_us.store(until_us);
+}
@@ -0,0 +1,277 @@
+/*
+ * SimI2C.cpp
+ * Legacy I2C master driver against simulated devices
+ */
+
+#include "Sim.hpp"
+#include "SimKernel.hpp"
+#include <map>
+#include <memory>
+#include <new>
+
+struct SimI2CCommand {
+    enum class Op : uint8_t {
+        Start,
+        Stop,
+        Write,
+        Read,
+    };
+    
+    struct Step {
+        Op op;
+        uint8_t byte;           // Single-byte write (copied)
+        const uint8_t* data;    // Multi-byte write (referenced)
+        uint8_t* read_buf;
+        size_t len;
+        i2c_ack_type_t ack;
+        bool ack_check;
+    };
+    
+    std::vector<Step> steps;
+    bool is_static;
+};
+
+namespace {
+
+struct Port {
+    bool configured;
+    bool installed;
+    uint32_t clk_speed;
+    std::map<uint8_t, SimI2CDevice*> devices;
+    uint64_t bus_time_us;
+    uint64_t bytes;
+    std::mutex bus;         // One command at a time, like the driver's lock
+};
+
+Port ports[I2C_NUM_MAX];
+
+bool validPort(i2c_port_t port)
+{
+    return port >= 0 && port < I2C_NUM_MAX;
+}
+
+esp_err_t addStep(i2c_cmd_handle_t cmd, const SimI2CCommand::Step& step)
+{
+    if (!cmd) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cmd->steps.push_back(step);
+    return ESP_OK;
+}
+
+}  // namespace
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t* config)
+{
+    if (!validPort(port) || !config || config->mode != I2C_MODE_MASTER) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    ports[port].configured = true;
+    ports[port].clk_speed = config->master.clk_speed ? config->master.clk_speed : 100000;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t slv_rx_buf_len,
+                             size_t slv_tx_buf_len, int intr_alloc_flags)
+{
+    (void)slv_rx_buf_len;
+    (void)slv_tx_buf_len;
+    (void)intr_alloc_flags;
+    if (!validPort(port) || mode != I2C_MODE_MASTER) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Port& p = ports[port];
+    if (p.installed) {
+        return ESP_FAIL;
+    }
+    if (!p.configured) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    p.installed = true;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t port)
+{
+    if (!validPort(port)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (!ports[port].installed) {
+        return ESP_FAIL;
+    }
+    ports[port].installed = false;
+    return ESP_OK;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void)
+{
+    return new (std::nothrow) SimI2CCommand{{}, false};
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t* buffer, uint32_t size)
+{
+    void* p = buffer;
+    size_t space = size;
+    if (!buffer || !std::align(alignof(SimI2CCommand), sizeof(SimI2CCommand), p, space)) {
+        return nullptr;
+    }
+    return new (p) SimI2CCommand{{}, true};
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd)
+{
+    delete cmd;
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd)
+{
+    if (cmd) {
+        cmd->~SimI2CCommand();
+    }
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd)
+{
+    return addStep(cmd, {SimI2CCommand::Op::Start, 0, nullptr, nullptr, 0, I2C_MASTER_ACK, false});
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd)
+{
+    return addStep(cmd, {SimI2CCommand::Op::Stop, 0, nullptr, nullptr, 0, I2C_MASTER_ACK, false});
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en)
+{
+    return addStep(cmd, {SimI2CCommand::Op::Write, data, nullptr, nullptr, 1, I2C_MASTER_ACK, ack_en});
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t* data, size_t len, bool ack_en)
+{
+    if (!data && len > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return addStep(cmd, {SimI2CCommand::Op::Write, 0, data, nullptr, len, I2C_MASTER_ACK, ack_en});
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t* data, size_t len, i2c_ack_type_t ack)
+{
+    if (!data || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return addStep(cmd, {SimI2CCommand::Op::Read, 0, nullptr, data, len, ack, false});
+}
+
+esp_err_t i2c_master_read_byte(i2c_cmd_handle_t cmd, uint8_t* data, i2c_ack_type_t ack)
+{
+    return i2c_master_read(cmd, data, 1, ack);
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, TickType_t ticks)
+{
+    if (!validPort(port) || !cmd) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Port& p = ports[port];
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::lock_guard<std::mutex> bus(p.bus);
+    
+    esp_err_t result = ESP_OK;
+    uint64_t bits = 0;
+    uint64_t bytes = 0;
+    uint64_t bus_us;
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        if (!p.installed) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        
+        SimI2CDevice* device = nullptr;
+        bool expect_address = false;
+        for (const SimI2CCommand::Step& step : cmd->steps) {
+            if (step.op == SimI2CCommand::Op::Start) {
+                expect_address = true;
+                bits += 1;
+                continue;
+            }
+            if (step.op == SimI2CCommand::Op::Stop) {
+                bits += 1;
+                break;
+            }
+            for (size_t i = 0; i < step.len; i++) {
+                bits += 9;
+                bytes++;
+                if (step.op == SimI2CCommand::Op::Read) {
+                    step.read_buf[i] = device ? device->read() : 0xFF;
+                    continue;
+                }
+                uint8_t byte = step.data ? step.data[i] : step.byte;
+                bool ack;
+                if (expect_address) {
+                    // 7-bit address + R/W; no device means nobody ACKs
+                    auto it = p.devices.find(byte >> 1);
+                    device = it != p.devices.end() ? it->second : nullptr;
+                    if (device) {
+                        device->start(byte & 1);
+                    }
+                    ack = device != nullptr;
+                    expect_address = false;
+                } else {
+                    ack = device && device->write(byte);
+                }
+                if (!ack && step.ack_check) {
+                    result = ESP_FAIL;
+                    break;
+                }
+            }
+            if (result != ESP_OK) {
+                bits += 1;     // The driver ends with STOP after a NACK
+                break;
+            }
+        }
+        if (device) {
+            device->stop();
+        }
+        bus_us = (bits * 1000000 + p.clk_speed - 1) / p.clk_speed;
+        p.bus_time_us += bus_us;
+        p.bytes += bytes;
+    }
+    
+    int64_t done_us = SimKernel::now() + (int64_t)bus_us;
+    if (done_us > deadline) {
+        SimKernel::sleepUntil(deadline);
+        return ESP_ERR_TIMEOUT;
+    }
+    SimKernel::sleepUntil(done_us);
+    return result;
+}
+
+void Sim::i2cAttach(i2c_port_t port, uint8_t address, SimI2CDevice* device)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (validPort(port)) {
+        ports[port].devices[address] = device;
+    }
+}
+
+void Sim::i2cDetach(i2c_port_t port, uint8_t address)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (validPort(port)) {
+        ports[port].devices.erase(address);
+    }
+}
+
+uint64_t Sim::i2cBusTimeUs(i2c_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return validPort(port) ? ports[port].bus_time_us : 0;
+}
+
+uint64_t Sim::i2cBytes(i2c_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return validPort(port) ? ports[port].bytes : 0;
+}
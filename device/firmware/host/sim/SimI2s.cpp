@@ -0,0 +1,179 @@
+/*
+ * SimI2s.cpp
+ * I2S standard-mode RX on the simulated clock
+ */
+
+#include "Sim.hpp"
+#include "SimKernel.hpp"
+#include "driver/i2s_std.h"
+#include <algorithm>
+#include <cstring>
+
+struct i2s_channel_obj_t {
+    i2s_port_t port;
+    uint32_t desc_num;
+    uint32_t frame_num;
+    uint32_t sample_rate;
+    bool configured;
+    bool enabled;
+    int64_t enabled_us;
+    uint64_t read_frames;       // Consumed or lost since the enable
+};
+
+namespace {
+
+constexpr int PORTS = 2;
+
+i2s_channel_obj_t* channels[PORTS];
+Sim::I2sSource sources[PORTS];
+uint64_t overflowed[PORTS];
+
+// Frames in completed descriptors at `t_us` (lock held)
+uint64_t completedFrames(const i2s_channel_obj_t* c, int64_t t_us)
+{
+    uint64_t produced = (uint64_t)(t_us - c->enabled_us) * c->sample_rate / 1000000;
+    return produced / c->frame_num * c->frame_num;
+}
+
+// Drops what the DMA ring no longer holds (lock held)
+void overflow(i2s_channel_obj_t* c, uint64_t completed)
+{
+    uint64_t capacity = (uint64_t)c->desc_num * c->frame_num;
+    if (completed - c->read_frames > capacity) {
+        uint64_t keep_from = completed - capacity;
+        overflowed[c->port] += keep_from - c->read_frames;
+        c->read_frames = keep_from;
+    }
+}
+
+}  // namespace
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t* chan_cfg, i2s_chan_handle_t* tx_handle,
+                          i2s_chan_handle_t* rx_handle)
+{
+    if (!chan_cfg || tx_handle || !rx_handle || chan_cfg->id < 0 || chan_cfg->id >= PORTS
+        || chan_cfg->dma_desc_num < 2 || chan_cfg->dma_frame_num == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (channels[chan_cfg->id]) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    i2s_channel_obj_t* c = new i2s_channel_obj_t();
+    c->port = chan_cfg->id;
+    c->desc_num = chan_cfg->dma_desc_num;
+    c->frame_num = chan_cfg->dma_frame_num;
+    channels[c->port] = c;
+    *rx_handle = c;
+    return ESP_OK;
+}
+
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (!handle || handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channels[handle->port] = nullptr;
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t* std_cfg)
+{
+    if (!handle || !std_cfg || std_cfg->clk_cfg.sample_rate_hz == 0
+        || std_cfg->slot_cfg.data_bit_width != I2S_DATA_BIT_WIDTH_32BIT
+        || std_cfg->slot_cfg.slot_mode != I2S_SLOT_MODE_MONO) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    handle->sample_rate = std_cfg->clk_cfg.sample_rate_hz;
+    handle->configured = true;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (!handle || !handle->configured || handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->enabled = true;
+    handle->enabled_us = SimKernel::now();
+    handle->read_frames = 0;
+    SimKernel::notifyAll();
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (!handle || !handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->enabled = false;
+    SimKernel::notifyAll();
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void* dest, size_t size, size_t* bytes_read,
+                           uint32_t timeout_ms)
+{
+    if (bytes_read) {
+        *bytes_read = 0;
+    }
+    if (!handle || !dest) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint64_t want = size / sizeof(int32_t);
+    int64_t deadline = SimKernel::now() + (int64_t)timeout_ms * 1000;
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    if (!handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The descriptor holding the last wanted frame completes at a known
+    // time; wait for it (or a disable) in steps no longer than that
+    uint64_t needed = (handle->read_frames + want + handle->frame_num - 1) / handle->frame_num * handle->frame_num;
+    int64_t ready_us = handle->enabled_us
+                       + (int64_t)((needed * 1000000 + handle->sample_rate - 1) / handle->sample_rate);
+    SimKernel::waitUntil(held, std::min(deadline, ready_us), [handle] { return !handle->enabled; });
+    if (!handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint64_t completed = completedFrames(handle, SimKernel::now());
+    overflow(handle, completed);
+    uint64_t count = std::min(want, completed - handle->read_frames);
+    int32_t* out = static_cast<int32_t*>(dest);
+    const Sim::I2sSource& source = sources[handle->port];
+    for (uint64_t i = 0; i < count; i++) {
+        out[i] = source ? source(handle->read_frames + i) : 0;
+    }
+    handle->read_frames += count;
+    if (bytes_read) {
+        *bytes_read = (size_t)count * sizeof(int32_t);
+    }
+    return count == want ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void Sim::i2sSetSource(int port, I2sSource source)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (port >= 0 && port < PORTS) {
+        sources[port] = source;
+    }
+}
+
+uint64_t Sim::i2sOverflowedFrames(int port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (port < 0 || port >= PORTS) {
+        return 0;
+    }
+    i2s_channel_obj_t* c = channels[port];
+    if (c && c->enabled) {
+        overflow(c, completedFrames(c, SimKernel::now()));
+    }
+    return overflowed[port];
+}
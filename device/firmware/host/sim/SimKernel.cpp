@@ -0,0 +1,147 @@
+/*
+ * SimKernel.cpp
+ * Shared lock, wake-ups and clock for the host simulation
+ */
+
+#include "SimKernel.hpp"
+#include "Sim.hpp"
+#include "esp_timer.h"
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// sim_us = sim_anchor + (wall - wall_anchor) * scale
+std::mutex clock_lock;
+Clock::time_point wall_anchor = Clock::now();
+int64_t sim_anchor = 0;
+double scale = 1.0;
+
+thread_local bool in_isr = false;
+
+// Never destroyed: task threads are detached and may still be waiting
+// when main() returns, and destroying a condition variable with waiters
+// blocks the exit
+std::condition_variable& kernelCv()
+{
+    static std::condition_variable* cv = new std::condition_variable;
+    return *cv;
+}
+
+}  // namespace
+
+// Defined with the tasks in SimRtos.cpp
+bool simCurrentTaskDeleted();
+
+std::mutex& SimKernel::lock()
+{
+    static std::mutex* kernel_lock = new std::mutex;
+    return *kernel_lock;
+}
+
+void SimKernel::notifyAll()
+{
+    kernelCv().notify_all();
+}
+
+int64_t SimKernel::now()
+{
+    std::lock_guard<std::mutex> guard(clock_lock);
+    double wall_us = std::chrono::duration<double, std::micro>(Clock::now() - wall_anchor).count();
+    return sim_anchor + (int64_t)(wall_us * scale);
+}
+
+void SimKernel::setTimeScale(double new_scale)
+{
+    if (new_scale <= 0) {
+        return;
+    }
+    int64_t t = now();
+    {
+        std::lock_guard<std::mutex> guard(clock_lock);
+        wall_anchor = Clock::now();
+        sim_anchor = t;
+        scale = new_scale;
+    }
+    // Sleepers recompute their wall-clock deadlines
+    std::lock_guard<std::mutex> guard(lock());
+    kernelCv().notify_all();
+}
+
+double SimKernel::timeScale()
+{
+    std::lock_guard<std::mutex> guard(clock_lock);
+    return scale;
+}
+
+int64_t SimKernel::deadlineAfter(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return FOREVER;
+    }
+    return now() + (int64_t)ticks * tickUs();
+}
+
+void SimKernel::wait(std::unique_lock<std::mutex>& held, int64_t deadline_us)
+{
+    if (deadline_us == FOREVER) {
+        kernelCv().wait(held);
+        return;
+    }
+    Clock::time_point wall;
+    {
+        std::lock_guard<std::mutex> guard(clock_lock);
+        double wall_us = (double)(deadline_us - sim_anchor) / scale;
+        wall = wall_anchor + std::chrono::microseconds((int64_t)wall_us + 1);
+    }
+    kernelCv().wait_until(held, wall);
+}
+
+void SimKernel::sleepUntil(int64_t t_us)
+{
+    std::unique_lock<std::mutex> held(lock());
+    waitUntil(held, t_us, [] { return false; });
+}
+
+void SimKernel::checkDeleted()
+{
+    if (simCurrentTaskDeleted()) {
+        throw TaskDeleted();
+    }
+}
+
+void SimKernel::setIsrContext(bool isr)
+{
+    in_isr = isr;
+}
+
+bool SimKernel::inIsrContext()
+{
+    return in_isr;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return SimKernel::now();
+}
+
+void Sim::setTimeScale(double scale)
+{
+    SimKernel::setTimeScale(scale);
+}
+
+double Sim::timeScale()
+{
+    return SimKernel::timeScale();
+}
+
+int64_t Sim::now()
+{
+    return SimKernel::now();
+}
+
+void Sim::sleepUntil(int64_t t_us)
+{
+    SimKernel::sleepUntil(t_us);
+}
@@ -0,0 +1,61 @@
+/*
+ * SimKernel.hpp
+ * Shared lock, wake-ups and clock for the host simulation
+ *
+ * Every simulated kernel object and peripheral shares one mutex and one
+ * condition variable. Waiters re-check their condition on every change;
+ * that is slower than per-object wake-ups but cannot miss one, and the
+ * host only runs a handful of tasks.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+class SimKernel {
+public:
+    // Thrown inside a task deleted with vTaskDelete(); unwinds to its entry
+    struct TaskDeleted {};
+    
+    static constexpr int64_t FOREVER = INT64_MAX;
+    
+    static std::mutex& lock();
+    static void notifyAll();
+    
+    // Block (lock held) until `ready()` or the simulated deadline.
+    // Returns ready(); throws TaskDeleted if the calling task was deleted.
+    template <typename Ready>
+    static bool waitUntil(std::unique_lock<std::mutex>& held, int64_t deadline_us, Ready ready)
+    {
+        while (true) {
+            checkDeleted();
+            if (ready()) {
+                return true;
+            }
+            if (deadline_us != FOREVER && now() >= deadline_us) {
+                return false;
+            }
+            wait(held, deadline_us);
+        }
+    }
+    
+    // Sleep (lock not held) until a simulated time; deletion still wakes it
+    static void sleepUntil(int64_t t_us);
+    
+    static int64_t now();
+    static int64_t tickUs() { return 1000000 / configTICK_RATE_HZ; }
+    static int64_t deadlineAfter(TickType_t ticks);
+    
+    static void setTimeScale(double scale);
+    static double timeScale();
+    
+    static void setIsrContext(bool in_isr);
+    static bool inIsrContext();
+    
+private:
+    static void wait(std::unique_lock<std::mutex>& held, int64_t deadline_us);
+    static void checkDeleted();
+};
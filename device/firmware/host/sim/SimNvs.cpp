@@ -0,0 +1,161 @@
+/*
+ * SimNvs.cpp
+ * In-memory NVS for the host simulation
+ */
+
+#include "SimKernel.hpp"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Handle {
+    std::string name_space;
+    bool writable;
+    bool open;
+};
+
+// Namespace -> key -> value. Values keep their width, as on the chip: a
+// u32 read of a u8 key is not found.
+struct Value {
+    uint32_t value;
+    uint8_t width;
+};
+std::map<std::string, std::map<std::string, Value>> store;
+std::vector<Handle> handles;
+bool initialized = false;
+
+Handle* lookup(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > handles.size() || !handles[handle - 1].open) {
+        return nullptr;
+    }
+    return &handles[handle - 1];
+}
+
+esp_err_t get(nvs_handle_t handle, const char* key, uint8_t width, uint32_t* out_value)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Handle* h = lookup(handle);
+    if (!h || !key || !out_value) {
+        return h ? ESP_ERR_INVALID_ARG : ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    auto ns = store.find(h->name_space);
+    if (ns == store.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    auto it = ns->second.find(key);
+    if (it == ns->second.end() || it->second.width != width) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = it->second.value;
+    return ESP_OK;
+}
+
+esp_err_t set(nvs_handle_t handle, const char* key, uint8_t width, uint32_t value)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Handle* h = lookup(handle);
+    if (!h || !key) {
+        return h ? ESP_ERR_INVALID_ARG : ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!h->writable) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    store[h->name_space][key] = {value, width};
+    return ESP_OK;
+}
+
+}  // namespace
+
+esp_err_t nvs_flash_init(void)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    store.clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (!initialized) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (!name || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // A read-only open of a namespace never written fails, as on the chip
+    if (open_mode == NVS_READONLY && store.find(name) == store.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    handles.push_back({name, open_mode == NVS_READWRITE, true});
+    *out_handle = (nvs_handle_t)handles.size();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Handle* h = lookup(handle);
+    if (h) {
+        h->open = false;
+    }
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out_value)
+{
+    uint32_t value;
+    esp_err_t err = get(handle, key, 1, &value);
+    if (err == ESP_OK) {
+        *out_value = (uint8_t)value;
+    }
+    return err;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value)
+{
+    return set(handle, key, 1, value);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value)
+{
+    return get(handle, key, 4, out_value);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value)
+{
+    return set(handle, key, 4, value);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Handle* h = lookup(handle);
+    if (!h || !key) {
+        return h ? ESP_ERR_INVALID_ARG : ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!h->writable) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    auto ns = store.find(h->name_space);
+    if (ns == store.end() || ns->second.erase(key) == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return lookup(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
@@ -0,0 +1,307 @@
+/*
+ * SimPrinter.cpp
+ * ESC/POS printer model on a simulated UART
+ */
+
+#include "SimPrinter.hpp"
+#include <algorithm>
+
+SimPrinter::SimPrinter(uart_port_t port, uint32_t baud, const Timing& timing)
+    : port_(port)
+    , baud_(baud)
+    , timing_(timing)
+    , inverse_(0)
+    , status_replies_(true)
+    , online_(true)
+    , stats_{}
+    , raster_left_(0)
+    , raster_width_(0)
+    , raster_col_(0)
+    , row_black_(0)
+    , heat_dots_(7)
+    , heat_time_(80)
+    , heat_interval_(2)
+    , density_(0x4A)
+    , buffered_(0)
+    , cmd_bytes_(0)
+{
+}
+
+SimPrinter::~SimPrinter()
+{
+    detach();
+}
+
+void SimPrinter::attach()
+{
+    Sim::uartListen(port_, [this](const uint8_t* data, const int64_t* t_us, size_t len) {
+        onBytes(data, t_us, len);
+    });
+}
+
+void SimPrinter::detach()
+{
+    Sim::uartListen(port_, nullptr);
+}
+
+void SimPrinter::setStatusReplies(bool enabled)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    status_replies_ = enabled;
+}
+
+void SimPrinter::setOnline(bool online)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    online_ = online;
+}
+
+SimPrinter::Stats SimPrinter::getStats() const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return stats_;
+}
+
+std::vector<std::string> SimPrinter::textLines() const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return lines_;
+}
+
+void SimPrinter::heating(uint8_t* dots, uint8_t* time, uint8_t* interval, uint8_t* density) const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    *dots = heat_dots_;
+    *time = heat_time_;
+    *interval = heat_interval_;
+    *density = density_;
+}
+
+std::vector<uint8_t> SimPrinter::raster() const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return raster_;
+}
+
+uint32_t SimPrinter::rowsPrintedBy(int64_t t_us) const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return (uint32_t)(std::upper_bound(row_done_us_.begin(), row_done_us_.end(), t_us)
+                      - row_done_us_.begin());
+}
+
+int64_t SimPrinter::rowDoneUs(uint32_t row) const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return row < row_done_us_.size() ? row_done_us_[row] : -1;
+}
+
+void SimPrinter::onBytes(const uint8_t* data, const int64_t* t_us, size_t len)
+{
+    // Wrong line settings read as noise: nothing parses or answers
+    if (Sim::uartBaud(port_) != baud_ || Sim::uartInverse(port_) != inverse_) {
+        std::lock_guard<std::mutex> guard(lock_);
+        stats_.garbled += len;
+        return;
+    }
+    
+    std::vector<Reply> replies;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        for (size_t i = 0; i < len; i++) {
+            onByte(data[i], t_us[i]);
+        }
+        replies.swap(replies_);
+    }
+    double byte_us = Sim::uartByteUs(port_);
+    for (const Reply& reply : replies) {
+        Sim::uartInject(port_, &reply.status, 1, reply.t_us + (int64_t)byte_us);
+    }
+}
+
+// Lock held
+void SimPrinter::onByte(uint8_t byte, int64_t t_us)
+{
+    stats_.bytes++;
+    
+    // Input buffer: commands the head has started no longer occupy it
+    while (!pending_.empty() && pending_.front().start_us <= t_us) {
+        buffered_ -= pending_.front().bytes;
+        pending_.pop_front();
+    }
+    buffered_++;
+    cmd_bytes_++;
+    if (buffered_ > timing_.buffer_bytes) {
+        stats_.overflowed++;
+    }
+    stats_.max_buffered = std::max(stats_.max_buffered, buffered_);
+    
+    if (raster_left_ > 0) {
+        if (raster_col_ == 0) {
+            raster_.resize(raster_.size() + widthBytes(), 0);
+        }
+        if (raster_col_ < widthBytes()) {
+            raster_[raster_.size() - widthBytes() + raster_col_] = byte;
+        }
+        row_black_ += (uint32_t)__builtin_popcount(byte);
+        if (++raster_col_ == raster_width_) {
+            // Heat firings of at most (n1 + 1) * 8 dots, then the interval
+            uint32_t firing_dots = (heat_dots_ + 1u) * 8u;
+            uint32_t firings = (row_black_ + firing_dots - 1) / firing_dots;
+            uint32_t line_us = std::max(timing_.feed_dot_us,
+                                        firings * heat_time_ * 10u + heat_interval_ * 10u);
+            band_row_us_.push_back(line_us);
+            raster_col_ = 0;
+            row_black_ = 0;
+            stats_.raster_rows++;
+        }
+        if (--raster_left_ == 0) {
+            stats_.bands++;
+            cmd_.clear();
+            uint64_t band_us = 0;
+            for (uint32_t us : band_row_us_) {
+                band_us += us;
+            }
+            work(t_us, band_us);
+            stats_.raster_head_us += (int64_t)band_us;
+            int64_t done = stats_.busy_until_us - (int64_t)band_us;
+            for (uint32_t us : band_row_us_) {
+                done += us;
+                row_done_us_.push_back(done);
+            }
+            band_row_us_.clear();
+        }
+        return;
+    }
+    
+    cmd_.push_back(byte);
+    size_t need = commandLength();
+    if (need > 0 && cmd_.size() >= need) {
+        execute(t_us);
+    }
+}
+
+// Total length of the command in cmd_, or 0 if more bytes are needed to tell
+size_t SimPrinter::commandLength() const
+{
+    uint8_t first = cmd_[0];
+    if (first != 0x1B && first != 0x1D && first != 0x10 && first != 0x12) {
+        return 1;
+    }
+    if (cmd_.size() < 2) {
+        return 0;
+    }
+    uint8_t second = cmd_[1];
+    switch (first) {
+    case 0x1B:  // ESC
+        switch (second) {
+        case '@': case '2': return 2;
+        case '7': return 5;
+        case 'd': case 'J': case '3': case '!': case 'a': case 'E': case '-':
+        case 'M': case '{': case 't': case 'R': case 'U': case 'G': case ' ':
+            return 3;
+        default: return 2;
+        }
+    case 0x1D:  // GS
+        switch (second) {
+        case 'v': return 8;
+        case 'V':
+            if (cmd_.size() < 3) {
+                return 0;
+            }
+            return cmd_[2] == 65 || cmd_[2] == 66 ? 4 : 3;
+        case '!': case 'B': case 'h': case 'w': case 'H': case 'f': return 3;
+        case 'L': case 'W': return 4;
+        default: return 2;
+        }
+    case 0x10:  // DLE
+        return second == 0x04 ? 3 : (second == 0x14 ? 5 : 2);
+    default:    // DC2
+        return second == '#' ? 3 : 2;
+    }
+}
+
+// Lock held
+void SimPrinter::execute(int64_t t_us)
+{
+    stats_.commands++;
+    uint8_t first = cmd_[0];
+    uint8_t second = cmd_.size() > 1 ? cmd_[1] : 0;
+    uint64_t cost_us = 0;
+    
+    if (cmd_.size() == 1) {
+        if (first == '\n') {
+            // Print the buffered line, or feed one line if it's empty
+            bool empty = text_.empty();
+            lines_.push_back(text_);
+            text_.clear();
+            stats_.text_lines++;
+            cost_us = (uint64_t)timing_.line_dots * (empty ? timing_.feed_dot_us : timing_.dot_line_us);
+        } else if (first >= 0x20) {
+            text_ += (char)first;
+        }
+    } else if (first == 0x1B && second == '@') {
+        text_.clear();
+        heat_dots_ = 7;
+        heat_time_ = 80;
+        heat_interval_ = 2;
+    } else if (first == 0x1B && second == '7') {
+        heat_dots_ = cmd_[2];
+        heat_time_ = cmd_[3];
+        heat_interval_ = cmd_[4];
+        stats_.heat_changes++;
+    } else if (first == 0x12 && second == '#') {
+        density_ = cmd_[2];
+    } else if (first == 0x1B && (second == 'd' || second == 'J')) {
+        uint32_t dots = second == 'd' ? (uint32_t)cmd_[2] * timing_.line_dots : cmd_[2];
+        stats_.feed_dots += dots;
+        cost_us = (uint64_t)dots * timing_.feed_dot_us;
+        if (second == 'J') {
+            // Dot feeds stand for blank raster rows: they go into the
+            // printed raster and its head time, one motor step each
+            raster_.resize(raster_.size() + (size_t)dots * widthBytes(), 0);
+            stats_.raster_head_us += (int64_t)cost_us;
+            int64_t done = std::max(stats_.busy_until_us, t_us);
+            for (uint32_t i = 0; i < dots; i++) {
+                done += timing_.feed_dot_us;
+                row_done_us_.push_back(done);
+            }
+        }
+    } else if (first == 0x1D && second == 'V') {
+        stats_.cuts++;
+        cost_us = timing_.cut_us;
+    } else if (first == 0x1D && second == 'v') {
+        raster_width_ = cmd_[4] | (cmd_[5] << 8);
+        raster_left_ = (size_t)raster_width_ * (cmd_[6] | (cmd_[7] << 8));
+        raster_col_ = 0;
+        row_black_ = 0;
+        band_row_us_.clear();
+        if (raster_left_ > 0) {
+            return;     // Header kept in cmd_ until the band completes
+        }
+    } else if (first == 0x10 && second == 0x04) {
+        // Real-time: answered on arrival instead of queued behind the head
+        stats_.status_queries++;
+        if (status_replies_) {
+            replies_.push_back({t_us, (uint8_t)(0x12 | (online_ ? 0 : 0x08))});
+        }
+        buffered_ -= cmd_bytes_;
+        cmd_bytes_ = 0;
+        cmd_.clear();
+        return;
+    } else if (!(first == 0x1B && (second == '2' || second == '3'))) {
+        stats_.unknown++;
+    }
+    
+    cmd_.clear();
+    work(t_us, cost_us);
+}
+
+// Lock held. The command just received starts once the head is free.
+void SimPrinter::work(int64_t t_us, uint64_t cost_us)
+{
+    int64_t start = std::max(stats_.busy_until_us, t_us);
+    pending_.push_back({start, cmd_bytes_});
+    cmd_bytes_ = 0;
+    stats_.busy_until_us = start + (int64_t)cost_us;
+}
@@ -0,0 +1,433 @@
+/*
+ * SimRtos.cpp
+ * FreeRTOS tasks, queues, semaphores and notifications on std::thread
+ */
+
+#include "SimKernel.hpp"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* TAG = "SimRtos";
+
+struct SimTask {
+    std::string name;
+    TaskFunction_t function;
+    void* arg;
+    UBaseType_t priority;
+    uint32_t stack_depth;
+    BaseType_t core;
+    uint32_t notify;
+    bool deleted;
+    bool finished;
+};
+
+struct SimQueue {
+    enum class Kind : uint8_t {
+        Queue,
+        Binary,
+        Mutex,
+        Counting,
+    };
+    
+    Kind kind;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    std::vector<uint8_t> storage;
+};
+
+namespace {
+
+thread_local SimTask* current_task = nullptr;
+std::atomic<int> next_core(0);
+
+SimTask* currentTask()
+{
+    if (!current_task) {
+        // Threads the simulation didn't start (main, test drivers)
+        current_task = new SimTask{"main", nullptr, nullptr, 1, 0, 0, 0, false, false};
+    }
+    return current_task;
+}
+
+void taskThread(SimTask* task)
+{
+    current_task = task;
+    try {
+        task->function(task->arg);
+        ESP_LOGE(TAG, "Task %s returned without vTaskDelete()", task->name.c_str());
+    } catch (const SimKernel::TaskDeleted&) {
+        // vTaskDelete()
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    task->finished = true;
+    SimKernel::notifyAll();
+}
+
+SimQueue* createQueue(SimQueue::Kind kind, UBaseType_t length, UBaseType_t item_size, UBaseType_t count)
+{
+    if (length == 0) {
+        return nullptr;
+    }
+    SimQueue* queue = new SimQueue{kind, length, item_size, count, 0, {}};
+    queue->storage.resize((size_t)length * item_size);
+    return queue;
+}
+
+// Lock held
+bool pushItem(SimQueue* queue, const void* item, bool front)
+{
+    if (queue->count >= queue->length) {
+        return false;
+    }
+    if (queue->item_size > 0 && item) {
+        UBaseType_t slot;
+        if (front) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            slot = queue->head;
+        } else {
+            slot = (queue->head + queue->count) % queue->length;
+        }
+        memcpy(&queue->storage[(size_t)slot * queue->item_size], item, queue->item_size);
+    }
+    queue->count++;
+    SimKernel::notifyAll();
+    return true;
+}
+
+// Lock held
+void popItem(SimQueue* queue, void* item, bool remove)
+{
+    if (queue->item_size > 0 && item) {
+        memcpy(item, &queue->storage[(size_t)queue->head * queue->item_size], queue->item_size);
+    }
+    if (remove) {
+        queue->head = queue->item_size > 0 ? (queue->head + 1) % queue->length : 0;
+        queue->count--;
+        SimKernel::notifyAll();
+    }
+}
+
+BaseType_t send(QueueHandle_t queue, const void* item, TickType_t ticks, bool front)
+{
+    if (!queue) {
+        return pdFALSE;
+    }
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    if (!SimKernel::waitUntil(held, deadline, [queue] { return queue->count < queue->length; })) {
+        return pdFALSE;
+    }
+    return pushItem(queue, item, front) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t receive(QueueHandle_t queue, void* item, TickType_t ticks, bool remove)
+{
+    if (!queue) {
+        return pdFALSE;
+    }
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    if (!SimKernel::waitUntil(held, deadline, [queue] { return queue->count > 0; })) {
+        return pdFALSE;
+    }
+    popItem(queue, item, remove);
+    return pdTRUE;
+}
+
+}  // namespace
+
+bool simCurrentTaskDeleted()
+{
+    return current_task && current_task->deleted;
+}
+
+BaseType_t xPortInIsrContext(void)
+{
+    return SimKernel::inIsrContext() ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    SimTask* task = currentTask();
+    return task->core == tskNO_AFFINITY ? 0 : task->core;
+}
+
+// ===== Tasks =====
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char* name,
+                                           uint32_t stack_depth, void* arg, UBaseType_t priority,
+                                           StackType_t* stack, StaticTask_t* task_buffer,
+                                           BaseType_t core)
+{
+    (void)stack;
+    (void)task_buffer;
+    if (core == tskNO_AFFINITY) {
+        core = next_core.fetch_add(1) % 2;
+    }
+    SimTask* task = new SimTask{name ? name : "", function, arg, priority, stack_depth, core, 0, false, false};
+    std::thread(taskThread, task).detach();
+    return task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core)
+{
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(function, name, stack_depth, arg, priority,
+                                                      nullptr, nullptr, core);
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    SimTask* self = currentTask();
+    if (!task || task == self) {
+        self->deleted = true;
+        throw SimKernel::TaskDeleted();
+    }
+    
+    // The task unwinds at its next kernel wait. Task memory is never freed
+    // so a late reference can't touch freed memory.
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    task->deleted = true;
+    SimKernel::notifyAll();
+    int64_t limit = SimKernel::now() + 1000000 * (int64_t)SimKernel::timeScale();
+    if (!SimKernel::waitUntil(held, limit, [task] { return task->finished; })) {
+        ESP_LOGW(TAG, "Task %s did not reach a kernel wait; left running", task->name.c_str());
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    // Wakes on a tick boundary, like the real scheduler
+    int64_t tick_us = SimKernel::tickUs();
+    int64_t tick = SimKernel::now() / tick_us;
+    if (ticks == 0) {
+        std::this_thread::yield();
+        return;
+    }
+    SimKernel::sleepUntil((tick + ticks) * tick_us);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(SimKernel::now() / SimKernel::tickUs());
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return currentTask();
+}
+
+char* pcTaskGetName(TaskHandle_t task)
+{
+    if (!task) {
+        task = currentTask();
+    }
+    return &task->name[0];
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    return (task ? task : currentTask())->priority;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    return (task ? task : currentTask())->stack_depth;
+}
+
+// ===== Notifications =====
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    SimTask* self = currentTask();
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    SimKernel::waitUntil(held, deadline, [self] { return self->notify > 0; });
+    uint32_t value = self->notify;
+    if (value > 0) {
+        self->notify = clear_on_exit ? 0 : value - 1;
+    }
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    task->notify++;
+    SimKernel::notifyAll();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_woken)
+{
+    xTaskNotifyGive(task);
+    if (higher_priority_woken) {
+        *higher_priority_woken = pdTRUE;
+    }
+}
+
+// ===== Queues =====
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return createQueue(SimQueue::Kind::Queue, length, item_size, 0);
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t* storage, StaticQueue_t* queue_buffer)
+{
+    (void)storage;
+    (void)queue_buffer;
+    return xQueueCreate(length, item_size);
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    return send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higher_priority_woken)
+{
+    if (higher_priority_woken) {
+        *higher_priority_woken = pdFALSE;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return pushItem(queue, item, false) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    queue->count = 0;
+    queue->head = 0;
+    return pushItem(queue, item, false) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    return receive(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    return receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    queue->count = 0;
+    queue->head = 0;
+    SimKernel::notifyAll();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return queue->length - queue->count;
+}
+
+// ===== Semaphores =====
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return createQueue(SimQueue::Kind::Binary, 1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer)
+{
+    (void)buffer;
+    return xSemaphoreCreateBinary();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return createQueue(SimQueue::Kind::Mutex, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer)
+{
+    (void)buffer;
+    return xSemaphoreCreateMutex();
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    return createQueue(SimQueue::Kind::Counting, max_count, 0, initial_count);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t max_count, UBaseType_t initial_count,
+                                                 StaticSemaphore_t* buffer)
+{
+    (void)buffer;
+    return xSemaphoreCreateCounting(max_count, initial_count);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    return receive(semaphore, nullptr, ticks, true);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    return send(semaphore, nullptr, 0, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higher_priority_woken)
+{
+    return xQueueSendFromISR(semaphore, nullptr, higher_priority_woken);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore)
+{
+    return uxQueueMessagesWaiting(semaphore);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    vQueueDelete(semaphore);
+}
@@ -0,0 +1,240 @@
+/*
+ * SimStreamBuffer.cpp
+ * FreeRTOS stream and message buffers for the host simulation
+ */
+
+#include "SimKernel.hpp"
+#include "freertos/message_buffer.h"
+#include "freertos/stream_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+struct SimStreamBuffer {
+    size_t capacity;
+    size_t trigger_level;
+    bool messages;
+    std::vector<uint8_t> ring;
+    size_t head;
+    size_t count;
+};
+
+namespace {
+
+// Message length header, as configMESSAGE_BUFFER_LENGTH_TYPE on the ESP32
+typedef uint32_t MessageLength;
+
+SimStreamBuffer* create(size_t size, size_t trigger_level, bool messages)
+{
+    if (size == 0 || (messages && size <= sizeof(MessageLength))) {
+        return nullptr;
+    }
+    trigger_level = std::max<size_t>(1, std::min(trigger_level, size));
+    return new SimStreamBuffer{size, trigger_level, messages, std::vector<uint8_t>(size), 0, 0};
+}
+
+// Lock held
+void put(SimStreamBuffer* buffer, const void* data, size_t len)
+{
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    size_t tail = (buffer->head + buffer->count) % buffer->capacity;
+    size_t first = std::min(len, buffer->capacity - tail);
+    memcpy(&buffer->ring[tail], in, first);
+    memcpy(&buffer->ring[0], in + first, len - first);
+    buffer->count += len;
+    SimKernel::notifyAll();
+}
+
+// Lock held. `data` nullptr only looks.
+void take(SimStreamBuffer* buffer, void* data, size_t len, bool remove)
+{
+    if (data) {
+        uint8_t* out = static_cast<uint8_t*>(data);
+        size_t first = std::min(len, buffer->capacity - buffer->head);
+        memcpy(out, &buffer->ring[buffer->head], first);
+        memcpy(out + first, &buffer->ring[0], len - first);
+    }
+    if (remove) {
+        buffer->head = (buffer->head + len) % buffer->capacity;
+        buffer->count -= len;
+        SimKernel::notifyAll();
+    }
+}
+
+// Lock held
+size_t nextLength(SimStreamBuffer* buffer)
+{
+    if (buffer->count < sizeof(MessageLength)) {
+        return 0;
+    }
+    MessageLength len;
+    take(buffer, &len, sizeof(len), false);
+    return len;
+}
+
+size_t spaces(SimStreamBuffer* buffer)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return buffer ? buffer->capacity - buffer->count : 0;
+}
+
+BaseType_t reset(SimStreamBuffer* buffer)
+{
+    if (!buffer) {
+        return pdFAIL;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    buffer->head = 0;
+    buffer->count = 0;
+    SimKernel::notifyAll();
+    return pdPASS;
+}
+
+}  // namespace
+
+// ===== Stream buffers =====
+
+StreamBufferHandle_t xStreamBufferCreate(size_t size, size_t trigger_level)
+{
+    return create(size, trigger_level, false);
+}
+
+StreamBufferHandle_t xStreamBufferCreateStatic(size_t size, size_t trigger_level, uint8_t* storage,
+                                               StaticStreamBuffer_t* buffer)
+{
+    (void)storage;
+    (void)buffer;
+    return size > 1 ? create(size - 1, trigger_level, false) : nullptr;
+}
+
+void vStreamBufferDelete(StreamBufferHandle_t buffer)
+{
+    delete buffer;
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void* data, size_t len, TickType_t ticks)
+{
+    if (!buffer || len == 0) {
+        return 0;
+    }
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    size_t needed = std::min(len, buffer->capacity);
+    SimKernel::waitUntil(held, deadline, [buffer, needed] { return buffer->capacity - buffer->count >= needed; });
+    size_t n = std::min(len, buffer->capacity - buffer->count);
+    put(buffer, data, n);
+    return n;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void* data, size_t max, TickType_t ticks)
+{
+    if (!buffer || max == 0) {
+        return 0;
+    }
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    if (buffer->count == 0) {
+        SimKernel::waitUntil(held, deadline, [buffer] { return buffer->count >= buffer->trigger_level; });
+    }
+    size_t n = std::min(max, buffer->count);
+    take(buffer, data, n, true);
+    return n;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t buffer)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return buffer ? buffer->count : 0;
+}
+
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer)
+{
+    return spaces(buffer);
+}
+
+BaseType_t xStreamBufferIsEmpty(StreamBufferHandle_t buffer)
+{
+    return xStreamBufferBytesAvailable(buffer) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xStreamBufferReset(StreamBufferHandle_t buffer)
+{
+    return reset(buffer);
+}
+
+// ===== Message buffers =====
+
+MessageBufferHandle_t xMessageBufferCreate(size_t size)
+{
+    return create(size, 1, true);
+}
+
+MessageBufferHandle_t xMessageBufferCreateStatic(size_t size, uint8_t* storage, StaticMessageBuffer_t* buffer)
+{
+    (void)storage;
+    (void)buffer;
+    return size > 1 ? create(size - 1, 1, true) : nullptr;
+}
+
+void vMessageBufferDelete(MessageBufferHandle_t buffer)
+{
+    delete buffer;
+}
+
+size_t xMessageBufferSend(MessageBufferHandle_t buffer, const void* data, size_t len, TickType_t ticks)
+{
+    size_t needed = len + sizeof(MessageLength);
+    if (!buffer || needed > buffer->capacity) {
+        return 0;
+    }
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    auto room = [buffer, needed] { return buffer->capacity - buffer->count >= needed; };
+    if (!SimKernel::waitUntil(held, deadline, room)) {
+        return 0;
+    }
+    MessageLength header = (MessageLength)len;
+    put(buffer, &header, sizeof(header));
+    put(buffer, data, len);
+    return len;
+}
+
+size_t xMessageBufferReceive(MessageBufferHandle_t buffer, void* data, size_t max, TickType_t ticks)
+{
+    if (!buffer) {
+        return 0;
+    }
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    if (!SimKernel::waitUntil(held, deadline, [buffer] { return buffer->count > 0; })) {
+        return 0;
+    }
+    size_t len = nextLength(buffer);
+    if (len > max) {
+        return 0;
+    }
+    take(buffer, nullptr, sizeof(MessageLength), true);
+    take(buffer, data, len, true);
+    return len;
+}
+
+size_t xMessageBufferSpacesAvailable(MessageBufferHandle_t buffer)
+{
+    return spaces(buffer);
+}
+
+size_t xMessageBufferNextLengthBytes(MessageBufferHandle_t buffer)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return buffer ? nextLength(buffer) : 0;
+}
+
+BaseType_t xMessageBufferIsEmpty(MessageBufferHandle_t buffer)
+{
+    return xStreamBufferBytesAvailable(buffer) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xMessageBufferReset(MessageBufferHandle_t buffer)
+{
+    return reset(buffer);
+}
@@ -0,0 +1,321 @@
+/*
+ * SimUart.cpp
+ * UART driver with per-byte wire timing for the host simulation
+ */
+
+#include "Sim.hpp"
+#include "SimKernel.hpp"
+#include <algorithm>
+#include <deque>
+
+namespace {
+
+struct RxByte {
+    int64_t t_us;       // Available to uart_read_bytes from this time
+    uint8_t value;
+};
+
+struct Port {
+    bool installed;
+    size_t tx_buffer_size;
+    uint32_t baud;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uint32_t inverse;
+    double wire_free_us;     // When the last queued byte has left
+    std::vector<Sim::UartByte> tx;
+    std::deque<RxByte> rx;
+    Sim::UartListener listener;
+};
+
+Port ports[UART_NUM_MAX];
+
+bool validPort(uart_port_t port)
+{
+    return port >= 0 && port < UART_NUM_MAX;
+}
+
+// Lock held
+double byteUs(const Port& p)
+{
+    double stop = p.stop_bits == UART_STOP_BITS_2 ? 2 : (p.stop_bits == UART_STOP_BITS_1_5 ? 1.5 : 1);
+    double bits = 1 + (5 + (int)p.data_bits) + (p.parity != UART_PARITY_DISABLE ? 1 : 0) + stop;
+    return bits * 1e6 / p.baud;
+}
+
+}  // namespace
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, void* uart_queue, int intr_alloc_flags)
+{
+    (void)rx_buffer_size;
+    (void)queue_size;
+    (void)uart_queue;
+    (void)intr_alloc_flags;
+    if (!validPort(port) || tx_buffer_size < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Port& p = ports[port];
+    if (p.installed) {
+        return ESP_FAIL;
+    }
+    p.installed = true;
+    p.tx_buffer_size = (size_t)tx_buffer_size;
+    if (p.baud == 0) {
+        p.baud = 115200;
+        p.data_bits = UART_DATA_8_BITS;
+        p.stop_bits = UART_STOP_BITS_1;
+    }
+    p.wire_free_us = 0;
+    p.rx.clear();
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t port)
+{
+    if (!validPort(port)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    ports[port].installed = false;
+    return ESP_OK;
+}
+
+bool uart_is_driver_installed(uart_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return validPort(port) && ports[port].installed;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config)
+{
+    if (!validPort(port) || !config || config->baud_rate <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    Port& p = ports[port];
+    p.baud = (uint32_t)config->baud_rate;
+    p.data_bits = config->data_bits;
+    p.parity = config->parity;
+    p.stop_bits = config->stop_bits;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx_pin, int rx_pin, int rts_pin, int cts_pin)
+{
+    (void)tx_pin;
+    (void)rx_pin;
+    (void)rts_pin;
+    (void)cts_pin;
+    return validPort(port) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate)
+{
+    if (!validPort(port) || baud_rate == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    ports[port].baud = baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_get_baudrate(uart_port_t port, uint32_t* baud_rate)
+{
+    if (!validPort(port) || !baud_rate) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    *baud_rate = ports[port].baud;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_line_inverse(uart_port_t port, uint32_t inverse_mask)
+{
+    if (!validPort(port)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    ports[port].inverse = inverse_mask;
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t port, const void* src, size_t size)
+{
+    if (!validPort(port) || (!src && size > 0)) {
+        return -1;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(src);
+    std::vector<int64_t> arrival(size);
+    int64_t accepted_us;
+    Sim::UartListener listener;
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        Port& p = ports[port];
+        if (!p.installed) {
+            return -1;
+        }
+        
+        // Ring + hardware FIFO. A byte is accepted once fewer than
+        // `capacity` bytes are still waiting to leave; the call returns
+        // when the last one is accepted.
+        double capacity = (double)(p.tx_buffer_size + UART_HW_FIFO_LEN(port));
+        double byte_us = byteUs(p);
+        double t = (double)SimKernel::now();
+        for (size_t i = 0; i < size; i++) {
+            t = std::max(t, p.wire_free_us - (capacity - 1) * byte_us);
+            double start = std::max(t, p.wire_free_us);
+            p.wire_free_us = start + byte_us;
+            p.tx.push_back({(int64_t)start, data[i]});
+            arrival[i] = (int64_t)p.wire_free_us;
+        }
+        accepted_us = (int64_t)t;
+        listener = p.listener;
+    }
+    
+    if (listener && size > 0) {
+        listener(data, arrival.data(), size);
+    }
+    SimKernel::sleepUntil(accepted_us);
+    return (int)size;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks)
+{
+    if (!validPort(port)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int64_t done_us;
+    {
+        std::lock_guard<std::mutex> guard(SimKernel::lock());
+        if (!ports[port].installed) {
+            return ESP_FAIL;
+        }
+        done_us = (int64_t)ports[port].wire_free_us;
+    }
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    if (done_us > deadline) {
+        SimKernel::sleepUntil(deadline);
+        return ESP_ERR_TIMEOUT;
+    }
+    SimKernel::sleepUntil(done_us);
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void* buf, uint32_t length, TickType_t ticks)
+{
+    if (!validPort(port) || !buf) {
+        return -1;
+    }
+    uint8_t* out = static_cast<uint8_t*>(buf);
+    uint32_t got = 0;
+    int64_t deadline = SimKernel::deadlineAfter(ticks);
+    std::unique_lock<std::mutex> held(SimKernel::lock());
+    Port& p = ports[port];
+    if (!p.installed) {
+        return -1;
+    }
+    
+    while (true) {
+        int64_t now = SimKernel::now();
+        while (got < length && !p.rx.empty() && p.rx.front().t_us <= now) {
+            out[got++] = p.rx.front().value;
+            p.rx.pop_front();
+        }
+        if (got == length || now >= deadline) {
+            return (int)got;
+        }
+        // Wake for the next scheduled byte, an injection or the deadline
+        int64_t wake = p.rx.empty() ? deadline : std::min(deadline, p.rx.front().t_us);
+        size_t pending = p.rx.size();
+        SimKernel::waitUntil(held, wake, [&p, pending] { return p.rx.size() != pending; });
+    }
+}
+
+esp_err_t uart_flush_input(uart_port_t port)
+{
+    if (!validPort(port)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Drops what has arrived; bytes still in flight arrive later
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    std::deque<RxByte>& rx = ports[port].rx;
+    int64_t now = SimKernel::now();
+    while (!rx.empty() && rx.front().t_us <= now) {
+        rx.pop_front();
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t* size)
+{
+    if (!validPort(port) || !size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    int64_t now = SimKernel::now();
+    *size = 0;
+    for (const RxByte& b : ports[port].rx) {
+        if (b.t_us <= now) {
+            (*size)++;
+        }
+    }
+    return ESP_OK;
+}
+
+std::vector<Sim::UartByte> Sim::uartTx(uart_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return validPort(port) ? ports[port].tx : std::vector<UartByte>();
+}
+
+void Sim::uartClearTx(uart_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (validPort(port)) {
+        ports[port].tx.clear();
+    }
+}
+
+void Sim::uartInject(uart_port_t port, const uint8_t* data, size_t len, int64_t at_us)
+{
+    if (!validPort(port)) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    std::deque<RxByte>& rx = ports[port].rx;
+    for (size_t i = 0; i < len; i++) {
+        // Keep arrival order even if a later injection is scheduled earlier
+        int64_t t = rx.empty() ? at_us : std::max(at_us, rx.back().t_us);
+        rx.push_back({t, data[i]});
+    }
+    SimKernel::notifyAll();
+}
+
+void Sim::uartListen(uart_port_t port, UartListener listener)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    if (validPort(port)) {
+        ports[port].listener = listener;
+    }
+}
+
+uint32_t Sim::uartBaud(uart_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return validPort(port) ? ports[port].baud : 0;
+}
+
+uint32_t Sim::uartInverse(uart_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return validPort(port) ? ports[port].inverse : 0;
+}
+
+double Sim::uartByteUs(uart_port_t port)
+{
+    std::lock_guard<std::mutex> guard(SimKernel::lock());
+    return validPort(port) && ports[port].baud ? byteUs(ports[port]) : 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * Sim.hpp
+ * Control side of the host simulation: clock, UART, GPIO, I2C, I2S, flash,
+ * heap and HTTP
+ *
+ * The firmware only sees the ESP-IDF/FreeRTOS API in this directory;
+ * benches and host tools use this class to drive inputs and inspect
+ * what the drivers put on the wire. Log output is filtered with
+ * esp_log_level_set() as on the device.
+ */
+
+#pragma once
+
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "driver/i2s_std.h"
+#include "driver/uart.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// A device on a simulated I2C bus (called with the bus lock held)
+class SimI2CDevice {
+public:
+    virtual ~SimI2CDevice() = default;
+    
+    virtual void start(bool read) { (void)read; }
+    virtual bool write(uint8_t byte) = 0;   // Return false to NACK
+    virtual uint8_t read() { return 0xFF; }
+    virtual void stop() {}
+};
+
+class Sim {
+public:
+    struct UartByte {
+        int64_t t_us;       // Start bit on the wire
+        uint8_t value;
+    };
+    
+    // Called for each transmitted chunk, outside the driver lock.
+    // t_us[i] is when data[i] has fully arrived at the receiver.
+    using UartListener = std::function<void(const uint8_t* data, const int64_t* t_us, size_t len)>;
+    
+    // One 32-bit slot per frame, frames counted from the channel's enable.
+    // Called with the simulation lock held: compute, don't block.
+    using I2sSource = std::function<int32_t(uint64_t frame)>;
+    
+    // Simulated time runs `scale` times faster than the wall clock.
+    // Everything (esp_timer, ticks, UART, I2C) follows it; CPU work does
+    // not, so keep it at 1 when measuring code speed.
+    static void setTimeScale(double scale);
+    static double timeScale();
+    static int64_t now();
+    static void sleepUntil(int64_t t_us);
+    
+    // UART: the recorded TX stream, RX injection and a TX listener
+    static std::vector<UartByte> uartTx(uart_port_t port);
+    static void uartClearTx(uart_port_t port);
+    static void uartInject(uart_port_t port, const uint8_t* data, size_t len, int64_t at_us = 0);
+    static void uartListen(uart_port_t port, UartListener listener);
+    static uint32_t uartBaud(uart_port_t port);
+    static uint32_t uartInverse(uart_port_t port);
+    // Time one frame takes at the port's current settings
+    static double uartByteUs(uart_port_t port);
+    
+    // GPIO: drive a pin from outside (runs its ISR on a matching edge)
+    static void gpioDrive(gpio_num_t pin, int level);
+    static void gpioRelease(gpio_num_t pin);
+    static int gpioOutput(gpio_num_t pin);
+    
+    // I2C: attach a device model at a 7-bit address
+    static void i2cAttach(i2c_port_t port, uint8_t address, SimI2CDevice* device);
+    static void i2cDetach(i2c_port_t port, uint8_t address);
+    static uint64_t i2cBusTimeUs(i2c_port_t port);   // Total time SCL was busy
+    static uint64_t i2cBytes(i2c_port_t port);
+    
+    // I2S: what the microphone on a port delivers, and the frames the DMA
+    // ring lost because the reader fell behind (all enables so far)
+    static void i2sSetSource(int port, I2sSource source);
+    static uint64_t i2sOverflowedFrames(int port);
+    
+    // Flash: a data partition found by esp_partition_find_first(). Its
+    // contents outlive the drivers, so a "reboot" is deleting and
+    // recreating them.
+    static void flashAddPartition(const char* label, uint8_t subtype, size_t size);
+    // Power cut: after `bytes` more bytes are programmed (0 = at once),
+    // writes and erases fail until flashRestore()
+    static void flashCutAfter(size_t bytes);
+    static void flashRestore();
+    static std::vector<uint32_t> flashEraseCounts(const char* label);
+    
+    // Heap: sizes of the heaps behind heap_caps_malloc() (0 PSRAM = a
+    // module without it). Also restarts the minimum-free watermarks.
+    static void heapSetSize(size_t internal_bytes, size_t psram_bytes);
+    
+    // HTTP: esp_http_client_write() blocks until the simulated time
+    // `until_us`, as on a link that stopped moving (0 ends a stall)
+    static void httpStallWrites(int64_t until_us);
+};
@@ -0,0 +1,130 @@
+/*
+ * SimPrinter.hpp
+ * ESC/POS printer model on a simulated UART
+ *
+ * Parses what the firmware sends (ESC @, text + LF, ESC d, ESC J,
+ * GS v 0 raster, GS V cut, ESC 7 heating, DC2 # density, DLE EOT),
+ * rebuilds the printed raster (an ESC J dot feed as that many blank
+ * rows), answers status queries and runs a mechanical model with a
+ * bounded input buffer, so pacing mistakes show up as overflowed bytes.
+ * Each raster dot line takes as long as its black dots need at the
+ * current ESC 7 settings: ceil(black / firing dots) firings of the heat
+ * time plus the interval, never less than one motor step (feed_dot_us).
+ * Bytes sent at the wrong baud rate or polarity are counted as garbled
+ * and ignored.
+ */
+
+#pragma once
+
+#include "Sim.hpp"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class SimPrinter {
+public:
+    struct Timing {
+        uint32_t dot_line_us;   // Print one text dot line
+        uint32_t feed_dot_us;   // Feed one dot
+        uint16_t line_dots;     // Text line pitch
+        uint32_t cut_us;
+        uint32_t buffer_bytes;  // Input buffer; more unprocessed data is lost
+    };
+    static constexpr Timing DEFAULT_TIMING = {2500, 1250, 30, 300000, 4096};
+    
+    struct Stats {
+        uint32_t bytes;
+        uint32_t commands;
+        uint32_t bands;
+        uint32_t raster_rows;
+        uint32_t text_lines;
+        uint32_t feed_dots;
+        uint32_t cuts;
+        uint32_t status_queries;
+        uint32_t heat_changes;   // ESC 7 received
+        int64_t raster_head_us;  // Head time spent on raster lines
+        uint32_t unknown;        // Unrecognized ESC/GS commands
+        uint32_t garbled;        // Bytes at the wrong baud rate/polarity
+        uint32_t max_buffered;   // Peak unprocessed bytes
+        uint32_t overflowed;     // Bytes that arrived with the buffer full
+        int64_t busy_until_us;   // Mechanism finishes the queued work
+    };
+    
+    SimPrinter(uart_port_t port, uint32_t baud = 9600, const Timing& timing = DEFAULT_TIMING);
+    ~SimPrinter();
+    
+    // Start listening on the port
+    void attach();
+    void detach();
+    
+    // Status reply settings: no reply models an unwired printer TX line
+    void setStatusReplies(bool enabled);
+    void setOnline(bool online);
+    // Line inversion the printer expects (UART_SIGNAL_TXD_INV if the
+    // firmware must invert its TX)
+    void setInverse(uint32_t inverse) { inverse_ = inverse; }
+    
+    Stats getStats() const;
+    std::vector<std::string> textLines() const;
+    // Current ESC 7 settings and DC2 # density byte
+    void heating(uint8_t* dots, uint8_t* time, uint8_t* interval, uint8_t* density) const;
+    
+    // Printed raster rows, widthBytes() bytes each, MSB = leftmost dot.
+    // ESC J dot feeds count as blank rows.
+    std::vector<uint8_t> raster() const;
+    // Raster rows the head has finished by `t_us` (the rest were still
+    // in the input buffer or on the wire, e.g. at a power cut)
+    uint32_t rowsPrintedBy(int64_t t_us) const;
+    // When the head finished raster row `row`, -1 if it has not yet
+    int64_t rowDoneUs(uint32_t row) const;
+    uint16_t widthBytes() const { return 48; }
+    
+private:
+    uart_port_t port_;
+    uint32_t baud_;
+    Timing timing_;
+    uint32_t inverse_;
+    bool status_replies_;
+    bool online_;
+    
+    mutable std::mutex lock_;
+    Stats stats_;
+    std::vector<uint8_t> cmd_;        // Command being assembled
+    size_t raster_left_;              // GS v 0 pixel bytes still expected
+    uint16_t raster_width_;
+    uint32_t raster_col_;
+    std::string text_;
+    std::vector<std::string> lines_;
+    std::vector<uint8_t> raster_;
+    std::vector<int64_t> row_done_us_;   // When each raster row was printed
+    std::vector<uint32_t> band_row_us_;  // Line times of the band being received
+    uint32_t row_black_;
+    
+    // ESC 7 n1 n2 n3 and DC2 # n; power-on values until set
+    uint8_t heat_dots_;
+    uint8_t heat_time_;
+    uint8_t heat_interval_;
+    uint8_t density_;
+    
+    // Mechanical model: commands waiting for the head, in arrival order
+    struct Pending {
+        int64_t start_us;
+        uint32_t bytes;
+    };
+    std::deque<Pending> pending_;
+    uint32_t buffered_;
+    uint32_t cmd_bytes_;              // Bytes of the command being received
+    
+    struct Reply {
+        int64_t t_us;
+        uint8_t status;
+    };
+    std::vector<Reply> replies_;      // Status bytes to inject after parsing
+    
+    void onBytes(const uint8_t* data, const int64_t* t_us, size_t len);
+    void onByte(uint8_t byte, int64_t t_us);
+    size_t commandLength() const;
+    void execute(int64_t t_us);
+    void work(int64_t t_us, uint64_t cost_us);
+};
@@ -0,0 +1,149 @@
+/*
+ * driver/i2s_std.h (host simulation, standard-mode RX only)
+ *
+ * An enabled RX channel fills DMA descriptors of dma_frame_num frames at
+ * the sample rate on the simulated clock, from the source set with
+ * Sim::i2sSetSource() (silence without one). i2s_channel_read() hands
+ * over completed descriptors and blocks until enough are in. As on the
+ * device, a reader that falls behind by more than dma_desc_num
+ * descriptors loses the oldest ones; Sim::i2sOverflowedFrames() counts
+ * them. Mono 32-bit slots only, as the INMP441 is wired.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    I2S_NUM_0 = 0,
+    I2S_NUM_1 = 1,
+    I2S_NUM_AUTO,
+} i2s_port_t;
+
+typedef enum {
+    I2S_ROLE_MASTER,
+    I2S_ROLE_SLAVE,
+} i2s_role_t;
+
+typedef enum {
+    I2S_DATA_BIT_WIDTH_8BIT = 8,
+    I2S_DATA_BIT_WIDTH_16BIT = 16,
+    I2S_DATA_BIT_WIDTH_24BIT = 24,
+    I2S_DATA_BIT_WIDTH_32BIT = 32,
+} i2s_data_bit_width_t;
+
+typedef enum {
+    I2S_SLOT_BIT_WIDTH_AUTO = 0,
+    I2S_SLOT_BIT_WIDTH_32BIT = 32,
+} i2s_slot_bit_width_t;
+
+typedef enum {
+    I2S_SLOT_MODE_MONO = 1,
+    I2S_SLOT_MODE_STEREO = 2,
+} i2s_slot_mode_t;
+
+typedef enum {
+    I2S_STD_SLOT_LEFT = 1,
+    I2S_STD_SLOT_RIGHT = 2,
+    I2S_STD_SLOT_BOTH = 3,
+} i2s_std_slot_mask_t;
+
+typedef enum {
+    I2S_CLK_SRC_DEFAULT = 0,
+} i2s_clock_src_t;
+
+typedef enum {
+    I2S_MCLK_MULTIPLE_256 = 256,
+} i2s_mclk_multiple_t;
+
+#define I2S_GPIO_UNUSED GPIO_NUM_NC
+
+typedef struct i2s_channel_obj_t* i2s_chan_handle_t;
+
+typedef struct {
+    i2s_port_t id;
+    i2s_role_t role;
+    uint32_t dma_desc_num;
+    uint32_t dma_frame_num;
+    bool auto_clear;
+    int intr_priority;
+} i2s_chan_config_t;
+
+#define I2S_CHANNEL_DEFAULT_CONFIG(i2s_num, i2s_role) { \
+    .id = i2s_num,                                      \
+    .role = i2s_role,                                   \
+    .dma_desc_num = 6,                                  \
+    .dma_frame_num = 240,                               \
+    .auto_clear = false,                                \
+    .intr_priority = 0,                                 \
+}
+
+typedef struct {
+    uint32_t sample_rate_hz;
+    i2s_clock_src_t clk_src;
+    i2s_mclk_multiple_t mclk_multiple;
+} i2s_std_clk_config_t;
+
+#define I2S_STD_CLK_DEFAULT_CONFIG(rate) { \
+    .sample_rate_hz = rate,                \
+    .clk_src = I2S_CLK_SRC_DEFAULT,        \
+    .mclk_multiple = I2S_MCLK_MULTIPLE_256, \
+}
+
+typedef struct {
+    i2s_data_bit_width_t data_bit_width;
+    i2s_slot_bit_width_t slot_bit_width;
+    i2s_slot_mode_t slot_mode;
+    i2s_std_slot_mask_t slot_mask;
+    uint32_t ws_width;
+    bool ws_pol;
+    bool bit_shift;
+} i2s_std_slot_config_t;
+
+#define I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bits, mode) {                             \
+    .data_bit_width = bits,                                                           \
+    .slot_bit_width = I2S_SLOT_BIT_WIDTH_AUTO,                                        \
+    .slot_mode = mode,                                                                \
+    .slot_mask = (mode) == I2S_SLOT_MODE_MONO ? I2S_STD_SLOT_LEFT : I2S_STD_SLOT_BOTH, \
+    .ws_width = bits,                                                                 \
+    .ws_pol = false,                                                                  \
+    .bit_shift = true,                                                                \
+}
+
+typedef struct {
+    gpio_num_t mclk;
+    gpio_num_t bclk;
+    gpio_num_t ws;
+    gpio_num_t dout;
+    gpio_num_t din;
+    struct {
+        uint32_t mclk_inv : 1;
+        uint32_t bclk_inv : 1;
+        uint32_t ws_inv : 1;
+    } invert_flags;
+} i2s_std_gpio_config_t;
+
+typedef struct {
+    i2s_std_clk_config_t clk_cfg;
+    i2s_std_slot_config_t slot_cfg;
+    i2s_std_gpio_config_t gpio_cfg;
+} i2s_std_config_t;
+
+// tx_handle must be nullptr: the simulation has no I2S output
+esp_err_t i2s_new_channel(const i2s_chan_config_t* chan_cfg, i2s_chan_handle_t* tx_handle,
+                          i2s_chan_handle_t* rx_handle);
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t* std_cfg);
+
+// Enabling starts the DMA from an empty ring at frame 0 of the source
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle);
+
+// Blocks until `size` bytes are in or `timeout_ms` passes (ESP_ERR_TIMEOUT
+// with what there was). ESP_ERR_INVALID_STATE on a disabled channel.
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void* dest, size_t size, size_t* bytes_read,
+                           uint32_t timeout_ms);
@@ -0,0 +1,88 @@
+/*
+ * driver/uart.h (host simulation)
+ *
+ * Bytes leave the TX ring one frame time apart at the configured baud
+ * rate (start + data + parity + stop bits). uart_write_bytes() blocks
+ * only while the ring and FIFO are full, like the real driver; every byte
+ * is recorded with the time it went out (Sim::uartTx()). Received bytes
+ * are injected with Sim::uartInject() or by an attached SimPrinter.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+
+typedef int uart_port_t;
+
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+#define UART_NUM_MAX 3
+
+#define UART_PIN_NO_CHANGE (-1)
+#define UART_HW_FIFO_LEN(port) 128
+
+typedef enum {
+    UART_DATA_5_BITS,
+    UART_DATA_6_BITS,
+    UART_DATA_7_BITS,
+    UART_DATA_8_BITS,
+} uart_word_length_t;
+
+typedef enum {
+    UART_PARITY_DISABLE = 0,
+    UART_PARITY_EVEN = 2,
+    UART_PARITY_ODD = 3,
+} uart_parity_t;
+
+typedef enum {
+    UART_STOP_BITS_1 = 1,
+    UART_STOP_BITS_1_5 = 2,
+    UART_STOP_BITS_2 = 3,
+} uart_stop_bits_t;
+
+typedef enum {
+    UART_HW_FLOWCTRL_DISABLE = 0,
+    UART_HW_FLOWCTRL_RTS,
+    UART_HW_FLOWCTRL_CTS,
+    UART_HW_FLOWCTRL_CTS_RTS,
+} uart_hw_flowcontrol_t;
+
+typedef enum {
+    UART_SCLK_DEFAULT = 0,
+} uart_sclk_t;
+
+typedef enum {
+    UART_SIGNAL_INV_DISABLE = 0,
+    UART_SIGNAL_RXD_INV = 1 << 2,
+    UART_SIGNAL_TXD_INV = 1 << 10,
+} uart_signal_inv_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    uart_sclk_t source_clk;
+} uart_config_t;
+
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, void* uart_queue, int intr_alloc_flags);
+esp_err_t uart_driver_delete(uart_port_t port);
+bool uart_is_driver_installed(uart_port_t port);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config);
+esp_err_t uart_set_pin(uart_port_t port, int tx_pin, int rx_pin, int rts_pin, int cts_pin);
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate);
+esp_err_t uart_get_baudrate(uart_port_t port, uint32_t* baud_rate);
+esp_err_t uart_set_line_inverse(uart_port_t port, uint32_t inverse_mask);
+
+int uart_write_bytes(uart_port_t port, const void* src, size_t size);
+int uart_read_bytes(uart_port_t port, void* buf, uint32_t length, TickType_t ticks);
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks);
+esp_err_t uart_flush_input(uart_port_t port);
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t* size);
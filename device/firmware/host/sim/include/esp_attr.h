@@ -0,0 +1,9 @@
+/*
+ * esp_attr.h (host simulation)
+ */
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
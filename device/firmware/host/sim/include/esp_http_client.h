@@ -0,0 +1,77 @@
+/*
+ * esp_http_client.h (host simulation)
+ *
+ * The subset of the ESP-IDF HTTP client the firmware uses, over real
+ * POSIX sockets so firmware code can talk to a server on the host (see
+ * scripts/standin_backend.py). Plain http:// only: there is no TLS.
+ *
+ * As on the device, a handle keeps its connection between requests
+ * while the URL stays on the same host and port: open() on a connected
+ * handle sends the next request on the same socket. If the server has
+ * dropped that connection in the meantime, fetch_headers() fails and
+ * the caller closes and retries.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ESP_ERR_HTTP_BASE               0x7000
+#define ESP_ERR_HTTP_MAX_REDIRECT       (ESP_ERR_HTTP_BASE + 1)
+#define ESP_ERR_HTTP_CONNECT            (ESP_ERR_HTTP_BASE + 2)
+#define ESP_ERR_HTTP_WRITE_DATA         (ESP_ERR_HTTP_BASE + 3)
+#define ESP_ERR_HTTP_FETCH_HEADER       (ESP_ERR_HTTP_BASE + 4)
+#define ESP_ERR_HTTP_INVALID_TRANSPORT  (ESP_ERR_HTTP_BASE + 5)
+#define ESP_ERR_HTTP_CONNECTING         (ESP_ERR_HTTP_BASE + 6)
+#define ESP_ERR_HTTP_EAGAIN             (ESP_ERR_HTTP_BASE + 7)
+
+typedef struct esp_http_client* esp_http_client_handle_t;
+
+typedef enum {
+    HTTP_METHOD_GET = 0,
+    HTTP_METHOD_POST,
+    HTTP_METHOD_PUT,
+    HTTP_METHOD_PATCH,
+    HTTP_METHOD_DELETE,
+    HTTP_METHOD_HEAD,
+} esp_http_client_method_t;
+
+typedef struct {
+    const char* url;                // http://host[:port]/path[?query]
+    esp_http_client_method_t method;
+    int timeout_ms;                 // Per socket read or write; 5000 if 0
+    int buffer_size;                // Receive buffer; 512 if 0
+    int buffer_size_tx;             // Unused: requests are sent as built
+    bool keep_alive_enable;         // TCP keep-alive probes
+} esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t* config);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+
+// Headers are kept for every later request on the handle
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char* key, const char* value);
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char* url);
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method);
+
+// Connects if needed and sends the request head. write_len: the body
+// length, 0 for none, -1 for Transfer-Encoding: chunked (the caller
+// writes the chunk framing).
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+int esp_http_client_write(esp_http_client_handle_t client, const char* buffer, int len);
+
+// Reads the response head. Returns the Content-Length, -1 for a chunked
+// (or unknown length) body, ESP_FAIL if the connection failed.
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client);
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client);
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client);
+
+// Body bytes with the chunk framing removed. 0 at the end of the body
+// (or if the connection closed first: see is_complete_data_received),
+// negative on an error or timeout.
+int esp_http_client_read(esp_http_client_handle_t client, char* buffer, int len);
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
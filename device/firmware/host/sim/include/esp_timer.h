@@ -0,0 +1,10 @@
+/*
+ * esp_timer.h (host simulation)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Microseconds of simulated time since the process started
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,38 @@
+/*
+ * freertos/FreeRTOS.h (host simulation)
+ * Scheduler types and tick configuration for the Linux host build
+ *
+ * Tasks are std::threads, all kernel objects share one lock, and time
+ * comes from the simulated clock in Sim.hpp. Priorities and core
+ * affinity are recorded but Linux schedules the threads.
+ */
+
+#pragma once
+
+#include "esp_attr.h"   // Via portmacro.h on the device
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ 1000  // CONFIG_FREERTOS_HZ of the Arduino-ESP32 core
+#endif
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)(1000 / configTICK_RATE_HZ))
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// The simulated GPIO calls handlers synchronously; nothing to yield to
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+BaseType_t xPortInIsrContext(void);
+BaseType_t xPortGetCoreID(void);
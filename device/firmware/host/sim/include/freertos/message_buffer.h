@@ -0,0 +1,28 @@
+/*
+ * freertos/message_buffer.h (host simulation)
+ *
+ * Length-prefixed messages on a stream buffer. Each message takes its
+ * length plus a 4-byte header (size_t on the ESP32); a send writes all
+ * of it or nothing.
+ */
+
+#pragma once
+
+#include "freertos/stream_buffer.h"
+
+typedef StreamBufferHandle_t MessageBufferHandle_t;
+typedef StaticStreamBuffer_t StaticMessageBuffer_t;
+
+MessageBufferHandle_t xMessageBufferCreate(size_t size);
+MessageBufferHandle_t xMessageBufferCreateStatic(size_t size, uint8_t* storage, StaticMessageBuffer_t* buffer);
+void vMessageBufferDelete(MessageBufferHandle_t buffer);
+
+// Returns `len`, or 0 if it didn't fit before the timeout
+size_t xMessageBufferSend(MessageBufferHandle_t buffer, const void* data, size_t len, TickType_t ticks);
+// Returns the message length, or 0 on timeout or if it is longer than
+// `max` (the message stays in the buffer)
+size_t xMessageBufferReceive(MessageBufferHandle_t buffer, void* data, size_t max, TickType_t ticks);
+size_t xMessageBufferSpacesAvailable(MessageBufferHandle_t buffer);
+size_t xMessageBufferNextLengthBytes(MessageBufferHandle_t buffer);
+BaseType_t xMessageBufferIsEmpty(MessageBufferHandle_t buffer);
+BaseType_t xMessageBufferReset(MessageBufferHandle_t buffer);
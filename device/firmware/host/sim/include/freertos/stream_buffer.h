@@ -0,0 +1,32 @@
+/*
+ * freertos/stream_buffer.h (host simulation)
+ *
+ * Byte streams between one writer and one reader. A send blocks until
+ * the whole write fits (or the timeout, then writes what fits); a
+ * receive blocks on an empty buffer until the trigger level is reached.
+ *
+ * As in FreeRTOS, a static buffer keeps one byte of its storage empty:
+ * `size` bytes of storage hold size - 1 bytes of data.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct SimStreamBuffer* StreamBufferHandle_t;
+
+typedef struct {
+    void* reserved[8];
+} StaticStreamBuffer_t;
+
+StreamBufferHandle_t xStreamBufferCreate(size_t size, size_t trigger_level);
+StreamBufferHandle_t xStreamBufferCreateStatic(size_t size, size_t trigger_level, uint8_t* storage,
+                                               StaticStreamBuffer_t* buffer);
+void vStreamBufferDelete(StreamBufferHandle_t buffer);
+
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void* data, size_t len, TickType_t ticks);
+size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void* data, size_t max, TickType_t ticks);
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t buffer);
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t buffer);
+BaseType_t xStreamBufferIsEmpty(StreamBufferHandle_t buffer);
+BaseType_t xStreamBufferReset(StreamBufferHandle_t buffer);
@@ -0,0 +1,128 @@
+/*
+ * pegavox_raster.cpp
+ * C interface to RasterPipeline for host tools
+ */
+
+#include "pegavox_raster.h"
+#include "RasterPipeline.hpp"
+#include <cstring>
+
+namespace {
+
+// Rows straight from the caller's pixel buffer
+class BufferSource : public GraySource {
+public:
+    BufferSource(const uint8_t* pixels, size_t row_bytes, size_t stride, int height)
+        : pixels_(pixels)
+        , row_bytes_(row_bytes)
+        , stride_(stride)
+        , height_(height)
+        , y_(0)
+    {
+    }
+
+    bool readRow(uint8_t* row) override
+    {
+        if (y_ >= height_) {
+            return false;
+        }
+        memcpy(row, pixels_ + (size_t)y_ * stride_, row_bytes_);
+        y_++;
+        return true;
+    }
+
+private:
+    const uint8_t* pixels_;
+    size_t row_bytes_;
+    size_t stride_;
+    int height_;
+    int y_;
+};
+
+bool inRange(int v)
+{
+    return v > 0 && v <= 0xFFFF;
+}
+
+}  // namespace
+
+int pegavox_raster_height(int width, int height, int printer_width)
+{
+    if (!inRange(width) || !inRange(height) || !inRange(printer_width)) {
+        return -1;
+    }
+    if (width == printer_width) {
+        return height;
+    }
+    return RasterPipeline::scaledHeight((uint16_t)width, (uint16_t)height, (uint16_t)printer_width);
+}
+
+long pegavox_raster_render(const uint8_t* pixels, int width, int height, int channels, size_t stride,
+                           int printer_width, int pixelate_width, int dither,
+                           uint8_t* out, size_t out_size)
+{
+    int rows = pegavox_raster_height(width, height, printer_width);
+    if (rows < 0 || !pixels || !out || (channels != 1 && channels != 3 && channels != 4)
+        || stride < (size_t)width * channels || pixelate_width < 0 || pixelate_width > 0xFFFF
+        || dither < PEGAVOX_DITHER_FLOYD_STEINBERG || dither > PEGAVOX_DITHER_ATKINSON) {
+        return -1;
+    }
+    size_t width_bytes = ((size_t)printer_width + 7) / 8;
+    if (out_size < width_bytes * rows) {
+        return -1;
+    }
+
+    BufferSource source(pixels, (size_t)width * channels, stride, height);
+    RasterPipeline pipeline;
+    RasterPipeline::Config config = {
+        RasterPipeline::Resample::Lanczos,
+        (uint16_t)width,
+        (uint16_t)height,
+        (uint16_t)printer_width,
+        0,
+        (uint16_t)pixelate_width,
+        (uint8_t)channels,
+        (RasterPipeline::Dither)dither,
+    };
+    if (!pipeline.begin(source, config)) {
+        return -1;
+    }
+    for (int y = 0; y < rows; y++) {
+        if (!pipeline.readRow(out + (size_t)y * width_bytes)) {
+            return -1;
+        }
+    }
+    return (long)(width_bytes * rows);
+}
+
+long pegavox_raster_escpos(const uint8_t* bitmap, int bytes_per_row, int height,
+                           uint8_t* out, size_t out_size)
+{
+    if (!bitmap || !out || !inRange(bytes_per_row) || !inRange(height)) {
+        return -1;
+    }
+    size_t data = (size_t)bytes_per_row * height;
+    if (out_size < data + 8) {
+        return -1;
+    }
+    const uint8_t header[8] = {
+        0x1D, 0x76, 0x30, 0x00,
+        (uint8_t)bytes_per_row, (uint8_t)(bytes_per_row >> 8),
+        (uint8_t)height, (uint8_t)(height >> 8),
+    };
+    memcpy(out, header, sizeof(header));
+    memcpy(out + sizeof(header), bitmap, data);
+    return (long)(data + sizeof(header));
+}
+
+const char* pegavox_raster_simd(void)
+{
+    // Same test as RasterPipeline.cpp, built with the same flags
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
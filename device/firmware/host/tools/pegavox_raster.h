@@ -0,0 +1,49 @@
+/*
+ * pegavox_raster.h
+ * C interface to RasterPipeline for host tools (raster_tool, and
+ * scripts/raster_native.py through ctypes)
+ *
+ * Runs the printer post-processing of scripts/pipeline.py in one pass
+ * over decoded pixels: alpha over white, LANCZOS to the printer width,
+ * pixelate, dither and pack. With Floyd-Steinberg the bitmap is byte for
+ * byte the .final.bitmap.bin pipeline.py writes.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    PEGAVOX_DITHER_FLOYD_STEINBERG = 0,
+    PEGAVOX_DITHER_ORDERED = 1,
+    PEGAVOX_DITHER_ATKINSON = 2,
+};
+
+// Rows of the bitmap for a width x height image, or -1 if out of range
+int pegavox_raster_height(int width, int height, int printer_width);
+
+// Renders `pixels` (height rows of width * channels bytes, `stride` bytes
+// apart; channels 1 gray, 3 RGB, 4 RGBA) into `out` as packed rows, MSB
+// first, 1 = black, (printer_width + 7) / 8 bytes each. pixelate_width 0
+// skips the pixelate step. Returns the bytes written, or -1 for bad
+// arguments or an `out` too small.
+long pegavox_raster_render(const uint8_t* pixels, int width, int height, int channels, size_t stride,
+                           int printer_width, int pixelate_width, int dither,
+                           uint8_t* out, size_t out_size);
+
+// pipeline.py's escpos_gs_v_0(): GS v 0 header, then the bitmap.
+// Returns the bytes written, or -1 if `out` is too small.
+long pegavox_raster_escpos(const uint8_t* bitmap, int bytes_per_row, int height,
+                           uint8_t* out, size_t out_size);
+
+// Resampling path of this build: "avx2", "neon" or "scalar"
+const char* pegavox_raster_simd(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,326 @@
+/*
+ * raster_tool.cpp
+ * Native replacement for the printer post-processing in scripts/pipeline.py
+ *
+ * Usage:
+ *   raster_tool run1.generated.png                 (writes run1.final.bitmap.bin
+ *                                                   and run1.final.escpos.bin)
+ *   raster_tool --check *.generated.png            (compare with pipeline.py's files)
+ *   raster_tool --dither atkinson --out sticker a.png
+ *   raster_tool --bench 200 a.png                  (images per second)
+ *
+ * Reads PNG (when built with libpng) and binary PGM/PPM/PAM, runs alpha
+ * over white -> LANCZOS -> pixelate -> dither -> pack in one pass through
+ * RasterPipeline, and writes the bitmap and the ESC/POS GS v 0 stream.
+ * Outputs go next to the input, named as pipeline.py names them
+ * (<run>.generated.png -> <run>.final.*), or to --out <prefix>.final.*.
+ *
+ * --check compares with the .final.*.bin files already there instead of
+ * writing: with the default Floyd-Steinberg they match byte for byte.
+ */
+
+#include "pegavox_raster.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifndef PEGAVOX_HAVE_PNG
+#define PEGAVOX_HAVE_PNG 0
+#endif
+#if PEGAVOX_HAVE_PNG
+#include <png.h>
+#endif
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> pixels;
+};
+
+static bool loadFile(const std::string& path, std::vector<uint8_t>& out)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool saveFile(const std::string& path, const uint8_t* data, size_t len)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+// Next whitespace-separated header token of a netpbm file, skipping comments
+static bool pnmToken(const std::vector<uint8_t>& data, size_t& pos, std::string& token)
+{
+    token.clear();
+    while (pos < data.size()) {
+        char c = (char)data[pos];
+        if (c == '#') {
+            while (pos < data.size() && data[pos] != '\n') {
+                pos++;
+            }
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            if (!token.empty()) {
+                break;
+            }
+            pos++;
+        } else {
+            token += c;
+            pos++;
+        }
+    }
+    return !token.empty();
+}
+
+// P5 (gray), P6 (RGB) and P7 (PAM: GRAYSCALE, RGB, RGB_ALPHA), 8-bit
+static bool loadPnm(const std::vector<uint8_t>& data, Image& image)
+{
+    size_t pos = 0;
+    std::string magic;
+    std::string token;
+    if (!pnmToken(data, pos, magic)) {
+        return false;
+    }
+    int maxval = 0;
+    if (magic == "P5" || magic == "P6") {
+        std::string w;
+        std::string h;
+        if (!pnmToken(data, pos, w) || !pnmToken(data, pos, h) || !pnmToken(data, pos, token)) {
+            return false;
+        }
+        image.width = atoi(w.c_str());
+        image.height = atoi(h.c_str());
+        image.channels = magic == "P5" ? 1 : 3;
+        maxval = atoi(token.c_str());
+    } else if (magic == "P7") {
+        while (pnmToken(data, pos, token) && token != "ENDHDR") {
+            std::string value;
+            if (!pnmToken(data, pos, value)) {
+                return false;
+            }
+            if (token == "WIDTH") {
+                image.width = atoi(value.c_str());
+            } else if (token == "HEIGHT") {
+                image.height = atoi(value.c_str());
+            } else if (token == "DEPTH") {
+                image.channels = atoi(value.c_str());
+            } else if (token == "MAXVAL") {
+                maxval = atoi(value.c_str());
+            }
+        }
+    } else {
+        return false;
+    }
+    // One whitespace byte ends the header
+    pos++;
+    size_t bytes = (size_t)image.width * image.height * image.channels;
+    if (maxval != 255 || image.width <= 0 || image.height <= 0 || pos + bytes > data.size()) {
+        return false;
+    }
+    image.pixels.assign(data.begin() + pos, data.begin() + pos + bytes);
+    return true;
+}
+
+#if PEGAVOX_HAVE_PNG
+// Any 8-bit PNG as RGBA, as Image.open(...).convert("RGBA")
+static bool loadPng(const std::vector<uint8_t>& data, Image& image)
+{
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&png, data.data(), data.size())) {
+        return false;
+    }
+    png.format = PNG_FORMAT_RGBA;
+    image.width = (int)png.width;
+    image.height = (int)png.height;
+    image.channels = 4;
+    image.pixels.resize(PNG_IMAGE_SIZE(png));
+    if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr)) {
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+#endif
+
+static bool loadImage(const std::string& path, Image& image)
+{
+    std::vector<uint8_t> data;
+    if (!loadFile(path, data)) {
+        return false;
+    }
+#if PEGAVOX_HAVE_PNG
+    static const uint8_t PNG_MAGIC[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (data.size() >= 8 && memcmp(data.data(), PNG_MAGIC, 8) == 0) {
+        return loadPng(data, image);
+    }
+#endif
+    return loadPnm(data, image);
+}
+
+// <run>.generated.png -> <run>, as pipeline.py names its outputs
+static std::string runPrefix(const std::string& path)
+{
+    std::string prefix = path;
+    size_t dot = prefix.rfind('.');
+    size_t slash = prefix.rfind('/');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        prefix.erase(dot);
+    }
+    const std::string generated = ".generated";
+    if (prefix.size() > generated.size()
+        && prefix.compare(prefix.size() - generated.size(), generated.size(), generated) == 0) {
+        prefix.erase(prefix.size() - generated.size());
+    }
+    return prefix;
+}
+
+static bool sameAsFile(const std::string& path, const uint8_t* data, size_t len)
+{
+    std::vector<uint8_t> ref;
+    return loadFile(path, ref) && ref.size() == len && memcmp(ref.data(), data, len) == 0;
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+            "usage: %s [options] image.{png,pgm,ppm,pam} [...]\n"
+            "  --printer-width N   dots per row (384)\n"
+            "  --pixelate N        pixelate width, 0 = off (96)\n"
+            "  --dither KIND       fs, ordered or atkinson (fs)\n"
+            "  --out PREFIX        write PREFIX.final.* (one input only)\n"
+            "  --check             compare with the .final.*.bin files instead of writing\n"
+            "  --bench N           render each image N times and report images/s\n",
+            argv0);
+}
+
+int main(int argc, char** argv)
+{
+    int printer_width = 384;
+    int pixelate_width = 96;
+    int dither = PEGAVOX_DITHER_FLOYD_STEINBERG;
+    std::string out_prefix;
+    bool check = false;
+    int bench = 0;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--printer-width" && has_value) {
+            printer_width = atoi(argv[++i]);
+        } else if (arg == "--pixelate" && has_value) {
+            pixelate_width = atoi(argv[++i]);
+        } else if (arg == "--dither" && has_value) {
+            std::string kind = argv[++i];
+            if (kind == "fs" || kind == "floyd-steinberg") {
+                dither = PEGAVOX_DITHER_FLOYD_STEINBERG;
+            } else if (kind == "ordered") {
+                dither = PEGAVOX_DITHER_ORDERED;
+            } else if (kind == "atkinson") {
+                dither = PEGAVOX_DITHER_ATKINSON;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--out" && has_value) {
+            out_prefix = argv[++i];
+        } else if (arg == "--check") {
+            check = true;
+        } else if (arg == "--bench" && has_value) {
+            bench = atoi(argv[++i]);
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty() || (!out_prefix.empty() && inputs.size() > 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (bench > 0) {
+        printf("Resampling path: %s\n", pegavox_raster_simd());
+        printf("%-40s %11s %6s %10s %9s\n", "file", "input", "rows", "ms/image", "images/s");
+    }
+
+    int failures = 0;
+    for (const std::string& path : inputs) {
+        Image image;
+        if (!loadImage(path, image)) {
+            fprintf(stderr, "%s: cannot read (PNG%s, binary PGM/PPM/PAM)\n", path.c_str(),
+                    PEGAVOX_HAVE_PNG ? "" : " needs libpng");
+            return 1;
+        }
+        int rows = pegavox_raster_height(image.width, image.height, printer_width);
+        if (rows < 0) {
+            fprintf(stderr, "%s: %dx%d does not fit\n", path.c_str(), image.width, image.height);
+            return 1;
+        }
+        int bpr = (printer_width + 7) / 8;
+        std::vector<uint8_t> bitmap((size_t)bpr * rows);
+        std::vector<uint8_t> escpos(bitmap.size() + 8);
+        size_t stride = (size_t)image.width * image.channels;
+
+        auto render = [&]() {
+            return pegavox_raster_render(image.pixels.data(), image.width, image.height, image.channels,
+                                         stride, printer_width, pixelate_width, dither,
+                                         bitmap.data(), bitmap.size()) >= 0
+                && pegavox_raster_escpos(bitmap.data(), bpr, rows, escpos.data(), escpos.size()) >= 0;
+        };
+        if (!render()) {
+            fprintf(stderr, "%s: render failed\n", path.c_str());
+            return 1;
+        }
+
+        if (bench > 0) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (int n = 0; n < bench; n++) {
+                render();
+            }
+            double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            char size[24];
+            snprintf(size, sizeof(size), "%dx%dx%d", image.width, image.height, image.channels);
+            printf("%-40.40s %11s %6d %10.3f %9.1f\n", path.c_str(), size, rows, s * 1000 / bench, bench / s);
+            continue;
+        }
+
+        std::string prefix = out_prefix.empty() ? runPrefix(path) : out_prefix;
+        std::string bitmap_path = prefix + ".final.bitmap.bin";
+        std::string escpos_path = prefix + ".final.escpos.bin";
+        if (check) {
+            bool same_bitmap = sameAsFile(bitmap_path, bitmap.data(), bitmap.size());
+            bool same_escpos = sameAsFile(escpos_path, escpos.data(), escpos.size());
+            printf("%s: bitmap %s, escpos %s\n", path.c_str(), same_bitmap ? "identical" : "DIFFERS",
+                   same_escpos ? "identical" : "DIFFERS");
+            failures += !same_bitmap || !same_escpos;
+        } else if (!saveFile(bitmap_path, bitmap.data(), bitmap.size())
+                   || !saveFile(escpos_path, escpos.data(), escpos.size())) {
+            fprintf(stderr, "%s: cannot write %s.final.*\n", path.c_str(), prefix.c_str());
+            return 1;
+        } else {
+            printf("%s -> %s (%d rows)\n", path.c_str(), bitmap_path.c_str(), rows);
+        }
+    }
+    return failures ? 1 : 0;
+}
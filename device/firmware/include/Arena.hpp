@@ -0,0 +1,106 @@
+/*
+ * Arena.hpp
+ * Per-job bump allocator over one block reserved at boot
+ *
+ * allocate() moves a pointer forward; reset() moves it back to the start,
+ * so everything a job took is given back at once in O(1) and the block is
+ * never fragmented. Nothing is freed on its own: buffers live until the
+ * owner's next reset(), which it calls once the job has ended. The owner
+ * decides where the block lives (internal RAM, PSRAM or a static array),
+ * see MemoryBudget::reserve().
+ *
+ * Not thread-safe: one task allocates from an arena and resets it.
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+class Arena {
+public:
+    Arena()
+        : base_(nullptr)
+        , capacity_(0)
+        , used_(0)
+        , high_water_(0)
+        , failures_(0)
+    {
+    }
+    
+    void init(void* base, size_t capacity)
+    {
+        base_ = static_cast<uint8_t*>(base);
+        capacity_ = base ? capacity : 0;
+        used_ = 0;
+        high_water_ = 0;
+        failures_ = 0;
+    }
+    
+    // nullptr once the block is full; the arena is left as it was
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        uintptr_t start = reinterpret_cast<uintptr_t>(base_) + used_;
+        size_t pad = (align - start % align) % align;
+        if (pad + bytes > capacity_ - used_) {
+            failures_++;
+            return nullptr;
+        }
+        void* ptr = base_ + used_ + pad;
+        used_ += pad + bytes;
+        if (used_ > high_water_) {
+            high_water_ = used_;
+        }
+        return ptr;
+    }
+    
+    // `count` zeroed elements; only for types that need no destructor
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        if (count > (capacity_ / sizeof(T))) {
+            failures_++;
+            return nullptr;
+        }
+        void* ptr = allocate(count * sizeof(T), alignof(T));
+        if (ptr) {
+            memset(ptr, 0, count * sizeof(T));
+        }
+        return static_cast<T*>(ptr);
+    }
+    
+    // Give back everything allocated since the last reset
+    void reset() { used_ = 0; }
+    
+    size_t used() const { return used_; }
+    size_t capacity() const { return capacity_; }
+    size_t highWater() const { return high_water_; }       // Most any one job used
+    uint32_t failures() const { return failures_; }        // Allocations that didn't fit
+    
+    // For code that runs with or without an arena: take `count` zeroed
+    // elements from `arena` if there is one, from the heap otherwise, and
+    // release() only what came from the heap.
+    template <typename T>
+    static T* allocateFrom(Arena* arena, size_t count)
+    {
+        return arena ? arena->allocate<T>(count) : new (std::nothrow) T[count]();
+    }
+    
+    template <typename T>
+    static void release(Arena* arena, T* ptr)
+    {
+        if (!arena) {
+            delete[] ptr;
+        }
+    }
+
+private:
+    uint8_t* base_;
+    size_t capacity_;
+    size_t used_;
+    size_t high_water_;
+    uint32_t failures_;
+};
@@ -0,0 +1,77 @@
+/*
+ * AudioCapture.hpp
+ * INMP441 I2S microphone capture into a lock-free ring buffer
+ */
+
+#pragma once
+
+#include "driver/i2s_std.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "SpscRing.hpp"
+#include "AudioFrontEnd.hpp"
+#include "TaskLayout.hpp"
+#include <atomic>
+
+class AudioCapture {
+public:
+    // ring_samples must be a power of two; 32768 = 2 s at 16 kHz
+    AudioCapture(gpio_num_t bclk_pin, gpio_num_t ws_pin, gpio_num_t data_pin,
+                 uint32_t sample_rate = 16000, size_t ring_samples = 32768);
+    ~AudioCapture();
+    
+    bool begin(const TaskSpec& task = TaskLayout::AUDIO_READER);
+    
+    // Start/stop recording. start() discards anything left in the ring;
+    // stop() returns once the reader task has parked (at most one DMA batch).
+    bool start();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+    
+    // Consumer side (one task): copies up to `max` samples, waiting up to
+    // `timeout` for the first one. Returns 0 on timeout.
+    size_t read(int16_t* out, size_t max, TickType_t timeout);
+    
+    // True once stopped and every captured sample has been read
+    bool drained() const { return !running_.load() && ring_.size() == 0; }
+    
+    uint32_t getSampleRate() const { return sample_rate_; }
+    uint32_t getDroppedSamples() const { return dropped_.load(); }
+    size_t getRingHighWater() const { return ring_high_water_; }
+
+private:
+    gpio_num_t bclk_pin_;
+    gpio_num_t ws_pin_;
+    gpio_num_t data_pin_;
+    uint32_t sample_rate_;
+    size_t ring_samples_;
+    
+    i2s_chan_handle_t rx_chan_;
+    TaskHandle_t reader_task_;
+    TaskStorage<TaskLayout::AUDIO_READER.stack> task_storage_;
+    std::atomic<TaskHandle_t> consumer_task_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stopping_;        // Set by stop(); the reader parks on it
+    SemaphoreHandle_t parked_;          // Given by the reader once parked
+    StaticSemaphore_t parked_buf_;
+    std::atomic<uint32_t> dropped_;
+    size_t ring_high_water_;
+    
+    int16_t* ring_storage_;
+    SpscRing<int16_t> ring_;
+    
+    // One DMA frame batch: 240 frames = 15 ms at 16 kHz
+    static constexpr size_t DMA_FRAMES = 240;
+    static constexpr uint32_t DMA_DESCRIPTORS = 6;
+    int32_t dma_buf_[DMA_FRAMES];
+    int16_t pcm_buf_[DMA_FRAMES];
+    DcBlocker dc_blocker_;
+    
+    static constexpr const char* TAG = "AudioCapture";
+    
+    static void taskEntry(void* arg);
+    void readerTask();
+};
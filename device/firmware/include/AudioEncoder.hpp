@@ -0,0 +1,135 @@
+/*
+ * AudioEncoder.hpp
+ * Streaming audio encoders for the upload path (WAV PCM, IMA-ADPCM, FLAC)
+ *
+ * Encoders take int16 mono PCM in arbitrary-sized pieces and hand out
+ * complete units (header, ADPCM block, FLAC frame) through the output
+ * callback, so each unit can go out as one HTTP chunk. Stream lengths are
+ * unknown up front: WAV sizes are 0xFFFFFFFF and FLAC total_samples is 0.
+ *
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include "Arena.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class AudioEncoder {
+public:
+    using Output = std::function<void(const uint8_t* data, size_t len)>;
+
+    AudioEncoder();
+    virtual ~AudioEncoder() = default;
+
+    // HTTP Content-Type for the encoded stream
+    virtual const char* contentType() const = 0;
+
+    // Allocates per-stream buffers and emits the stream header.
+    // Returns false if the sample rate is unsupported or out of memory.
+    virtual bool begin(uint32_t sample_rate, Output output) = 0;
+
+    // Feed samples; complete units are emitted as they fill
+    virtual void encode(const int16_t* samples, size_t count) = 0;
+
+    // Flush the last partial unit
+    virtual void finish() = 0;
+
+    // Release buffers held since begin()
+    virtual void end() {}
+
+    // Per-stream buffers come from `arena` from the next begin() on
+    // (nullptr: the heap). Reset the arena only after end().
+    void setArena(Arena* arena) { arena_ = arena; }
+
+    uint32_t samplesIn() const { return samples_in_; }
+    uint32_t bytesOut() const { return bytes_out_; }
+
+protected:
+    Output output_;
+    Arena* arena_;
+    uint32_t samples_in_;
+    uint32_t bytes_out_;
+
+    void start(Output output);
+    void emit(const uint8_t* data, size_t len);
+};
+
+// Raw 16-bit PCM in a streaming WAV container (audio/wav)
+class PcmWavEncoder : public AudioEncoder {
+public:
+    const char* contentType() const override { return "audio/wav"; }
+    bool begin(uint32_t sample_rate, Output output) override;
+    void encode(const int16_t* samples, size_t count) override;
+    void finish() override {}
+};
+
+// 4-bit IMA-ADPCM in WAV (format tag 0x0011), 4:1 at minimal CPU
+class ImaAdpcmEncoder : public AudioEncoder {
+public:
+    // 256-byte blocks hold 505 samples (~32 ms at 16 kHz)
+    static constexpr uint16_t BLOCK_ALIGN = 256;
+    static constexpr uint16_t SAMPLES_PER_BLOCK = (BLOCK_ALIGN - 4) * 2 + 1;
+
+    ImaAdpcmEncoder();
+
+    const char* contentType() const override { return "audio/wav"; }
+    bool begin(uint32_t sample_rate, Output output) override;
+    void encode(const int16_t* samples, size_t count) override;
+    void finish() override;
+
+private:
+    int16_t block_[SAMPLES_PER_BLOCK];
+    uint16_t block_fill_;
+    uint8_t out_[BLOCK_ALIGN];
+    int32_t predictor_;
+    int32_t step_index_;
+
+    void encodeBlock();
+    uint8_t encodeSample(int16_t sample);
+};
+
+// Lossless FLAC subset: fixed block size, fixed predictors (order 0-4),
+// partitioned Rice residuals. One frame of working memory.
+class FlacEncoder : public AudioEncoder {
+public:
+    // 1024 samples = 64 ms at 16 kHz per frame
+    static constexpr uint16_t BLOCK_SIZE = 1024;
+    static constexpr uint8_t MAX_PARTITION_ORDER = 4;
+
+    FlacEncoder();
+    ~FlacEncoder() override;
+
+    const char* contentType() const override { return "audio/flac"; }
+    bool begin(uint32_t sample_rate, Output output) override;
+    void encode(const int16_t* samples, size_t count) override;
+    void finish() override;
+    void end() override;
+
+    // Working memory held between begin() and end()
+    size_t memoryUsed() const;
+
+private:
+    uint32_t sample_rate_;
+    uint8_t rate_code_;       // Frame-header sample rate code
+    Arena* buffers_arena_;    // Where the buffers below came from
+    int16_t* block_;          // Samples of the frame being filled
+    uint16_t block_fill_;
+    uint32_t* residual_;      // Zigzag-mapped residuals of the chosen order
+    uint8_t* frame_;          // Encoded frame (worst case: verbatim)
+    size_t frame_capacity_;
+    uint32_t frame_number_;
+
+    // MSB-first bit writer into frame_
+    size_t byte_pos_;
+    uint64_t bit_acc_;
+    uint8_t bit_count_;
+
+    void encodeFrame();
+    void writeSubframe(uint16_t count);
+    void putBits(uint32_t value, uint8_t bits);
+    void putRice(uint32_t value, uint8_t k);
+    void alignByte();
+};
@@ -0,0 +1,112 @@
+/*
+ * AudioFrontEnd.hpp
+ * Fixed-point audio front-end: 32->16-bit conversion, DC blocking and
+ * frame-RMS silence trimming
+ *
+ * SilenceTrimmer is trim_silence_pcm16() in scripts/pipeline.py (same
+ * frames, threshold_db and pad_ms) on a stream instead of the whole
+ * recording. Silence after voice is held back until it is known to be a
+ * pause, which is kept, or the tail, which is cut to the pad. Memory is
+ * bounded by hold_ms: a longer silence is sent as it goes, so the output
+ * equals the Python function's whenever the trailing silence, or with no
+ * voice at all the whole recording, fits in hold_ms. Past that it only
+ * ever has more silence, never less audio.
+ *
+ * max_gap_ms > 0 opts into cutting pauses inside the recording as well,
+ * down to pad_ms each side, which the Python function does not do.
+ *
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include "Arena.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// INMP441 delivers 24-bit samples left-justified in 32-bit slots.
+// shift = 16 keeps full scale; smaller shifts add 6 dB of gain per bit
+// and saturate instead of wrapping.
+void convertSamples32to16(const int32_t* in, int16_t* out, size_t count, int shift = 16);
+
+// One-pole DC-blocking high-pass: y[n] = x[n] - x[n-1] + R * y[n-1]
+// R = 0.995 puts the corner near 13 Hz at 16 kHz.
+class DcBlocker {
+public:
+    explicit DcBlocker(int16_t r_q15 = 32604);
+
+    void reset();
+    void process(int16_t* samples, size_t count);
+
+private:
+    int32_t r_q15_;
+    int32_t x_prev_;
+    int64_t y_prev_q15_;   // Previous output with 15 fractional bits
+};
+
+class SilenceTrimmer {
+public:
+    using Output = std::function<void(const int16_t* samples, size_t count)>;
+
+    struct Config {
+        uint32_t sample_rate;
+        uint16_t frame_ms;
+        float threshold_db;    // Frames above this RMS dBFS count as voice
+        uint16_t pad_ms;       // Audio kept before/after voice
+        uint32_t hold_ms;      // Silence held back before it is sent anyway
+        uint16_t max_gap_ms;   // 0: keep pauses, as pipeline.py; else cut
+                               // longer ones down to pad_ms each side
+    };
+    static constexpr Config DEFAULT_CONFIG = {16000, 30, -35.0f, 120, 600, 0};
+
+    SilenceTrimmer();
+    ~SilenceTrimmer();
+
+    // Allocates the frame buffers; returns false if out of memory
+    bool begin(const Config& config, Output output);
+    void end();
+
+    // Frame buffers come from `arena` from the next begin() on (nullptr:
+    // the heap). Reset the arena only after end().
+    void setArena(Arena* arena) { arena_ = arena; }
+
+    // Feed captured samples; voiced audio is passed to the output callback
+    void process(const int16_t* samples, size_t count);
+
+    // End of recording: flush the trailing pad and drop the rest. With no
+    // voice at all, the held recording goes out as is instead.
+    void finish();
+
+    bool voiceDetected() const { return voice_seen_; }
+    uint32_t samplesIn() const { return samples_in_; }
+    uint32_t samplesOut() const { return samples_out_; }
+    size_t memoryUsed() const { return (size_t)(slots_ + 1) * frame_len_ * sizeof(int16_t); }
+
+private:
+    Output output_;
+    uint16_t frame_len_;
+    uint16_t pad_frames_;
+    uint16_t gap_frames_;     // Pause length that is cut, 0: never
+    uint16_t slots_;          // Held-frame capacity (pre-roll or pause)
+    double threshold_sum_;    // frame_len * (32768 * 10^(dB/20))^2
+    Arena* arena_;
+    Arena* buffers_arena_;    // Where frame_ and held_ came from
+
+    int16_t* frame_;          // Frame being filled
+    uint16_t frame_fill_;
+    int16_t* held_;           // Ring of silent frames held back
+    uint16_t held_start_;
+    uint16_t held_count_;
+    bool voice_seen_;
+    bool in_voice_;           // Inside an utterance (pause not cut)
+
+    uint32_t samples_in_;
+    uint32_t samples_out_;
+
+    void onFrame();
+    void holdFrame();
+    void emitHeld(uint16_t count);
+    void dropHeld(uint16_t count);
+    void emit(const int16_t* samples, size_t count);
+};
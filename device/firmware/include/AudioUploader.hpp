@@ -0,0 +1,79 @@
+/*
+ * AudioUploader.hpp
+ * Streams live microphone audio to POST /api/v1/audio (chunked transfer)
+ * with leading/trailing silence trimmed on the device
+ *
+ * The trimmer's and encoder's buffers come from a per-upload Arena
+ * reserved in begin() (PSRAM when the module has it) and reset after
+ * each upload, so recording after recording leaves the heap untouched.
+ */
+
+#pragma once
+
+#include "AudioCapture.hpp"
+#include "AudioEncoder.hpp"
+#include "AudioFrontEnd.hpp"
+#include "Arena.hpp"
+#include "TaskLayout.hpp"
+#include "esp_http_client.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <functional>
+
+class AudioUploader {
+public:
+    // job_id is empty when ok == false
+    using DoneCallback = std::function<void(bool ok, const char* job_id)>;
+    
+    AudioUploader(AudioCapture& capture, const char* base_url, const char* device_token);
+    ~AudioUploader();
+    
+    bool begin(const TaskSpec& task = TaskLayout::NETWORK);
+    void setCallback(DoneCallback callback);
+    
+    // Body encoding for the next uploads (ImaAdpcmEncoder, FlacEncoder);
+    // nullptr selects plain PCM WAV. Must not change during an upload.
+    void setEncoder(AudioEncoder* encoder);
+    
+    // Begin streaming the current recording; the upload ends once the
+    // capture is stopped and drained. Returns false if one is running.
+    bool startUpload();
+
+private:
+    AudioCapture& capture_;
+    const char* base_url_;
+    const char* device_token_;
+    DoneCallback callback_;
+    SemaphoreHandle_t start_sem_;
+    StaticSemaphore_t start_storage_;
+    TaskHandle_t task_handle_;
+    TaskStorage<TaskLayout::NETWORK.stack> task_storage_;
+    volatile bool busy_;
+    
+    // 512 samples = 32 ms of audio per HTTP chunk
+    static constexpr size_t CHUNK_SAMPLES = 512;
+    static constexpr size_t JOB_ID_LEN = 64;
+    // Pauses longer than this are cut to SilenceTrimmer's pad each side
+    static constexpr uint16_t MAX_PAUSE_MS = 600;
+    // Trimmer at 16 kHz (24 KB) and a FLAC frame (8 KB), with headroom
+    static constexpr size_t ARENA_BYTES = 40 * 1024;
+    int16_t chunk_buf_[CHUNK_SAMPLES];
+    Arena arena_;
+    SilenceTrimmer trimmer_;
+    PcmWavEncoder pcm_encoder_;
+    AudioEncoder* encoder_;
+    char job_id_[JOB_ID_LEN];
+    
+    // Current upload, for the encoder output
+    esp_http_client_handle_t client_;
+    bool write_ok_;
+    
+    static constexpr const char* TAG = "AudioUploader";
+    
+    static void taskEntry(void* arg);
+    void task();
+    bool upload();
+    bool writeChunk(esp_http_client_handle_t client, const void* data, size_t len);
+    bool parseJobId(const char* body);
+};
@@ -0,0 +1,146 @@
+/*
+ * BackendClient.hpp
+ * Fetches a job's sticker from the backend straight into the StickerPipeline
+ *
+ * One HTTP/1.1 connection is kept open and reused for every request. The
+ * result is long-polled: GET /api/v1/job/{id}/raster?wait=N is held by
+ * the server until the job is done (or N seconds pass, 204, and the
+ * client asks again at once), then the PVR1 raster comes back as a
+ * chunked application/x-pvr1 body. Each piece is written into the
+ * pipeline as it arrives, so the first band prints while the rest is
+ * still downloading, and nothing here grows with the sticker: RAM is
+ * one receive buffer plus the pipeline's fixed buffers.
+ *
+ * Format::Json uses GET /api/v1/job/{id}?wait=N instead, for a backend
+ * that only serves the JSON document: JsonRasterParser decodes its
+ * base64 raster_data on the fly into the same pipeline, and its optional
+ * caption is printed under the sticker. See
+ * docs/backend-device-api-contract.md.
+ *
+ * With setSpool(), the raster is also teed into the PrintSpool as it
+ * downloads, like a buffered sticker: the record is committed once the
+ * whole body is in, just before the pipeline is closed, so the sticker
+ * resumes after a reset (from its first row: the streamed job writes no
+ * progress marks) and can be put in the StickerCache. The flash erases
+ * and programs run in the network task between reads; the pipeline's
+ * stream buffer keeps the head fed meanwhile. A caption is not part of
+ * the record.
+ */
+
+#pragma once
+
+#include "JsonRasterParser.hpp"
+#include "PrintSpool.hpp"
+#include "StickerPipeline.hpp"
+#include "esp_http_client.h"
+#include "freertos/FreeRTOS.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class BackendClient {
+public:
+    enum class Format : uint8_t {
+        Pvr1,           // Binary result endpoint
+        Json,           // Base64 inside the job document
+    };
+    
+    struct Config {
+        Format format;
+        uint32_t wait_s;            // Long poll: how long the server may hold a request
+        uint32_t job_timeout_s;     // Give up on a job still processing after this
+    };
+    
+    static constexpr Config DEFAULT_CONFIG = {
+        Format::Pvr1,
+        20,
+        120,
+    };
+    
+    struct Stats {
+        uint32_t connections;       // Connects, first or after a drop
+        uint32_t requests;
+        uint32_t waits;             // Long polls answered "still processing"
+        uint32_t body_bytes;        // Result bodies as received
+        uint32_t raster_bytes;      // PVR1 bytes written into the pipeline
+        uint32_t stickers;
+        uint32_t failed;
+        uint32_t spooled;           // Stickers committed to the spool
+        uint32_t spool_failures;    // Tees given up (spool full or failing)
+    };
+    
+    // Network task, for a sticker committed to the spool; the pipeline is
+    // closed once it returns
+    using SpooledCallback = std::function<void(const PrintSpool::Record& record)>;
+    
+    BackendClient(const char* base_url, const char* device_token, const Config& config = DEFAULT_CONFIG);
+    ~BackendClient();
+    
+    bool begin();
+    
+    // Tee every sticker into `spool` (nullptr for none). A full or failing
+    // spool only drops the tee; the sticker still prints. Set before
+    // fetchSticker().
+    void setSpool(PrintSpool* spool, SpooledCallback on_spooled = nullptr);
+    
+    // Network task: waits for the job's result and writes its raster into
+    // `pipeline` as it downloads. Returns once the download has ended (the
+    // printer may still be busy with the last rows). False if the job
+    // failed, timed out or the download broke; a sticker already started
+    // is then closed as failed.
+    bool fetchSticker(const char* job_id, StickerPipeline& pipeline);
+    
+    // Closes the connection (e.g. before Wi-Fi goes to sleep); the next
+    // request opens a new one
+    void disconnect();
+    
+    Stats getStats() const { return stats_; }
+    // The backend's message for the last job that failed, "" if none
+    const char* lastError() const { return error_; }
+    
+private:
+    enum class Reply : uint8_t {
+        Done,
+        Pending,
+        Failed,
+    };
+    
+    const char* base_url_;
+    const char* device_token_;
+    Config config_;
+    esp_http_client_handle_t client_;
+    bool connected_;
+    Stats stats_;
+    
+    // Current sticker
+    StickerPipeline* pipeline_;
+    bool opened_;
+    bool write_ok_;
+    uint32_t received_;         // Raster bytes of this sticker
+    PrintSpool* spool_;
+    SpooledCallback on_spooled_;
+    bool spooling_;             // Record open for this sticker
+    JsonRasterParser parser_;
+    
+    // One TCP segment per read
+    static constexpr size_t RX_BYTES = 1460;
+    static constexpr size_t URL_LEN = 160;
+    // "HTTP <status>: " and the whole of JsonRasterParser's 64-byte message
+    static constexpr size_t ERROR_LEN = 96;
+    char rx_buf_[RX_BYTES];
+    char url_[URL_LEN];
+    char error_[ERROR_LEN];
+    
+    static constexpr const char* TAG = "BackendClient";
+    static constexpr TickType_t OPEN_TICKS = pdMS_TO_TICKS(30000);
+    static constexpr TickType_t WRITE_TICKS = pdMS_TO_TICKS(15000);
+    
+    int request(const char* url);
+    Reply readRaster();
+    Reply readDocument();
+    Reply readError(int status);
+    bool writeRaster(const uint8_t* data, size_t len);
+    void finishSpool(bool ok);
+    bool drain();
+    void drop();
+};
@@ -1,32 +1,64 @@
 /*
  * Button.hpp
  * Debounced button handler with interrupt support
+ *
+ * The ISR stamps each edge with esp_timer_get_time(), pushes it into a
+ * lock-free ring and wakes the button task with a direct notification.
+ * The task feeds the edges to ButtonGesture and calls the handler for
+ * press, release, click, double press and long press.
  */
 
 #pragma once
 
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
-#include <functional>
+#include "freertos/task.h"
+#include "ButtonGesture.hpp"
+#include "LatencyHistogram.hpp"
+#include "SpscRing.hpp"
+#include <atomic>
 
 class Button {
 public:
-    using Callback = std::function<void()>;
+    using Event = ButtonGesture::Event;
+    
+    // Runs on the button task; keep it short
+    using Callback = void (*)(Event event, void* ctx);
     
     Button(gpio_num_t pin, uint32_t debounce_ms = 50);
     ~Button();
     
     bool begin();
-    void setCallback(Callback callback);
+    void configure(const ButtonGesture::Config& config);
+    void setCallback(Callback callback, void* ctx = nullptr);
     void task();  // Call from FreeRTOS task
     
+    // Edge (or gesture deadline) to callback entry, in microseconds
+    const LatencyHistogram& getLatency() const { return latency_; }
+    void logLatency() const;
+    uint32_t getDroppedEdges() const { return dropped_.load(); }
+    
 private:
+    struct Edge {
+        int64_t t_us;
+        uint8_t level;
+    };
+    
+    // A bouncing contact can produce a few dozen edges per press
+    static constexpr size_t EDGE_RING = 64;
+    
     gpio_num_t pin_;
-    uint32_t debounce_ms_;
     Callback callback_;
-    QueueHandle_t event_queue_;
-    TickType_t last_press_time_;
+    void* ctx_;
+    ButtonGesture gesture_;
+    LatencyHistogram latency_;
+    
+    Edge edge_buf_[EDGE_RING];
+    SpscRing<Edge> edges_;
+    std::atomic<TaskHandle_t> task_handle_;
+    std::atomic<uint32_t> dropped_;
+    bool isr_installed_;
     
     static void IRAM_ATTR isrHandler(void* arg);
+    static void onGesture(Event event, int64_t due_us, void* ctx);
 };
@@ -0,0 +1,74 @@
+/*
+ * ButtonGesture.hpp
+ * Debounce and gesture state machine for a single push button
+ *
+ * Fed with timestamped edges (microseconds, as captured in the ISR) and
+ * polled at nextDeadline(), it reports press, release, click, double
+ * press and long press. It has no timers or RTOS calls of its own, so
+ * the same code runs in Button's task and on the host.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+class ButtonGesture {
+public:
+    enum class Event : uint8_t {
+        Press,          // Debounced press edge
+        Release,        // Debounced release edge
+        Click,          // Press + release with no second press in time
+        DoublePress,    // Second press within double_press_us of a release
+        LongPress,      // Held for long_press_us (fires while still held)
+    };
+    
+    // due_us: when the event happened (edge time, or the deadline for
+    // Click/LongPress), for latency accounting
+    using Handler = void (*)(Event event, int64_t due_us, void* ctx);
+    
+    struct Config {
+        uint32_t debounce_us;      // Edges closer than this to the last accepted one are bounce
+        uint32_t long_press_us;
+        uint32_t double_press_us;  // Release-to-press window; also delays Click
+    };
+    static constexpr Config DEFAULT_CONFIG = {50000, 800000, 300000};
+    
+    static constexpr int64_t NO_DEADLINE = INT64_MAX;
+    
+    ButtonGesture();
+    
+    void configure(const Config& config);
+    void setHandler(Handler handler, void* ctx);
+    
+    // Raw edge: level after the edge (true = pressed)
+    void edge(int64_t t_us, bool pressed);
+    
+    // Fire whatever timers are due at now_us
+    void poll(int64_t now_us);
+    
+    // Next time poll() has something to do, or NO_DEADLINE
+    int64_t nextDeadline() const;
+    
+    bool isPressed() const { return stable_; }
+    uint32_t bouncesRejected() const { return bounces_; }
+    
+private:
+    Config config_;
+    Handler handler_;
+    void* ctx_;
+    
+    bool stable_;            // Debounced level
+    bool raw_;               // Level after the latest raw edge
+    int64_t raw_us_;
+    int64_t last_change_us_;
+    
+    int64_t long_due_us_;    // NO_DEADLINE when not armed
+    int64_t click_due_us_;
+    int64_t last_release_us_;
+    bool double_pending_;    // Second press of a double: its release is silent
+    bool long_fired_;
+    uint32_t bounces_;
+    
+    void accept(int64_t t_us, bool pressed);
+    void emit(Event event, int64_t due_us);
+};
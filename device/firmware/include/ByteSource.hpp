@@ -0,0 +1,45 @@
+/*
+ * ByteSource.hpp
+ * Pull-style byte stream feeding the raster decoders
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+
+    // Copy up to `max` bytes into `buf`. Returns 0 at end of stream.
+    virtual size_t read(uint8_t* buf, size_t max) = 0;
+};
+
+// Serves bytes from a buffer that is already in memory (flash or RAM).
+class MemoryByteSource : public ByteSource {
+public:
+    MemoryByteSource(const uint8_t* data, size_t len)
+        : data_(data)
+        , len_(len)
+        , pos_(0)
+    {
+    }
+
+    size_t read(uint8_t* buf, size_t max) override
+    {
+        size_t n = len_ - pos_;
+        if (n > max) {
+            n = max;
+        }
+        memcpy(buf, data_ + pos_, n);
+        pos_ += n;
+        return n;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t len_;
+    size_t pos_;
+};
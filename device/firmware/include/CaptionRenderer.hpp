@@ -0,0 +1,105 @@
+/*
+ * CaptionRenderer.hpp
+ * UTF-8 caption drawn as 1-bpp raster rows from the FontAtlas
+ *
+ * begin() decodes the caption once into atlas glyphs and lays it out:
+ * word-wrapped to the row width less a margin, up to MAX_LINES centered
+ * lines, below a blank gap that separates it from the sticker. readRow()
+ * then yields the rows one at a time in the same packed layout as any
+ * RasterSource, so the caption can follow the sticker's rows in one
+ * raster job (and the gap goes out as a paper feed, see BandLayout).
+ *
+ * Drawing a row touches every glyph of its line, HEIGHT times per line.
+ * Rather than unpack the flash bitmap each time, glyphs are kept unpacked
+ * in a small cache of 32-bit rows, MSB at the glyph's first column, so
+ * blitting one is a shift and a few ORs per row. The cache is searched
+ * once per glyph per line, at the line's first row: its glyphs are then
+ * pinned for the line's other rows, and a miss evicts the least recently
+ * used glyph of an earlier line. The hot letters stay cached from line
+ * to line and caption to caption. A line with more distinct glyphs than
+ * slots draws the rest straight from flash.
+ *
+ * Malformed UTF-8 and code points the atlas lacks draw U+FFFD. Text past
+ * the last line is dropped and counted.
+ *
+ * No allocation and no ESP-IDF dependencies: the host benches check it
+ * against a plain per-dot blit of the atlas.
+ */
+
+#pragma once
+
+#include "FontAtlas.hpp"
+#include <cstddef>
+#include <cstdint>
+
+class CaptionRenderer {
+public:
+    static constexpr size_t MAX_BYTES = 128;        // UTF-8 bytes laid out, at most one glyph each
+    static constexpr uint8_t MAX_LINES = 3;
+    static constexpr uint8_t CACHE_SLOTS = 32;
+    static constexpr uint16_t MARGIN_DOTS = 8;      // Each side
+    static constexpr uint16_t GAP_ROWS = 16;        // Blank rows above the first line
+    static constexpr uint8_t LINE_GAP = 4;          // Blank rows between lines
+
+    struct Stats {
+        uint32_t glyphs;            // Laid out
+        uint32_t replaced;          // Drawn as U+FFFD
+        uint32_t dropped;           // Past the last line
+        uint32_t hits;              // Glyphs of a line found in the cache
+        uint32_t misses;            // Not found: unpacked from flash
+    };
+
+    CaptionRenderer();
+
+    // Lays out `utf8` for rows of `width_bytes`. Returns the rows the
+    // caption takes, gap included; 0 if there is nothing to draw.
+    uint16_t begin(const char* utf8, uint16_t width_bytes);
+    uint16_t height() const { return height_; }
+    uint8_t lines() const { return line_count_; }
+
+    // Fills `row` (width_bytes) with the next row; false after the last
+    bool readRow(uint8_t* row);
+
+    Stats getStats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+    // Decodes one code point at `p` and moves past it. Malformed, overlong
+    // and surrogate sequences give U+FFFD and skip one byte; 0 at the end.
+    static uint32_t nextCodepoint(const char*& p);
+
+private:
+    struct Line {
+        uint8_t first;              // Index into glyphs_
+        uint8_t count;
+        uint16_t x;                 // Pen start, centered
+    };
+
+    struct Slot {
+        int16_t glyph;              // Atlas index, -1 if empty
+        uint32_t used;              // stamp_ of the last line that drew it
+        uint32_t bits[FontAtlas::HEIGHT];   // From the glyph's top row
+    };
+
+    static constexpr uint8_t NEWLINE = 0xFF;    // In glyphs_: forced line break
+    static constexpr uint8_t NO_SLOT = 0xFF;    // In line_slots_: drawn from flash
+
+    uint8_t glyphs_[MAX_BYTES];     // Atlas indices of the caption
+    uint8_t glyph_count_;
+    Line lines_[MAX_LINES];
+    uint8_t line_count_;
+    uint16_t width_bytes_;
+    uint16_t height_;
+    uint16_t row_;
+    Slot cache_[CACHE_SLOTS];
+    uint8_t line_slots_[MAX_BYTES]; // Slot of each glyph of the line being drawn
+    int line_;                      // Whose glyphs are in line_slots_, -1 if none
+    uint32_t stamp_;                // Counts lines drawn
+    Stats stats_;
+
+    void layout();
+    uint16_t lineWidth(uint8_t first, uint8_t count) const;
+    void pinLine(const Line& line);
+    uint8_t slotFor(uint8_t index);
+    static uint32_t flashRow(const FontAtlas::Glyph& g, int r);
+    void blit(uint8_t* row, int x, uint32_t bits) const;
+};
@@ -0,0 +1,165 @@
+/*
+ * EscPos.hpp
+ * Compile-time ESC/POS command builder
+ *
+ * Each command is a constexpr function returning a fixed-size Seq, and
+ * sequences concatenate with `+`, so a fixed preamble such as
+ * `EscPos::init() + EscPos::feed(3) + EscPos::cut()` folds into one
+ * read-only byte array in flash. The same functions also work at run time
+ * for arguments that are only known then (raster band height, feed count).
+ *
+ * The static_asserts at the end pin the encodings, including the GS v 0
+ * header against escpos_gs_v_0() in scripts/pipeline.py.
+ *
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace EscPos {
+
+constexpr uint8_t DLE = 0x10;
+constexpr uint8_t DC2 = 0x12;
+constexpr uint8_t EOT = 0x04;
+constexpr uint8_t ESC = 0x1B;
+constexpr uint8_t GS = 0x1D;
+constexpr uint8_t LF = 0x0A;
+
+template <size_t N>
+struct Seq {
+    static_assert(N > 0, "empty command sequence");
+    uint8_t bytes[N];
+
+    static constexpr size_t size() { return N; }
+    constexpr const uint8_t* data() const { return bytes; }
+    constexpr uint8_t operator[](size_t i) const { return bytes[i]; }
+};
+
+template <size_t A, size_t B>
+constexpr Seq<A + B> operator+(const Seq<A>& a, const Seq<B>& b)
+{
+    Seq<A + B> out{};
+    for (size_t i = 0; i < A; i++) {
+        out.bytes[i] = a.bytes[i];
+    }
+    for (size_t i = 0; i < B; i++) {
+        out.bytes[A + i] = b.bytes[i];
+    }
+    return out;
+}
+
+template <size_t N>
+constexpr bool equal(const Seq<N>& seq, const uint8_t (&expected)[N])
+{
+    for (size_t i = 0; i < N; i++) {
+        if (seq.bytes[i] != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ESC @ - Initialize printer
+constexpr Seq<2> init()
+{
+    return {{ESC, '@'}};
+}
+
+// ESC d n - Print the buffer and feed n lines
+constexpr Seq<3> feed(uint8_t lines)
+{
+    return {{ESC, 'd', lines}};
+}
+
+// ESC J n - Print the buffer and feed n dot lines (n motion units, one
+// dot line on 203 dpi heads)
+constexpr Seq<3> feedDots(uint8_t dots)
+{
+    return {{ESC, 'J', dots}};
+}
+
+// GS V m - Cut paper (0 = full, 1 = partial)
+constexpr Seq<3> cut(bool partial = true)
+{
+    return {{GS, 'V', (uint8_t)(partial ? 1 : 0)}};
+}
+
+// DLE EOT n - Real-time status (1 = printer status)
+constexpr Seq<3> status(uint8_t n = 1)
+{
+    return {{DLE, EOT, n}};
+}
+
+// GS v 0 m xL xH yL yH - Raster bit image header; width_bytes * rows
+// bytes of pixel data (MSB = leftmost dot, 1 = black) must follow
+constexpr Seq<8> rasterHeader(uint16_t width_bytes, uint16_t rows, uint8_t mode = 0)
+{
+    return {{GS, 'v', '0', mode,
+             (uint8_t)(width_bytes & 0xFF), (uint8_t)(width_bytes >> 8),
+             (uint8_t)(rows & 0xFF), (uint8_t)(rows >> 8)}};
+}
+
+// ESC 7 n1 n2 n3 - Heating: (n1 + 1) * 8 dots fired at once, n2 * 10 us
+// per firing, n3 * 10 us between dot lines
+constexpr Seq<5> heating(uint8_t dots, uint8_t time, uint8_t interval)
+{
+    return {{ESC, '7', dots, time, interval}};
+}
+
+// DC2 # n - Print density 50% + 5% * level (0..31), break time
+// break_time * 250 us (0..7)
+constexpr Seq<3> density(uint8_t level, uint8_t break_time)
+{
+    return {{DC2, '#', (uint8_t)((break_time << 5) | (level & 0x1F))}};
+}
+
+// Text literal without its terminating NUL: text("Hola\n")
+template <size_t N>
+constexpr Seq<N - 1> text(const char (&str)[N])
+{
+    Seq<N - 1> out{};
+    for (size_t i = 0; i + 1 < N; i++) {
+        out.bytes[i] = (uint8_t)str[i];
+    }
+    return out;
+}
+
+// Fixed sequences the driver sends as-is
+inline constexpr Seq<2> INIT = init();
+inline constexpr Seq<3> STATUS = status();
+inline constexpr Seq<3> PARTIAL_CUT = cut();
+
+constexpr size_t RASTER_HEADER_LEN = decltype(rasterHeader(0, 0))::size();
+constexpr size_t FEED_DOTS_LEN = decltype(feedDots(0))::size();
+
+// Encodings
+static_assert(equal(init(), {0x1B, 0x40}), "ESC @");
+static_assert(equal(feed(3), {0x1B, 0x64, 0x03}), "ESC d n");
+static_assert(equal(feedDots(24), {0x1B, 0x4A, 0x18}), "ESC J n");
+static_assert(equal(cut(), {0x1D, 0x56, 0x01}), "GS V 1");
+static_assert(equal(cut(false), {0x1D, 0x56, 0x00}), "GS V 0");
+static_assert(equal(status(), {0x10, 0x04, 0x01}), "DLE EOT 1");
+static_assert(equal(text("Hi\n"), {'H', 'i', 0x0A}), "text drops the NUL");
+static_assert(equal(heating(7, 80, 2), {0x1B, 0x37, 0x07, 0x50, 0x02}), "ESC 7 (power-on values)");
+static_assert(equal(density(10, 2), {0x12, 0x23, 0x4A}), "DC2 # packs break time high");
+static_assert(equal(density(0xFF, 0), {0x12, 0x23, 0x1F}), "DC2 # density is 5 bits");
+
+// escpos_gs_v_0(data, 48, 24)[:8] and escpos_gs_v_0(data, 48, 600)[:8]
+// from scripts/pipeline.py: 384-dot head, one band and a whole sticker
+static_assert(RASTER_HEADER_LEN == 8, "GS v 0 header length");
+static_assert(equal(rasterHeader(48, 24), {0x1D, 0x76, 0x30, 0x00, 0x30, 0x00, 0x18, 0x00}),
+              "GS v 0 band header");
+static_assert(equal(rasterHeader(48, 600), {0x1D, 0x76, 0x30, 0x00, 0x30, 0x00, 0x58, 0x02}),
+              "GS v 0 yH carries the high byte");
+static_assert(equal(rasterHeader(0x1234, 0xABCD), {0x1D, 0x76, 0x30, 0x00, 0x34, 0x12, 0xCD, 0xAB}),
+              "GS v 0 little-endian fields");
+
+// Composition: a whole text receipt is one contiguous constant
+static_assert(equal(init() + text("OK\n") + feed(3) + cut(),
+                    {0x1B, 0x40, 'O', 'K', 0x0A, 0x1B, 0x64, 0x03, 0x1D, 0x56, 0x01}),
+              "receipt concatenation");
+
+} // namespace EscPos
@@ -0,0 +1,62 @@
+/*
+ * FontAtlas.hpp
+ * Flash-resident bitmap font for captions
+ *
+ * lib/CaptionRenderer/FontAtlas.cpp is generated by scripts/font_atlas.py
+ * from a TrueType font: printable ASCII, the Spanish letters and marks,
+ * and U+FFFD for everything else, in a HEIGHT-dot cell. Each glyph keeps
+ * only its inked rows, packed MSB first in ceil(width / 8) bytes each,
+ * in one const array, so the atlas stays in flash and costs no RAM.
+ *
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FontAtlas {
+
+constexpr uint8_t HEIGHT = 24;              // Cell rows; must match the generator
+constexpr uint8_t MAX_WIDTH = 32;           // A glyph row fits a 32-bit word
+constexpr uint16_t REPLACEMENT = 0xFFFD;    // Drawn for code points not in the atlas
+
+struct Glyph {
+    uint16_t codepoint;
+    uint16_t offset;        // First byte in BITS
+    uint8_t advance;        // Pen step in dots
+    uint8_t width;          // Columns stored, from `left`
+    int8_t left;            // First column relative to the pen (<= 0)
+    uint8_t top;            // First stored row in the cell
+    uint8_t rows;           // Stored rows; the rest of the cell is blank
+
+    size_t stride() const { return (width + 7) / 8; }
+};
+
+// Sorted by code point
+extern const Glyph GLYPHS[];
+extern const uint16_t GLYPH_COUNT;
+extern const uint8_t BITS[];
+
+// Index of `codepoint` in GLYPHS by binary search, -1 if absent
+inline int find(uint32_t codepoint)
+{
+    int lo = 0;
+    int hi = (int)GLYPH_COUNT - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        uint32_t cp = GLYPHS[mid].codepoint;
+        if (cp == codepoint) {
+            return mid;
+        }
+        if (cp < codepoint) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+}  // namespace FontAtlas
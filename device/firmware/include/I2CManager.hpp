@@ -1,27 +1,91 @@
 /*
  * I2CManager.hpp
  * I2C bus initialization and utilities for OLED displays
+ *
+ * The bus is owned by one task. Drivers submit Transactions to its queue
+ * and get a completion callback; write()/probe() wrap that for callers
+ * that want to block. The task builds each transaction in a static
+ * command-link buffer (no heap per transaction) and merges back-to-back
+ * stream writes to the same device into one bus transaction.
  */
 
 #pragma once
 
 #include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 #include "esp_log.h"
+#include "TaskLayout.hpp"
+#include <atomic>
 
 class I2CManager {
 public:
+    // Runs on the bus task; must not block or call the blocking helpers
+    using DoneCallback = void (*)(esp_err_t result, void* ctx);
+    
+    struct Transaction {
+        enum Flags : uint8_t {
+            PREFIX = 0x01,      // Send `prefix` before the data
+            // Data is a byte stream behind a control byte (e.g. SSD1327
+            // 0x00/0x40): consecutive ones with the same address and
+            // prefix may be joined into one START..STOP
+            COALESCE = 0x02,
+            // Not a transfer: clock the bus free and reinstall the driver,
+            // between two transactions (bus_reset())
+            BUS_RESET = 0x04,
+        };
+        
+        uint8_t address;
+        uint8_t flags;
+        uint8_t prefix;
+        const uint8_t* data;    // Must stay valid until `done` runs
+        size_t len;
+        uint8_t* read_buf;      // Optional read after a repeated START
+        size_t read_len;
+        DoneCallback done;
+        void* ctx;
+    };
+    
+    struct Stats {
+        uint32_t transactions;  // Run on the bus
+        uint32_t bus_writes;    // START..STOP sequences issued
+        uint32_t coalesced;     // Transactions merged into a previous one
+        uint32_t errors;
+        uint32_t queue_high_water;
+    };
+    
+    // Up to this many transactions share one command link
+    static constexpr size_t MAX_COALESCE = 16;
+    static constexpr size_t QUEUE_DEPTH = 32;
+    
     I2CManager(gpio_num_t sda_pin = GPIO_NUM_41,
                gpio_num_t scl_pin = GPIO_NUM_42,
                uint32_t freq_hz = 400000);
     ~I2CManager();
     
-    bool begin();
+    // Installs the driver and starts the bus task
+    bool begin(const TaskSpec& task = TaskLayout::I2C_BUS);
     void scan();  // Scan for I2C devices (debugging)
     i2c_port_t get_port() const { return port_; }
     
-    // Optional: Bus reset if locked
-    void bus_reset();
+    // Queue a transaction; waits up to `wait` for queue space
+    bool submit(const Transaction& txn, TickType_t wait = portMAX_DELAY);
+    
+    // Blocking helpers (not from the bus task): one write transaction of
+    // START, address, `prefix` (control or register byte), data, STOP
+    bool write(uint8_t address, uint8_t prefix, const uint8_t* data, size_t len,
+               TickType_t timeout = pdMS_TO_TICKS(100));
+    bool probe(uint8_t address, TickType_t timeout = pdMS_TO_TICKS(50));
+    
+    // Snapshot of the bus task's counters; safe from any task
+    Stats getStats() const;
     
+    // Optional: Bus reset if locked. Queued behind pending transactions and
+    // run by the bus task, so nothing is mid-transfer when the driver is
+    // reinstalled; blocks until done (not from the bus task).
+    bool bus_reset(TickType_t timeout = pdMS_TO_TICKS(500));
+
 private:
     i2c_port_t port_;
     gpio_num_t sda_pin_;
@@ -29,5 +93,33 @@ private:
     uint32_t freq_hz_;
     bool initialized_;
     
+    QueueHandle_t queue_;
+    StaticQueue_t queue_buffer_;
+    uint8_t queue_storage_[QUEUE_DEPTH * sizeof(Transaction)];
+    TaskHandle_t task_handle_;
+    TaskStorage<TaskLayout::I2C_BUS.stack> task_storage_;
+    
+    // Stats: the bus task counts transactions, submit() the queue depth
+    struct Counters {
+        std::atomic<uint32_t> transactions{0};
+        std::atomic<uint32_t> bus_writes{0};
+        std::atomic<uint32_t> coalesced{0};
+        std::atomic<uint32_t> errors{0};
+        std::atomic<uint32_t> queue_high_water{0};
+    };
+    Counters counters_;
+    
+    // Command link storage: START, address, prefix, MAX_COALESCE writes,
+    // optional read, STOP
+    uint8_t link_buf_[I2C_LINK_RECOMMENDED_SIZE(MAX_COALESCE)];
+    Transaction batch_[MAX_COALESCE];
+    
     static constexpr const char* TAG = "I2CManager";
+    
+    bool installDriver();
+    bool transact(const Transaction& txn, TickType_t timeout);
+    esp_err_t execute(const Transaction* txns, size_t count);
+    esp_err_t resetBus();
+    static void taskEntry(void* arg);
+    void busTask();
 };
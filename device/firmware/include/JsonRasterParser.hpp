@@ -0,0 +1,106 @@
+/*
+ * JsonRasterParser.hpp
+ * Incremental parser for the job result document, base64 decoded on the fly
+ *
+ *   { "status": "done", "raster_format": "pvr1", "caption": "¡Hola!",
+ *     "raster_data": "UFZSMQ..." }
+ *
+ * feed() takes the body in whatever pieces the socket delivers. The
+ * short top-level strings (status, message, raster_format, caption) are
+ * kept, as UTF-8 with \uXXXX escapes decoded, cut on a whole character
+ * if too long; raster_data is never stored: its base64 is decoded as it
+ * goes by and handed on in small blocks, so a raster of any size costs
+ * the same few hundred bytes. Other fields and nested values are skipped.
+ *
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class JsonRasterParser {
+public:
+    // Decoded raster bytes; return false to stop the parse
+    using DataCallback = std::function<bool(const uint8_t* data, size_t len)>;
+
+    JsonRasterParser();
+
+    void begin(DataCallback on_raster);
+    // False once the document is malformed or the callback refused data;
+    // later calls do nothing
+    bool feed(const char* data, size_t len);
+    // End of the body: hands on the last decoded bytes. True if the
+    // document was complete and well-formed.
+    bool finish();
+
+    const char* status() const { return status_; }          // "" until seen
+    const char* message() const { return message_; }
+    const char* format() const { return format_; }
+    const char* caption() const { return caption_; }        // "" if none
+    uint32_t rasterBytes() const { return raster_bytes_; }   // Decoded so far
+    bool failed() const { return failed_; }
+
+private:
+    enum class Field : uint8_t {
+        None,
+        Status,
+        Message,
+        Format,
+        Caption,
+        Raster,
+    };
+
+    static constexpr size_t KEY_LEN = 16;
+    static constexpr size_t STATUS_LEN = 16;
+    static constexpr size_t MESSAGE_LEN = 64;
+    static constexpr size_t CAPTION_LEN = 128;
+    static constexpr size_t OUT_BYTES = 192;
+
+    DataCallback on_raster_;
+    int depth_;
+    bool in_string_;
+    bool escape_;
+    uint8_t unicode_left_;      // Hex digits of a \uXXXX still to come
+    uint16_t unicode_;          // Its value so far
+    uint16_t high_surrogate_;   // First half of a pair, 0 if none
+    bool string_is_key_;
+    bool expect_key_;           // At the top level after '{' or ','
+    bool done_;
+    bool failed_;
+
+    Field field_;               // Whose value comes next
+    char key_[KEY_LEN];
+    size_t key_len_;
+    char* text_;                // String value being kept, if any
+    size_t text_cap_;
+    size_t text_len_;
+    bool text_cut_;             // Bytes were dropped for lack of room
+
+    char status_[STATUS_LEN];
+    char message_[MESSAGE_LEN];
+    char format_[STATUS_LEN];
+    char caption_[CAPTION_LEN];
+
+    // Base64 state for raster_data
+    uint32_t quad_;
+    uint8_t quad_len_;
+    bool padded_;
+    uint8_t out_[OUT_BYTES];
+    size_t out_len_;
+    uint32_t raster_bytes_;
+
+    void stringChar(char c);
+    void escapedUnit(uint16_t unit);
+    void stringCodepoint(uint32_t cp);
+    void unpaired();
+    void stringEnd();
+    void keyEnd();
+    bool base64Char(char c);
+    bool endQuad();
+    void emit(uint8_t b);
+    bool flush();
+    void fail();
+};
@@ -0,0 +1,74 @@
+/*
+ * LatencyHistogram.hpp
+ * Power-of-two latency histogram (microseconds), cheap enough for hot paths
+ *
+ * Bucket i counts samples in [2^(i-1), 2^i) us; bucket 0 is < 1 us and
+ * the last bucket collects everything above ~1 s. Recording is a few
+ * instructions and never allocates.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKETS = 22;
+    
+    LatencyHistogram() { reset(); }
+    
+    void reset()
+    {
+        for (size_t i = 0; i < BUCKETS; i++) {
+            buckets_[i] = 0;
+        }
+        count_ = 0;
+        sum_us_ = 0;
+        min_us_ = UINT32_MAX;
+        max_us_ = 0;
+    }
+    
+    void record(uint32_t us)
+    {
+        size_t b = 0;
+        while (b < BUCKETS - 1 && (us >> b) != 0) {
+            b++;
+        }
+        buckets_[b]++;
+        count_++;
+        sum_us_ += us;
+        if (us < min_us_) min_us_ = us;
+        if (us > max_us_) max_us_ = us;
+    }
+    
+    uint32_t count() const { return count_; }
+    uint32_t minUs() const { return count_ ? min_us_ : 0; }
+    uint32_t maxUs() const { return max_us_; }
+    uint32_t meanUs() const { return count_ ? (uint32_t)(sum_us_ / count_) : 0; }
+    uint32_t bucket(size_t i) const { return i < BUCKETS ? buckets_[i] : 0; }
+    
+    // Upper bound of the bucket holding the given percentile (0-100)
+    uint32_t percentileUs(uint32_t pct) const
+    {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t target = ((uint64_t)count_ * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += buckets_[i];
+            if (seen >= target && seen > 0) {
+                return i == 0 ? 0 : (i == BUCKETS - 1 ? max_us_ : (1u << i) - 1);
+            }
+        }
+        return max_us_;
+    }
+    
+private:
+    uint32_t buckets_[BUCKETS];
+    uint32_t count_;
+    uint64_t sum_us_;
+    uint32_t min_us_;
+    uint32_t max_us_;
+};
@@ -0,0 +1,53 @@
+/*
+ * MemoryBudget.hpp
+ * Where the RAM goes: static objects, task stacks, boot reservations, heap
+ *
+ * The firmware takes all of its memory while booting: objects and RTOS
+ * storage are static (.bss), task stacks come from TaskStorage, and the
+ * few large buffers are reserved once with reserve() and then used as
+ * per-job Arenas. After bootDone() the heap should stay flat; log()
+ * prints every registered item with its high-water mark, and the heap
+ * now, at its lowest since power-on and relative to the end of boot, so
+ * a leak or fragmentation shows up as a drift between two reports.
+ *
+ * Registration is meant for boot (app_main); entries are kept in fixed
+ * tables and never allocate.
+ */
+
+#pragma once
+
+#include "Arena.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <cstddef>
+#include <cstdint>
+
+class MemoryBudget {
+public:
+    static constexpr size_t MAX_ENTRIES = 16;    // Per table; extra entries are dropped
+    
+    struct Heap {
+        size_t total;
+        size_t free;
+        size_t min_free;            // Lowest since power-on: the high-water mark
+        size_t largest_block;       // Well below `free` means fragmentation
+        size_t boot_free;           // At bootDone(), 0 before
+    };
+    
+    // An object or RTOS storage that lives in .bss
+    static void addStatic(const char* name, size_t bytes);
+    // A running task and its stack size in bytes
+    static void addTask(const char* name, TaskHandle_t handle, uint32_t stack);
+    // A block for the rest of the uptime, from PSRAM first if asked and
+    // there is any, else internal RAM. nullptr if neither has room.
+    static void* reserve(const char* name, size_t bytes, bool prefer_psram);
+    static void addArena(const char* name, const Arena* arena);
+    
+    // End of boot: heap use from here on is the steady state
+    static void bootDone();
+    
+    static Heap internalHeap();
+    static Heap psramHeap();         // total 0 without PSRAM
+    
+    static void log();
+};
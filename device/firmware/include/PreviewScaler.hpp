@@ -0,0 +1,60 @@
+/*
+ * PreviewScaler.hpp
+ * 3:1 box downscale of 1-bpp printer rows to 4-bpp preview rows
+ *
+ * A 384-dot row becomes 128 preview pixels, so a sticker fits the
+ * SSD1327 across. Each preview pixel is the ink count of a 3x3 dot cell
+ * (0..9) mapped to a gray level. Rows are taken 3 bytes (24 dots, 8
+ * preview pixels) at a time and summed bit-sliced: two bit planes hold
+ * every dot column's count over the cell's rows, so adding a row is
+ * three logic ops per 24 dots. After the third row a 64-entry table
+ * turns each column triple's 3+3 plane bits into its level. Wider
+ * rasters are cropped to the middle 128 pixels, narrower ones centered;
+ * dots past the last whole 3-byte group are left out.
+ *
+ * No allocation and no FreeRTOS: the host benches check it against a
+ * plain 3x3 count.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class PreviewScaler {
+public:
+    static constexpr uint8_t FACTOR = 3;
+    static constexpr int16_t WIDTH = 128;                   // Preview pixels per row
+    static constexpr size_t ROW_BYTES = WIDTH / 2;          // Two pixels per byte, even one high
+    static constexpr uint8_t GROUPS = WIDTH / 8;            // 3-byte groups per preview row
+
+    PreviewScaler();
+
+    // Starts a raster of `width_bytes` per row. With `ink_lit` inked
+    // cells are bright (an OLED's dark background stands for the paper);
+    // otherwise the preview is paper white.
+    void begin(uint16_t width_bytes, bool ink_lit = true);
+
+    // Adds one printer row. Every third row completes a preview row, which
+    // is written to `out` (ROW_BYTES); returns true then.
+    bool addRow(const uint8_t* row, uint8_t* out);
+
+    // At the end of the raster: a last cell of 1 or 2 rows is written out
+    // as if the rows past the end were blank paper. False if there is none.
+    bool flush(uint8_t* out);
+
+    // Preview rows for a raster `height` rows tall
+    static uint16_t previewRows(uint16_t height) { return (height + FACTOR - 1) / FACTOR; }
+
+private:
+    uint8_t level_[64];         // (plane 1 bits << 3 | plane 0 bits) -> gray
+    uint32_t plane0_[GROUPS];   // Low bit of each dot column's count
+    uint32_t plane1_[GROUPS];   // High bit
+    uint16_t first_byte_;       // Input byte of the first group used
+    uint8_t groups_;            // Groups in use
+    uint8_t out_offset_;        // Output byte of the first group
+    uint8_t rows_;              // Rows in the current cell
+    bool ink_lit_;
+
+    void emit(uint8_t* out);
+};
@@ -0,0 +1,130 @@
+/*
+ * PrintJob.hpp
+ * Sequence of printer operations submitted to PrintQueue as one unit
+ *
+ * Jobs come from PrintQueue's fixed pool (PrintQueue::acquire()) and go
+ * back to it once done, so building one doesn't touch the heap: steps
+ * and text live in the job, and the job's raster sources are built with
+ * make<T>() in its own Arena. The job owns what make<T>() built: the
+ * printer task destroys it and resets the arena after complete().
+ */
+
+#pragma once
+
+#include "Arena.hpp"
+#include "RasterSource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class ThermalPrinter;
+struct PrintProfile;
+
+class PrintJob {
+public:
+    static constexpr size_t MAX_STEPS = 8;
+    static constexpr size_t TEXT_BYTES = 160;      // All text steps of a job, each with its NUL
+    static constexpr size_t ARENA_BYTES = 512;     // Sources (~300 B each); PrintQueue reserves one per job
+    static constexpr size_t MAX_OWNED = 4;         // make<T>() objects with a destructor
+    
+    // Called from the printer task once the last byte has left the UART
+    using DoneCallback = void (*)(uint32_t job_id, bool ok, void* ctx);
+    // Rows of a raster step printed so far (printer task)
+    using Progress = void (*)(uint32_t rows_printed, void* ctx);
+    
+    PrintJob();
+    ~PrintJob();
+    
+    PrintJob(const PrintJob&) = delete;
+    PrintJob& operator=(const PrintJob&) = delete;
+    
+    // Builder-style: job->reset().line("Hola").feed(3).cut(); a step or
+    // text that doesn't fit marks the job overflowed()
+    PrintJob& reset();
+    PrintJob& text(const char* text);
+    PrintJob& line(const char* text);
+    PrintJob& feed(uint8_t lines);
+    PrintJob& cut();
+    // `source` is read on the printer task; build it with make<T>()
+    PrintJob& raster(RasterSource* source, uint16_t width_bytes, Progress progress = nullptr,
+                     void* ctx = nullptr);
+    // Heating profile for the rasters after it, for this job only
+    // (nullptr = per band, see ThermalPrinter::setProfile)
+    PrintJob& profile(const PrintProfile* profile);
+    
+    void onDone(DoneCallback callback, void* ctx = nullptr)
+    {
+        done_ = callback;
+        done_ctx_ = ctx;
+    }
+    
+    // A T built in the job's arena, alive until the job is cleared;
+    // nullptr if the arena is full
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        if (!std::is_trivially_destructible<T>::value && owned_count_ == MAX_OWNED) {
+            overflowed_ = true;
+            return nullptr;
+        }
+        void* ptr = arena_.allocate(sizeof(T), alignof(T));
+        if (!ptr) {
+            overflowed_ = true;
+            return nullptr;
+        }
+        T* obj = new (ptr) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            owned_[owned_count_++] = {obj, [](void* p) { static_cast<T*>(p)->~T(); }};
+        }
+        return obj;
+    }
+    
+    // Too many steps, text or sources: PrintQueue::submit() refuses it
+    bool overflowed() const { return overflowed_; }
+    
+    // Executes every step on the printer (printer task only)
+    bool run(ThermalPrinter& printer);
+    void complete(uint32_t job_id, bool ok);
+    
+    // Destroys what make<T>() built, drops the steps and gives the arena
+    // back (PrintQueue, as the job returns to the pool)
+    void clear();
+    Arena& arena() { return arena_; }
+    const Arena& arena() const { return arena_; }
+    
+private:
+    enum class StepType : uint8_t { Reset, Text, Feed, Cut, Raster, Profile };
+    
+    struct Step {
+        StepType type;
+        uint8_t arg;
+        uint16_t width_bytes;
+        uint16_t text;              // Offset into text_
+        RasterSource* source;
+        Progress progress;
+        void* progress_ctx;
+        const PrintProfile* profile;
+    };
+    
+    struct Owned {
+        void* ptr;
+        void (*destroy)(void* ptr);
+    };
+    
+    Step steps_[MAX_STEPS];
+    size_t step_count_;
+    char text_[TEXT_BYTES];
+    size_t text_used_;
+    Owned owned_[MAX_OWNED];
+    size_t owned_count_;
+    Arena arena_;
+    DoneCallback done_;
+    void* done_ctx_;
+    bool overflowed_;
+    
+    Step* addStep(StepType type);
+    PrintJob& addText(const char* text, bool newline);
+    bool runSteps(ThermalPrinter& printer);
+};
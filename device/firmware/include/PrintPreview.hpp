@@ -0,0 +1,75 @@
+/*
+ * PrintPreview.hpp
+ * Live preview of the sticker being printed, on the SSD1327
+ *
+ * Plugged into StickerPipeline as its RowObserver, so it runs on the
+ * decode task and sees each row just after the printer has it. Rows go
+ * through PreviewScaler (384 dots -> 128 pixels, 3:1 both ways); every
+ * third one completes a 4-bpp line in the framebuffer, and every
+ * `push_lines` lines the new ones go to the panel with display(). A push
+ * is skipped while the previous one is still on the bus, so the decode
+ * task never waits on I2C: the lines stay dirty and leave with the next
+ * push. Lines are drawn top down; past 128 of them (stickers over 384
+ * rows) the panel's start line follows the newest, so the preview
+ * scrolls up like the paper.
+ *
+ * While a sticker prints the panel belongs to the preview. The last
+ * sticker stays up until the next one starts.
+ */
+
+#pragma once
+
+#include "PreviewScaler.hpp"
+#include "SSD1327.hpp"
+#include "StickerPipeline.hpp"
+#include "esp_log.h"
+#include <cstdint>
+
+class PrintPreview : public StickerPipeline::RowObserver {
+public:
+    struct Config {
+        uint8_t push_lines;     // Preview lines per push to the panel
+        bool ink_lit;           // Ink bright on a dark panel (else paper white)
+    };
+    
+    static constexpr Config DEFAULT_CONFIG = {
+        8,
+        true,
+    };
+    
+    struct Stats {
+        uint32_t stickers;
+        uint32_t rows;          // Printer rows seen
+        uint32_t lines;         // Preview lines drawn
+        uint32_t pushes;        // display() calls
+        uint32_t skipped;       // Pushes put off while the bus was busy
+        uint32_t busy_us;       // Decode task time spent in row()
+        uint32_t max_row_us;
+    };
+    
+    explicit PrintPreview(SSD1327& oled, const Config& config = DEFAULT_CONFIG);
+    
+    // StickerPipeline::RowObserver, decode task
+    void begin(uint16_t width_bytes, uint16_t height) override;
+    void row(const uint8_t* data) override;
+    // Draws the last partial line and pushes what is left, waiting for a
+    // flush still on the bus
+    void end(bool ok) override;
+    
+    const Stats& getStats() const { return stats_; }
+    void logStats() const;
+
+private:
+    SSD1327& oled_;
+    Config config_;
+    PreviewScaler scaler_;
+    uint8_t line_buf_[PreviewScaler::ROW_BYTES];
+    uint32_t lines_;            // Lines of the current sticker
+    uint8_t unpushed_;
+    Stats stats_;
+    
+    static constexpr const char* TAG = "PrintPreview";
+    
+    void addLine();
+    void push(bool wait);
+};
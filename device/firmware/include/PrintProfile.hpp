@@ -0,0 +1,217 @@
+/*
+ * PrintProfile.hpp
+ * Heating profiles for raster bands and the print throughput model
+ *
+ * ESC 7 sets how the head fires a dot line: at most (n1 + 1) * 8 dots at
+ * a time, each firing n2 * 10 us long, then n3 * 10 us before the next
+ * line. A line with b black dots therefore takes
+ *
+ *   max(motor step, ceil(b / dots per firing) * heat + interval)
+ *
+ * Big firings print dense lines faster but draw more current. What sags
+ * the supply is the load, the dots heated on average over a line
+ * (b * heat / line time). Every profile keeps the load of each line it is
+ * picked for under LOAD_LIMIT_DOTS, the load of a solid line at the
+ * printer's power-on settings, so no profile draws more than the printer
+ * already does after ESC @. ThermalPrinter picks, per band, the fastest
+ * profile whose max_black covers the band's densest row: line art runs at
+ * motor speed and only the dense bands slow down.
+ *
+ * Blank rows cost as much wire time as black ones inside a GS v 0 block.
+ * BandLayout decides which of a band's blank runs go out as ESC J dot
+ * feeds instead: the runs at its edges, and runs inside it long enough to
+ * pay for the GS v 0 header that restarts the block after them.
+ *
+ * ThroughputModel replays the driver's pacing (wire time at the baud
+ * rate, the printer-buffer allowance, head time per line) over a raster,
+ * to predict how long it prints for a given baud rate and profile policy.
+ * host/bench/profile_bench.cpp checks it against the simulated printer.
+ *
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include "EscPos.hpp"
+#include <cstddef>
+#include <cstdint>
+
+struct PrintProfile {
+    static constexpr size_t COMMAND_LEN = 8;            // ESC 7 + DC2 #
+    static constexpr uint32_t LOAD_LIMIT_DOTS = 64;
+
+    const char* name;
+    uint8_t heat_dots;      // ESC 7 n1: (n1 + 1) * 8 dots per firing
+    uint8_t heat_time;      // ESC 7 n2: 10 us units
+    uint8_t heat_interval;  // ESC 7 n3: 10 us units
+    uint8_t density;        // DC2 # level: 50% + 5% per step
+    uint8_t break_time;     // DC2 # break time: 250 us units
+    uint16_t max_black;     // Densest row (black dots) it may print
+
+    constexpr uint32_t dotsPerFiring() const { return (heat_dots + 1u) * 8u; }
+
+    // Head time for a dot line; `motor_us` is the fastest one-dot paper step
+    constexpr uint32_t lineUs(uint32_t black, uint32_t motor_us) const
+    {
+        uint32_t firings = (black + dotsPerFiring() - 1) / dotsPerFiring();
+        uint32_t us = firings * heat_time * 10u + heat_interval * 10u;
+        return us > motor_us ? us : motor_us;
+    }
+
+    // Dots heated on average over that line
+    constexpr uint32_t load(uint32_t black, uint32_t motor_us) const
+    {
+        return black * heat_time * 10u / lineUs(black, motor_us);
+    }
+
+    // Highest load over every row it may print
+    constexpr uint32_t peakLoad(uint32_t motor_us) const
+    {
+        uint32_t peak = 0;
+        for (uint32_t b = 0; b <= max_black; b++) {
+            uint32_t l = load(b, motor_us);
+            peak = l > peak ? l : peak;
+        }
+        return peak;
+    }
+
+    constexpr EscPos::Seq<COMMAND_LEN> command() const
+    {
+        return EscPos::heating(heat_dots, heat_time, heat_interval)
+               + EscPos::density(density, break_time);
+    }
+
+    // Black dots in a packed row
+    static uint32_t blackDots(const uint8_t* row, uint16_t width_bytes);
+    // No black dots: ORs the row a word at a time, much cheaper than
+    // counting them where popcount is a library call
+    static bool isBlank(const uint8_t* row, uint16_t width_bytes);
+};
+
+namespace PrintProfiles {
+
+// What the printer runs after power-on or ESC @
+inline constexpr PrintProfile POWER_ON = {"power-on", 7, 80, 2, 10, 2, 384};
+
+// Candidates for automatic selection, fastest first
+inline constexpr PrintProfile LINE_ART = {"line-art", 23, 70, 2, 12, 2, 96};
+inline constexpr PrintProfile NORMAL = {"normal", 7, 70, 10, 10, 2, 192};
+inline constexpr PrintProfile DENSE = {"dense", 7, 65, 10, 8, 2, 384};
+inline constexpr const PrintProfile* AUTO[] = {&LINE_ART, &NORMAL, &DENSE};
+
+// Fastest profile whose range covers a row with `black` dots
+constexpr const PrintProfile& select(uint32_t black)
+{
+    for (const PrintProfile* profile : AUTO) {
+        if (black <= profile->max_black) {
+            return *profile;
+        }
+    }
+    return DENSE;
+}
+
+// The load limit holds at the default motor step
+// (ThermalPrinter::DEFAULT_TIMING.feed_dot_us)
+constexpr uint32_t MOTOR_US = 1250;
+static_assert(POWER_ON.peakLoad(MOTOR_US) <= PrintProfile::LOAD_LIMIT_DOTS, "power-on reference");
+static_assert(LINE_ART.peakLoad(MOTOR_US) <= PrintProfile::LOAD_LIMIT_DOTS, "line-art load");
+static_assert(NORMAL.peakLoad(MOTOR_US) <= PrintProfile::LOAD_LIMIT_DOTS, "normal load");
+static_assert(DENSE.peakLoad(MOTOR_US) <= PrintProfile::LOAD_LIMIT_DOTS, "dense load");
+static_assert(DENSE.max_black >= 384, "dense covers a solid 384-dot line");
+static_assert(EscPos::equal(POWER_ON.command(), {0x1B, 0x37, 7, 80, 2, 0x12, 0x23, 0x4A}),
+              "profile command");
+
+}  // namespace PrintProfiles
+
+// How one band goes out once its blank runs are cut: spans of rows sent
+// as GS v 0 blocks, with ESC J feeds for the blank runs before, between
+// and after them. A run is cut when its bytes outweigh what replaces it:
+// an ESC J at an edge of the band, an ESC J and a new header inside it.
+struct BandLayout {
+    // The largest band anywhere: ThermalPrinter and ThroughputModel size
+    // their band arrays from it
+    static constexpr uint16_t MAX_ROWS = 32;
+
+    struct Span {
+        uint16_t first;
+        uint16_t rows;
+    };
+
+    Span spans[MAX_ROWS / 2 + 1];
+    uint8_t span_count;
+    uint16_t rows;
+    uint16_t lead;          // Blank rows fed before the first span
+    uint16_t trail;         // And after the last
+    uint16_t blank_rows;    // All rows fed, lead and trail included
+
+    // `blank[r]` for each of the band's `rows` (at most MAX_ROWS)
+    void plan(const bool* blank, uint16_t rows, uint16_t width_bytes);
+
+    uint16_t feeds() const
+    {
+        return (uint16_t)((lead > 0) + (trail > 0) + (span_count > 1 ? span_count - 1 : 0));
+    }
+
+    // Header, feed and pixel bytes (no profile command)
+    uint32_t bytes(uint16_t width_bytes) const
+    {
+        return (uint32_t)feeds() * EscPos::FEED_DOTS_LEN + (uint32_t)span_count * EscPos::RASTER_HEADER_LEN
+               + (uint32_t)(rows - blank_rows) * width_bytes;
+    }
+};
+
+// Print time of a raster under ThermalPrinter's pacing, row by row
+class ThroughputModel {
+public:
+    static constexpr uint16_t MAX_BAND_ROWS = BandLayout::MAX_ROWS;     // As ThermalPrinter
+    static constexpr size_t MAX_QUEUED = 8;
+
+    struct Config {
+        uint32_t baud;
+        uint16_t band_rows;
+        uint32_t motor_us;          // PrintTiming::feed_dot_us
+        uint32_t max_ahead_us;      // PrintTiming::max_ahead_us
+        uint32_t buffer_bytes;      // PrintTiming::buffer_bytes
+        uint32_t tx_ring_bytes;     // UART TX ring the driver writes into
+        uint32_t tick_us;           // Pacing sleeps round up to a tick
+    };
+
+    struct Result {
+        uint32_t rows;
+        uint32_t bands;
+        uint32_t bytes;             // Header, profile, feed and pixel bytes
+        uint32_t profile_changes;
+        uint32_t blank_rows;        // Fed with ESC J instead of sent
+        uint32_t peak_load;         // Dots, see PrintProfile::load()
+        int64_t wire_us;            // Bytes on the wire alone
+        int64_t head_us;            // Head time alone
+        int64_t total_us;           // First write -> head finished
+    };
+
+    // `fixed` prints every band with one profile; nullptr picks per band
+    // as ThermalPrinter does
+    ThroughputModel(const Config& config, const PrintProfile* fixed = nullptr);
+
+    void addRow(const uint8_t* row, uint16_t width_bytes);
+    Result finish();
+
+private:
+    Config config_;
+    const PrintProfile* fixed_;
+    const PrintProfile* current_;
+    Result result_;
+    double byte_us_;
+    double cpu_us_;             // When the driver issues its next write
+    double wire_free_us_;
+    double head_free_us_;
+    uint16_t band_width_;
+    uint16_t band_fill_;
+    uint32_t band_black_[MAX_BAND_ROWS];
+    bool band_blank_[MAX_BAND_ROWS];
+    double queued_start_[MAX_QUEUED];   // Commands in the printer's buffer
+    uint32_t queued_bytes_[MAX_QUEUED];
+    size_t queued_count_;
+
+    double holdUs(uint32_t bytes);
+    void flushBand();
+};
@@ -0,0 +1,70 @@
+/*
+ * PrintQueue.hpp
+ * Asynchronous print job queue drained by a printer-owned FreeRTOS task
+ *
+ * Jobs come from a fixed pool: as many as the queue holds, plus the one
+ * printing and one being built. Each has an arena of
+ * PrintJob::ARENA_BYTES, all carved from one block reserved at begin().
+ * The printer task clears a job and puts it back once it has completed,
+ * so printing never touches the heap.
+ */
+
+#pragma once
+
+#include "ThermalPrinter.hpp"
+#include "PrintJob.hpp"
+#include "TaskLayout.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <cstddef>
+
+class PrintQueue {
+public:
+    static constexpr UBaseType_t MAX_DEPTH = 8;     // Queue storage is sized for this
+    static constexpr size_t MAX_JOBS = MAX_DEPTH + 2;
+    
+    PrintQueue(ThermalPrinter& printer, UBaseType_t depth = 4);
+    ~PrintQueue();
+    
+    bool begin(const TaskSpec& task = TaskLayout::PRINTER);
+    
+    // Never blocks: an empty job from the pool, nullptr if every one is
+    // queued, printing or being built. Hand it to submit(), or back with
+    // release() to drop it.
+    PrintJob* acquire();
+    void release(PrintJob* job);
+    
+    // Never blocks: returns the job id, or 0 if the queue is full or the
+    // job overflowed. Either way the queue owns the job from here.
+    uint32_t submit(PrintJob* job);
+    
+    UBaseType_t pending() const;
+    // Arena of the first job, the one acquire() hands out when idle
+    const Arena& jobArena() const { return jobs_[0].arena(); }
+    
+private:
+    struct Entry {
+        uint32_t id;
+        PrintJob* job;
+    };
+    
+    ThermalPrinter& printer_;
+    UBaseType_t depth_;
+    size_t job_count_;
+    PrintJob jobs_[MAX_JOBS];
+    std::atomic<bool> taken_[MAX_JOBS];
+    uint8_t* arena_block_;
+    QueueHandle_t job_queue_;
+    StaticQueue_t queue_buffer_;
+    uint8_t queue_storage_[MAX_DEPTH * sizeof(Entry)];
+    TaskHandle_t task_handle_;
+    TaskStorage<TaskLayout::PRINTER.stack> task_storage_;
+    std::atomic<uint32_t> next_id_;
+    
+    static constexpr const char* TAG = "PrintQueue";
+    
+    static void taskEntry(void* arg);
+    void task();
+};
@@ -0,0 +1,217 @@
+/*
+ * PrintSpool.hpp
+ * Log-structured print spool on a raw flash partition
+ *
+ * Each finished compressed raster (PVR1) is stored in the "spool"
+ * partition (partitions.csv) before it is printed. After a brown-out or
+ * reset the job resumes from the last band the printer finished, instead
+ * of paying the transcribe/moderate/generate round trip again.
+ *
+ * The partition is a ring of 4 KB sectors written strictly in order.
+ * A record starts on a sector boundary with a 128-byte header, and its
+ * payload follows over as many sectors as it needs:
+ *
+ *   magic | seq | header_crc          programmed when the record is opened
+ *   length | data_crc | commit_crc    programmed once the payload is on flash
+ *   done                              cleared once the job has printed
+ *   progress[64]                      one more bit cleared per MARK_ROWS rows
+ *
+ * Every field goes from erased to its final value once (progress only
+ * ever clears more bits), so nothing is rewritten in place, and each
+ * sector is erased once per lap of the ring. A record whose commit block
+ * is missing or bad was cut off mid-write and is dropped at begin().
+ *
+ * Writer side (network task): open(), write()..., commit(). Erases and
+ * page programs run in the calling task. Printer side: SpoolSource reads
+ * the committed payload, which never changes, and markPrinted()/
+ * markDone() only post to the spool task's queue and never wait.
+ */
+
+#pragma once
+
+#include "ByteSource.hpp"
+#include "RasterDecoder.hpp"
+#include "RasterSource.hpp"
+#include "TaskLayout.hpp"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class PrintSpool {
+public:
+    static constexpr size_t SECTOR_SIZE = 4096;
+    static constexpr size_t PAGE_SIZE = 256;
+    static constexpr size_t HEADER_SIZE = 128;
+    static constexpr size_t MAX_RECORDS = 32;
+    static constexpr uint16_t MARK_ROWS = 8;            // Resume granularity
+    static constexpr size_t PROGRESS_BYTES = 64;        // 512 marks = 4096 rows
+    
+    // A committed record that has not finished printing
+    struct Record {
+        uint32_t id;
+        uint32_t length;        // Payload bytes
+        uint32_t offset;        // Partition offset of the payload (wraps)
+        uint32_t resume_row;    // Rows already printed
+    };
+    
+    struct Stats {
+        uint32_t records;       // Committed since begin()
+        uint32_t bytes;         // Payload bytes committed
+        uint32_t erases;        // Sectors erased
+        uint32_t programs;      // Flash program operations
+        uint32_t marks;         // Progress/done marks written
+        uint32_t marks_dropped; // Mark queue full (job resumes a little early)
+        uint32_t discarded;     // Torn or corrupt records found at begin()
+    };
+    
+    PrintSpool();
+    ~PrintSpool();
+    
+    // Finds the partition, rebuilds the index from flash and starts the
+    // task that writes progress marks. Returns false if there is no usable
+    // partition.
+    bool begin(const char* label = "spool", const TaskSpec& task = TaskLayout::SPOOL);
+    
+    // Writer (one at a time). write() returns false once the ring is full
+    // up to the oldest unprinted record or the flash fails; the record
+    // must then be aborted. commit() returns the record id, 0 on error.
+    bool open();
+    bool write(const uint8_t* data, size_t len);
+    uint32_t commit();
+    void abort();
+    
+    // Oldest first; returns how many records were copied to `out`
+    size_t pending(Record* out, size_t max) const;
+    // One of them by id; false once it is done or gone
+    bool find(uint32_t id, Record* out) const;
+    
+    // Printer side: never block. `rows` counts from the top of the image.
+    bool markPrinted(uint32_t id, uint32_t rows);
+    bool markDone(uint32_t id);
+    
+    // Read payload bytes of a committed record; wraps at the partition end
+    bool read(const Record& record, uint32_t pos, uint8_t* buf, size_t len) const;
+    
+    size_t capacity() const { return sectors_ * SECTOR_SIZE; }
+    size_t freeBytes() const;
+    Stats getStats() const;
+
+private:
+    struct RecordHeader {
+        uint32_t magic;
+        uint32_t seq;
+        uint32_t header_crc;    // Over magic and seq
+        uint32_t reserved0;
+        uint32_t length;
+        uint32_t data_crc;
+        uint32_t commit_crc;    // Over length and data_crc
+        uint32_t done;          // 0 = printed
+        uint8_t progress[PROGRESS_BYTES];
+        uint8_t reserved1[HEADER_SIZE - 32 - PROGRESS_BYTES];
+    };
+    static_assert(sizeof(RecordHeader) == HEADER_SIZE, "record header layout");
+    
+    struct Entry {
+        uint32_t seq;
+        uint32_t length;
+        uint16_t first_sector;
+        uint16_t sectors;
+        uint16_t marks;         // Progress marks on flash
+        bool done;
+    };
+    
+    struct Mark {
+        uint32_t seq;
+        uint32_t rows;          // UINT32_MAX = done
+    };
+    
+    static constexpr UBaseType_t MARK_QUEUE_DEPTH = 16;
+    
+    const esp_partition_t* partition_;
+    uint16_t sectors_;
+    uint16_t head_;             // Sector after the newest committed record
+    uint32_t next_seq_;
+    
+    mutable SemaphoreHandle_t lock_;    // Index and stats only, never held over flash I/O
+    StaticSemaphore_t lock_storage_;
+    Entry entries_[MAX_RECORDS];        // Oldest first
+    size_t count_;
+    Stats stats_;
+    
+    QueueHandle_t marks_;
+    StaticQueue_t marks_buffer_;
+    uint8_t marks_storage_[MARK_QUEUE_DEPTH * sizeof(Mark)];
+    TaskHandle_t task_handle_;
+    TaskStorage<TaskLayout::SPOOL.stack> task_storage_;     // The cache spool's task is the same size
+    std::atomic<uint32_t> marks_dropped_;
+    
+    // Open record
+    bool open_;
+    uint32_t open_seq_;
+    uint16_t open_first_;
+    uint16_t open_sectors_;
+    uint32_t open_len_;
+    uint32_t open_crc_;
+    uint8_t page_buf_[PAGE_SIZE];
+    size_t page_fill_;
+    
+    static constexpr uint32_t MAGIC = 0x31535650;       // "PVS1"
+    static constexpr const char* TAG = "PrintSpool";
+    
+    void scan();
+    bool verify(const Entry& entry, uint32_t crc) const;
+    uint32_t payloadOffset(uint16_t first_sector, uint32_t pos) const;
+    uint16_t sectorsFor(uint32_t length) const;
+    uint16_t usedSectors() const;
+    bool takeSector(uint16_t sector);
+    bool flushPage();
+    bool program(uint32_t offset, const void* data, size_t len);
+    void applyMark(const Mark& mark);
+    void prune();
+    static uint16_t countMarks(const uint8_t* progress);
+    static uint32_t crc32(uint32_t crc, const void* data, size_t len);
+    static void taskEntry(void* arg);
+    void task();
+};
+
+// Payload bytes of a committed record, from `start` on
+class SpoolReader : public ByteSource {
+public:
+    SpoolReader(const PrintSpool& spool, const PrintSpool::Record& record, uint32_t start = 0)
+        : spool_(spool)
+        , record_(record)
+        , pos_(start)
+    {
+    }
+    
+    size_t read(uint8_t* buf, size_t max) override;
+
+private:
+    const PrintSpool& spool_;
+    PrintSpool::Record record_;
+    uint32_t pos_;
+};
+
+// Decodes a spooled PVR1 record, starting at the first row not printed yet
+class SpoolSource : public RasterSource {
+public:
+    SpoolSource(const PrintSpool& spool, const PrintSpool::Record& record);
+    
+    // Reads the PVR1 header and skips the rows already printed
+    bool begin();
+    uint16_t widthBytes() const { return decoder_.widthBytes(); }
+    uint32_t firstRow() const { return record_.resume_row; }
+    const PrintSpool::Record& record() const { return record_; }
+    
+    bool readRow(uint8_t* row) override { return decoder_.readRow(row); }
+
+private:
+    PrintSpool::Record record_;
+    SpoolReader reader_;
+    RasterDecoder decoder_;
+};
@@ -0,0 +1,59 @@
+/*
+ * RasterDecoder.hpp
+ * Streaming decoder for the PVR1 compressed raster format
+ *
+ * PVR1 layout (encoder: encode_pvr_rows() in scripts/pipeline.py):
+ *   "PVR1" | width_bytes (u16 LE) | height (u16 LE) | row opcodes...
+ *
+ *   0x00        Literal row, PackBits-coded until width_bytes are filled
+ *   0x40 + n-1  n blank (all-white) rows, n = 1..64
+ *   0x80 + n-1  n copies of the previous row, n = 1..128
+ *
+ * Memory is constant: one previous-row buffer and a small input buffer.
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include "ByteSource.hpp"
+#include "RasterSource.hpp"
+#include <cstdint>
+
+class RasterDecoder : public RasterSource {
+public:
+    static constexpr uint16_t MAX_WIDTH_BYTES = 72;  // 576 dots (80 mm heads)
+
+    RasterDecoder();
+
+    // Reads and validates the header; returns false on a bad stream
+    bool begin(ByteSource& source);
+
+    uint16_t widthBytes() const { return width_bytes_; }
+    uint16_t height() const { return height_; }
+    bool failed() const { return failed_; }
+
+    // Produce the next packed row (MSB first, 1 = black)
+    bool readRow(uint8_t* row) override;
+
+private:
+    enum : uint8_t {
+        OP_LITERAL = 0x00,
+        OP_BLANK = 0x40,
+        OP_REPEAT = 0x80,
+    };
+
+    ByteSource* source_;
+    uint16_t width_bytes_;
+    uint16_t height_;
+    uint16_t row_;
+    uint8_t repeat_left_;
+    bool failed_;
+
+    uint8_t prev_[MAX_WIDTH_BYTES];
+    uint8_t in_buf_[64];
+    size_t in_pos_;
+    size_t in_len_;
+
+    bool readByte(uint8_t* b);
+    bool decodeLiteral();
+};
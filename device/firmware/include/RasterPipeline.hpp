@@ -0,0 +1,154 @@
+/*
+ * RasterPipeline.hpp
+ * Streaming gray/RGB/RGBA -> 1-bpp printer rows (resize, pixelate, dither)
+ *
+ * Mirrors the post-processing chain in scripts/pipeline.py
+ * (alpha over white -> resize_to_width -> pixelate -> to_1bit_dither ->
+ * pack_1bit_rows) one row at a time, using the same integer math as
+ * Pillow so the output matches the backend bit for bit. RGB is resized
+ * per channel and only then converted to gray, as Pillow does.
+ *
+ * Only the resized pixels the pixelate step samples are computed: with
+ * the default 96-dot pixelate that is one column and row in four.
+ * Where AVX2 or NEON is available the resampling runs eight 32-bit sums
+ * at a time; the sums are exact, so the output is the same either way.
+ *
+ * No ESP-IDF dependencies: builds on the host as well as on the device.
+ */
+
+#pragma once
+
+#include "Arena.hpp"
+#include "RasterSource.hpp"
+#include <cstdint>
+
+// Supplies 8-bit rows top to bottom: grayscale (0 = black, 255 = white),
+// or RGB / RGBA bytes per pixel when Config::channels says so
+class GraySource {
+public:
+    virtual ~GraySource() = default;
+
+    // Fill `row` with the next in_width pixels (in_width * channels bytes).
+    // Returns false once the image is exhausted.
+    virtual bool readRow(uint8_t* row) = 0;
+};
+
+class RasterPipeline : public RasterSource {
+public:
+    enum class Resample : uint8_t {
+        // Full pipeline.py chain: LANCZOS to out_width (aspect kept),
+        // then optional pixelate through pixelate_width.
+        Lanczos,
+        // Input is already the small pixelated image; scale it up with
+        // NEAREST to out_width x out_height (pixelate()'s second half).
+        Nearest,
+    };
+
+    enum class Dither : uint8_t {
+        // Pillow's convert("1"), as pipeline.py
+        FloydSteinberg,
+        // Bayer 8x8 threshold map: no error carried, so flat areas get a
+        // regular pattern that survives a thermal head's dot gain
+        Ordered,
+        // Atkinson: 6/8 of the error spread over two rows; lighter
+        // shadows and crisper edges than Floyd-Steinberg
+        Atkinson,
+    };
+
+    struct Config {
+        Resample resample;
+        uint16_t in_width;
+        uint16_t in_height;
+        uint16_t out_width;       // Printer width in dots (384 for 58 mm)
+        uint16_t out_height;      // Nearest only; Lanczos derives it
+        uint16_t pixelate_width;  // Lanczos only; 0 disables
+        uint8_t channels;         // Bytes per input pixel: 1 (or 0) gray, 3 RGB,
+                                  // 4 RGBA composited over white
+        Dither dither;
+    };
+
+    RasterPipeline();
+    ~RasterPipeline();
+
+    // Allocates the row buffers for `config`; returns false if the
+    // configuration is invalid or out of memory.
+    bool begin(GraySource& source, const Config& config);
+    void end();
+
+    uint16_t outWidth() const { return out_width_; }
+    uint16_t outHeight() const { return out_height_; }
+    uint16_t widthBytes() const { return (out_width_ + 7) / 8; }
+
+    // Working memory held between begin() and end()
+    size_t memoryUsed() const { return memory_used_; }
+
+    // Working memory comes from `arena` from the next begin() on (nullptr:
+    // the heap). Reset the arena only after end().
+    void setArena(Arena* arena) { arena_ = arena; }
+
+    // Produce the next packed row (MSB first, 1 = black)
+    bool readRow(uint8_t* row) override;
+
+    // Output height of pipeline.py's resize_to_width()
+    static uint16_t scaledHeight(uint16_t width, uint16_t height, uint16_t target_width);
+
+private:
+    GraySource* source_;
+    Config config_;
+    uint16_t out_width_;
+    uint16_t out_height_;
+    uint16_t out_row_;
+    size_t memory_used_;
+    Arena* arena_;
+    Arena* buffers_arena_;   // Where the buffers below came from
+
+    // Resized (pre-pixelate) geometry and the coordinate maps into it
+    uint16_t resized_width_;
+    uint16_t resized_height_;
+    uint16_t* x_map_;        // Output column -> pixel of resizedRow()
+    uint16_t* y_map_;        // Output row -> resized row
+
+    // Resized rows hold only the columns x_map_ samples, in order, at
+    // 1 byte per pixel for gray and 4 (R, G, B, unused) for color
+    uint8_t pixel_bytes_;
+    uint16_t col_count_;
+    uint16_t* cols_;         // Pixel of resizedRow() -> resized column
+    size_t row_bytes_;       // Resized row and ring slot stride
+
+    // Lanczos state: horizontal taps, ring of horizontally resized rows
+    bool need_horizontal_;
+    bool need_vertical_;
+    uint16_t h_ksize_;
+    uint16_t h_stride_;      // Coefficients per column, padded for SIMD
+    uint16_t v_ksize_;
+    int32_t* h_coeffs_;
+    uint16_t* h_bounds_;
+    int32_t* v_coeffs_;
+    double* v_work_;
+    uint8_t* ring_;
+    int32_t ring_next_;      // Next input row to pull into the ring
+
+    // Current resized row and the input row buffers: source_row_ is
+    // what the source wrote, in_row_ the same pixels at pixel_bytes_
+    // (one buffer for gray)
+    uint8_t* resized_row_;
+    int32_t resized_index_;
+    uint8_t* source_row_;
+    uint8_t* in_row_;
+
+    // Error rows: Floyd-Steinberg keeps one in 1/16 units (Pillow's
+    // single-row form), Atkinson three (this row and the next two)
+    int16_t* errors_;
+    uint8_t* gray_row_;
+    uint8_t* dots_;          // 1 = black, padded to whole bytes with 0
+    void (RasterPipeline::*dither_row_)(const uint8_t* gray, uint8_t* dots);
+
+    const uint8_t* resizedRow(int32_t y);
+    bool pullInputRow(int32_t y);
+    void unpackSourceRow();
+    void resampleHorizontal(const uint8_t* in, uint8_t* out) const;
+    bool resampleVertical(int32_t y, uint8_t* out);
+    template <Dither D>
+    void ditherRow(const uint8_t* gray, uint8_t* dots);
+    void packDots(const uint8_t* dots, uint8_t* packed) const;
+};
@@ -0,0 +1,49 @@
+/*
+ * RasterSource.hpp
+ * Row-by-row supplier of packed 1-bpp raster data
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Rows are packed MSB first with 1 = black, the same layout as
+// pack_1bit_rows() in scripts/pipeline.py.
+class RasterSource {
+public:
+    virtual ~RasterSource() = default;
+
+    // Fill `row` with the next row (width_bytes long).
+    // Returns false once the image is exhausted.
+    virtual bool readRow(uint8_t* row) = 0;
+};
+
+// Serves rows from a bitmap that is already in memory (flash or RAM).
+class BitmapSource : public RasterSource {
+public:
+    BitmapSource(const uint8_t* data, uint16_t width_bytes, uint16_t height)
+        : data_(data)
+        , width_bytes_(width_bytes)
+        , height_(height)
+        , row_(0)
+    {
+    }
+
+    bool readRow(uint8_t* row) override
+    {
+        if (row_ >= height_) {
+            return false;
+        }
+        memcpy(row, data_ + (size_t)row_ * width_bytes_, width_bytes_);
+        row_++;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    uint16_t width_bytes_;
+    uint16_t height_;
+    uint16_t row_;
+};
@@ -0,0 +1,110 @@
+/*
+ * SSD1327.hpp
+ * SSD1327 128x128 16-level grayscale OLED driver over I2CManager
+ *
+ * Drawing goes to a local 4-bpp framebuffer (8 KB). display() pushes only
+ * the dirty rectangles: each becomes one column/row window command and
+ * its rows, queued on the I2C bus task straight from the framebuffer.
+ * The bus task joins the rows into large writes, so a status icon costs
+ * a couple of milliseconds of bus time instead of a 180 ms full refresh,
+ * and the caller doesn't wait for it.
+ */
+
+#pragma once
+
+#include "I2CManager.hpp"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <atomic>
+#include <cstdint>
+
+class SSD1327 {
+public:
+    static constexpr uint8_t DEFAULT_ADDRESS = 0x3C;
+    static constexpr int16_t WIDTH = 128;
+    static constexpr int16_t HEIGHT = 128;
+    static constexpr size_t BUFFER_SIZE = WIDTH * HEIGHT / 2;
+    
+    // Separate dirty windows tracked before the closest pair is merged
+    static constexpr uint8_t MAX_DIRTY = 4;
+    
+    struct Stats {
+        uint32_t flushes;
+        uint32_t windows;
+        uint32_t data_bytes;     // Pixel bytes queued (2 pixels each)
+        uint32_t last_flush_us;  // Queue to last byte on the wire
+    };
+    
+    SSD1327(I2CManager& i2c, uint8_t address = DEFAULT_ADDRESS);
+    ~SSD1327();
+    
+    // Allocates the framebuffer, initializes the panel and clears it
+    bool begin();
+    
+    void setContrast(uint8_t contrast);
+    void setPower(bool on);
+    
+    // Drawing (gray 0 = off .. 15 = full); clipped to the panel
+    void clear(uint8_t gray = 0);
+    void setPixel(int16_t x, int16_t y, uint8_t gray);
+    uint8_t getPixel(int16_t x, int16_t y) const;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t gray);
+    
+    // 1-bpp bitmap, MSB first, rows padded to whole bytes. Set bits are
+    // drawn in `fg`; clear bits in `bg`, or left untouched if bg < 0.
+    void drawBitmap(int16_t x, int16_t y, int16_t w, int16_t h,
+                    const uint8_t* bits, uint8_t fg, int16_t bg = -1);
+    
+    // `h` full-width rows in the framebuffer's own layout (WIDTH / 2 bytes
+    // each, even pixel in the high nibble), copied in at row `y`
+    void drawRows(int16_t y, int16_t h, const uint8_t* rows);
+    
+    // GDDRAM row shown at the top of the panel, for scrolling without
+    // redrawing. Goes out with the next display(), after its windows.
+    void setStartLine(uint8_t line);
+    uint8_t startLine() const { return start_line_; }
+    
+    // Queue the dirty windows for the bus task and return. If the previous
+    // flush is still on the bus, waits for it first. After an I2C error
+    // the next call resends the whole panel.
+    bool display();
+    bool isDirty() const { return dirty_count_ > 0 || start_line_dirty_; }
+    bool isFlushing() const { return pending_.load() > 0; }
+    
+    const uint8_t* buffer() const { return buffer_; }
+    const Stats& getStats() const { return stats_; }
+
+private:
+    // Inclusive window; x in column pairs (the controller's column unit)
+    struct Rect {
+        uint8_t col0, row0, col1, row1;
+    };
+    
+    I2CManager& i2c_;
+    uint8_t address_;
+    uint8_t* buffer_;            // Row-major, even pixel in the high nibble
+    Rect dirty_[MAX_DIRTY];
+    uint8_t dirty_count_;
+    Stats stats_;
+    
+    uint8_t start_line_;
+    bool start_line_dirty_;
+    
+    // In-flight flush: window commands must outlive their transactions
+    uint8_t window_cmds_[MAX_DIRTY][6];
+    uint8_t start_cmd_[2];
+    std::atomic<uint16_t> pending_;
+    std::atomic<bool> flush_error_;
+    int64_t flush_start_us_;
+    SemaphoreHandle_t idle_sem_;
+    StaticSemaphore_t idle_storage_;
+    
+    static constexpr const char* TAG = "SSD1327";
+    
+    void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+    void addDirty(Rect r);
+    bool sendCommands(const uint8_t* cmds, size_t len);
+    bool queueWrite(uint8_t control, const uint8_t* data, size_t len);
+    bool queueWindow(uint8_t slot, const Rect& r);
+    static void transferDone(esp_err_t result, void* ctx);
+};
@@ -0,0 +1,98 @@
+/*
+ * SpscRing.hpp
+ * Lock-free single-producer / single-consumer ring buffer
+ *
+ * One context may push (task or ISR) and one task may pop, without locks.
+ * Capacity must be a power of two; storage is supplied by the caller so
+ * the ring can live in internal RAM, PSRAM or a static array.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+template <typename T>
+class SpscRing {
+public:
+    SpscRing()
+        : buf_(nullptr)
+        , mask_(0)
+        , head_(0)
+        , tail_(0)
+    {
+    }
+
+    bool init(T* storage, size_t capacity)
+    {
+        if (!storage || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            return false;
+        }
+        buf_ = storage;
+        mask_ = capacity - 1;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    size_t size() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    // Producer side: copies as many items as fit, returns the count
+    size_t push(const T* items, size_t count)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t space = capacity() - (head - tail);
+        if (count > space) {
+            count = space;
+        }
+        size_t first = head & mask_;
+        size_t n = capacity() - first;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(buf_ + first, items, n * sizeof(T));
+        memcpy(buf_, items + n, (count - n) * sizeof(T));
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    bool push(const T& item) { return push(&item, 1) == 1; }
+
+    // Consumer side: copies up to `max` items, returns the count
+    size_t pop(T* items, size_t max)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t count = head - tail;
+        if (count > max) {
+            count = max;
+        }
+        size_t first = tail & mask_;
+        size_t n = capacity() - first;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(items, buf_ + first, n * sizeof(T));
+        memcpy(items + n, buf_, (count - n) * sizeof(T));
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool pop(T* item) { return pop(item, 1) == 1; }
+
+    // Consumer side only
+    void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    T* buf_;
+    size_t mask_;
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+};
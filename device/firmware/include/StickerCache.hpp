@@ -0,0 +1,186 @@
+/*
+ * StickerCache.hpp
+ * Recently printed stickers, kept on the device for instant reprints
+ *
+ * Each entry is a finished PVR1 raster keyed by a hash of the prompt
+ * (or transcription) the backend returned for it, or of its job id when
+ * the backend returns neither, as main.cpp does. A repeat prompt or a
+ * reprint gesture then prints straight from the device, with no
+ * transcribe/moderate/generate round trip.
+ *
+ * Two tiers under fixed byte budgets, one LRU order across both:
+ *
+ *   RAM    one block reserved at begin(), PSRAM (internal RAM on
+ *          modules without it); entries are packed into it first-fit
+ *   flash  records in the "cache" partition, stored by a PrintSpool as
+ *          key (8 bytes) | PVR1; rebuilt from flash at begin()
+ *
+ * put() stores in RAM. Making room spills the least recently used
+ * entries to flash (or drops their RAM copy if flash has one already);
+ * when the free space is there but split up, the unpinned entries are
+ * slid together. The flash tier is a victim log: going over its budget
+ * drops the oldest records first, which is the order the spool ring can
+ * reuse sectors in. Entries with neither copy are forgotten. Spilling
+ * writes flash in the calling task, never with the index locked, so
+ * lookups from the button task don't wait for it.
+ *
+ * Source::open() pins the entry until the source is destroyed; a pinned
+ * entry is never evicted or moved, so a reprint in progress can't lose
+ * its data. A Source reads straight from the RAM block or the partition
+ * and needs no heap: build it where the job lives (PrintJob::make()).
+ */
+
+#pragma once
+
+#include "ByteSource.hpp"
+#include "PrintSpool.hpp"
+#include "RasterDecoder.hpp"
+#include "RasterSource.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+class StickerCache {
+public:
+    static constexpr size_t MAX_ENTRIES = 64;
+    static constexpr size_t KEY_SIZE = sizeof(uint64_t);    // Prefix of each flash record
+    
+    struct Config {
+        size_t ram_budget;      // PVR1 bytes held in RAM
+        size_t flash_budget;    // PVR1 bytes held in flash
+    };
+    
+    static constexpr Config DEFAULT_CONFIG = {
+        512 * 1024,             // ~100 typical stickers in PSRAM
+        448 * 1024,             // Half the cache partition: the spool frees oldest first
+    };
+    
+    // RAM tier without PSRAM: a few stickers, leaving the heap to WiFi/TLS
+    static constexpr size_t INTERNAL_RAM_BUDGET = 48 * 1024;
+    
+    struct Metrics {
+        uint32_t lookups;
+        uint32_t ram_hits;
+        uint32_t flash_hits;
+        uint32_t misses;
+        uint32_t inserts;
+        uint32_t spills;            // RAM copies written to flash
+        uint32_t spill_failures;    // Flash full or failing; entry dropped
+        uint32_t evictions;         // Entries forgotten entirely
+        uint32_t compactions;       // RAM entries slid together to make room
+        uint32_t ram_entries;
+        uint32_t flash_entries;
+        size_t ram_bytes;
+        size_t flash_bytes;
+        size_t ram_budget;
+        size_t flash_budget;
+        size_t index_bytes;         // The cache object itself
+        bool psram;
+    };
+    
+    // Decodes a cached sticker; keeps it pinned while alive
+    class Source : public RasterSource {
+    public:
+        explicit Source(StickerCache& cache);
+        ~Source();
+        
+        // Looks `key` up and pins it. False on a miss or a corrupt entry
+        // (dropped). Counts toward the hit rate.
+        bool open(uint64_t key);
+        
+        uint16_t widthBytes() const { return decoder_.widthBytes(); }
+        uint16_t height() const { return decoder_.height(); }
+        bool fromFlash() const { return flash_.has_value(); }
+        
+        bool readRow(uint8_t* row) override { return decoder_.readRow(row); }
+        
+    private:
+        StickerCache& cache_;
+        int16_t slot_;                  // NONE until open() pins one
+        std::optional<SpoolReader> flash_;
+        std::optional<MemoryByteSource> ram_;
+        RasterDecoder decoder_;
+    };
+    
+    // FNV-1a 64 over the prompt with ASCII case folded and whitespace runs
+    // collapsed, so "A cat " and "a  cat" share an entry. Never 0.
+    static uint64_t key(const char* text);
+    
+    // `spool` is the flash tier (begun on its own partition), nullptr for
+    // RAM only. The cache doesn't own it.
+    explicit StickerCache(PrintSpool* spool = nullptr);
+    ~StickerCache();
+    
+    // Sizes the RAM tier and indexes the stickers already on flash
+    bool begin(const Config& config = DEFAULT_CONFIG);
+    
+    // Store `len` bytes of PVR1 read from `data` (one writer task at a
+    // time). The key becomes the most recent one. Returns false if the
+    // sticker can't be stored.
+    bool put(uint64_t key, ByteSource& data, size_t len);
+    bool put(uint64_t key, const uint8_t* data, size_t len);
+    
+    bool contains(uint64_t key) const;
+    
+    // Most recently stored or opened key, 0 if none
+    uint64_t lastKey() const;
+    
+    Metrics getMetrics() const;
+    void logMetrics() const;
+    
+private:
+    static constexpr int16_t NONE = -1;
+    
+    struct Entry {
+        uint64_t key;
+        uint8_t* ram;               // In ram_block_, nullptr if not in RAM
+        uint32_t length;
+        PrintSpool::Record flash;   // id 0 if not on flash
+        uint16_t pins;
+        bool used;
+        int16_t newer;              // LRU links
+        int16_t older;
+    };
+    
+    PrintSpool* spool_;
+    Config config_;
+    bool psram_;
+    uint8_t* ram_block_;        // config_.ram_budget bytes
+    
+    mutable SemaphoreHandle_t lock_;
+    StaticSemaphore_t lock_storage_;
+    Entry entries_[MAX_ENTRIES];
+    int16_t newest_;
+    int16_t oldest_;
+    uint64_t last_key_;
+    size_t ram_bytes_;
+    size_t flash_bytes_;
+    size_t flash_entries_;
+    Metrics metrics_;
+    
+    static constexpr size_t MAX_FLASH_RECORDS = PrintSpool::MAX_RECORDS - 4;
+    static constexpr int SPILL_ATTEMPTS = 10;
+    static constexpr const char* TAG = "StickerCache";
+    
+    // Index helpers, called with lock_ held
+    int16_t find(uint64_t key) const;
+    int16_t allocSlot();
+    void link(int16_t slot);
+    void unlink(int16_t slot);
+    void touch(int16_t slot);
+    void dropRam(int16_t slot);
+    void dropFlash(int16_t slot);
+    void drop(int16_t slot);
+    void trimFlash(size_t incoming);
+    
+    uint8_t* allocRam(size_t len);
+    size_t ramOrder(int16_t* order) const;
+    uint8_t* findGap(size_t len) const;
+    void compactRam();
+    
+    void unpin(int16_t slot);
+    void trimRam(size_t incoming);
+    bool spill(uint64_t key, const uint8_t* data, size_t len, PrintSpool::Record* record);
+};
@@ -0,0 +1,184 @@
+/*
+ * StickerPipeline.hpp
+ * Download -> decode -> print stages for one sticker, overlapped
+ *
+ *   network task  --stream buffer (PVR1 bytes)-->  decode task
+ *   decode task   --message buffer (one row each)-->  printer task
+ *
+ * The network task writes PVR1 bytes as they arrive. The decode task
+ * (core 1, see TaskLayout) runs RasterDecoder over them and posts every
+ * row as one message; as soon as the header is in, it queues a PrintJob
+ * whose raster reads those messages, so the first band prints while the
+ * rest is still downloading. Both buffers block their writer when full:
+ * a fast download waits for decoding, decoding waits for the head, and
+ * RAM use stays at the two buffers whatever the sticker's size. Their
+ * storage is part of the object, sized at build time.
+ *
+ * A caption handed to close() is drawn by the decode task (CaptionRenderer)
+ * and posted after the sticker's last row, so it prints in the same
+ * raster job, below the image. The job's raster ends on a one-byte
+ * END_OK once the network side has closed: until then a caption may
+ * still come.
+ *
+ * One sticker is in the pipeline at a time; open() waits until the last
+ * one has left both stages. A download cut short (close(false)), a bad
+ * stream or a stalled one ends the raster early and the job reports
+ * failure.
+ */
+
+#pragma once
+
+#include "ByteSource.hpp"
+#include "CaptionRenderer.hpp"
+#include "PrintQueue.hpp"
+#include "RasterDecoder.hpp"
+#include "RasterSource.hpp"
+#include "TaskLayout.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/message_buffer.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class StickerPipeline {
+public:
+    // Network -> decode, compressed bytes: ~1 s of a slow Wi-Fi link
+    static constexpr size_t STREAM_BYTES = 8 * 1024;
+    // Decode -> printer, rows of the widest raster: two 32-row bands
+    // ahead of the head
+    static constexpr size_t ROW_SLOTS = 64;
+    
+    struct Config {
+        uint32_t row_timeout_ms;    // The printer gives up on a stream this quiet
+    };
+    
+    static constexpr Config DEFAULT_CONFIG = {
+        10000,
+    };
+    
+    // Fill of each stage now, its capacity and its peak since begin()
+    struct Depths {
+        size_t stream_bytes;
+        size_t stream_capacity;
+        size_t stream_peak;
+        size_t rows;
+        size_t row_capacity;        // At the current sticker's width
+        size_t row_peak;
+        uint32_t network_waits;     // Writes that found the stream full
+        uint32_t decode_waits;      // Rows that found the row buffer full
+        UBaseType_t print_jobs;     // Waiting in the PrintQueue
+        uint32_t stickers;
+        uint32_t failed;
+    };
+    
+    // Printer task, once the sticker's job is done; job_id 0 if it never
+    // got to the queue
+    using DoneCallback = std::function<void(uint32_t job_id, bool ok)>;
+    
+    // Decode task: sees each sticker's rows just after they are handed to
+    // the printer (e.g. PrintPreview). Runs in the decode loop, so it must
+    // not block.
+    class RowObserver {
+    public:
+        virtual ~RowObserver() = default;
+        virtual void begin(uint16_t width_bytes, uint16_t height) = 0;
+        virtual void row(const uint8_t* data) = 0;
+        // `ok` = false: the raster ended early
+        virtual void end(bool ok) = 0;
+    };
+    
+    explicit StickerPipeline(PrintQueue& queue, const Config& config = DEFAULT_CONFIG);
+    ~StickerPipeline();
+    
+    // Sets up the buffers and starts the decode task
+    bool begin(const TaskSpec& task = TaskLayout::DECODE);
+    void setCallback(DoneCallback callback) { callback_ = callback; }
+    // Set before begin(); nullptr for none
+    void setObserver(RowObserver* observer) { observer_ = observer; }
+    
+    // Network task, one sticker at a time: open(), write() as bytes
+    // arrive, close(). open() waits up to `ticks` for the previous
+    // sticker to clear the pipeline.
+    bool open(TickType_t ticks);
+    // Blocks while the stream buffer is full, up to `ticks`. False on a
+    // timeout or once the decoder has given up on the sticker; the caller
+    // should stop downloading and close(false).
+    bool write(const uint8_t* data, size_t len, TickType_t ticks);
+    // `ok` = false aborts: the raster stops where the download did.
+    // `caption` (UTF-8, cut to CaptionRenderer::MAX_BYTES) prints under a
+    // sticker that downloaded in full; nullptr or "" for none.
+    void close(bool ok, const char* caption = nullptr);
+    
+    Depths getDepths() const;
+    // Decode task's glyph cache and layout counts, all stickers so far
+    CaptionRenderer::Stats getCaptionStats() const { return caption_renderer_.getStats(); }
+    void logDepths() const;
+
+private:
+    class StreamReader;
+    class RowReader;
+    
+    PrintQueue& queue_;
+    Config config_;
+    DoneCallback callback_;
+    RowObserver* observer_;
+    StreamBufferHandle_t stream_;
+    MessageBufferHandle_t rows_;
+    SemaphoreHandle_t start_sem_;
+    SemaphoreHandle_t idle_sem_;
+    TaskHandle_t task_handle_;
+    
+    // Message buffers store each length as a size_t ahead of the message
+    static constexpr size_t LENGTH_BYTES = 4;
+    static constexpr size_t ROW_BUFFER_BYTES = ROW_SLOTS * (RasterDecoder::MAX_WIDTH_BYTES + LENGTH_BYTES);
+    // FreeRTOS keeps one byte of a static buffer's storage empty
+    uint8_t stream_storage_[STREAM_BYTES + 1];
+    uint8_t rows_storage_[ROW_BUFFER_BYTES + 1];
+    StaticStreamBuffer_t stream_buffer_;
+    StaticMessageBuffer_t rows_buffer_;
+    StaticSemaphore_t start_storage_;
+    StaticSemaphore_t idle_storage_;
+    TaskStorage<TaskLayout::DECODE.stack> task_storage_;
+    
+    RasterDecoder decoder_;
+    uint8_t row_buf_[RasterDecoder::MAX_WIDTH_BYTES];
+    CaptionRenderer caption_renderer_;
+    // Written by close() before closed_ is set, read by the decode task after
+    char caption_[CaptionRenderer::MAX_BYTES + 1];
+    
+    // Current sticker
+    std::atomic<bool> closed_;
+    std::atomic<bool> aborted_;
+    std::atomic<bool> rejected_;        // Decoder gave up; writes fail
+    std::atomic<bool> reader_done_;     // The print job stopped reading
+    std::atomic<int> holders_;          // Decode and print stages still on it
+    
+    // Depth accounting
+    std::atomic<uint16_t> width_bytes_;
+    std::atomic<size_t> stream_peak_;
+    std::atomic<size_t> row_peak_;
+    std::atomic<uint32_t> network_waits_;
+    std::atomic<uint32_t> decode_waits_;
+    std::atomic<uint32_t> stickers_;
+    std::atomic<uint32_t> failed_;
+    
+    static constexpr const char* TAG = "StickerPipeline";
+    static constexpr TickType_t POLL_TICKS = pdMS_TO_TICKS(20);
+    static constexpr uint8_t END_FAILED = 0;   // One-byte message: raster ends early
+    static constexpr uint8_t END_OK = 1;       // One-byte message: raster is complete
+    
+    static void taskEntry(void* arg);
+    void task();
+    bool decode();
+    bool sendCaption();
+    bool sendRow(const uint8_t* data, size_t len);
+    size_t readStream(uint8_t* buf, size_t max);
+    void release(int stages);
+    size_t queuedRows(uint16_t width_bytes) const;
+    void finish(uint32_t job_id, bool ok);
+    static void onJobDone(uint32_t job_id, bool ok, void* ctx);
+};
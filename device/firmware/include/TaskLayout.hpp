@@ -0,0 +1,100 @@
+/*
+ * TaskLayout.hpp
+ * Core, priority and stack of every firmware task
+ *
+ * Core 0 (PRO) runs what talks to the outside world: the button, the
+ * I2C bus, microphone capture and the network, next to the Wi-Fi driver
+ * and lwIP that ESP-IDF already pins there. Core 1 (APP) runs the sticker
+ * path: the decode stage and the printer task. The two halves only meet
+ * through StickerPipeline's stream and message buffers and PrintQueue,
+ * so a slow download never takes CPU from decoding, and a printer band
+ * never delays the button or the I2S reads.
+ *
+ * Priorities (higher runs first; Wi-Fi is 23 and lwIP 18 on core 0):
+ *   audio_reader 18   I2S DMA must be drained within 8 x 32 ms
+ *   i2c_bus      12   OLED updates are short and keep the UI live
+ *   button       10   Gestures are timestamped in the ISR; this only
+ *                     classifies them and must not sit behind transfers
+ *   network       8   Upload and sticker download; block on sockets
+ *   spool         4   Flash writes, erases between jobs
+ *   cache         3   Reprint cache, the least urgent flash writer
+ *   printer       6   Outranks decode: once a row is buffered, writing
+ *                     it to the UART comes first and decode fills the
+ *                     waits for the wire and the head
+ *   decode        5
+ *
+ * Stacks are in bytes (ESP-IDF counts stack depth in bytes): the deepest
+ * call path of the task plus about 1 KB for ESP_LOGx formatting. Check
+ * uxTaskGetStackHighWaterMark() after changing what a task runs.
+ *
+ * Each library's begin() takes its TaskSpec, with the entry below as the
+ * default, so this table is the one place tasks are placed and sized.
+ * Stacks and task control blocks are static (TaskStorage): no task takes
+ * heap, and STACK_BUDGET checks the sum at build time.
+ */
+
+#pragma once
+
+#include "MemoryBudget.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <cstdint>
+
+struct TaskSpec {
+    const char* name;
+    uint32_t stack;
+    UBaseType_t priority;
+    BaseType_t core;
+};
+
+namespace TaskLayout {
+
+constexpr BaseType_t IO_CORE = 0;
+constexpr BaseType_t PRINT_CORE = 1;
+
+// Core 0
+constexpr TaskSpec AUDIO_READER = {"audio_reader", 3072, 18, IO_CORE};
+constexpr TaskSpec I2C_BUS = {"i2c_bus", 3072, 12, IO_CORE};
+// Long press logs latency, cache and pipeline reports from this task
+constexpr TaskSpec BUTTON = {"button_task", 3072, 10, IO_CORE};
+// HTTP client plus TLS record buffers
+constexpr TaskSpec NETWORK = {"audio_upload", 6144, 8, IO_CORE};
+constexpr TaskSpec SPOOL = {"spool", 3072, 4, IO_CORE};
+constexpr TaskSpec CACHE = {"cache", 3072, 3, IO_CORE};
+
+// Core 1
+constexpr TaskSpec PRINTER = {"printer_task", 4096, 6, PRINT_CORE};
+// RasterDecoder keeps its buffers in the pipeline object, not the stack
+constexpr TaskSpec DECODE = {"decode", 3072, 5, PRINT_CORE};
+
+constexpr uint32_t STACK_TOTAL = AUDIO_READER.stack + I2C_BUS.stack + BUTTON.stack + NETWORK.stack
+                                 + SPOOL.stack + CACHE.stack + PRINTER.stack + DECODE.stack;
+constexpr uint32_t STACK_BUDGET = 32 * 1024;
+static_assert(STACK_TOTAL <= STACK_BUDGET, "Task stacks are over budget");
+    
+}  // namespace TaskLayout
+
+// A task's stack and control block as a member, so the task lives in
+// whatever holds it (.bss for the firmware's static objects) and not on
+// the heap. Size it from the spec: TaskStorage<TaskLayout::PRINTER.stack>.
+template <uint32_t STACK>
+class TaskStorage {
+public:
+    // nullptr if the spec asks for a bigger stack than this storage has
+    TaskHandle_t start(TaskFunction_t entry, void* arg, const TaskSpec& spec)
+    {
+        if (spec.stack > STACK) {
+            return nullptr;
+        }
+        TaskHandle_t handle = xTaskCreateStaticPinnedToCore(entry, spec.name, spec.stack, arg, spec.priority,
+                                                            stack_, &tcb_, spec.core);
+        if (handle) {
+            MemoryBudget::addTask(spec.name, handle, spec.stack);
+        }
+        return handle;
+    }
+
+private:
+    StackType_t stack_[STACK];      // Bytes on the ESP32
+    StaticTask_t tcb_;
+};
@@ -8,29 +8,208 @@
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "EscPos.hpp"
+#include "PrintProfile.hpp"
+#include "RasterSource.hpp"
 
 class ThermalPrinter {
 public:
+    // Printer head width for 58 mm units: 384 dots = 48 bytes per row
+    static constexpr uint16_t MAX_WIDTH_BYTES = 48;
+    static constexpr uint16_t MAX_BAND_ROWS = BandLayout::MAX_ROWS;
+    static constexpr uint16_t DEFAULT_BAND_ROWS = 24;
+    
+    struct RasterStats {
+        uint32_t rows;
+        uint32_t bands;      // GS v 0 blocks
+        uint32_t bytes;      // Header, profile, feed + pixel bytes sent over UART
+        uint32_t profile_changes;
+        uint32_t blank_rows; // Fed with ESC J instead of sent
+        uint32_t feeds;
+        uint32_t bytes_saved;   // Against one GS v 0 block per band
+        int64_t saved_us;    // Wire time of bytes_saved at the baud rate
+        int64_t head_us;     // Modeled head time for the rows
+        int64_t elapsed_us;  // First band queued -> last byte on the wire
+    };
+    
+    // Mechanical timing model used to pace commands. Transfer time comes
+    // from the baud rate; these cover what the printer does afterwards.
+    // Raster dot lines follow the heating profile (PrintProfile::lineUs).
+    struct PrintTiming {
+        uint32_t dot_line_us;   // Print one text dot line
+        uint32_t feed_dot_us;   // Feed paper by one dot (fastest motor step)
+        uint16_t line_dots;     // Text line pitch in dots (ESC 2 default)
+        uint32_t cut_us;        // Cutter cycle
+        uint32_t reset_us;      // ESC @ housekeeping
+        uint32_t max_ahead_us;  // Work the printer's input buffer may hold
+        uint32_t buffer_bytes;  // Bytes it may hold: sparse bands print so
+                                // fast that max_ahead_us of them won't fit
+    };
+    static constexpr PrintTiming DEFAULT_TIMING = {2500, 1250, 30, 300000, 20000, 150000, 4096};
+    
+    // Line settings the auto-baud probe tries, fastest first: each one is
+    // tried with normal and inverted polarity before the next slower rate
+    static constexpr uint32_t BAUDS[] = {230400, 115200, 57600, 38400, 19200, 9600};
+    static constexpr uint32_t INVERTED = UART_SIGNAL_TXD_INV | UART_SIGNAL_RXD_INV;
+    
+    // Pass as baud_rate to let begin() find the printer: it reuses the
+    // settings saved in NVS if the printer still answers DLE EOT on them,
+    // and otherwise probes BAUDS and saves the winner. Needs the printer TX
+    // wired to rx_pin and NVS initialized (the Arduino core does it);
+    // without a reply it falls back to FALLBACK_BAUD, normal polarity.
+    static constexpr int AUTO_BAUD = 0;
+    static constexpr int FALLBACK_BAUD = 9600;
+    
     ThermalPrinter(uart_port_t port, int tx_pin, int rx_pin, int baud_rate = 9600);
     ~ThermalPrinter();
     
     bool begin();
+    
+    // Line settings in use after begin()
+    int getBaudRate() const { return baud_rate_; }
+    bool isInverted() const { return inverse_ != 0; }
+    
+    // Drop the settings saved by the auto-baud probe, so the next
+    // AUTO_BAUD begin() probes again
+    static void forgetLink();
     void printText(const char* text);
     void printLine(const char* text);
     void feedLines(uint8_t lines);
     void cutPaper();
     void reset();
     
+    // Rows of the current raster the head has finished, by the timing
+    // model. Rows still in the printer's buffer or on the wire don't count,
+    // so a job resumed from here after a reset loses nothing.
+    using RasterProgress = void (*)(uint32_t rows_printed, void* ctx);
+    
+    // Stream a raster image as a sequence of GS v 0 bands.
+    // Only one band is buffered; returns false on error. Runs of blank
+    // rows are cut out of the bands and fed with ESC J (see BandLayout):
+    // a blank row costs 3 bytes for the whole run instead of a full row.
+    bool printRaster(RasterSource& source, uint16_t width_bytes,
+                     RasterProgress progress = nullptr, void* ctx = nullptr);
+    
+    // Heating profile for raster bands. nullptr (the default) picks one
+    // per band from its densest row (PrintProfiles::select); a fixed
+    // profile is sent once and kept.
+    void setProfile(const PrintProfile* profile) { profile_ = profile; }
+    const PrintProfile* getProfile() const { return profile_; }
+    
+    // Rows per GS v 0 band (1..MAX_BAND_ROWS). Larger bands mean fewer
+    // headers on the wire at the cost of a bigger fill burst.
+    void setBandRows(uint16_t rows);
+    uint16_t getBandRows() const { return band_rows_; }
+    
+    // Feed blank runs with ESC J (the default) or send every row
+    void setBlankFeeds(bool on) { blank_feeds_ = on; }
+    const RasterStats& getRasterStats() const { return raster_stats_; }
+    
+    // Commands issued between beginBatch() and endBatch() are staged in one
+    // buffer and leave in a single UART write. A raster band flushes what
+    // is staged in front of it; the last band stays staged so trailing
+    // feed/cut commands ride along with it. Staging also flushes early if
+    // the buffer fills up.
+    void beginBatch();
+    void endBatch();
+    
+    // Block until the TX ring buffer and FIFO are empty
+    bool waitTxDone(TickType_t timeout = portMAX_DELAY);
+    
+    void setTiming(const PrintTiming& timing) { timing_ = timing; }
+    
+    // DLE EOT 1 real-time status. Only available when the printer TX line
+    // is wired to rx_pin and answered the probe in begin().
+    bool hasStatus() const { return status_supported_; }
+    bool queryStatus(uint8_t* status);
+    
 private:
     uart_port_t uart_port_;
     int tx_pin_;
     int rx_pin_;
     int baud_rate_;
+    uint32_t inverse_;          // uart_set_line_inverse() mask
+    bool auto_baud_;
     bool initialized_;
+    uint16_t band_rows_;
+    bool blank_feeds_;
+    RasterStats raster_stats_;
+    PrintTiming timing_;
+    bool status_supported_;
+    int64_t wire_free_at_us_;   // Modeled time the last queued byte leaves the UART
+    int64_t head_free_at_us_;   // Modeled time the printer finishes queued work
+    bool batching_;
+    bool raster_pending_;       // Last band staged, stats not final yet
+    int64_t raster_start_us_;
+    RasterProgress progress_;
+    void* progress_ctx_;
+    const PrintProfile* profile_;           // nullptr = per band
+    const PrintProfile* active_profile_;    // What the printer runs now
+    
+    // Writes waiting in the printer's input buffer, oldest first: each
+    // leaves it once the head starts on it
+    struct Queued {
+        int64_t start_us;
+        uint32_t bytes;
+    };
+    static constexpr size_t MAX_QUEUED = 8;
+    Queued queued_[MAX_QUEUED];
+    size_t queued_count_;
+    uint32_t queued_bytes_;
+    
+    // Staged commands, then at most one profile change, a leading feed,
+    // GS v 0 header and band of rows. The band's rows are read in behind
+    // that reserve; cutting blank runs only ever moves them left.
+    static constexpr size_t BATCH_ROOM = 256;
+    static constexpr size_t BAND_RESERVE = PrintProfile::COMMAND_LEN + EscPos::FEED_DOTS_LEN
+                                           + EscPos::RASTER_HEADER_LEN;
+    static constexpr size_t TX_BUF_SIZE = BATCH_ROOM + BAND_RESERVE
+                                          + MAX_BAND_ROWS * MAX_WIDTH_BYTES;
+    uint8_t tx_buf_[TX_BUF_SIZE];
+    size_t tx_len_;
+    
+    // Staged commands and the feeds and GS v 0 blocks of a band, each with
+    // its print time: the printer starts on one as soon as its last byte
+    // is in and the one before is done, so a leading feed runs while the
+    // rows behind it are still on the wire. A full list grows its last
+    // piece, which only starts later.
+    struct Piece {
+        uint16_t end;           // Offset in tx_buf_ past its last byte
+        uint32_t head_us;
+    };
+    static constexpr size_t MAX_PIECES = MAX_BAND_ROWS + 8;
+    Piece tx_pieces_[MAX_PIECES];
+    size_t tx_piece_count_;
     
     static constexpr size_t UART_BUF_SIZE = 1024;
-    static constexpr char* TAG = "ThermalPrinter";
+    static constexpr const char* TAG = "ThermalPrinter";
+    
+    static constexpr uint8_t STATUS_OFFLINE = 0x08;
+    static constexpr uint32_t STATUS_TIMEOUT_MS = 50;
+    static constexpr uint32_t STATUS_POLL_MS = 10;
+    static constexpr int64_t OFFLINE_WAIT_LIMIT_US = 5000000;
+    static constexpr const char* NVS_NAMESPACE = "printer";
+    
+    bool setLink(uint32_t baud, uint32_t inverse);
+    bool findLink();
+    bool loadLink(uint32_t* baud, uint32_t* inverse);
+    void saveLink();
     
-    void sendCommand(const uint8_t* cmd, size_t len);
+    void sendCommand(const uint8_t* cmd, size_t len, uint32_t head_us = 0);
+    template <size_t N>
+    void sendCommand(const EscPos::Seq<N>& cmd, uint32_t head_us = 0)
+    {
+        sendCommand(cmd.data(), N, head_us);
+    }
+    void write(const uint8_t* data, size_t len, uint32_t head_us);
+    void write(const uint8_t* data, size_t len, const Piece* pieces, size_t count);
+    void stage(size_t len, uint32_t head_us);
+    void stageFeed(uint16_t dots, uint32_t head_us);
+    void flush();
+    void finishRaster();
+    void reportProgress();
     void sendText(const char* text);
+    void pace(size_t len);
+    int64_t holdUs(size_t len);
+    void account(int64_t issued_us, const Piece* pieces, size_t count);
 };
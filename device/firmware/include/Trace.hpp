@@ -0,0 +1,75 @@
+/*
+ * Trace.hpp
+ * Lightweight span/instant/counter tracing into a lock-free ring
+ *
+ * Events are recorded from tasks or ISRs into a fixed ring (oldest
+ * overwritten) with one atomic increment and a few stores. Trace::dump()
+ * prints the ring as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+ * between marker lines on the console; scripts/trace_extract.py pulls it
+ * out of a monitor log.
+ *
+ * Build with -DPEGAVOX_TRACE=1 to record. Otherwise every TRACE_* macro
+ * compiles to nothing and the ring isn't allocated.
+ *
+ * Names must be string literals (only the pointer is stored).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef PEGAVOX_TRACE
+#define PEGAVOX_TRACE 0
+#endif
+
+#ifndef PEGAVOX_TRACE_EVENTS
+#define PEGAVOX_TRACE_EVENTS 1024   // Power of two; 24 bytes each
+#endif
+
+class Trace {
+public:
+    enum class Type : uint8_t {
+        Begin,
+        End,
+        Instant,
+        Counter,
+    };
+    
+    static void record(Type type, const char* name, int32_t arg = 0);
+    
+    // Pause/resume recording (dump() pauses while it prints)
+    static void setEnabled(bool enabled);
+    
+    // Print everything in the ring as Chrome trace JSON
+    static void dump();
+    
+    // Events lost to overwrite since boot
+    static uint32_t overwritten();
+    
+    // RAII span for TRACE_SCOPE
+    class Scope {
+    public:
+        explicit Scope(const char* name, int32_t arg = 0) : name_(name) { record(Type::Begin, name, arg); }
+        ~Scope() { record(Type::End, name_); }
+    private:
+        const char* name_;
+    };
+};
+
+#if PEGAVOX_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_BEGIN(name, ...)   Trace::record(Trace::Type::Begin, name, ##__VA_ARGS__)
+#define TRACE_END(name)          Trace::record(Trace::Type::End, name)
+#define TRACE_INSTANT(name, ...) Trace::record(Trace::Type::Instant, name, ##__VA_ARGS__)
+#define TRACE_COUNTER(name, v)   Trace::record(Trace::Type::Counter, name, (int32_t)(v))
+#define TRACE_SCOPE(name, ...)   Trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name, ##__VA_ARGS__)
+#else
+#define TRACE_BEGIN(name, ...)   ((void)0)
+#define TRACE_END(name)          ((void)0)
+#define TRACE_INSTANT(name, ...) ((void)0)
+#define TRACE_COUNTER(name, v)   ((void)0)
+#define TRACE_SCOPE(name, ...)   ((void)0)
+#endif
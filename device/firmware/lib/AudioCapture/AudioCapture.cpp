@@ -0,0 +1,202 @@
+/*
+ * AudioCapture.cpp
+ * INMP441 I2S microphone capture into a lock-free ring buffer
+ */
+
+#include "AudioCapture.hpp"
+#include "MemoryBudget.hpp"
+#include "esp_heap_caps.h"
+
+AudioCapture::AudioCapture(gpio_num_t bclk_pin, gpio_num_t ws_pin, gpio_num_t data_pin,
+                           uint32_t sample_rate, size_t ring_samples)
+    : bclk_pin_(bclk_pin)
+    , ws_pin_(ws_pin)
+    , data_pin_(data_pin)
+    , sample_rate_(sample_rate)
+    , ring_samples_(ring_samples)
+    , rx_chan_(nullptr)
+    , reader_task_(nullptr)
+    , consumer_task_(nullptr)
+    , running_(false)
+    , stopping_(false)
+    , parked_(nullptr)
+    , dropped_(0)
+    , ring_high_water_(0)
+    , ring_storage_(nullptr)
+{
+}
+
+AudioCapture::~AudioCapture()
+{
+    if (reader_task_) {
+        vTaskDelete(reader_task_);
+    }
+    if (rx_chan_) {
+        if (running_.load()) {
+            i2s_channel_disable(rx_chan_);
+        }
+        i2s_del_channel(rx_chan_);
+    }
+    heap_caps_free(ring_storage_);
+}
+
+bool AudioCapture::begin(const TaskSpec& task)
+{
+    // Ring lives in PSRAM when available; the reader only memcpy's into it
+    ring_storage_ = (int16_t*)MemoryBudget::reserve("audio ring", ring_samples_ * sizeof(int16_t), true);
+    if (!ring_.init(ring_storage_, ring_samples_)) {
+        ESP_LOGE(TAG, "Failed to allocate %u-sample ring", (unsigned)ring_samples_);
+        return false;
+    }
+    
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = DMA_DESCRIPTORS;
+    chan_cfg.dma_frame_num = DMA_FRAMES;
+    esp_err_t err = i2s_new_channel(&chan_cfg, nullptr, &rx_chan_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "I2S channel create failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    
+    // INMP441: 24-bit samples left-justified in 32-bit slots, L/R tied low
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate_),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = bclk_pin_,
+            .ws = ws_pin_,
+            .dout = I2S_GPIO_UNUSED,
+            .din = data_pin_,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        },
+    };
+    std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;
+    
+    err = i2s_channel_init_std_mode(rx_chan_, &std_cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "I2S std mode init failed: %s", esp_err_to_name(err));
+        i2s_del_channel(rx_chan_);
+        rx_chan_ = nullptr;
+        return false;
+    }
+    
+    parked_ = xSemaphoreCreateBinaryStatic(&parked_buf_);
+    reader_task_ = task_storage_.start(taskEntry, this, task);
+    if (!reader_task_) {
+        ESP_LOGE(TAG, "Failed to create reader task");
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "Initialized: BCLK=%d, WS=%d, DATA=%d, %u Hz, ring=%u samples",
+             bclk_pin_, ws_pin_, data_pin_, (unsigned)sample_rate_, (unsigned)ring_samples_);
+    return true;
+}
+
+bool AudioCapture::start()
+{
+    if (!rx_chan_ || running_.load()) {
+        return false;
+    }
+    
+    // The reader is parked (stop() waited for it), so nothing else touches
+    // the ring's producer side or the filter
+    ring_.clear();
+    dropped_.store(0);
+    ring_high_water_ = 0;
+    dc_blocker_.reset();
+    
+    esp_err_t err = i2s_channel_enable(rx_chan_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "I2S enable failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    stopping_.store(false);
+    running_.store(true);
+    xTaskNotifyGive(reader_task_);
+    ESP_LOGI(TAG, "Recording started");
+    return true;
+}
+
+void AudioCapture::stop()
+{
+    if (!running_.load() || stopping_.exchange(true)) {
+        return;
+    }
+    
+    // Let the reader finish the batch it is on (one DMA descriptor, 15 ms)
+    // and park; running_ stays set until then, so a consumer keeps reading
+    // until the last pushed samples are out
+    xSemaphoreTake(parked_, portMAX_DELAY);
+    i2s_channel_disable(rx_chan_);
+    running_.store(false);
+    
+    // Wake a consumer blocked in read() so it can see the end of stream
+    TaskHandle_t consumer = consumer_task_.load();
+    if (consumer) {
+        xTaskNotifyGive(consumer);
+    }
+    ESP_LOGI(TAG, "Recording stopped: dropped=%u, ring high-water=%u/%u",
+             (unsigned)dropped_.load(), (unsigned)ring_high_water_, (unsigned)ring_samples_);
+}
+
+size_t AudioCapture::read(int16_t* out, size_t max, TickType_t timeout)
+{
+    consumer_task_.store(xTaskGetCurrentTaskHandle());
+    
+    size_t n = ring_.pop(out, max);
+    while (n == 0 && running_.load()) {
+        if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            break;
+        }
+        n = ring_.pop(out, max);
+    }
+    if (n == 0) {
+        n = ring_.pop(out, max);  // Samples pushed just before stop()
+    }
+    return n;
+}
+
+void AudioCapture::taskEntry(void* arg)
+{
+    static_cast<AudioCapture*>(arg)->readerTask();
+}
+
+void AudioCapture::readerTask()
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);    // start()
+        
+        while (!stopping_.load()) {
+            size_t bytes_read = 0;
+            esp_err_t err = i2s_channel_read(rx_chan_, dma_buf_, sizeof(dma_buf_), &bytes_read, 100);
+            if (err != ESP_OK || bytes_read == 0) {
+                continue;
+            }
+            
+            size_t frames = bytes_read / sizeof(int32_t);
+            convertSamples32to16(dma_buf_, pcm_buf_, frames);
+            dc_blocker_.process(pcm_buf_, frames);
+            
+            // Never block the DMA path: a full ring drops and counts samples
+            size_t pushed = ring_.push(pcm_buf_, frames);
+            if (pushed < frames) {
+                dropped_.fetch_add(frames - pushed);
+            }
+            size_t level = ring_.size();
+            if (level > ring_high_water_) {
+                ring_high_water_ = level;
+            }
+            
+            TaskHandle_t consumer = consumer_task_.load();
+            if (consumer) {
+                xTaskNotifyGive(consumer);
+            }
+        }
+        xSemaphoreGive(parked_);
+    }
+}
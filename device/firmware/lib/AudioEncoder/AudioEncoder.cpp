@@ -0,0 +1,223 @@
+/*
+ * AudioEncoder.cpp
+ * Streaming WAV PCM and IMA-ADPCM encoders
+ */
+
+#include "AudioEncoder.hpp"
+#include <cstring>
+
+// RIFF/WAVE header with unknown (0xFFFFFFFF) sizes. Returns its length.
+static size_t writeWavHeader(uint8_t* out, uint16_t format, uint32_t sample_rate,
+                             uint32_t byte_rate, uint16_t block_align, uint16_t bits,
+                             uint16_t samples_per_block)
+{
+    auto put16 = [&](size_t at, uint16_t v) {
+        out[at] = (uint8_t)v;
+        out[at + 1] = (uint8_t)(v >> 8);
+    };
+    auto put32 = [&](size_t at, uint32_t v) {
+        put16(at, (uint16_t)v);
+        put16(at + 2, (uint16_t)(v >> 16));
+    };
+
+    // PCM uses the 16-byte fmt chunk, ADPCM adds cbSize + samplesPerBlock
+    const uint32_t fmt_len = samples_per_block ? 20 : 16;
+    size_t p = 0;
+    memcpy(out + p, "RIFF", 4);
+    put32(p + 4, 0xFFFFFFFF);
+    memcpy(out + p + 8, "WAVE", 4);
+    p += 12;
+
+    memcpy(out + p, "fmt ", 4);
+    put32(p + 4, fmt_len);
+    put16(p + 8, format);
+    put16(p + 10, 1);               // Mono
+    put32(p + 12, sample_rate);
+    put32(p + 16, byte_rate);
+    put16(p + 20, block_align);
+    put16(p + 22, bits);
+    if (samples_per_block) {
+        put16(p + 24, 2);
+        put16(p + 26, samples_per_block);
+    }
+    p += 8 + fmt_len;
+
+    memcpy(out + p, "data", 4);
+    put32(p + 4, 0xFFFFFFFF);
+    return p + 8;
+}
+
+AudioEncoder::AudioEncoder()
+    : output_(nullptr)
+    , arena_(nullptr)
+    , samples_in_(0)
+    , bytes_out_(0)
+{
+}
+
+void AudioEncoder::start(Output output)
+{
+    output_ = output;
+    samples_in_ = 0;
+    bytes_out_ = 0;
+}
+
+void AudioEncoder::emit(const uint8_t* data, size_t len)
+{
+    bytes_out_ += len;
+    if (output_) {
+        output_(data, len);
+    }
+}
+
+// --- PCM ---
+
+bool PcmWavEncoder::begin(uint32_t sample_rate, Output output)
+{
+    start(output);
+    uint8_t header[44];
+    size_t len = writeWavHeader(header, 1, sample_rate, sample_rate * 2, 2, 16, 0);
+    emit(header, len);
+    return true;
+}
+
+void PcmWavEncoder::encode(const int16_t* samples, size_t count)
+{
+    // ESP32 and every host we build on are little-endian, like WAV
+    samples_in_ += count;
+    emit((const uint8_t*)samples, count * sizeof(int16_t));
+}
+
+// --- IMA-ADPCM ---
+
+static const int16_t IMA_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+};
+
+static const int8_t IMA_INDEX_TABLE[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+ImaAdpcmEncoder::ImaAdpcmEncoder()
+    : block_fill_(0)
+    , predictor_(0)
+    , step_index_(0)
+{
+}
+
+bool ImaAdpcmEncoder::begin(uint32_t sample_rate, Output output)
+{
+    start(output);
+    block_fill_ = 0;
+    predictor_ = 0;
+    step_index_ = 0;
+
+    uint8_t header[48];
+    uint32_t byte_rate = (uint32_t)((uint64_t)sample_rate * BLOCK_ALIGN / SAMPLES_PER_BLOCK);
+    size_t len = writeWavHeader(header, 0x0011, sample_rate, byte_rate,
+                                BLOCK_ALIGN, 4, SAMPLES_PER_BLOCK);
+    emit(header, len);
+    return true;
+}
+
+void ImaAdpcmEncoder::encode(const int16_t* samples, size_t count)
+{
+    samples_in_ += count;
+    while (count > 0) {
+        size_t n = SAMPLES_PER_BLOCK - block_fill_;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(block_ + block_fill_, samples, n * sizeof(int16_t));
+        block_fill_ += n;
+        samples += n;
+        count -= n;
+
+        if (block_fill_ == SAMPLES_PER_BLOCK) {
+            encodeBlock();
+            block_fill_ = 0;
+        }
+    }
+}
+
+void ImaAdpcmEncoder::finish()
+{
+    if (block_fill_ == 0) {
+        return;
+    }
+    // Decoders expect whole blocks: hold the last sample to the end
+    int16_t last = block_[block_fill_ - 1];
+    while (block_fill_ < SAMPLES_PER_BLOCK) {
+        block_[block_fill_++] = last;
+    }
+    encodeBlock();
+    block_fill_ = 0;
+}
+
+void ImaAdpcmEncoder::encodeBlock()
+{
+    // Block header: first sample verbatim + current step index
+    predictor_ = block_[0];
+    out_[0] = (uint8_t)block_[0];
+    out_[1] = (uint8_t)((uint16_t)block_[0] >> 8);
+    out_[2] = (uint8_t)step_index_;
+    out_[3] = 0;
+
+    // Two samples per byte, low nibble first
+    uint8_t* out = out_ + 4;
+    for (uint16_t i = 1; i < SAMPLES_PER_BLOCK; i += 2) {
+        uint8_t lo = encodeSample(block_[i]);
+        uint8_t hi = encodeSample(block_[i + 1]);
+        *out++ = lo | (hi << 4);
+    }
+    emit(out_, BLOCK_ALIGN);
+}
+
+uint8_t ImaAdpcmEncoder::encodeSample(int16_t sample)
+{
+    int32_t step = IMA_STEP_TABLE[step_index_];
+    int32_t diff = sample - predictor_;
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    // Successive approximation, reconstructing exactly as the decoder does
+    int32_t vpdiff = step >> 3;
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 1;
+        vpdiff += step;
+    }
+
+    predictor_ += (nibble & 8) ? -vpdiff : vpdiff;
+    if (predictor_ > 32767) {
+        predictor_ = 32767;
+    } else if (predictor_ < -32768) {
+        predictor_ = -32768;
+    }
+
+    step_index_ += IMA_INDEX_TABLE[nibble & 7];
+    if (step_index_ < 0) {
+        step_index_ = 0;
+    } else if (step_index_ > 88) {
+        step_index_ = 88;
+    }
+    return nibble;
+}
@@ -0,0 +1,437 @@
+/*
+ * FlacEncoder.cpp
+ * Streaming FLAC subset encoder (fixed predictors, partitioned Rice)
+ */
+
+#include "AudioEncoder.hpp"
+#include <cstring>
+
+// CRC-8 (poly 0x07) for frame headers, CRC-16 (poly 0x8005) for frames
+struct FlacCrcTables {
+    uint8_t crc8[256];
+    uint16_t crc16[256];
+
+    constexpr FlacCrcTables() : crc8(), crc16()
+    {
+        for (int i = 0; i < 256; i++) {
+            uint8_t c8 = (uint8_t)i;
+            uint16_t c16 = (uint16_t)(i << 8);
+            for (int b = 0; b < 8; b++) {
+                c8 = (uint8_t)((c8 & 0x80) ? (c8 << 1) ^ 0x07 : c8 << 1);
+                c16 = (uint16_t)((c16 & 0x8000) ? (c16 << 1) ^ 0x8005 : c16 << 1);
+            }
+            crc8[i] = c8;
+            crc16[i] = c16;
+        }
+    }
+};
+
+static constexpr FlacCrcTables CRC_TABLES;
+
+static uint8_t crc8(const uint8_t* data, size_t len)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc = CRC_TABLES.crc8[crc ^ data[i]];
+    }
+    return crc;
+}
+
+static uint16_t crc16(const uint8_t* data, size_t len)
+{
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 8) ^ CRC_TABLES.crc16[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+// Frame-header code for sizes the table can express directly, else 0
+static uint8_t blockSizeCode(uint16_t count)
+{
+    for (uint8_t code = 8; code <= 15; code++) {
+        if (count == (256u << (code - 8))) {
+            return code;
+        }
+    }
+    return 0;
+}
+
+static uint8_t sampleRateCode(uint32_t rate)
+{
+    switch (rate) {
+    case 88200: return 1;
+    case 176400: return 2;
+    case 192000: return 3;
+    case 8000: return 4;
+    case 16000: return 5;
+    case 22050: return 6;
+    case 24000: return 7;
+    case 32000: return 8;
+    case 44100: return 9;
+    case 48000: return 10;
+    case 96000: return 11;
+    }
+    if (rate % 1000 == 0 && rate / 1000 <= 255) {
+        return 12;
+    }
+    if (rate <= 65535) {
+        return 13;
+    }
+    return 14;
+}
+
+// Rice parameter for n values summing to `sum`, and the bits it costs.
+// sum >> k bounds the quotient total from above, so the estimate never
+// undercounts what putRice() writes.
+static uint8_t riceParameter(uint32_t n, uint64_t sum, uint64_t* bits)
+{
+    uint8_t k = 0;
+    while (k < 14 && ((uint64_t)n << (k + 1)) < sum) {
+        k++;
+    }
+    *bits = 4 + (uint64_t)n * (k + 1) + (sum >> k);
+    return k;
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+FlacEncoder::FlacEncoder()
+    : sample_rate_(0)
+    , rate_code_(0)
+    , buffers_arena_(nullptr)
+    , block_(nullptr)
+    , block_fill_(0)
+    , residual_(nullptr)
+    , frame_(nullptr)
+    , frame_capacity_(0)
+    , frame_number_(0)
+    , byte_pos_(0)
+    , bit_acc_(0)
+    , bit_count_(0)
+{
+}
+
+FlacEncoder::~FlacEncoder()
+{
+    end();
+}
+
+size_t FlacEncoder::memoryUsed() const
+{
+    if (!block_) {
+        return 0;
+    }
+    return BLOCK_SIZE * (sizeof(int16_t) + sizeof(uint32_t)) + frame_capacity_;
+}
+
+bool FlacEncoder::begin(uint32_t sample_rate, Output output)
+{
+    end();
+    if (sample_rate == 0 || sample_rate > 655350
+        || (sample_rate > 65535 && sample_rate % 10 != 0)) {
+        return false;
+    }
+
+    // Worst case is a verbatim frame plus header and CRC
+    frame_capacity_ = BLOCK_SIZE * sizeof(int16_t) + 32;
+    buffers_arena_ = arena_;
+    block_ = Arena::allocateFrom<int16_t>(buffers_arena_, BLOCK_SIZE);
+    residual_ = Arena::allocateFrom<uint32_t>(buffers_arena_, BLOCK_SIZE);
+    frame_ = Arena::allocateFrom<uint8_t>(buffers_arena_, frame_capacity_);
+    if (!block_ || !residual_ || !frame_) {
+        end();
+        return false;
+    }
+
+    start(output);
+    sample_rate_ = sample_rate;
+    rate_code_ = sampleRateCode(sample_rate);
+    block_fill_ = 0;
+    frame_number_ = 0;
+
+    // "fLaC" + last-block STREAMINFO; frame sizes, length and MD5 unknown
+    byte_pos_ = 0;
+    bit_acc_ = 0;
+    bit_count_ = 0;
+    putBits(0x664C6143, 32);
+    putBits(0x80, 8);
+    putBits(34, 24);
+    putBits(BLOCK_SIZE, 16);
+    putBits(BLOCK_SIZE, 16);
+    putBits(0, 24);
+    putBits(0, 24);
+    putBits(sample_rate, 20);
+    putBits(0, 3);                  // Channels - 1
+    putBits(15, 5);                 // Bits per sample - 1
+    putBits(0, 4);                  // Total samples (36 bits): unknown
+    putBits(0, 32);
+    for (int i = 0; i < 4; i++) {
+        putBits(0, 32);             // MD5 not computed
+    }
+    emit(frame_, byte_pos_);
+    return true;
+}
+
+void FlacEncoder::end()
+{
+    Arena::release(buffers_arena_, block_);
+    Arena::release(buffers_arena_, residual_);
+    Arena::release(buffers_arena_, frame_);
+    block_ = nullptr;
+    residual_ = nullptr;
+    frame_ = nullptr;
+}
+
+void FlacEncoder::encode(const int16_t* samples, size_t count)
+{
+    if (!block_) {
+        return;
+    }
+    samples_in_ += count;
+
+    while (count > 0) {
+        size_t n = BLOCK_SIZE - block_fill_;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(block_ + block_fill_, samples, n * sizeof(int16_t));
+        block_fill_ += n;
+        samples += n;
+        count -= n;
+
+        if (block_fill_ == BLOCK_SIZE) {
+            encodeFrame();
+            block_fill_ = 0;
+        }
+    }
+}
+
+void FlacEncoder::finish()
+{
+    // The subset allows a short last frame in a fixed-blocksize stream
+    if (block_ && block_fill_ > 0) {
+        encodeFrame();
+        block_fill_ = 0;
+    }
+}
+
+void FlacEncoder::encodeFrame()
+{
+    const uint16_t count = block_fill_;
+    byte_pos_ = 0;
+    bit_acc_ = 0;
+    bit_count_ = 0;
+
+    // Frame header: sync + fixed blocking, sizes, mono 16-bit
+    uint8_t size_code = blockSizeCode(count);
+    if (size_code == 0) {
+        size_code = count <= 256 ? 6 : 7;
+    }
+    putBits(0xFFF8, 16);
+    putBits(size_code, 4);
+    putBits(rate_code_, 4);
+    putBits(0, 4);
+    putBits(4, 3);
+    putBits(0, 1);
+
+    // Frame number, UTF-8 style
+    uint32_t fn = frame_number_;
+    if (fn < 0x80) {
+        putBits(fn, 8);
+    } else {
+        uint8_t extra = fn < 0x800 ? 1 : fn < 0x10000 ? 2 : fn < 0x200000 ? 3 : fn < 0x4000000 ? 4 : 5;
+        putBits(((0xFF00u >> (extra + 1)) & 0xFF) | (fn >> (6 * extra)), 8);
+        for (int i = extra - 1; i >= 0; i--) {
+            putBits(0x80 | ((fn >> (6 * i)) & 0x3F), 8);
+        }
+    }
+
+    if (size_code == 6) {
+        putBits(count - 1, 8);
+    } else if (size_code == 7) {
+        putBits(count - 1, 16);
+    }
+    if (rate_code_ == 12) {
+        putBits(sample_rate_ / 1000, 8);
+    } else if (rate_code_ == 13) {
+        putBits(sample_rate_, 16);
+    } else if (rate_code_ == 14) {
+        putBits(sample_rate_ / 10, 16);
+    }
+    putBits(crc8(frame_, byte_pos_), 8);
+
+    writeSubframe(count);
+
+    alignByte();
+    putBits(crc16(frame_, byte_pos_), 16);
+    emit(frame_, byte_pos_);
+    frame_number_++;
+}
+
+void FlacEncoder::writeSubframe(uint16_t count)
+{
+    const int16_t* x = block_;
+
+    bool constant = true;
+    for (uint16_t i = 1; i < count && constant; i++) {
+        constant = x[i] == x[0];
+    }
+    if (constant) {
+        putBits(0x00, 8);
+        putBits((uint16_t)x[0], 16);
+        return;
+    }
+
+    // Pick the fixed predictor with the smallest total |residual|
+    uint8_t order = 0;
+    if (count > 4) {
+        uint32_t err[5] = {0, 0, 0, 0, 0};
+        for (uint16_t i = 4; i < count; i++) {
+            int32_t e0 = x[i];
+            int32_t e1 = e0 - x[i - 1];
+            int32_t e2 = e1 - (x[i - 1] - x[i - 2]);
+            int32_t e3 = e2 - (x[i - 1] - 2 * x[i - 2] + x[i - 3]);
+            int32_t e4 = e3 - (x[i - 1] - 3 * x[i - 2] + 3 * x[i - 3] - x[i - 4]);
+            err[0] += e0 < 0 ? -e0 : e0;
+            err[1] += e1 < 0 ? -e1 : e1;
+            err[2] += e2 < 0 ? -e2 : e2;
+            err[3] += e3 < 0 ? -e3 : e3;
+            err[4] += e4 < 0 ? -e4 : e4;
+        }
+        for (uint8_t o = 1; o <= 4; o++) {
+            if (err[o] < err[order]) {
+                order = o;
+            }
+        }
+    }
+
+    for (uint16_t i = order; i < count; i++) {
+        int32_t e;
+        switch (order) {
+        case 0: e = x[i]; break;
+        case 1: e = x[i] - x[i - 1]; break;
+        case 2: e = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+        case 3: e = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+        default: e = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+        }
+        residual_[i - order] = zigzag(e);
+    }
+
+    // Fall back to verbatim when the prediction doesn't pay
+    uint64_t fixed_bits = (uint64_t)order * 16 + 6;
+    uint8_t partition_order = 0;
+    {
+        uint8_t max_order = 0;
+        while (max_order < MAX_PARTITION_ORDER && count % (2u << max_order) == 0
+               && (count >> (max_order + 1)) > order) {
+            max_order++;
+        }
+
+        // Partition sums at the finest order, merged pairwise upwards
+        uint64_t sums[1 << MAX_PARTITION_ORDER];
+        const uint16_t fine = count >> max_order;
+        uint32_t r = 0;
+        for (uint16_t p = 0; p < (1u << max_order); p++) {
+            uint16_t n = p == 0 ? fine - order : fine;
+            uint64_t s = 0;
+            for (uint16_t i = 0; i < n; i++) {
+                s += residual_[r++];
+            }
+            sums[p] = s;
+        }
+
+        uint64_t best = UINT64_MAX;
+        for (int po = max_order; po >= 0; po--) {
+            uint16_t parts = 1u << po;
+            uint16_t len = count >> po;
+            uint64_t total = 0;
+            for (uint16_t p = 0; p < parts; p++) {
+                uint64_t bits;
+                riceParameter(p == 0 ? len - order : len, sums[p], &bits);
+                total += bits;
+            }
+            if (total <= best) {
+                best = total;
+                partition_order = (uint8_t)po;
+            }
+            for (uint16_t p = 0; p < parts / 2; p++) {
+                sums[p] = sums[2 * p] + sums[2 * p + 1];
+            }
+        }
+        fixed_bits += best;
+    }
+
+    if (fixed_bits >= (uint64_t)count * 16) {
+        putBits(0x02, 8);
+        for (uint16_t i = 0; i < count; i++) {
+            putBits((uint16_t)x[i], 16);
+        }
+        return;
+    }
+
+    putBits(0x10 | (order << 1), 8);
+    for (uint8_t i = 0; i < order; i++) {
+        putBits((uint16_t)x[i], 16);
+    }
+    putBits(0, 2);                  // 4-bit Rice parameters
+    putBits(partition_order, 4);
+
+    const uint16_t parts = 1u << partition_order;
+    const uint16_t len = count >> partition_order;
+    uint32_t r = 0;
+    for (uint16_t p = 0; p < parts; p++) {
+        uint16_t n = p == 0 ? len - order : len;
+        uint64_t sum = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            sum += residual_[r + i];
+        }
+        uint64_t bits;
+        uint8_t k = riceParameter(n, sum, &bits);
+        putBits(k, 4);
+        for (uint16_t i = 0; i < n; i++) {
+            putRice(residual_[r++], k);
+        }
+    }
+}
+
+void FlacEncoder::putBits(uint32_t value, uint8_t bits)
+{
+    bit_acc_ = (bit_acc_ << bits) | (value & (uint32_t)((1ull << bits) - 1));
+    bit_count_ += bits;
+    while (bit_count_ >= 8) {
+        bit_count_ -= 8;
+        if (byte_pos_ < frame_capacity_) {
+            frame_[byte_pos_++] = (uint8_t)(bit_acc_ >> bit_count_);
+        }
+    }
+}
+
+void FlacEncoder::putRice(uint32_t value, uint8_t k)
+{
+    // Unary quotient (zeros then a one), then k low bits
+    uint32_t q = value >> k;
+    uint32_t low = value & ((1u << k) - 1);
+    if (q + 1 + k <= 32) {
+        putBits((1u << k) | low, (uint8_t)(q + 1 + k));
+        return;
+    }
+    while (q >= 32) {
+        putBits(0, 32);
+        q -= 32;
+    }
+    putBits(1, (uint8_t)(q + 1));
+    if (k) {
+        putBits(low, k);
+    }
+}
+
+void FlacEncoder::alignByte()
+{
+    if (bit_count_) {
+        putBits(0, 8 - bit_count_);
+    }
+}
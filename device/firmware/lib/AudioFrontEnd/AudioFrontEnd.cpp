@@ -0,0 +1,254 @@
+/*
+ * AudioFrontEnd.cpp
+ * Fixed-point audio front-end: 32->16-bit conversion, DC blocking and
+ * frame-RMS silence trimming
+ */
+
+#include "AudioFrontEnd.hpp"
+#include <cmath>
+#include <cstring>
+
+static inline int16_t saturate16(int64_t v)
+{
+    return v > 32767 ? 32767 : v < -32768 ? -32768 : (int16_t)v;
+}
+
+void convertSamples32to16(const int32_t* in, int16_t* out, size_t count, int shift)
+{
+    // Unrolled by four so the loads and shifts pipeline on the LX7
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32_t a = in[i] >> shift;
+        int32_t b = in[i + 1] >> shift;
+        int32_t c = in[i + 2] >> shift;
+        int32_t d = in[i + 3] >> shift;
+        out[i] = saturate16(a);
+        out[i + 1] = saturate16(b);
+        out[i + 2] = saturate16(c);
+        out[i + 3] = saturate16(d);
+    }
+    for (; i < count; i++) {
+        out[i] = saturate16(in[i] >> shift);
+    }
+}
+
+DcBlocker::DcBlocker(int16_t r_q15)
+    : r_q15_(r_q15)
+    , x_prev_(0)
+    , y_prev_q15_(0)
+{
+}
+
+void DcBlocker::reset()
+{
+    x_prev_ = 0;
+    y_prev_q15_ = 0;
+}
+
+void DcBlocker::process(int16_t* samples, size_t count)
+{
+    // The feedback term keeps 15 fractional bits so small signals don't
+    // stall in a limit cycle
+    for (size_t i = 0; i < count; i++) {
+        int32_t x = samples[i];
+        int64_t y = ((int64_t)(x - x_prev_) << 15) + ((r_q15_ * y_prev_q15_) >> 15);
+        x_prev_ = x;
+        y_prev_q15_ = y;
+        samples[i] = saturate16(y >> 15);
+    }
+}
+
+SilenceTrimmer::SilenceTrimmer()
+    : output_(nullptr)
+    , frame_len_(0)
+    , pad_frames_(0)
+    , gap_frames_(0)
+    , slots_(0)
+    , threshold_sum_(0)
+    , arena_(nullptr)
+    , buffers_arena_(nullptr)
+    , frame_(nullptr)
+    , frame_fill_(0)
+    , held_(nullptr)
+    , held_start_(0)
+    , held_count_(0)
+    , voice_seen_(false)
+    , in_voice_(false)
+    , samples_in_(0)
+    , samples_out_(0)
+{
+}
+
+SilenceTrimmer::~SilenceTrimmer()
+{
+    end();
+}
+
+bool SilenceTrimmer::begin(const Config& config, Output output)
+{
+    end();
+
+    // Same frame and pad arithmetic as trim_silence_pcm16()
+    uint32_t frame_len = config.sample_rate * config.frame_ms / 1000;
+    frame_len_ = (uint16_t)(frame_len > 0 ? frame_len : 1);
+    pad_frames_ = (uint16_t)ceil((config.pad_ms / 1000.0) * config.sample_rate / frame_len_);
+    uint32_t hold_frames = config.frame_ms ? config.hold_ms / config.frame_ms : 0;
+    gap_frames_ = config.frame_ms ? config.max_gap_ms / config.frame_ms : 0;
+    if (gap_frames_ > hold_frames) {
+        hold_frames = gap_frames_;
+    }
+    uint32_t slots = pad_frames_ + hold_frames;
+    slots_ = (uint16_t)(slots == 0 ? 1 : slots > 0xFFFF ? 0xFFFF : slots);
+
+    double threshold = 32768.0 * pow(10.0, config.threshold_db / 20.0);
+    threshold_sum_ = frame_len_ * threshold * threshold;
+
+    buffers_arena_ = arena_;
+    frame_ = Arena::allocateFrom<int16_t>(buffers_arena_, frame_len_);
+    held_ = Arena::allocateFrom<int16_t>(buffers_arena_, (size_t)slots_ * frame_len_);
+    if (!frame_ || !held_) {
+        end();
+        return false;
+    }
+
+    output_ = output;
+    frame_fill_ = 0;
+    held_start_ = 0;
+    held_count_ = 0;
+    voice_seen_ = false;
+    in_voice_ = false;
+    samples_in_ = 0;
+    samples_out_ = 0;
+    return true;
+}
+
+void SilenceTrimmer::end()
+{
+    Arena::release(buffers_arena_, frame_);
+    Arena::release(buffers_arena_, held_);
+    frame_ = nullptr;
+    held_ = nullptr;
+}
+
+void SilenceTrimmer::process(const int16_t* samples, size_t count)
+{
+    if (!frame_) {
+        return;
+    }
+    samples_in_ += count;
+
+    while (count > 0) {
+        size_t n = frame_len_ - frame_fill_;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(frame_ + frame_fill_, samples, n * sizeof(int16_t));
+        frame_fill_ += n;
+        samples += n;
+        count -= n;
+
+        if (frame_fill_ == frame_len_) {
+            onFrame();
+            frame_fill_ = 0;
+        }
+    }
+}
+
+void SilenceTrimmer::finish()
+{
+    if (!frame_) {
+        return;
+    }
+
+    // Like pipeline.py, a partial last frame is zero-padded to full length
+    uint16_t tail = frame_fill_;
+    if (frame_fill_ > 0) {
+        memset(frame_ + frame_fill_, 0, (frame_len_ - frame_fill_) * sizeof(int16_t));
+        onFrame();
+        frame_fill_ = 0;
+    }
+
+    if (in_voice_) {
+        // Trailing silence: keep pad_frames after the last voiced frame
+        emitHeld(held_count_ < pad_frames_ ? held_count_ : pad_frames_);
+    } else if (!voice_seen_ && held_count_ > 0) {
+        // No voice: pipeline.py returns the recording untouched, so the
+        // held frames go out without the last one's zero padding
+        emitHeld(held_count_ - 1);
+        emit(held_ + (size_t)held_start_ * frame_len_, tail > 0 ? tail : frame_len_);
+        dropHeld(1);
+    }
+    dropHeld(held_count_);
+    in_voice_ = false;
+}
+
+void SilenceTrimmer::onFrame()
+{
+    uint64_t sum = 0;
+    for (uint16_t i = 0; i < frame_len_; i++) {
+        int32_t s = frame_[i];
+        sum += (uint64_t)(s * s);
+    }
+    bool voiced = (double)sum > threshold_sum_;
+
+    if (voiced) {
+        // Pre-roll is the last pad_frames of silence; a pause inside the
+        // utterance is kept whole
+        if (!in_voice_ && held_count_ > pad_frames_) {
+            dropHeld(held_count_ - pad_frames_);
+        }
+        emitHeld(held_count_);
+        emit(frame_, frame_len_);
+        voice_seen_ = true;
+        in_voice_ = true;
+        return;
+    }
+
+    if (in_voice_ && gap_frames_ > 0 && held_count_ == pad_frames_ + gap_frames_) {
+        // Pause longer than max_gap_ms: close the utterance with its
+        // trailing pad and keep the rest of the pause as the next pre-roll
+        emitHeld(pad_frames_);
+        in_voice_ = false;
+    }
+
+    if (held_count_ == slots_) {
+        if (in_voice_) {
+            // Longer than hold_ms: still a pause as far as anyone knows,
+            // and pipeline.py keeps pauses, so the oldest frame goes out
+            emitHeld(1);
+        } else {
+            dropHeld(1);
+        }
+    }
+    holdFrame();
+}
+
+void SilenceTrimmer::holdFrame()
+{
+    uint16_t slot = (held_start_ + held_count_) % slots_;
+    memcpy(held_ + (size_t)slot * frame_len_, frame_, frame_len_ * sizeof(int16_t));
+    held_count_++;
+}
+
+void SilenceTrimmer::emitHeld(uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        emit(held_ + (size_t)held_start_ * frame_len_, frame_len_);
+        held_start_ = (held_start_ + 1) % slots_;
+        held_count_--;
+    }
+}
+
+void SilenceTrimmer::dropHeld(uint16_t count)
+{
+    held_start_ = (held_start_ + count) % slots_;
+    held_count_ -= count;
+}
+
+void SilenceTrimmer::emit(const int16_t* samples, size_t count)
+{
+    samples_out_ += count;
+    if (output_) {
+        output_(samples, count);
+    }
+}
@@ -0,0 +1,228 @@
+/*
+ * AudioUploader.cpp
+ * Streams live microphone audio to POST /api/v1/audio (chunked transfer)
+ */
+
+#include "AudioUploader.hpp"
+#include "MemoryBudget.hpp"
+#include "esp_log.h"
+#include <cstdio>
+#include <cstring>
+
+AudioUploader::AudioUploader(AudioCapture& capture, const char* base_url, const char* device_token)
+    : capture_(capture)
+    , base_url_(base_url)
+    , device_token_(device_token)
+    , callback_(nullptr)
+    , start_sem_(nullptr)
+    , start_storage_()
+    , task_handle_(nullptr)
+    , busy_(false)
+    , encoder_(&pcm_encoder_)
+    , client_(nullptr)
+    , write_ok_(false)
+{
+    job_id_[0] = '\0';
+}
+
+AudioUploader::~AudioUploader()
+{
+    if (task_handle_) {
+        vTaskDelete(task_handle_);
+    }
+    if (start_sem_) {
+        vSemaphoreDelete(start_sem_);
+    }
+}
+
+bool AudioUploader::begin(const TaskSpec& task)
+{
+    start_sem_ = xSemaphoreCreateBinaryStatic(&start_storage_);
+    if (!start_sem_) {
+        ESP_LOGE(TAG, "Failed to create start semaphore");
+        return false;
+    }
+    void* block = MemoryBudget::reserve("upload arena", ARENA_BYTES, true);
+    if (!block) {
+        ESP_LOGE(TAG, "No room for the upload buffers");
+        return false;
+    }
+    arena_.init(block, ARENA_BYTES);
+    MemoryBudget::addArena("upload", &arena_);
+    
+    task_handle_ = task_storage_.start(taskEntry, this, task);
+    if (!task_handle_) {
+        ESP_LOGE(TAG, "Failed to create upload task");
+        return false;
+    }
+    return true;
+}
+
+void AudioUploader::setCallback(DoneCallback callback)
+{
+    callback_ = callback;
+}
+
+void AudioUploader::setEncoder(AudioEncoder* encoder)
+{
+    encoder_ = encoder ? encoder : &pcm_encoder_;
+}
+
+bool AudioUploader::startUpload()
+{
+    if (busy_) {
+        return false;
+    }
+    busy_ = true;
+    xSemaphoreGive(start_sem_);
+    return true;
+}
+
+void AudioUploader::taskEntry(void* arg)
+{
+    static_cast<AudioUploader*>(arg)->task();
+}
+
+void AudioUploader::task()
+{
+    while (xSemaphoreTake(start_sem_, portMAX_DELAY) == pdTRUE) {
+        bool ok = upload();
+        busy_ = false;
+        if (callback_) {
+            callback_(ok, ok ? job_id_ : "");
+        }
+    }
+}
+
+bool AudioUploader::writeChunk(esp_http_client_handle_t client, const void* data, size_t len)
+{
+    // HTTP/1.1 chunk: <hex length>\r\n<data>\r\n
+    char size_line[12];
+    int n = snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned)len);
+    return esp_http_client_write(client, size_line, n) == n
+        && esp_http_client_write(client, (const char*)data, len) == (int)len
+        && esp_http_client_write(client, "\r\n", 2) == 2;
+}
+
+bool AudioUploader::parseJobId(const char* body)
+{
+    // {"job_id": "..."} - the only field the contract defines
+    const char* key = strstr(body, "\"job_id\"");
+    if (!key) {
+        return false;
+    }
+    const char* start = strchr(key + 8, '"');
+    if (!start) {
+        return false;
+    }
+    start++;
+    const char* end = strchr(start, '"');
+    if (!end || end == start || (size_t)(end - start) >= JOB_ID_LEN) {
+        return false;
+    }
+    memcpy(job_id_, start, end - start);
+    job_id_[end - start] = '\0';
+    return true;
+}
+
+bool AudioUploader::upload()
+{
+    char url[128];
+    snprintf(url, sizeof(url), "%s/api/v1/audio", base_url_);
+    job_id_[0] = '\0';
+    
+    esp_http_client_config_t config = {};
+    config.url = url;
+    config.method = HTTP_METHOD_POST;
+    config.timeout_ms = 10000;
+    
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (!client) {
+        ESP_LOGE(TAG, "HTTP client init failed");
+        return false;
+    }
+    
+    char auth[96];
+    snprintf(auth, sizeof(auth), "Bearer %s", device_token_);
+    esp_http_client_set_header(client, "Content-Type", encoder_->contentType());
+    esp_http_client_set_header(client, "Authorization", auth);
+    
+    // Length -1 = Transfer-Encoding: chunked; the body starts before the
+    // recording ends
+    esp_err_t err = esp_http_client_open(client, -1);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP open failed: %s", esp_err_to_name(err));
+        esp_http_client_cleanup(client);
+        return false;
+    }
+    
+    // Each encoder unit (header, ADPCM block, FLAC frame) is one chunk.
+    // The callbacks capture only `this`, which std::function stores
+    // without allocating.
+    uint32_t rate = capture_.getSampleRate();
+    client_ = client;
+    write_ok_ = true;
+    encoder_->setArena(&arena_);
+    trimmer_.setArena(&arena_);
+    bool ok = encoder_->begin(rate, [this](const uint8_t* data, size_t len) {
+        write_ok_ = write_ok_ && writeChunk(client_, data, len);
+    }) && write_ok_;
+    
+    // Only voiced audio (plus pad) is encoded. Long pauses are cut too,
+    // unlike pipeline.py: they would only cost upload time.
+    SilenceTrimmer::Config trim = SilenceTrimmer::DEFAULT_CONFIG;
+    trim.sample_rate = rate;
+    trim.max_gap_ms = MAX_PAUSE_MS;
+    ok = ok && trimmer_.begin(trim, [this](const int16_t* samples, size_t count) {
+        encoder_->encode(samples, count);
+    });
+    
+    while (ok && !capture_.drained()) {
+        size_t n = capture_.read(chunk_buf_, CHUNK_SAMPLES, pdMS_TO_TICKS(100));
+        if (n > 0) {
+            trimmer_.process(chunk_buf_, n);
+        }
+        ok = write_ok_;
+    }
+    if (ok) {
+        trimmer_.finish();
+        encoder_->finish();
+        ok = write_ok_;
+    }
+    size_t total = trimmer_.samplesOut();
+    uint32_t encoded = encoder_->bytesOut();
+    if (ok && !trimmer_.voiceDetected()) {
+        ESP_LOGW(TAG, "No voice detected in %u samples", (unsigned)trimmer_.samplesIn());
+    }
+    trimmer_.end();
+    encoder_->end();
+    arena_.reset();
+    
+    // Terminating zero-length chunk
+    ok = ok && esp_http_client_write(client, "0\r\n\r\n", 5) == 5;
+    if (!ok) {
+        ESP_LOGE(TAG, "Upload write failed after %u samples", (unsigned)total);
+        esp_http_client_close(client);
+        esp_http_client_cleanup(client);
+        return false;
+    }
+    
+    esp_http_client_fetch_headers(client);
+    int status = esp_http_client_get_status_code(client);
+    char body[128];
+    int len = esp_http_client_read(client, body, sizeof(body) - 1);
+    body[len > 0 ? len : 0] = '\0';
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    
+    if (status != 202 || !parseJobId(body)) {
+        ESP_LOGE(TAG, "Upload rejected: HTTP %d", status);
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "Uploaded %u of %u samples (%u ms) as %u bytes %s, job %s",
+             (unsigned)total, (unsigned)trimmer_.samplesIn(),
+             (unsigned)(total * 1000 / rate), (unsigned)encoded,
+             encoder_->contentType(), job_id_);
+    return true;
+}
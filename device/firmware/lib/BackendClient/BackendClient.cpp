@@ -0,0 +1,338 @@
+/*
+ * BackendClient.cpp
+ * Fetches a job's sticker from the backend straight into the StickerPipeline
+ */
+
+#include "BackendClient.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <cstdio>
+#include <cstring>
+
+BackendClient::BackendClient(const char* base_url, const char* device_token, const Config& config)
+    : base_url_(base_url)
+    , device_token_(device_token)
+    , config_(config)
+    , client_(nullptr)
+    , connected_(false)
+    , stats_()
+    , pipeline_(nullptr)
+    , opened_(false)
+    , write_ok_(false)
+    , received_(0)
+    , spool_(nullptr)
+    , spooling_(false)
+{
+    url_[0] = '\0';
+    error_[0] = '\0';
+}
+
+BackendClient::~BackendClient()
+{
+    if (client_) {
+        esp_http_client_cleanup(client_);
+    }
+}
+
+bool BackendClient::begin()
+{
+    snprintf(url_, sizeof(url_), "%s/api/v1/job", base_url_);
+    esp_http_client_config_t config = {};
+    config.url = url_;
+    config.method = HTTP_METHOD_GET;
+    // A long poll is quiet for up to wait_s before the server answers
+    config.timeout_ms = (int)(config_.wait_s + 10) * 1000;
+    config.buffer_size = RX_BYTES;
+    config.keep_alive_enable = true;
+    
+    client_ = esp_http_client_init(&config);
+    if (!client_) {
+        ESP_LOGE(TAG, "HTTP client init failed");
+        return false;
+    }
+    
+    // Headers stay on the handle for every request
+    char auth[96];
+    snprintf(auth, sizeof(auth), "Bearer %s", device_token_);
+    esp_http_client_set_header(client_, "Authorization", auth);
+    esp_http_client_set_header(client_, "Accept",
+                               config_.format == Format::Pvr1 ? "application/x-pvr1" : "application/json");
+    return true;
+}
+
+void BackendClient::setSpool(PrintSpool* spool, SpooledCallback on_spooled)
+{
+    spool_ = spool;
+    on_spooled_ = on_spooled;
+}
+
+bool BackendClient::fetchSticker(const char* job_id, StickerPipeline& pipeline)
+{
+    if (!client_) {
+        return false;
+    }
+    const char* path = config_.format == Format::Pvr1 ? "/raster" : "";
+    int n = snprintf(url_, sizeof(url_), "%s/api/v1/job/%s%s?wait=%u", base_url_, job_id, path,
+                     (unsigned)config_.wait_s);
+    if (n <= 0 || (size_t)n >= sizeof(url_)) {
+        ESP_LOGE(TAG, "Job id too long");
+        return false;
+    }
+    
+    error_[0] = '\0';
+    pipeline_ = &pipeline;
+    opened_ = false;
+    write_ok_ = true;
+    received_ = 0;
+    spooling_ = false;
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)config_.job_timeout_s * 1000000;
+    
+    // No sleeping between polls: the server holds each request until the
+    // job is done or wait_s has passed
+    Reply reply = Reply::Pending;
+    while (reply == Reply::Pending) {
+        if (esp_timer_get_time() > deadline_us) {
+            snprintf(error_, sizeof(error_), "timed out after %u s", (unsigned)config_.job_timeout_s);
+            reply = Reply::Failed;
+            break;
+        }
+        int status = request(url_);
+        if (status < 0) {
+            snprintf(error_, sizeof(error_), "no connection to the backend");
+            reply = Reply::Failed;
+        } else if (status == 200) {
+            reply = config_.format == Format::Pvr1 ? readRaster() : readDocument();
+        } else if (status == 204 && config_.format == Format::Pvr1) {
+            stats_.waits++;
+            reply = drain() ? Reply::Pending : Reply::Failed;
+        } else {
+            reply = readError(status);
+        }
+    }
+    
+    bool ok = reply == Reply::Done && opened_;
+    if (opened_) {
+        if (spooling_) {
+            finishSpool(ok);
+        }
+        // Only the job document carries a caption
+        pipeline.close(ok, config_.format == Format::Json ? parser_.caption() : nullptr);
+    }
+    if (ok) {
+        stats_.stickers++;
+        ESP_LOGI(TAG, "Job %s: %u raster bytes, %u requests, %u connections so far",
+                 job_id, (unsigned)received_, (unsigned)stats_.requests, (unsigned)stats_.connections);
+    } else {
+        stats_.failed++;
+        if (!error_[0]) {
+            snprintf(error_, sizeof(error_), "%s", write_ok_ ? "download failed" : "printer side gave up");
+        }
+        ESP_LOGE(TAG, "Job %s: %s", job_id, error_);
+    }
+    pipeline_ = nullptr;
+    return ok;
+}
+
+void BackendClient::disconnect()
+{
+    if (client_) {
+        drop();
+    }
+}
+
+int BackendClient::request(const char* url)
+{
+    esp_http_client_set_url(client_, url);
+    // The server may close a kept connection while it is idle; the
+    // request then fails before any response and is sent once more on a
+    // new connection
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = connected_;
+        if (!connected_) {
+            stats_.connections++;
+        }
+        esp_err_t err = esp_http_client_open(client_, 0);
+        if (err == ESP_OK) {
+            connected_ = true;
+            stats_.requests++;
+            int64_t length = esp_http_client_fetch_headers(client_);
+            int status = esp_http_client_get_status_code(client_);
+            if (status > 0 && (length >= 0 || esp_http_client_is_chunked_response(client_))) {
+                return status;
+            }
+        } else {
+            ESP_LOGW(TAG, "HTTP open failed: %s", esp_err_to_name(err));
+        }
+        drop();
+        if (!reused) {
+            break;
+        }
+    }
+    return -1;
+}
+
+BackendClient::Reply BackendClient::readRaster()
+{
+    while (true) {
+        int n = esp_http_client_read(client_, rx_buf_, RX_BYTES);
+        if (n < 0) {
+            drop();
+            return Reply::Failed;
+        }
+        if (n == 0) {
+            break;
+        }
+        stats_.body_bytes += n;
+        // The rest of the body is abandoned with the connection
+        if (!writeRaster((const uint8_t*)rx_buf_, n)) {
+            drop();
+            return Reply::Failed;
+        }
+    }
+    if (!esp_http_client_is_complete_data_received(client_)) {
+        snprintf(error_, sizeof(error_), "download cut off after %u bytes", (unsigned)received_);
+        drop();
+        return Reply::Failed;
+    }
+    return opened_ ? Reply::Done : Reply::Failed;
+}
+
+BackendClient::Reply BackendClient::readDocument()
+{
+    // Captures only `this`: std::function stores it without allocating
+    parser_.begin([this](const uint8_t* data, size_t len) {
+        return writeRaster(data, len);
+    });
+    while (true) {
+        int n = esp_http_client_read(client_, rx_buf_, RX_BYTES);
+        if (n < 0) {
+            drop();
+            return Reply::Failed;
+        }
+        if (n == 0) {
+            break;
+        }
+        stats_.body_bytes += n;
+        if (!parser_.feed(rx_buf_, n)) {
+            drop();
+            if (write_ok_) {
+                snprintf(error_, sizeof(error_), "bad job document");
+            }
+            return Reply::Failed;
+        }
+    }
+    bool complete = esp_http_client_is_complete_data_received(client_);
+    if (!complete) {
+        drop();
+    }
+    if (!parser_.finish() || !complete) {
+        if (write_ok_) {
+            snprintf(error_, sizeof(error_), "job document cut off");
+        }
+        return Reply::Failed;
+    }
+    
+    const char* status = parser_.status();
+    if (strcmp(status, "processing") == 0) {
+        stats_.waits++;
+        return Reply::Pending;
+    }
+    if (strcmp(status, "done") == 0) {
+        const char* format = parser_.format();
+        if (format[0] && strcmp(format, "pvr1") != 0) {
+            snprintf(error_, sizeof(error_), "raster_format %s not supported", format);
+            return Reply::Failed;
+        }
+        return opened_ ? Reply::Done : Reply::Failed;
+    }
+    snprintf(error_, sizeof(error_), "%s", parser_.message()[0] ? parser_.message() : "job failed");
+    return Reply::Failed;
+}
+
+BackendClient::Reply BackendClient::readError(int status)
+{
+    // {"status": "error", "message": "..."} when the backend has one
+    parser_.begin(nullptr);
+    int n;
+    while ((n = esp_http_client_read(client_, rx_buf_, RX_BYTES)) > 0) {
+        parser_.feed(rx_buf_, n);
+    }
+    if (!esp_http_client_is_complete_data_received(client_)) {
+        drop();
+    }
+    parser_.finish();
+    snprintf(error_, sizeof(error_), "HTTP %d%s%s", status, parser_.message()[0] ? ": " : "",
+             parser_.message());
+    return Reply::Failed;
+}
+
+bool BackendClient::writeRaster(const uint8_t* data, size_t len)
+{
+    if (!opened_) {
+        if (!pipeline_->open(OPEN_TICKS)) {
+            snprintf(error_, sizeof(error_), "pipeline busy");
+            write_ok_ = false;
+            return false;
+        }
+        opened_ = true;
+        spooling_ = spool_ && spool_->open();
+        if (spool_ && !spooling_) {
+            stats_.spool_failures++;
+            ESP_LOGW(TAG, "Spool unavailable, this sticker won't survive a reset");
+        }
+    }
+    if (!pipeline_->write(data, len, WRITE_TICKS)) {
+        write_ok_ = false;
+        return false;
+    }
+    // After the pipeline has the bytes: the decoder needn't wait for flash
+    if (spooling_ && !spool_->write(data, len)) {
+        spool_->abort();
+        spooling_ = false;
+        stats_.spool_failures++;
+        ESP_LOGW(TAG, "Spool full after %u bytes, this sticker won't survive a reset",
+                 (unsigned)received_);
+    }
+    stats_.raster_bytes += len;
+    received_ += len;
+    return true;
+}
+
+// Commits the sticker downloaded whole, drops a partial one
+void BackendClient::finishSpool(bool ok)
+{
+    spooling_ = false;
+    if (!ok) {
+        spool_->abort();
+        return;
+    }
+    PrintSpool::Record record;
+    uint32_t id = spool_->commit();
+    if (id == 0 || !spool_->find(id, &record)) {
+        stats_.spool_failures++;
+        ESP_LOGW(TAG, "Spool commit failed, this sticker won't survive a reset");
+        return;
+    }
+    stats_.spooled++;
+    if (on_spooled_) {
+        on_spooled_(record);
+    }
+}
+
+bool BackendClient::drain()
+{
+    int n;
+    while ((n = esp_http_client_read(client_, rx_buf_, RX_BYTES)) > 0) {
+    }
+    if (n < 0 || !esp_http_client_is_complete_data_received(client_)) {
+        drop();
+        return false;
+    }
+    return true;
+}
+
+void BackendClient::drop()
+{
+    esp_http_client_close(client_);
+    connected_ = false;
+}
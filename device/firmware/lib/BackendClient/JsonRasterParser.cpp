@@ -0,0 +1,382 @@
+/*
+ * JsonRasterParser.cpp
+ * Incremental parser for the job result document, base64 decoded on the fly
+ */
+
+#include "JsonRasterParser.hpp"
+#include <cstring>
+
+JsonRasterParser::JsonRasterParser()
+{
+    begin(nullptr);
+}
+
+void JsonRasterParser::begin(DataCallback on_raster)
+{
+    on_raster_ = on_raster;
+    depth_ = 0;
+    in_string_ = false;
+    escape_ = false;
+    unicode_left_ = 0;
+    unicode_ = 0;
+    high_surrogate_ = 0;
+    string_is_key_ = false;
+    expect_key_ = false;
+    done_ = false;
+    failed_ = false;
+    field_ = Field::None;
+    key_len_ = 0;
+    text_ = nullptr;
+    text_cap_ = 0;
+    text_len_ = 0;
+    text_cut_ = false;
+    status_[0] = '\0';
+    message_[0] = '\0';
+    format_[0] = '\0';
+    caption_[0] = '\0';
+    quad_ = 0;
+    quad_len_ = 0;
+    padded_ = false;
+    out_len_ = 0;
+    raster_bytes_ = 0;
+}
+
+bool JsonRasterParser::feed(const char* data, size_t len)
+{
+    for (size_t i = 0; i < len && !failed_; i++) {
+        char c = data[i];
+
+        if (in_string_) {
+            if (unicode_left_) {
+                // \uXXXX: kept strings get it as UTF-8
+                bool hex = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+                if (!hex) {
+                    fail();
+                } else {
+                    uint8_t digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+                    unicode_ = (uint16_t)((unicode_ << 4) | digit);
+                    if (--unicode_left_ == 0) {
+                        escapedUnit(unicode_);
+                    }
+                }
+            } else if (escape_) {
+                escape_ = false;
+                switch (c) {
+                case 'u': unicode_left_ = 4; unicode_ = 0; break;
+                case 'n': stringChar('\n'); break;
+                case 'r': stringChar('\r'); break;
+                case 't': stringChar('\t'); break;
+                case 'b': case 'f': break;
+                case '"': case '\\': case '/': stringChar(c); break;
+                default: fail(); break;
+                }
+            } else if (c == '\\') {
+                escape_ = true;
+            } else if (c == '"') {
+                in_string_ = false;
+                stringEnd();
+            } else {
+                stringChar(c);
+            }
+            continue;
+        }
+
+        switch (c) {
+        case ' ': case '\t': case '\r': case '\n':
+            break;
+        case '"':
+            if (depth_ == 0) {
+                fail();
+                break;
+            }
+            in_string_ = true;
+            string_is_key_ = depth_ == 1 && expect_key_;
+            key_len_ = 0;
+            text_ = nullptr;
+            text_len_ = 0;
+            text_cut_ = false;
+            if (!string_is_key_ && depth_ == 1) {
+                if (field_ == Field::Status) {
+                    text_ = status_;
+                    text_cap_ = sizeof(status_);
+                } else if (field_ == Field::Message) {
+                    text_ = message_;
+                    text_cap_ = sizeof(message_);
+                } else if (field_ == Field::Format) {
+                    text_ = format_;
+                    text_cap_ = sizeof(format_);
+                } else if (field_ == Field::Caption) {
+                    text_ = caption_;
+                    text_cap_ = sizeof(caption_);
+                } else if (field_ == Field::Raster) {
+                    quad_ = 0;
+                    quad_len_ = 0;
+                    padded_ = false;
+                }
+            }
+            break;
+        case '{': case '[':
+            if (done_ || (depth_ == 0 && c != '{')) {
+                fail();
+                break;
+            }
+            depth_++;
+            expect_key_ = depth_ == 1;
+            break;
+        case '}': case ']':
+            if (depth_ == 0) {
+                fail();
+                break;
+            }
+            if (--depth_ == 0) {
+                done_ = true;
+            }
+            break;
+        case ':':
+            if (depth_ == 1) {
+                expect_key_ = false;
+            }
+            break;
+        case ',':
+            if (depth_ == 1) {
+                expect_key_ = true;
+                field_ = Field::None;
+            }
+            break;
+        default:
+            // Numbers, true, false, null: not for any kept field
+            if (depth_ == 0) {
+                fail();
+            } else if (depth_ == 1) {
+                field_ = Field::None;
+            }
+            break;
+        }
+    }
+    return !failed_;
+}
+
+bool JsonRasterParser::finish()
+{
+    flush();
+    return !failed_ && done_;
+}
+
+void JsonRasterParser::stringChar(char c)
+{
+    unpaired();
+    if (string_is_key_) {
+        // An overlong key matches no field
+        if (key_len_ < KEY_LEN) {
+            key_[key_len_++] = c;
+        }
+    } else if (text_) {
+        // Nothing more once a byte was dropped
+        if (!text_cut_ && text_len_ + 1 < text_cap_) {
+            text_[text_len_++] = c;
+        } else {
+            text_cut_ = true;
+        }
+    } else if (depth_ == 1 && field_ == Field::Raster) {
+        if (!base64Char(c)) {
+            fail();
+        }
+    }
+}
+
+void JsonRasterParser::stringEnd()
+{
+    unpaired();
+    if (string_is_key_) {
+        keyEnd();
+        return;
+    }
+    if (text_) {
+        if (text_cut_) {
+            // Drop a last character that didn't fit whole
+            size_t lead = text_len_;
+            while (lead > 0 && ((uint8_t)text_[lead - 1] & 0xC0) == 0x80) {
+                lead--;
+            }
+            if (lead > 0) {
+                uint8_t b = (uint8_t)text_[lead - 1];
+                size_t need = b >= 0xF0 ? 4 : b >= 0xE0 ? 3 : b >= 0xC0 ? 2 : 1;
+                if (text_len_ - (lead - 1) < need) {
+                    text_len_ = lead - 1;
+                }
+            }
+        }
+        text_[text_len_] = '\0';
+        text_ = nullptr;
+    } else if (depth_ == 1 && field_ == Field::Raster) {
+        // Trailing '=' are optional
+        if (!endQuad()) {
+            fail();
+            return;
+        }
+        flush();
+    }
+}
+
+// One UTF-16 unit of a \uXXXX escape; a surrogate pair makes one code point
+void JsonRasterParser::escapedUnit(uint16_t unit)
+{
+    if (unit >= 0xDC00 && unit <= 0xDFFF && high_surrogate_) {
+        uint32_t cp = 0x10000 + ((uint32_t)(high_surrogate_ - 0xD800) << 10) + (unit - 0xDC00);
+        high_surrogate_ = 0;
+        stringCodepoint(cp);
+    } else if (unit >= 0xD800 && unit <= 0xDBFF) {
+        unpaired();
+        high_surrogate_ = unit;
+    } else {
+        stringCodepoint(unit >= 0xD800 && unit <= 0xDFFF ? 0xFFFD : unit);
+    }
+}
+
+void JsonRasterParser::stringCodepoint(uint32_t cp)
+{
+    unpaired();
+    char utf8[4];
+    size_t n;
+    if (cp < 0x80) {
+        utf8[0] = (char)cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        utf8[0] = (char)(0xC0 | (cp >> 6));
+        utf8[1] = (char)(0x80 | (cp & 0x3F));
+        n = 2;
+    } else if (cp < 0x10000) {
+        utf8[0] = (char)(0xE0 | (cp >> 12));
+        utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        utf8[0] = (char)(0xF0 | (cp >> 18));
+        utf8[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        utf8[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        utf8[3] = (char)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    // A kept string takes the whole character or none of it
+    if (text_) {
+        if (!text_cut_ && text_len_ + n < text_cap_) {
+            memcpy(text_ + text_len_, utf8, n);
+            text_len_ += n;
+        } else {
+            text_cut_ = true;
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        stringChar(utf8[i]);
+    }
+}
+
+// A high surrogate without its low half
+void JsonRasterParser::unpaired()
+{
+    if (high_surrogate_) {
+        high_surrogate_ = 0;
+        stringCodepoint(0xFFFD);
+    }
+}
+
+void JsonRasterParser::keyEnd()
+{
+    static const struct {
+        const char* name;
+        Field field;
+    } KEYS[] = {
+        {"status", Field::Status},
+        {"message", Field::Message},
+        {"raster_format", Field::Format},
+        {"caption", Field::Caption},
+        {"raster_data", Field::Raster},
+    };
+    field_ = Field::None;
+    for (const auto& key : KEYS) {
+        if (strlen(key.name) == key_len_ && memcmp(key.name, key_, key_len_) == 0) {
+            field_ = key.field;
+            break;
+        }
+    }
+}
+
+bool JsonRasterParser::base64Char(char c)
+{
+    uint32_t v;
+    if (c >= 'A' && c <= 'Z') {
+        v = c - 'A';
+    } else if (c >= 'a' && c <= 'z') {
+        v = c - 'a' + 26;
+    } else if (c >= '0' && c <= '9') {
+        v = c - '0' + 52;
+    } else if (c == '+') {
+        v = 62;
+    } else if (c == '/') {
+        v = 63;
+    } else if (c == '=') {
+        // Padding ends the data
+        if (!padded_) {
+            if (quad_len_ == 0 || !endQuad()) {
+                return false;
+            }
+            padded_ = true;
+        }
+        return true;
+    } else {
+        // Line breaks (escaped) are allowed between groups
+        return c == '\n' || c == '\r';
+    }
+    if (padded_) {
+        return false;
+    }
+    quad_ = (quad_ << 6) | v;
+    if (++quad_len_ == 4) {
+        emit((uint8_t)(quad_ >> 16));
+        emit((uint8_t)(quad_ >> 8));
+        emit((uint8_t)quad_);
+        quad_len_ = 0;
+    }
+    return true;
+}
+
+// The 1 or 2 bytes in a partial group; a single character left over
+// is not valid base64
+bool JsonRasterParser::endQuad()
+{
+    if (quad_len_ == 1) {
+        return false;
+    }
+    if (quad_len_ == 2) {
+        emit((uint8_t)(quad_ >> 4));
+    } else if (quad_len_ == 3) {
+        emit((uint8_t)(quad_ >> 10));
+        emit((uint8_t)(quad_ >> 2));
+    }
+    quad_len_ = 0;
+    return true;
+}
+
+void JsonRasterParser::emit(uint8_t b)
+{
+    out_[out_len_++] = b;
+    raster_bytes_++;
+    if (out_len_ == OUT_BYTES) {
+        flush();
+    }
+}
+
+bool JsonRasterParser::flush()
+{
+    if (out_len_ && !failed_ && on_raster_ && !on_raster_(out_, out_len_)) {
+        fail();
+    }
+    out_len_ = 0;
+    return !failed_;
+}
+
+void JsonRasterParser::fail()
+{
+    failed_ = true;
+}
@@ -4,36 +4,55 @@
  */
 
 #include "Button.hpp"
+#include "Trace.hpp"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char* TAG = "Button";
 
+static const char* eventName(Button::Event event)
+{
+    switch (event) {
+    case Button::Event::Press: return "press";
+    case Button::Event::Release: return "release";
+    case Button::Event::Click: return "click";
+    case Button::Event::DoublePress: return "double";
+    case Button::Event::LongPress: return "long";
+    }
+    return "?";
+}
+
 Button::Button(gpio_num_t pin, uint32_t debounce_ms)
     : pin_(pin)
-    , debounce_ms_(debounce_ms)
     , callback_(nullptr)
-    , event_queue_(nullptr)
-    , last_press_time_(0)
+    , ctx_(nullptr)
+    , task_handle_(nullptr)
+    , dropped_(0)
+    , isr_installed_(false)
 {
+    ButtonGesture::Config config = ButtonGesture::DEFAULT_CONFIG;
+    config.debounce_us = debounce_ms * 1000;
+    gesture_.configure(config);
+    gesture_.setHandler(onGesture, this);
+    edges_.init(edge_buf_, EDGE_RING);
 }
 
 Button::~Button()
 {
-    if (event_queue_) {
+    if (isr_installed_) {
         gpio_isr_handler_remove(pin_);
-        vQueueDelete(event_queue_);
     }
 }
 
 bool Button::begin()
 {
-    // Configure GPIO
+    // Configure GPIO: both edges, so release and hold time are visible
     gpio_config_t config = {
         .pin_bit_mask = (1ULL << pin_),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_ENABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_NEGEDGE,  // Trigger on falling edge
+        .intr_type = GPIO_INTR_ANYEDGE,
     };
     
     esp_err_t err = gpio_config(&config);
@@ -42,52 +61,92 @@ bool Button::begin()
         return false;
     }
     
-    // Create event queue
-    event_queue_ = xQueueCreate(10, sizeof(uint32_t));
-    if (!event_queue_) {
-        ESP_LOGE(TAG, "Failed to create event queue");
-        return false;
-    }
-    
     // Install ISR
     gpio_install_isr_service(0);
-    gpio_isr_handler_add(pin_, isrHandler, this);
+    err = gpio_isr_handler_add(pin_, isrHandler, this);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ISR handler add failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    isr_installed_ = true;
     
     ESP_LOGI(TAG, "Initialized on GPIO %d", pin_);
     return true;
 }
 
-void Button::setCallback(Callback callback)
+void Button::configure(const ButtonGesture::Config& config)
 {
+    gesture_.configure(config);
+}
+
+void Button::setCallback(Callback callback, void* ctx)
+{
+    ctx_ = ctx;
     callback_ = callback;
 }
 
 void IRAM_ATTR Button::isrHandler(void* arg)
 {
     Button* button = static_cast<Button*>(arg);
-    uint32_t gpio_num = button->pin_;
-    xQueueSendFromISR(button->event_queue_, &gpio_num, nullptr);
+    Edge edge = {esp_timer_get_time(), (uint8_t)gpio_get_level(button->pin_)};
+    TRACE_INSTANT("button_edge", edge.level);
+    if (!button->edges_.push(edge)) {
+        button->dropped_.fetch_add(1);
+    }
+    
+    TaskHandle_t task = button->task_handle_.load();
+    if (task) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
 }
 
 void Button::task()
 {
-    uint32_t io_num;
+    task_handle_.store(xTaskGetCurrentTaskHandle());
     
-    while (xQueueReceive(event_queue_, &io_num, portMAX_DELAY)) {
-        TickType_t current_time = xTaskGetTickCount();
-        
-        // Debounce: ignore if pressed within debounce time
-        if ((current_time - last_press_time_) > pdMS_TO_TICKS(debounce_ms_)) {
-            // Verify button is actually pressed (LOW with pull-up)
-            if (gpio_get_level(pin_) == 0) {
-                ESP_LOGI(TAG, "Button pressed");
-                
-                if (callback_) {
-                    callback_();
-                }
-                
-                last_press_time_ = current_time;
+    while (true) {
+        // Sleep until an edge arrives or the next gesture timer is due
+        int64_t deadline = gesture_.nextDeadline();
+        TickType_t wait = portMAX_DELAY;
+        if (deadline != ButtonGesture::NO_DEADLINE) {
+            int64_t remaining_us = deadline - esp_timer_get_time();
+            wait = remaining_us > 0 ? pdMS_TO_TICKS((remaining_us + 999) / 1000) : 0;
+            if (remaining_us > 0 && wait == 0) {
+                wait = 1;
             }
         }
+        ulTaskNotifyTake(pdTRUE, wait);
+        
+        // Active-low input: level 0 = pressed
+        Edge edge;
+        while (edges_.pop(&edge)) {
+            gesture_.edge(edge.t_us, edge.level == 0);
+        }
+        gesture_.poll(esp_timer_get_time());
     }
 }
+
+void Button::onGesture(Event event, int64_t due_us, void* ctx)
+{
+    Button* button = static_cast<Button*>(ctx);
+    int64_t latency = esp_timer_get_time() - due_us;
+    button->latency_.record(latency > 0 ? (uint32_t)latency : 0);
+    TRACE_INSTANT(eventName(event), (int32_t)latency);
+    
+    if (button->callback_) {
+        button->callback_(event, button->ctx_);
+    }
+    ESP_LOGI(TAG, "Button %s (%lld us after edge)", eventName(event), (long long)latency);
+}
+
+void Button::logLatency() const
+{
+    ESP_LOGI(TAG, "Edge->callback latency: n=%u min=%u mean=%u p50<=%u p99<=%u max=%u us, "
+             "bounces=%u dropped=%u",
+             (unsigned)latency_.count(), (unsigned)latency_.minUs(), (unsigned)latency_.meanUs(),
+             (unsigned)latency_.percentileUs(50), (unsigned)latency_.percentileUs(99),
+             (unsigned)latency_.maxUs(), (unsigned)gesture_.bouncesRejected(),
+             (unsigned)dropped_.load());
+}
@@ -0,0 +1,128 @@
+/*
+ * ButtonGesture.cpp
+ * Debounce and gesture state machine for a single push button
+ */
+
+#include "ButtonGesture.hpp"
+
+ButtonGesture::ButtonGesture()
+    : config_(DEFAULT_CONFIG)
+    , handler_(nullptr)
+    , ctx_(nullptr)
+    , stable_(false)
+    , raw_(false)
+    , raw_us_(0)
+    , last_change_us_(INT64_MIN / 2)
+    , long_due_us_(NO_DEADLINE)
+    , click_due_us_(NO_DEADLINE)
+    , last_release_us_(INT64_MIN / 2)
+    , double_pending_(false)
+    , long_fired_(false)
+    , bounces_(0)
+{
+}
+
+void ButtonGesture::configure(const Config& config)
+{
+    config_ = config;
+}
+
+void ButtonGesture::setHandler(Handler handler, void* ctx)
+{
+    handler_ = handler;
+    ctx_ = ctx;
+}
+
+void ButtonGesture::edge(int64_t t_us, bool pressed)
+{
+    // Timers that fell due before this edge fire first, in order
+    poll(t_us);
+    
+    raw_ = pressed;
+    raw_us_ = t_us;
+    if (pressed == stable_) {
+        return;
+    }
+    
+    // Leading-edge debounce: the first edge is taken at once (no added
+    // latency), then the level is locked for debounce_us
+    if (t_us - last_change_us_ >= config_.debounce_us) {
+        accept(t_us, pressed);
+    } else {
+        bounces_++;
+    }
+}
+
+void ButtonGesture::poll(int64_t now_us)
+{
+    // Bounce ended on the other level inside the lockout: take it when
+    // the lockout expires, stamped with the edge that got us there
+    int64_t settle_us = last_change_us_ + config_.debounce_us;
+    if (raw_ != stable_ && now_us >= settle_us) {
+        accept(raw_us_ > settle_us ? raw_us_ : settle_us, raw_);
+    }
+    
+    if (stable_ && !long_fired_ && now_us >= long_due_us_) {
+        long_fired_ = true;
+        int64_t due = long_due_us_;
+        long_due_us_ = NO_DEADLINE;
+        emit(Event::LongPress, due);
+    }
+    if (now_us >= click_due_us_) {
+        int64_t due = click_due_us_;
+        click_due_us_ = NO_DEADLINE;
+        emit(Event::Click, due);
+    }
+}
+
+int64_t ButtonGesture::nextDeadline() const
+{
+    int64_t next = NO_DEADLINE;
+    if (raw_ != stable_) {
+        next = last_change_us_ + config_.debounce_us;
+    }
+    if (long_due_us_ < next) {
+        next = long_due_us_;
+    }
+    if (click_due_us_ < next) {
+        next = click_due_us_;
+    }
+    return next;
+}
+
+void ButtonGesture::accept(int64_t t_us, bool pressed)
+{
+    stable_ = pressed;
+    last_change_us_ = t_us;
+    
+    if (pressed) {
+        emit(Event::Press, t_us);
+        long_fired_ = false;
+        if (click_due_us_ != NO_DEADLINE && t_us - last_release_us_ <= config_.double_press_us) {
+            // Second press of a double: no Click and no LongPress for it
+            click_due_us_ = NO_DEADLINE;
+            double_pending_ = true;
+            long_due_us_ = NO_DEADLINE;
+            emit(Event::DoublePress, t_us);
+        } else {
+            double_pending_ = false;
+            long_due_us_ = t_us + config_.long_press_us;
+        }
+        return;
+    }
+    
+    emit(Event::Release, t_us);
+    long_due_us_ = NO_DEADLINE;
+    last_release_us_ = t_us;
+    if (!long_fired_ && !double_pending_) {
+        click_due_us_ = t_us + config_.double_press_us;
+    }
+    double_pending_ = false;
+}
+
+void ButtonGesture::emit(Event event, int64_t due_us)
+{
+    if (handler_) {
+        handler_(event, due_us, ctx_);
+    }
+}
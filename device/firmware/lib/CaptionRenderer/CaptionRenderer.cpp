@@ -0,0 +1,274 @@
+/*
+ * CaptionRenderer.cpp
+ * UTF-8 caption drawn as 1-bpp raster rows from the FontAtlas
+ */
+
+#include "CaptionRenderer.hpp"
+#include <cstring>
+
+CaptionRenderer::CaptionRenderer()
+    : glyph_count_(0)
+    , line_count_(0)
+    , width_bytes_(0)
+    , height_(0)
+    , row_(0)
+    , line_(-1)
+    , stamp_(0)
+    , stats_()
+{
+    for (Slot& slot : cache_) {
+        slot.glyph = -1;
+        slot.used = 0;
+    }
+}
+
+uint16_t CaptionRenderer::begin(const char* utf8, uint16_t width_bytes)
+{
+    width_bytes_ = width_bytes;
+    glyph_count_ = 0;
+    line_count_ = 0;
+    height_ = 0;
+    row_ = 0;
+    line_ = -1;
+
+    int replacement = FontAtlas::find(FontAtlas::REPLACEMENT);
+    const char* p = utf8 ? utf8 : "";
+    uint32_t cp;
+    while ((cp = nextCodepoint(p)) != 0) {
+        if (glyph_count_ == MAX_BYTES) {
+            stats_.dropped++;
+            continue;
+        }
+        if (cp == '\n') {
+            glyphs_[glyph_count_++] = NEWLINE;
+            continue;
+        }
+        if (cp == '\r') {
+            continue;
+        }
+        if (cp == '\t') {
+            cp = ' ';
+        }
+        int index = FontAtlas::find(cp);
+        if (index < 0 || cp == FontAtlas::REPLACEMENT) {
+            index = replacement;
+            stats_.replaced++;
+        }
+        glyphs_[glyph_count_++] = (uint8_t)index;
+    }
+
+    layout();
+    if (line_count_ > 0) {
+        height_ = GAP_ROWS + line_count_ * FontAtlas::HEIGHT + (line_count_ - 1) * LINE_GAP;
+    }
+    return height_;
+}
+
+void CaptionRenderer::layout()
+{
+    uint8_t space = (uint8_t)FontAtlas::find(' ');
+    uint16_t width = width_bytes_ * 8;
+    uint16_t avail = width > 2 * MARGIN_DOTS ? width - 2 * MARGIN_DOTS : 0;
+
+    uint8_t i = 0;
+    while (i < glyph_count_ && line_count_ < MAX_LINES) {
+        // A line never starts with spaces or an empty break
+        if (glyphs_[i] == space || glyphs_[i] == NEWLINE) {
+            i++;
+            continue;
+        }
+        uint8_t first = i;
+        int wrap = -1;      // Last space on the line
+        uint16_t used = 0;
+        while (i < glyph_count_ && glyphs_[i] != NEWLINE) {
+            uint8_t advance = FontAtlas::GLYPHS[glyphs_[i]].advance;
+            // Always at least one glyph per line, even one too wide
+            if (used + advance > avail && i > first) {
+                if (glyphs_[i] != space && wrap > first) {
+                    i = (uint8_t)wrap;
+                }
+                break;
+            }
+            if (glyphs_[i] == space) {
+                wrap = i;
+            }
+            used += advance;
+            i++;
+        }
+        uint8_t count = i - first;
+        while (count > 0 && glyphs_[first + count - 1] == space) {
+            count--;
+        }
+        uint16_t line_width = lineWidth(first, count);
+        Line& line = lines_[line_count_++];
+        line.first = first;
+        line.count = count;
+        line.x = line_width < width ? (width - line_width) / 2 : 0;
+    }
+
+    for (; i < glyph_count_; i++) {
+        if (glyphs_[i] != space && glyphs_[i] != NEWLINE) {
+            stats_.dropped++;
+        }
+    }
+    stats_.glyphs += glyph_count_;
+}
+
+uint16_t CaptionRenderer::lineWidth(uint8_t first, uint8_t count) const
+{
+    uint16_t width = 0;
+    for (uint8_t k = 0; k < count; k++) {
+        width += FontAtlas::GLYPHS[glyphs_[first + k]].advance;
+    }
+    return width;
+}
+
+bool CaptionRenderer::readRow(uint8_t* row)
+{
+    if (row_ >= height_) {
+        return false;
+    }
+    memset(row, 0, width_bytes_);
+    int y = (int)row_++ - GAP_ROWS;
+    if (y < 0) {
+        return true;
+    }
+    int line_index = y / (FontAtlas::HEIGHT + LINE_GAP);
+    int glyph_row = y % (FontAtlas::HEIGHT + LINE_GAP);
+    if (glyph_row >= FontAtlas::HEIGHT) {
+        return true;
+    }
+    const Line& line = lines_[line_index];
+    if (line_ != line_index) {
+        pinLine(line);
+        line_ = line_index;
+    }
+
+    int x = line.x;
+    for (uint8_t k = 0; k < line.count; k++) {
+        const FontAtlas::Glyph& g = FontAtlas::GLYPHS[glyphs_[line.first + k]];
+        int r = glyph_row - g.top;
+        if (r >= 0 && r < g.rows) {
+            uint8_t slot = line_slots_[k];
+            blit(row, x + g.left, slot != NO_SLOT ? cache_[slot].bits[r] : flashRow(g, r));
+        }
+        x += g.advance;
+    }
+    return true;
+}
+
+// Looks up the line's glyphs once; they stay put until the next line
+void CaptionRenderer::pinLine(const Line& line)
+{
+    stamp_++;
+    for (uint8_t k = 0; k < line.count; k++) {
+        line_slots_[k] = slotFor(glyphs_[line.first + k]);
+    }
+}
+
+uint8_t CaptionRenderer::slotFor(uint8_t index)
+{
+    const FontAtlas::Glyph& g = FontAtlas::GLYPHS[index];
+    if (g.rows == 0) {
+        return NO_SLOT;     // Blank, nothing to draw
+    }
+    // Least recently used slot not pinned by this line; empty ones first
+    uint8_t victim = NO_SLOT;
+    for (uint8_t s = 0; s < CACHE_SLOTS; s++) {
+        Slot& slot = cache_[s];
+        if (slot.glyph == index) {
+            slot.used = stamp_;
+            stats_.hits++;
+            return s;
+        }
+        if (slot.used != stamp_ && (victim == NO_SLOT || slot.used < cache_[victim].used)) {
+            victim = s;
+        }
+    }
+    stats_.misses++;
+    if (victim == NO_SLOT) {
+        return NO_SLOT;
+    }
+
+    Slot& slot = cache_[victim];
+    for (uint8_t r = 0; r < g.rows; r++) {
+        slot.bits[r] = flashRow(g, r);
+    }
+    slot.glyph = index;
+    slot.used = stamp_;
+    return victim;
+}
+
+// Row `r` of a glyph's stored rows, MSB at its first column
+uint32_t CaptionRenderer::flashRow(const FontAtlas::Glyph& g, int r)
+{
+    size_t stride = g.stride();
+    const uint8_t* src = FontAtlas::BITS + g.offset + r * stride;
+    uint32_t bits = 0;
+    for (size_t b = 0; b < stride; b++) {
+        bits |= (uint32_t)src[b] << (24 - 8 * b);
+    }
+    return bits;
+}
+
+void CaptionRenderer::blit(uint8_t* row, int x, uint32_t bits) const
+{
+    if (x < 0) {
+        bits <<= -x;
+        x = 0;
+    }
+    if (bits == 0) {
+        return;
+    }
+    // 32 columns starting anywhere in a byte span at most 5 bytes
+    size_t byte = (size_t)x >> 3;
+    uint64_t span = (uint64_t)bits << (32 - (x & 7));
+    for (int i = 0; i < 5 && byte + i < width_bytes_; i++) {
+        row[byte + i] |= (uint8_t)(span >> (56 - 8 * i));
+    }
+}
+
+uint32_t CaptionRenderer::nextCodepoint(const char*& p)
+{
+    const uint8_t* s = (const uint8_t*)p;
+    if (s[0] < 0x80) {
+        if (s[0]) {
+            p++;
+        }
+        return s[0];
+    }
+
+    uint32_t cp;
+    uint32_t min;
+    int extra;
+    if ((s[0] & 0xE0) == 0xC0) {
+        cp = s[0] & 0x1F;
+        min = 0x80;
+        extra = 1;
+    } else if ((s[0] & 0xF0) == 0xE0) {
+        cp = s[0] & 0x0F;
+        min = 0x800;
+        extra = 2;
+    } else if ((s[0] & 0xF8) == 0xF0) {
+        cp = s[0] & 0x07;
+        min = 0x10000;
+        extra = 3;
+    } else {
+        p++;
+        return FontAtlas::REPLACEMENT;
+    }
+    // A NUL fails the continuation test, so this never reads past the end
+    for (int i = 1; i <= extra; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            p++;
+            return FontAtlas::REPLACEMENT;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        p++;
+        return FontAtlas::REPLACEMENT;
+    }
+    p += extra + 1;
+    return cp;
+}
@@ -0,0 +1,359 @@
+/*
+ * FontAtlas.cpp
+ * Caption glyphs, generated by scripts/font_atlas.py: do not edit
+ *
+ * DejaVuSans-Bold.ttf at 20 px, 24-dot cell, baseline at row 19,
+ * 123 glyphs, 3392 bytes of bits
+ */
+
+#include "FontAtlas.hpp"
+
+static_assert(FontAtlas::HEIGHT == 24, "regenerate with scripts/font_atlas.py --height");
+
+namespace FontAtlas {
+
+// {codepoint, offset, advance, width, left, top, rows}
+const Glyph GLYPHS[] = {
+    {0x0020, 0, 7, 7, 0, 0, 0},
+    {0x0021, 0, 9, 9, 0, 4, 15},  // !
+    {0x0022, 30, 10, 10, 0, 4, 5},  // "
+    {0x0023, 40, 17, 17, 0, 4, 15},  // #
+    {0x0024, 85, 14, 14, 0, 4, 18},  // $
+    {0x0025, 121, 20, 20, 0, 4, 15},  // %
+    {0x0026, 166, 17, 17, 0, 4, 15},  // &
+    {0x0027, 211, 6, 6, 0, 4, 5},  // '
+    {0x0028, 216, 9, 9, 0, 4, 18},  // (
+    {0x0029, 252, 9, 9, 0, 4, 18},  // )
+    {0x002A, 288, 10, 11, 0, 4, 9},  // *
+    {0x002B, 306, 17, 17, 0, 7, 12},  // +
+    {0x002C, 342, 8, 8, 0, 15, 7},  // ,
+    {0x002D, 349, 8, 8, 0, 12, 3},  // -
+    {0x002E, 352, 8, 8, 0, 15, 4},  // .
+    {0x002F, 356, 7, 8, 0, 4, 16},  // /
+    {0x0030, 372, 14, 14, 0, 4, 15},  // 0
+    {0x0031, 402, 14, 14, 0, 4, 15},  // 1
+    {0x0032, 432, 14, 14, 0, 4, 15},  // 2
+    {0x0033, 462, 14, 14, 0, 4, 15},  // 3
+    {0x0034, 492, 14, 14, 0, 4, 15},  // 4
+    {0x0035, 522, 14, 14, 0, 4, 15},  // 5
+    {0x0036, 552, 14, 14, 0, 4, 15},  // 6
+    {0x0037, 582, 14, 14, 0, 4, 15},  // 7
+    {0x0038, 612, 14, 14, 0, 4, 15},  // 8
+    {0x0039, 642, 14, 14, 0, 4, 15},  // 9
+    {0x003A, 672, 8, 8, 0, 8, 11},  // :
+    {0x003B, 683, 8, 8, 0, 8, 14},  // ;
+    {0x003C, 697, 17, 17, 0, 7, 11},  // <
+    {0x003D, 730, 17, 17, 0, 10, 6},  // =
+    {0x003E, 748, 17, 17, 0, 7, 11},  // >
+    {0x003F, 781, 12, 12, 0, 4, 15},  // ?
+    {0x0040, 811, 20, 20, 0, 4, 18},  // @
+    {0x0041, 865, 15, 16, 0, 4, 15},  // A
+    {0x0042, 895, 15, 15, 0, 4, 15},  // B
+    {0x0043, 925, 15, 15, 0, 4, 15},  // C
+    {0x0044, 955, 17, 17, 0, 4, 15},  // D
+    {0x0045, 1000, 14, 14, 0, 4, 15},  // E
+    {0x0046, 1030, 14, 14, 0, 4, 15},  // F
+    {0x0047, 1060, 16, 16, 0, 4, 15},  // G
+    {0x0048, 1090, 17, 17, 0, 4, 15},  // H
+    {0x0049, 1135, 7, 7, 0, 4, 15},  // I
+    {0x004A, 1150, 7, 9, -2, 4, 19},  // J
+    {0x004B, 1188, 16, 17, 0, 4, 15},  // K
+    {0x004C, 1233, 13, 13, 0, 4, 15},  // L
+    {0x004D, 1263, 20, 20, 0, 4, 15},  // M
+    {0x004E, 1308, 17, 17, 0, 4, 15},  // N
+    {0x004F, 1353, 17, 17, 0, 4, 15},  // O
+    {0x0050, 1398, 15, 15, 0, 4, 15},  // P
+    {0x0051, 1428, 17, 17, 0, 4, 18},  // Q
+    {0x0052, 1482, 15, 15, 0, 4, 15},  // R
+    {0x0053, 1512, 14, 14, 0, 4, 15},  // S
+    {0x0054, 1542, 14, 14, 0, 4, 15},  // T
+    {0x0055, 1572, 16, 16, 0, 4, 15},  // U
+    {0x0056, 1602, 15, 16, 0, 4, 15},  // V
+    {0x0057, 1632, 22, 22, 0, 4, 15},  // W
+    {0x0058, 1677, 15, 16, 0, 4, 15},  // X
+    {0x0059, 1707, 14, 16, -1, 4, 15},  // Y
+    {0x005A, 1737, 15, 15, 0, 4, 15},  // Z
+    {0x005B, 1767, 9, 9, 0, 4, 18},  // [
+    {0x005C, 1803, 7, 8, 0, 4, 16},
+    {0x005D, 1819, 9, 9, 0, 4, 18},  // ]
+    {0x005E, 1855, 17, 17, 0, 4, 5},  // ^
+    {0x005F, 1870, 10, 10, 0, 22, 2},  // _
+    {0x0060, 1874, 10, 10, 0, 3, 4},  // `
+    {0x0061, 1882, 14, 14, 0, 8, 11},  // a
+    {0x0062, 1904, 14, 14, 0, 4, 15},  // b
+    {0x0063, 1934, 12, 12, 0, 8, 11},  // c
+    {0x0064, 1956, 14, 14, 0, 4, 15},  // d
+    {0x0065, 1986, 14, 14, 0, 8, 11},  // e
+    {0x0066, 2008, 9, 9, 0, 4, 15},  // f
+    {0x0067, 2038, 14, 14, 0, 8, 15},  // g
+    {0x0068, 2068, 14, 14, 0, 4, 15},  // h
+    {0x0069, 2098, 7, 7, 0, 4, 15},  // i
+    {0x006A, 2113, 7, 8, -1, 4, 19},  // j
+    {0x006B, 2132, 13, 14, 0, 4, 15},  // k
+    {0x006C, 2162, 7, 7, 0, 4, 15},  // l
+    {0x006D, 2177, 21, 21, 0, 8, 11},  // m
+    {0x006E, 2210, 14, 14, 0, 8, 11},  // n
+    {0x006F, 2232, 14, 14, 0, 8, 11},  // o
+    {0x0070, 2254, 14, 14, 0, 8, 15},  // p
+    {0x0071, 2284, 14, 14, 0, 8, 15},  // q
+    {0x0072, 2314, 10, 10, 0, 8, 11},  // r
+    {0x0073, 2336, 12, 12, 0, 8, 11},  // s
+    {0x0074, 2358, 10, 10, 0, 5, 14},  // t
+    {0x0075, 2386, 14, 14, 0, 8, 11},  // u
+    {0x0076, 2408, 13, 13, 0, 8, 11},  // v
+    {0x0077, 2430, 18, 18, 0, 8, 11},  // w
+    {0x0078, 2463, 13, 13, 0, 8, 11},  // x
+    {0x0079, 2485, 13, 13, 0, 8, 15},  // y
+    {0x007A, 2515, 12, 12, 0, 8, 11},  // z
+    {0x007B, 2537, 14, 14, 0, 4, 18},  // {
+    {0x007C, 2573, 7, 7, 0, 4, 20},  // |
+    {0x007D, 2593, 14, 14, 0, 4, 18},  // }
+    {0x007E, 2629, 17, 17, 0, 10, 3},  // ~
+    {0x00A1, 2638, 9, 9, 0, 8, 15},  // ¡
+    {0x00AB, 2668, 13, 13, 0, 9, 9},  // «
+    {0x00B0, 2686, 10, 10, 0, 4, 7},  // °
+    {0x00BB, 2700, 13, 13, 0, 9, 9},  // »
+    {0x00BF, 2718, 12, 12, 0, 8, 15},  // ¿
+    {0x00C1, 2748, 15, 16, 0, 0, 19},  // Á
+    {0x00C9, 2786, 14, 14, 0, 0, 19},  // É
+    {0x00CD, 2824, 7, 7, 0, 0, 19},  // Í
+    {0x00D1, 2843, 17, 17, 0, 0, 19},  // Ñ
+    {0x00D3, 2900, 17, 17, 0, 0, 19},  // Ó
+    {0x00DA, 2957, 16, 16, 0, 0, 19},  // Ú
+    {0x00DC, 2995, 16, 16, 0, 0, 19},  // Ü
+    {0x00E1, 3033, 14, 14, 0, 3, 16},  // á
+    {0x00E9, 3065, 14, 14, 0, 3, 16},  // é
+    {0x00ED, 3097, 7, 8, 0, 3, 16},  // í
+    {0x00F1, 3113, 14, 14, 0, 3, 16},  // ñ
+    {0x00F3, 3145, 14, 14, 0, 3, 16},  // ó
+    {0x00FA, 3177, 14, 14, 0, 3, 16},  // ú
+    {0x00FC, 3209, 14, 14, 0, 4, 15},  // ü
+    {0x2013, 3239, 10, 10, 0, 12, 3},  // –
+    {0x2014, 3245, 20, 20, 0, 12, 3},  // —
+    {0x2018, 3254, 8, 8, 0, 4, 6},  // ‘
+    {0x2019, 3260, 8, 8, 0, 4, 6},  // ’
+    {0x201C, 3266, 13, 13, 0, 4, 6},  // “
+    {0x201D, 3278, 13, 13, 0, 4, 6},  // ”
+    {0x2026, 3290, 20, 20, 0, 15, 4},  // …
+    {0x20AC, 3302, 14, 15, -1, 4, 15},  // €
+    {0xFFFD, 3332, 22, 22, 0, 1, 20},  // �
+};
+
+const uint16_t GLYPH_COUNT = sizeof(GLYPHS) / sizeof(GLYPHS[0]);
+
+const uint8_t BITS[] = {
+    0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00,
+    0x1E, 0x00, 0x1E, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x33, 0x00,
+    0x33, 0x00, 0x33, 0x00, 0x33, 0x00, 0x33, 0x00, 0x03, 0x18, 0x00, 0x03, 0x18, 0x00, 0x03, 0x18,
+    0x00, 0x03, 0x30, 0x00, 0x3F, 0xFE, 0x00, 0x3F, 0xFE, 0x00, 0x06, 0x70, 0x00, 0x06, 0x60, 0x00,
+    0x0C, 0x60, 0x00, 0x7F, 0xFC, 0x00, 0x7F, 0xFC, 0x00, 0x0C, 0xC0, 0x00, 0x1C, 0xC0, 0x00, 0x18,
+    0xC0, 0x00, 0x18, 0xC0, 0x00, 0x03, 0x00, 0x03, 0x00, 0x0F, 0xE0, 0x3F, 0xF0, 0x73, 0x10, 0x73,
+    0x00, 0x7B, 0x00, 0x7F, 0xC0, 0x3F, 0xF0, 0x0F, 0xF8, 0x03, 0x78, 0x03, 0x38, 0x43, 0x38, 0x7F,
+    0xF0, 0x1F, 0xE0, 0x03, 0x00, 0x03, 0x00, 0x03, 0x00, 0x1E, 0x03, 0x00, 0x3F, 0x06, 0x00, 0x73,
+    0x8E, 0x00, 0x61, 0x8C, 0x00, 0x61, 0x9C, 0x00, 0x73, 0x98, 0x00, 0x3F, 0x30, 0x00, 0x1E, 0x73,
+    0xC0, 0x00, 0x67, 0xE0, 0x00, 0xCE, 0x70, 0x01, 0xCC, 0x30, 0x01, 0x8C, 0x30, 0x03, 0x8E, 0x70,
+    0x03, 0x07, 0xE0, 0x06, 0x03, 0xC0, 0x07, 0xC0, 0x00, 0x0F, 0xE0, 0x00, 0x1E, 0x20, 0x00, 0x1E,
+    0x00, 0x00, 0x1E, 0x00, 0x00, 0x0F, 0x00, 0x00, 0x1F, 0x8E, 0x00, 0x3F, 0x8E, 0x00, 0x79, 0xCE,
+    0x00, 0x79, 0xFC, 0x00, 0x78, 0xFC, 0x00, 0x78, 0x78, 0x00, 0x3C, 0x78, 0x00, 0x3F, 0xFC, 0x00,
+    0x0F, 0xDE, 0x00, 0x30, 0x30, 0x30, 0x30, 0x30, 0x0F, 0x00, 0x0E, 0x00, 0x1E, 0x00, 0x1C, 0x00,
+    0x1C, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00,
+    0x38, 0x00, 0x1C, 0x00, 0x1C, 0x00, 0x1E, 0x00, 0x0E, 0x00, 0x0F, 0x00, 0x78, 0x00, 0x38, 0x00,
+    0x3C, 0x00, 0x1C, 0x00, 0x1C, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00,
+    0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x1C, 0x00, 0x1C, 0x00, 0x3C, 0x00, 0x38, 0x00, 0x78, 0x00,
+    0x0C, 0x00, 0x0C, 0x00, 0xCC, 0xC0, 0x7F, 0x80, 0x1E, 0x00, 0x7F, 0x80, 0xCC, 0xC0, 0x0C, 0x00,
+    0x0C, 0x00, 0x01, 0x80, 0x00, 0x01, 0x80, 0x00, 0x01, 0x80, 0x00, 0x01, 0x80, 0x00, 0x01, 0x80,
+    0x00, 0x3F, 0xFC, 0x00, 0x3F, 0xFC, 0x00, 0x01, 0x80, 0x00, 0x01, 0x80, 0x00, 0x01, 0x80, 0x00,
+    0x01, 0x80, 0x00, 0x01, 0x80, 0x00, 0x3C, 0x3C, 0x3C, 0x3C, 0x38, 0x70, 0x60, 0x7E, 0x7E, 0x7E,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x06, 0x0E, 0x0C, 0x0C, 0x0C, 0x18, 0x18, 0x18, 0x30, 0x30, 0x30, 0x60,
+    0x60, 0x60, 0xE0, 0xC0, 0x0F, 0xC0, 0x1F, 0xE0, 0x3C, 0xF0, 0x38, 0x70, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x38, 0x70, 0x3C, 0xF0, 0x1F, 0xE0,
+    0x0F, 0xC0, 0x0F, 0xC0, 0x1F, 0xC0, 0x1B, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0,
+    0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x1F, 0xF8, 0x1F, 0xF8,
+    0x0F, 0xC0, 0x3F, 0xF0, 0x30, 0xF8, 0x20, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0xF8, 0x00, 0xF8,
+    0x01, 0xF0, 0x03, 0xF0, 0x07, 0xC0, 0x0F, 0x80, 0x1F, 0x00, 0x3F, 0xF8, 0x3F, 0xF8, 0x3F, 0xC0,
+    0x7F, 0xE0, 0x41, 0xF0, 0x00, 0xF0, 0x00, 0xF0, 0x01, 0xE0, 0x0F, 0xC0, 0x0F, 0xE0, 0x01, 0xF0,
+    0x00, 0xF0, 0x00, 0xF0, 0x00, 0xF0, 0x41, 0xF0, 0x7F, 0xE0, 0x3F, 0x80, 0x03, 0xE0, 0x03, 0xE0,
+    0x07, 0xE0, 0x0F, 0xE0, 0x0D, 0xE0, 0x1D, 0xE0, 0x39, 0xE0, 0x31, 0xE0, 0x71, 0xE0, 0x61, 0xE0,
+    0x7F, 0xF8, 0x7F, 0xF8, 0x01, 0xE0, 0x01, 0xE0, 0x01, 0xE0, 0x1F, 0xF0, 0x1F, 0xF0, 0x1C, 0x00,
+    0x1C, 0x00, 0x1C, 0x00, 0x1F, 0xC0, 0x1F, 0xF0, 0x10, 0xF0, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78,
+    0x00, 0x78, 0x20, 0xF0, 0x3F, 0xF0, 0x1F, 0xC0, 0x07, 0xE0, 0x1F, 0xF0, 0x1E, 0x10, 0x3C, 0x00,
+    0x78, 0x00, 0x7B, 0xC0, 0x7F, 0xF0, 0x7C, 0xF8, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x38, 0x78,
+    0x3C, 0xF0, 0x1F, 0xE0, 0x0F, 0xC0, 0x7F, 0xF0, 0x7F, 0xF0, 0x01, 0xF0, 0x01, 0xE0, 0x01, 0xE0,
+    0x03, 0xE0, 0x03, 0xC0, 0x07, 0xC0, 0x07, 0x80, 0x0F, 0x80, 0x0F, 0x00, 0x1F, 0x00, 0x1E, 0x00,
+    0x1E, 0x00, 0x3E, 0x00, 0x1F, 0xE0, 0x3F, 0xF0, 0x7C, 0xF8, 0x78, 0x78, 0x78, 0x78, 0x3C, 0xF0,
+    0x1F, 0xE0, 0x1F, 0xE0, 0x3C, 0xF0, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x7C, 0xF8, 0x3F, 0xF0,
+    0x0F, 0xC0, 0x0F, 0x80, 0x1F, 0xE0, 0x3C, 0xF0, 0x78, 0x70, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x7C, 0xF8, 0x3F, 0xF8, 0x0F, 0x78, 0x00, 0x78, 0x00, 0xF0, 0x21, 0xE0, 0x3F, 0xE0, 0x1F, 0x80,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x00, 0x00, 0x00, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x00,
+    0x00, 0x00, 0x3C, 0x3C, 0x3C, 0x3C, 0x38, 0x70, 0x60, 0x00, 0x02, 0x00, 0x00, 0x1E, 0x00, 0x00,
+    0xFE, 0x00, 0x07, 0xE0, 0x00, 0x3F, 0x00, 0x00, 0x38, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x07, 0xE0,
+    0x00, 0x00, 0xFE, 0x00, 0x00, 0x1E, 0x00, 0x00, 0x02, 0x00, 0x3F, 0xFE, 0x00, 0x3F, 0xFE, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3F, 0xFE, 0x00, 0x3F, 0xFE, 0x00, 0x20, 0x00, 0x00, 0x3C,
+    0x00, 0x00, 0x3F, 0x80, 0x00, 0x03, 0xF0, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x0E, 0x00, 0x00, 0x7E,
+    0x00, 0x03, 0xF0, 0x00, 0x3F, 0x80, 0x00, 0x3C, 0x00, 0x00, 0x20, 0x00, 0x00, 0x3F, 0x00, 0x7F,
+    0x80, 0x43, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x07, 0xC0, 0x0F, 0x80, 0x1F, 0x00, 0x1E, 0x00, 0x1E,
+    0x00, 0x00, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x01, 0xF8, 0x00, 0x07, 0xFE,
+    0x00, 0x0E, 0x0F, 0x00, 0x1C, 0x03, 0x80, 0x39, 0xED, 0x80, 0x33, 0xFD, 0xC0, 0x67, 0x1C, 0xC0,
+    0x66, 0x0C, 0xC0, 0x66, 0x0C, 0xC0, 0x66, 0x0C, 0xC0, 0x66, 0x0C, 0xC0, 0x67, 0x1D, 0x80, 0x33,
+    0xFF, 0x00, 0x39, 0xEE, 0x00, 0x1C, 0x02, 0x00, 0x0E, 0x0E, 0x00, 0x07, 0xFC, 0x00, 0x01, 0xF0,
+    0x00, 0x07, 0xC0, 0x07, 0xC0, 0x0F, 0xE0, 0x0F, 0xE0, 0x0E, 0xE0, 0x1E, 0xF0, 0x1E, 0xF0, 0x1C,
+    0x70, 0x3C, 0x78, 0x3C, 0x78, 0x3F, 0xF8, 0x7F, 0xFC, 0x78, 0x3C, 0x78, 0x3C, 0xF0, 0x1E, 0x3F,
+    0xE0, 0x3F, 0xF0, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3F, 0xF0, 0x3F, 0xF8, 0x3C,
+    0x78, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x7C, 0x3F, 0xF8, 0x3F, 0xE0, 0x07, 0xF0, 0x0F,
+    0xF8, 0x1E, 0x08, 0x3C, 0x00, 0x7C, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78,
+    0x00, 0x7C, 0x00, 0x3C, 0x00, 0x1E, 0x08, 0x0F, 0xF8, 0x07, 0xF0, 0x3F, 0xE0, 0x00, 0x3F, 0xF8,
+    0x00, 0x3C, 0x3C, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1F, 0x00, 0x3C, 0x0F, 0x00, 0x3C, 0x0F, 0x00,
+    0x3C, 0x0F, 0x00, 0x3C, 0x0F, 0x00, 0x3C, 0x0F, 0x00, 0x3C, 0x1F, 0x00, 0x3C, 0x1E, 0x00, 0x3C,
+    0x3C, 0x00, 0x3F, 0xF8, 0x00, 0x3F, 0xE0, 0x00, 0x3F, 0xF0, 0x3F, 0xF0, 0x3C, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x3C, 0x00, 0x3F, 0xE0, 0x3F, 0xE0, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x3F, 0xF0, 0x3F, 0xF0, 0x3F, 0xF0, 0x3F, 0xF0, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x3F, 0xF0, 0x3F, 0xF0, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x3C, 0x00, 0x03, 0xF8, 0x0F, 0xFC, 0x1E, 0x04, 0x3C, 0x00, 0x7C, 0x00, 0x78, 0x00,
+    0x78, 0x00, 0x78, 0x7E, 0x78, 0x7E, 0x78, 0x1E, 0x78, 0x1E, 0x3C, 0x1E, 0x1E, 0x1E, 0x0F, 0xFE,
+    0x03, 0xF8, 0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1E,
+    0x00, 0x3C, 0x1E, 0x00, 0x3F, 0xFE, 0x00, 0x3F, 0xFE, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00,
+    0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x1E, 0x00, 0x3C,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x0F, 0x00,
+    0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00,
+    0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x1F, 0x00,
+    0x7E, 0x00, 0x78, 0x00, 0x3C, 0x1E, 0x00, 0x3C, 0x3C, 0x00, 0x3C, 0x78, 0x00, 0x3C, 0xF0, 0x00,
+    0x3D, 0xE0, 0x00, 0x3F, 0xC0, 0x00, 0x3F, 0x80, 0x00, 0x3F, 0x80, 0x00, 0x3F, 0xC0, 0x00, 0x3F,
+    0xE0, 0x00, 0x3D, 0xF0, 0x00, 0x3C, 0xF8, 0x00, 0x3C, 0x7C, 0x00, 0x3C, 0x3E, 0x00, 0x3C, 0x1F,
+    0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C,
+    0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3F, 0xF0, 0x3F, 0xF0, 0x3E,
+    0x07, 0xC0, 0x3E, 0x07, 0xC0, 0x3F, 0x0F, 0xC0, 0x3F, 0x0F, 0xC0, 0x3F, 0x0F, 0xC0, 0x3F, 0x9F,
+    0xC0, 0x3D, 0x9B, 0xC0, 0x3D, 0x9B, 0xC0, 0x3D, 0xFB, 0xC0, 0x3C, 0xF3, 0xC0, 0x3C, 0xF3, 0xC0,
+    0x3C, 0x63, 0xC0, 0x3C, 0x03, 0xC0, 0x3C, 0x03, 0xC0, 0x3C, 0x03, 0xC0, 0x3E, 0x1E, 0x00, 0x3E,
+    0x1E, 0x00, 0x3F, 0x1E, 0x00, 0x3F, 0x1E, 0x00, 0x3F, 0x9E, 0x00, 0x3D, 0x9E, 0x00, 0x3D, 0x9E,
+    0x00, 0x3D, 0xDE, 0x00, 0x3C, 0xDE, 0x00, 0x3C, 0xDE, 0x00, 0x3C, 0xFE, 0x00, 0x3C, 0x7E, 0x00,
+    0x3C, 0x7E, 0x00, 0x3C, 0x3E, 0x00, 0x3C, 0x3E, 0x00, 0x07, 0xF0, 0x00, 0x0F, 0xF8, 0x00, 0x1E,
+    0x3C, 0x00, 0x3C, 0x1E, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F,
+    0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x3C, 0x1E, 0x00, 0x1E, 0x3C, 0x00,
+    0x0F, 0xF8, 0x00, 0x07, 0xF0, 0x00, 0x3F, 0xE0, 0x3F, 0xF8, 0x3C, 0x78, 0x3C, 0x3C, 0x3C, 0x3C,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x78, 0x3F, 0xF8, 0x3F, 0xE0, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x3C, 0x00, 0x07, 0xF0, 0x00, 0x0F, 0xF8, 0x00, 0x1E, 0x3C, 0x00, 0x3C, 0x1E, 0x00,
+    0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78,
+    0x0F, 0x00, 0x78, 0x0F, 0x00, 0x3C, 0x1E, 0x00, 0x1E, 0x3C, 0x00, 0x0F, 0xF8, 0x00, 0x07, 0xF0,
+    0x00, 0x00, 0x78, 0x00, 0x00, 0x3C, 0x00, 0x00, 0x1C, 0x00, 0x3F, 0xE0, 0x3F, 0xF0, 0x3C, 0x78,
+    0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x70, 0x3F, 0xE0, 0x3F, 0xE0, 0x3C, 0xF0, 0x3C, 0xF8,
+    0x3C, 0x78, 0x3C, 0x7C, 0x3C, 0x3C, 0x3C, 0x3E, 0x0F, 0xF0, 0x3F, 0xF0, 0x7C, 0x30, 0x78, 0x10,
+    0x78, 0x00, 0x7C, 0x00, 0x7F, 0xC0, 0x3F, 0xF0, 0x0F, 0xF8, 0x00, 0xF8, 0x00, 0x78, 0x40, 0x78,
+    0x70, 0xF8, 0x7F, 0xF0, 0x3F, 0xC0, 0xFF, 0xFC, 0xFF, 0xFC, 0x07, 0x80, 0x07, 0x80, 0x07, 0x80,
+    0x07, 0x80, 0x07, 0x80, 0x07, 0x80, 0x07, 0x80, 0x07, 0x80, 0x07, 0x80, 0x07, 0x80, 0x07, 0x80,
+    0x07, 0x80, 0x07, 0x80, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E,
+    0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x1E, 0x3C, 0x1F, 0xFC,
+    0x07, 0xF0, 0xF0, 0x1E, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78,
+    0x1E, 0xF0, 0x1E, 0xF0, 0x1E, 0xF0, 0x0F, 0xE0, 0x0F, 0xE0, 0x0F, 0xE0, 0x07, 0xC0, 0x07, 0xC0,
+    0x78, 0x38, 0x3C, 0x78, 0x38, 0x3C, 0x3C, 0x7C, 0x78, 0x3C, 0x7C, 0x78, 0x3C, 0x6C, 0x78, 0x1C,
+    0xEE, 0x70, 0x1E, 0xEE, 0xF0, 0x1E, 0xC6, 0xF0, 0x1E, 0xC6, 0xF0, 0x0F, 0xC7, 0xE0, 0x0F, 0xC7,
+    0xE0, 0x0F, 0x83, 0xE0, 0x07, 0x83, 0xC0, 0x07, 0x83, 0xC0, 0x07, 0x01, 0xC0, 0xF8, 0x3E, 0x78,
+    0x3C, 0x3C, 0x78, 0x3E, 0xF8, 0x1E, 0xF0, 0x0F, 0xE0, 0x07, 0xC0, 0x07, 0xC0, 0x0F, 0xE0, 0x0F,
+    0xE0, 0x1E, 0xF0, 0x3E, 0xF8, 0x3C, 0x78, 0x78, 0x3C, 0xF8, 0x3E, 0xF8, 0x1F, 0x7C, 0x3E, 0x3C,
+    0x3C, 0x3E, 0x7C, 0x1E, 0x78, 0x0F, 0xF0, 0x0F, 0xF0, 0x07, 0xE0, 0x03, 0xC0, 0x03, 0xC0, 0x03,
+    0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x03, 0xC0, 0x7F, 0xFC, 0x7F, 0xFC, 0x00, 0x7C, 0x00,
+    0xF8, 0x01, 0xF0, 0x01, 0xF0, 0x03, 0xE0, 0x07, 0xC0, 0x0F, 0x80, 0x1F, 0x00, 0x1F, 0x00, 0x3E,
+    0x00, 0x7C, 0x00, 0x7F, 0xFC, 0x7F, 0xFC, 0x3F, 0x00, 0x3F, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38,
+    0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x38,
+    0x00, 0x38, 0x00, 0x38, 0x00, 0x38, 0x00, 0x3F, 0x00, 0x3F, 0x00, 0xC0, 0xE0, 0x60, 0x60, 0x60,
+    0x30, 0x30, 0x30, 0x18, 0x18, 0x18, 0x0C, 0x0C, 0x0C, 0x0E, 0x06, 0x7E, 0x00, 0x7E, 0x00, 0x0E,
+    0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E,
+    0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x7E, 0x00, 0x7E, 0x00, 0x01,
+    0xC0, 0x00, 0x03, 0xE0, 0x00, 0x07, 0x70, 0x00, 0x0E, 0x38, 0x00, 0x18, 0x0C, 0x00, 0xFF, 0xC0,
+    0xFF, 0xC0, 0x70, 0x00, 0x38, 0x00, 0x1C, 0x00, 0x0E, 0x00, 0x1F, 0xC0, 0x3F, 0xE0, 0x20, 0xF0,
+    0x00, 0xF0, 0x1F, 0xF0, 0x3F, 0xF0, 0x78, 0xF0, 0x78, 0xF0, 0x79, 0xF0, 0x3F, 0xF0, 0x1E, 0xF0,
+    0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0xF0, 0x3F, 0xF8, 0x3E, 0x78, 0x3C, 0x3C,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3E, 0x78, 0x3F, 0xF8, 0x3C, 0xF0, 0x0F, 0xC0,
+    0x1F, 0xE0, 0x3C, 0x20, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x3C, 0x20,
+    0x1F, 0xE0, 0x0F, 0xC0, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x1E, 0x78, 0x3F, 0xF8,
+    0x3C, 0xF8, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x3C, 0xF8, 0x3F, 0xF8,
+    0x1E, 0x78, 0x0F, 0xC0, 0x1F, 0xF0, 0x3C, 0xF0, 0x78, 0x78, 0x7F, 0xF8, 0x7F, 0xF8, 0x78, 0x00,
+    0x78, 0x00, 0x3C, 0x10, 0x1F, 0xF0, 0x0F, 0xE0, 0x0F, 0x80, 0x3F, 0x80, 0x3C, 0x00, 0x3C, 0x00,
+    0xFF, 0x80, 0xFF, 0x80, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x1E, 0x78, 0x3F, 0xF8, 0x3C, 0xF8, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x3C, 0xF8, 0x3F, 0xF8, 0x0E, 0x78, 0x00, 0x78, 0x20, 0xF0,
+    0x3F, 0xE0, 0x1F, 0xC0, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0xE0, 0x3F, 0xF0,
+    0x3E, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78,
+    0x3C, 0x78, 0x3C, 0x3C, 0x3C, 0x00, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C,
+    0x3C, 0x1E, 0x1E, 0x1E, 0x00, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E,
+    0x1E, 0x1E, 0x7C, 0x78, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x38, 0x3C, 0x70,
+    0x3C, 0xE0, 0x3D, 0xC0, 0x3F, 0x80, 0x3F, 0x80, 0x3F, 0xC0, 0x3D, 0xE0, 0x3C, 0xF0, 0x3C, 0x78,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C,
+    0x3C, 0x3D, 0xE3, 0xC0, 0x3F, 0xF7, 0xE0, 0x3E, 0x7C, 0xF0, 0x3C, 0x78, 0xF0, 0x3C, 0x78, 0xF0,
+    0x3C, 0x78, 0xF0, 0x3C, 0x78, 0xF0, 0x3C, 0x78, 0xF0, 0x3C, 0x78, 0xF0, 0x3C, 0x78, 0xF0, 0x3C,
+    0x78, 0xF0, 0x3C, 0xE0, 0x3F, 0xF0, 0x3E, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78,
+    0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x0F, 0xC0, 0x1F, 0xE0, 0x3C, 0xF0, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x3C, 0xF0, 0x1F, 0xE0, 0x0F, 0xC0, 0x3C, 0xF0,
+    0x3F, 0xF8, 0x3E, 0x78, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3E, 0x78,
+    0x3F, 0xF8, 0x3C, 0xF0, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x1E, 0x78, 0x3F, 0xF8,
+    0x3C, 0xF8, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x3C, 0xF8, 0x3F, 0xF8,
+    0x1E, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x3D, 0xC0, 0x3F, 0xC0, 0x3E, 0x00,
+    0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00,
+    0x1F, 0xC0, 0x3F, 0xE0, 0x78, 0x20, 0x78, 0x00, 0x7E, 0x00, 0x3F, 0xC0, 0x0F, 0xE0, 0x01, 0xE0,
+    0x41, 0xE0, 0x7F, 0xC0, 0x3F, 0x80, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0xFF, 0xC0, 0xFF, 0xC0,
+    0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3F, 0x80,
+    0x1F, 0x80, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78,
+    0x3C, 0x78, 0x3C, 0xF8, 0x1F, 0xF8, 0x0E, 0x78, 0xF0, 0xF0, 0x70, 0xE0, 0x79, 0xE0, 0x79, 0xE0,
+    0x39, 0xC0, 0x39, 0xC0, 0x3F, 0xC0, 0x1F, 0x80, 0x1F, 0x80, 0x0F, 0x00, 0x0F, 0x00, 0x78, 0xE3,
+    0xC0, 0x78, 0xE3, 0xC0, 0x38, 0xE3, 0x80, 0x3D, 0xF7, 0x80, 0x3D, 0xB7, 0x80, 0x1D, 0xB7, 0x00,
+    0x1D, 0xB7, 0x00, 0x1F, 0x1F, 0x00, 0x1F, 0x1F, 0x00, 0x0F, 0x1E, 0x00, 0x0F, 0x1E, 0x00, 0x78,
+    0x78, 0x3C, 0xF0, 0x1C, 0xE0, 0x0F, 0xC0, 0x0F, 0xC0, 0x07, 0x80, 0x0F, 0xC0, 0x1F, 0xE0, 0x1C,
+    0xE0, 0x3C, 0xF0, 0x78, 0x78, 0x78, 0x78, 0x38, 0x78, 0x3C, 0x70, 0x3C, 0xF0, 0x1C, 0xE0, 0x1C,
+    0xE0, 0x0E, 0xE0, 0x0F, 0xC0, 0x0F, 0xC0, 0x07, 0xC0, 0x07, 0x80, 0x07, 0x80, 0x0F, 0x00, 0x3F,
+    0x00, 0x3E, 0x00, 0x7F, 0xE0, 0x7F, 0xE0, 0x01, 0xE0, 0x03, 0xC0, 0x07, 0x80, 0x0F, 0x00, 0x1E,
+    0x00, 0x3C, 0x00, 0x78, 0x00, 0x7F, 0xE0, 0x7F, 0xE0, 0x01, 0xF0, 0x03, 0xF0, 0x03, 0x80, 0x03,
+    0x80, 0x03, 0x80, 0x03, 0x80, 0x03, 0x80, 0x07, 0x80, 0x1F, 0x00, 0x1F, 0x00, 0x07, 0x80, 0x03,
+    0x80, 0x03, 0x80, 0x03, 0x80, 0x03, 0x80, 0x03, 0x80, 0x03, 0xF0, 0x01, 0xF0, 0x18, 0x18, 0x18,
+    0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18,
+    0x18, 0x3E, 0x00, 0x3F, 0x00, 0x07, 0x00, 0x07, 0x00, 0x07, 0x00, 0x07, 0x00, 0x07, 0x00, 0x07,
+    0x80, 0x03, 0xE0, 0x03, 0xE0, 0x07, 0x80, 0x07, 0x00, 0x07, 0x00, 0x07, 0x00, 0x07, 0x00, 0x07,
+    0x00, 0x3F, 0x00, 0x3E, 0x00, 0x1F, 0x82, 0x00, 0x3F, 0xFE, 0x00, 0x30, 0xFC, 0x00, 0x1E, 0x00,
+    0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00,
+    0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x1E, 0x00, 0x02, 0x10, 0x06, 0x30,
+    0x0E, 0x70, 0x39, 0xC0, 0x31, 0x80, 0x39, 0xC0, 0x0E, 0x70, 0x06, 0x30, 0x02, 0x10, 0x0E, 0x00,
+    0x1F, 0x00, 0x31, 0x80, 0x31, 0x80, 0x31, 0x80, 0x1F, 0x00, 0x0E, 0x00, 0x21, 0x00, 0x31, 0x80,
+    0x39, 0xC0, 0x0E, 0x70, 0x06, 0x30, 0x0E, 0x70, 0x39, 0xC0, 0x31, 0x80, 0x21, 0x00, 0x0F, 0x00,
+    0x0F, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x00, 0x00, 0x0F, 0x00, 0x0F, 0x00, 0x1F, 0x00, 0x3E, 0x00,
+    0x7C, 0x00, 0x78, 0x00, 0x78, 0x00, 0x78, 0x40, 0x3F, 0xC0, 0x1F, 0x80, 0x00, 0x70, 0x00, 0xE0,
+    0x01, 0xC0, 0x00, 0x00, 0x07, 0xC0, 0x07, 0xC0, 0x0F, 0xE0, 0x0F, 0xE0, 0x0E, 0xE0, 0x1E, 0xF0,
+    0x1E, 0xF0, 0x1C, 0x70, 0x3C, 0x78, 0x3C, 0x78, 0x3F, 0xF8, 0x7F, 0xFC, 0x78, 0x3C, 0x78, 0x3C,
+    0xF0, 0x1E, 0x00, 0xE0, 0x01, 0xC0, 0x03, 0x80, 0x00, 0x00, 0x3F, 0xF0, 0x3F, 0xF0, 0x3C, 0x00,
+    0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x3F, 0xE0, 0x3F, 0xE0, 0x3C, 0x00, 0x3C, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x3C, 0x00, 0x3F, 0xF0, 0x3F, 0xF0, 0x0E, 0x1C, 0x38, 0x00, 0x3C, 0x3C, 0x3C, 0x3C,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x03, 0xB0, 0x00, 0x07, 0xF0,
+    0x00, 0x06, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x1E, 0x00, 0x3E, 0x1E, 0x00, 0x3F, 0x1E, 0x00,
+    0x3F, 0x1E, 0x00, 0x3F, 0x9E, 0x00, 0x3D, 0x9E, 0x00, 0x3D, 0x9E, 0x00, 0x3D, 0xDE, 0x00, 0x3C,
+    0xDE, 0x00, 0x3C, 0xDE, 0x00, 0x3C, 0xFE, 0x00, 0x3C, 0x7E, 0x00, 0x3C, 0x7E, 0x00, 0x3C, 0x3E,
+    0x00, 0x3C, 0x3E, 0x00, 0x00, 0x70, 0x00, 0x00, 0xE0, 0x00, 0x01, 0xC0, 0x00, 0x00, 0x00, 0x00,
+    0x07, 0xF0, 0x00, 0x0F, 0xF8, 0x00, 0x1E, 0x3C, 0x00, 0x3C, 0x1E, 0x00, 0x78, 0x0F, 0x00, 0x78,
+    0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F, 0x00, 0x78, 0x0F,
+    0x00, 0x3C, 0x1E, 0x00, 0x1E, 0x3C, 0x00, 0x0F, 0xF8, 0x00, 0x07, 0xF0, 0x00, 0x00, 0x70, 0x00,
+    0xE0, 0x01, 0xC0, 0x00, 0x00, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C,
+    0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x1E, 0x3C, 0x1F,
+    0xFC, 0x07, 0xF0, 0x06, 0x30, 0x06, 0x30, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C,
+    0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C, 0x1E, 0x3C,
+    0x1E, 0x3C, 0x1E, 0x1E, 0x3C, 0x1F, 0xFC, 0x07, 0xF0, 0x00, 0x70, 0x00, 0xE0, 0x01, 0xC0, 0x03,
+    0x80, 0x00, 0x00, 0x1F, 0xC0, 0x3F, 0xE0, 0x20, 0xF0, 0x00, 0xF0, 0x1F, 0xF0, 0x3F, 0xF0, 0x78,
+    0xF0, 0x78, 0xF0, 0x79, 0xF0, 0x3F, 0xF0, 0x1E, 0xF0, 0x00, 0x70, 0x00, 0xE0, 0x01, 0xC0, 0x03,
+    0x80, 0x00, 0x00, 0x0F, 0xC0, 0x1F, 0xF0, 0x3C, 0xF0, 0x78, 0x78, 0x7F, 0xF8, 0x7F, 0xF8, 0x78,
+    0x00, 0x78, 0x00, 0x3C, 0x10, 0x1F, 0xF0, 0x0F, 0xE0, 0x03, 0x07, 0x0E, 0x1C, 0x00, 0x3C, 0x3C,
+    0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x06, 0x60, 0x0F, 0x60, 0x0D, 0xE0, 0x0C,
+    0xC0, 0x00, 0x00, 0x3C, 0xE0, 0x3F, 0xF0, 0x3E, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C,
+    0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x00, 0x70, 0x00, 0xE0, 0x01, 0xC0, 0x03,
+    0x80, 0x00, 0x00, 0x0F, 0xC0, 0x1F, 0xE0, 0x3C, 0xF0, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x3C, 0xF0, 0x1F, 0xE0, 0x0F, 0xC0, 0x00, 0x70, 0x00, 0xE0, 0x01, 0xC0, 0x03,
+    0x80, 0x00, 0x00, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C,
+    0x78, 0x3C, 0x78, 0x3C, 0xF8, 0x1F, 0xF8, 0x0E, 0x78, 0x0C, 0x60, 0x0C, 0x60, 0x00, 0x00, 0x00,
+    0x00, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C, 0x78, 0x3C,
+    0x78, 0x3C, 0xF8, 0x1F, 0xF8, 0x0E, 0x78, 0x7F, 0x80, 0x7F, 0x80, 0x7F, 0x80, 0x7F, 0xFF, 0xE0,
+    0x7F, 0xFF, 0xE0, 0x7F, 0xFF, 0xE0, 0x0C, 0x1C, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38, 0x38,
+    0x70, 0x60, 0x0C, 0x60, 0x1C, 0xE0, 0x39, 0xC0, 0x39, 0xC0, 0x39, 0xC0, 0x39, 0xC0, 0x1C, 0xE0,
+    0x1C, 0xE0, 0x1C, 0xE0, 0x1C, 0xE0, 0x39, 0xC0, 0x31, 0x80, 0x3C, 0x78, 0xF0, 0x3C, 0x78, 0xF0,
+    0x3C, 0x78, 0xF0, 0x3C, 0x78, 0xF0, 0x03, 0xF0, 0x07, 0xF8, 0x0F, 0x18, 0x1E, 0x00, 0x1E, 0x00,
+    0x7F, 0xF0, 0xFF, 0xE0, 0x3C, 0x00, 0x7F, 0xC0, 0xFF, 0x80, 0x1E, 0x00, 0x1E, 0x00, 0x0F, 0x18,
+    0x07, 0xF8, 0x03, 0xF0, 0x00, 0x30, 0x00, 0x00, 0x78, 0x00, 0x00, 0xFC, 0x00, 0x01, 0x82, 0x00,
+    0x02, 0x01, 0x00, 0x06, 0x00, 0x80, 0x0E, 0xF8, 0xC0, 0x1F, 0xF8, 0xE0, 0x3F, 0xF0, 0xF0, 0x7F,
+    0xE1, 0xF8, 0x7F, 0xC3, 0xF8, 0x3F, 0xC7, 0xF0, 0x1F, 0x87, 0xE0, 0x0F, 0xFF, 0xC0, 0x07, 0xFF,
+    0x80, 0x03, 0x87, 0x00, 0x01, 0x86, 0x00, 0x00, 0x84, 0x00, 0x00, 0x78, 0x00, 0x00, 0x30, 0x00,
+};
+
+}  // namespace FontAtlas
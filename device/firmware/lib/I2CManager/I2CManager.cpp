@@ -4,27 +4,75 @@
  */
 
 #include "I2CManager.hpp"
+#include "Trace.hpp"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include <cstdio>
 
+// Per-call state for the blocking helpers, lives on the caller's stack
+struct SyncWait {
+    StaticSemaphore_t storage;
+    SemaphoreHandle_t sem;
+    esp_err_t result;
+};
+
+static void syncDone(esp_err_t result, void* ctx)
+{
+    SyncWait* wait = static_cast<SyncWait*>(ctx);
+    wait->result = result;
+    xSemaphoreGive(wait->sem);
+}
+
 I2CManager::I2CManager(gpio_num_t sda_pin, gpio_num_t scl_pin, uint32_t freq_hz)
     : port_(I2C_NUM_0)
     , sda_pin_(sda_pin)
     , scl_pin_(scl_pin)
     , freq_hz_(freq_hz)
     , initialized_(false)
+    , queue_(nullptr)
+    , queue_buffer_()
+    , task_handle_(nullptr)
 {
 }
 
 I2CManager::~I2CManager()
 {
+    if (task_handle_) {
+        vTaskDelete(task_handle_);
+    }
+    if (queue_) {
+        vQueueDelete(queue_);
+    }
     if (initialized_) {
         i2c_driver_delete(port_);
     }
 }
 
-bool I2CManager::begin()
+bool I2CManager::begin(const TaskSpec& task)
+{
+    if (!installDriver()) {
+        return false;
+    }
+    
+    if (!queue_) {
+        queue_ = xQueueCreateStatic(QUEUE_DEPTH, sizeof(Transaction), queue_storage_, &queue_buffer_);
+        if (!queue_) {
+            ESP_LOGE(TAG, "Failed to create transaction queue");
+            return false;
+        }
+    }
+    if (!task_handle_) {
+        task_handle_ = task_storage_.start(taskEntry, this, task);
+        if (!task_handle_) {
+            ESP_LOGE(TAG, "Failed to create bus task");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool I2CManager::installDriver()
 {
     i2c_config_t conf = {
         .mode = I2C_MODE_MASTER,
@@ -59,7 +107,6 @@ bool I2CManager::begin()
 
 void I2CManager::scan()
 {
-    esp_err_t ret;
     printf("\nI2C Scanner Results:\n");
     printf("     0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f\r\n");
     
@@ -67,14 +114,7 @@ void I2CManager::scan()
         printf("%02x: ", i);
         for (int j = 0; j < 16; j++) {
             uint8_t address = i + j;
-            i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-            i2c_master_start(cmd);
-            i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
-            i2c_master_stop(cmd);
-            ret = i2c_master_cmd_begin(port_, cmd, 50 / portTICK_PERIOD_MS);
-            i2c_cmd_link_delete(cmd);
-            
-            if (ret == ESP_OK) {
+            if (probe(address)) {
                 printf("%02x ", address);
             } else {
                 printf("-- ");
@@ -84,7 +124,178 @@ void I2CManager::scan()
     }
 }
 
-void I2CManager::bus_reset()
+bool I2CManager::submit(const Transaction& txn, TickType_t wait)
+{
+    if (!queue_ || !initialized_) {
+        return false;
+    }
+    if (xQueueSend(queue_, &txn, wait) != pdTRUE) {
+        return false;
+    }
+    uint32_t depth = uxQueueMessagesWaiting(queue_);
+    TRACE_COUNTER("i2c_queue", depth);
+    // Submitters race each other here; the bus task counts the rest
+    uint32_t high = counters_.queue_high_water.load(std::memory_order_relaxed);
+    while (depth > high
+           && !counters_.queue_high_water.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {
+        // `high` was reloaded with what another submitter stored
+    }
+    return true;
+}
+
+I2CManager::Stats I2CManager::getStats() const
+{
+    Stats stats;
+    stats.transactions = counters_.transactions.load(std::memory_order_relaxed);
+    stats.bus_writes = counters_.bus_writes.load(std::memory_order_relaxed);
+    stats.coalesced = counters_.coalesced.load(std::memory_order_relaxed);
+    stats.errors = counters_.errors.load(std::memory_order_relaxed);
+    stats.queue_high_water = counters_.queue_high_water.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool I2CManager::transact(const Transaction& txn, TickType_t timeout)
+{
+    SyncWait wait;
+    wait.sem = xSemaphoreCreateBinaryStatic(&wait.storage);
+    wait.result = ESP_FAIL;
+    
+    Transaction t = txn;
+    t.done = syncDone;
+    t.ctx = &wait;
+    if (!submit(t, timeout)) {
+        return false;
+    }
+    // The callback always runs once the bus task has taken the
+    // transaction, so wait for it even past `timeout`: `wait` is on our
+    // stack
+    xSemaphoreTake(wait.sem, portMAX_DELAY);
+    return wait.result == ESP_OK;
+}
+
+bool I2CManager::write(uint8_t address, uint8_t prefix, const uint8_t* data, size_t len,
+                       TickType_t timeout)
+{
+    Transaction txn = {};
+    txn.address = address;
+    txn.flags = Transaction::PREFIX;
+    txn.prefix = prefix;
+    txn.data = data;
+    txn.len = len;
+    if (!transact(txn, timeout)) {
+        ESP_LOGW(TAG, "Write to 0x%02x failed", address);
+        return false;
+    }
+    return true;
+}
+
+bool I2CManager::probe(uint8_t address, TickType_t timeout)
+{
+    Transaction txn = {};
+    txn.address = address;
+    return transact(txn, timeout);
+}
+
+void I2CManager::taskEntry(void* arg)
+{
+    static_cast<I2CManager*>(arg)->busTask();
+}
+
+void I2CManager::busTask()
+{
+    while (true) {
+        if (xQueueReceive(queue_, &batch_[0], portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (batch_[0].flags & Transaction::BUS_RESET) {
+            esp_err_t err = resetBus();
+            if (batch_[0].done) {
+                batch_[0].done(err, batch_[0].ctx);
+            }
+            continue;
+        }
+        
+        // Pull in queued stream writes that continue the same stream
+        size_t count = 1;
+        const Transaction& first = batch_[0];
+        if ((first.flags & Transaction::COALESCE) && !first.read_len) {
+            Transaction next;
+            while (count < MAX_COALESCE
+                   && xQueuePeek(queue_, &next, 0) == pdTRUE
+                   && (next.flags & Transaction::COALESCE)
+                   && next.address == first.address
+                   && next.flags == first.flags
+                   && next.prefix == first.prefix
+                   && !next.read_len) {
+                xQueueReceive(queue_, &batch_[count++], 0);
+            }
+        }
+        
+        esp_err_t err = execute(batch_, count);
+        counters_.transactions.fetch_add(count, std::memory_order_relaxed);
+        counters_.bus_writes.fetch_add(1, std::memory_order_relaxed);
+        counters_.coalesced.fetch_add(count - 1, std::memory_order_relaxed);
+        if (err != ESP_OK) {
+            counters_.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (batch_[i].done) {
+                batch_[i].done(err, batch_[i].ctx);
+            }
+        }
+    }
+}
+
+esp_err_t I2CManager::execute(const Transaction* txns, size_t count)
+{
+    const Transaction& first = txns[0];
+    TRACE_SCOPE("i2c_xfer", (int32_t)count);
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link_buf_, sizeof(link_buf_));
+    if (!cmd) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (first.address << 1) | I2C_MASTER_WRITE, true);
+    if (first.flags & Transaction::PREFIX) {
+        i2c_master_write_byte(cmd, first.prefix, true);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (txns[i].len > 0) {
+            i2c_master_write(cmd, txns[i].data, txns[i].len, true);
+        }
+    }
+    if (first.read_len > 0) {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (first.address << 1) | I2C_MASTER_READ, true);
+        i2c_master_read(cmd, first.read_buf, first.read_len, I2C_MASTER_LAST_NACK);
+    }
+    i2c_master_stop(cmd);
+    
+    // 400 kHz moves ~44 bytes/ms; allow generous slack for long streams
+    size_t bytes = 2 + first.read_len;
+    for (size_t i = 0; i < count; i++) {
+        bytes += txns[i].len;
+    }
+    TickType_t timeout = pdMS_TO_TICKS(50 + bytes / 8);
+    esp_err_t err = i2c_master_cmd_begin(port_, cmd, timeout);
+    i2c_cmd_link_delete_static(cmd);
+    return err;
+}
+
+bool I2CManager::bus_reset(TickType_t timeout)
+{
+    Transaction txn = {};
+    txn.flags = Transaction::BUS_RESET;
+    if (!transact(txn, timeout)) {
+        ESP_LOGW(TAG, "Bus reset failed");
+        return false;
+    }
+    return true;
+}
+
+// Bus task only: the driver is never deleted under a transfer
+esp_err_t I2CManager::resetBus()
 {
     ESP_LOGI(TAG, "Attempting I2C bus reset...");
     
@@ -93,6 +304,8 @@ void I2CManager::bus_reset()
         .pin_bit_mask = (1ULL << scl_pin_),
         .mode = GPIO_MODE_OUTPUT_OD,
         .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
     };
     gpio_config(&scl_config);
     
@@ -107,5 +320,5 @@ void I2CManager::bus_reset()
     ESP_LOGI(TAG, "Bus reset complete. Reinitialize I2C driver.");
     i2c_driver_delete(port_);
     vTaskDelay(pdMS_TO_TICKS(100));
-    begin();
+    return installDriver() ? ESP_OK : ESP_FAIL;
 }
@@ -0,0 +1,166 @@
+/*
+ * MemoryBudget.cpp
+ * Where the RAM goes: static objects, task stacks, boot reservations, heap
+ */
+
+#include "MemoryBudget.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static constexpr const char* TAG = "MemoryBudget";
+
+namespace {
+
+struct StaticEntry {
+    const char* name;
+    size_t bytes;
+};
+
+struct TaskEntry {
+    const char* name;
+    TaskHandle_t handle;
+    uint32_t stack;
+};
+
+struct Reservation {
+    const char* name;
+    size_t bytes;
+    bool psram;
+};
+
+struct ArenaEntry {
+    const char* name;
+    const Arena* arena;
+};
+
+StaticEntry statics[MemoryBudget::MAX_ENTRIES];
+size_t static_count = 0;
+TaskEntry tasks[MemoryBudget::MAX_ENTRIES];
+size_t task_count = 0;
+Reservation reservations[MemoryBudget::MAX_ENTRIES];
+size_t reservation_count = 0;
+ArenaEntry arenas[MemoryBudget::MAX_ENTRIES];
+size_t arena_count = 0;
+
+size_t internal_boot_free = 0;
+size_t psram_boot_free = 0;
+
+MemoryBudget::Heap heapStats(uint32_t caps, size_t boot_free)
+{
+    MemoryBudget::Heap heap;
+    heap.total = heap_caps_get_total_size(caps);
+    heap.free = heap_caps_get_free_size(caps);
+    heap.min_free = heap_caps_get_minimum_free_size(caps);
+    heap.largest_block = heap_caps_get_largest_free_block(caps);
+    heap.boot_free = boot_free;
+    return heap;
+}
+
+void logHeap(const char* name, const MemoryBudget::Heap& heap)
+{
+    ESP_LOGI(TAG, "  %-8s %7u total, %7u free, %7u largest, high water %u used",
+             name, (unsigned)heap.total, (unsigned)heap.free, (unsigned)heap.largest_block,
+             (unsigned)(heap.total - heap.min_free));
+    if (heap.boot_free) {
+        long drift = (long)heap.boot_free - (long)heap.free;
+        ESP_LOGI(TAG, "  %-8s %+ld bytes since boot", "", drift);
+    }
+}
+    
+}  // namespace
+
+void MemoryBudget::addStatic(const char* name, size_t bytes)
+{
+    if (static_count < MAX_ENTRIES) {
+        statics[static_count++] = {name, bytes};
+    }
+}
+
+void MemoryBudget::addTask(const char* name, TaskHandle_t handle, uint32_t stack)
+{
+    if (task_count < MAX_ENTRIES) {
+        tasks[task_count++] = {name, handle, stack};
+    }
+}
+
+void* MemoryBudget::reserve(const char* name, size_t bytes, bool prefer_psram)
+{
+    bool psram = prefer_psram && heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+    void* block = psram ? heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : nullptr;
+    if (!block) {
+        psram = false;
+        block = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!block) {
+        ESP_LOGE(TAG, "No room for %s (%u bytes)", name, (unsigned)bytes);
+        return nullptr;
+    }
+    if (reservation_count < MAX_ENTRIES) {
+        reservations[reservation_count++] = {name, bytes, psram};
+    }
+    return block;
+}
+
+void MemoryBudget::addArena(const char* name, const Arena* arena)
+{
+    if (arena_count < MAX_ENTRIES) {
+        arenas[arena_count++] = {name, arena};
+    }
+}
+
+void MemoryBudget::bootDone()
+{
+    internal_boot_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    psram_boot_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+MemoryBudget::Heap MemoryBudget::internalHeap()
+{
+    return heapStats(MALLOC_CAP_INTERNAL, internal_boot_free);
+}
+
+MemoryBudget::Heap MemoryBudget::psramHeap()
+{
+    return heapStats(MALLOC_CAP_SPIRAM, psram_boot_free);
+}
+
+void MemoryBudget::log()
+{
+    size_t total = 0;
+    ESP_LOGI(TAG, "Static objects:");
+    for (size_t i = 0; i < static_count; i++) {
+        ESP_LOGI(TAG, "  %-16s %6u", statics[i].name, (unsigned)statics[i].bytes);
+        total += statics[i].bytes;
+    }
+    ESP_LOGI(TAG, "  %-16s %6u", "total", (unsigned)total);
+    
+    total = 0;
+    ESP_LOGI(TAG, "Task stacks (static):");
+    for (size_t i = 0; i < task_count; i++) {
+        const TaskEntry& t = tasks[i];
+        // The high-water mark is the least stack ever left free, in bytes
+        uint32_t unused = uxTaskGetStackHighWaterMark(t.handle);
+        ESP_LOGI(TAG, "  %-16s %6u, peak %u used", t.name, (unsigned)t.stack,
+                 (unsigned)(t.stack > unused ? t.stack - unused : 0));
+        total += t.stack;
+    }
+    ESP_LOGI(TAG, "  %-16s %6u", "total", (unsigned)total);
+    
+    ESP_LOGI(TAG, "Reserved at boot:");
+    for (size_t i = 0; i < reservation_count; i++) {
+        ESP_LOGI(TAG, "  %-16s %6u  %s", reservations[i].name, (unsigned)reservations[i].bytes,
+                 reservations[i].psram ? "PSRAM" : "internal");
+    }
+    for (size_t i = 0; i < arena_count; i++) {
+        const Arena* a = arenas[i].arena;
+        ESP_LOGI(TAG, "  arena %-10s %6u, peak %u used, %u failed allocations", arenas[i].name,
+                 (unsigned)a->capacity(), (unsigned)a->highWater(), (unsigned)a->failures());
+    }
+    
+    ESP_LOGI(TAG, "Heap:");
+    logHeap("internal", internalHeap());
+    Heap psram = psramHeap();
+    if (psram.total) {
+        logHeap("PSRAM", psram);
+    }
+}
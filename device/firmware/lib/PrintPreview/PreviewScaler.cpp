@@ -0,0 +1,84 @@
+/*
+ * PreviewScaler.cpp
+ * 3:1 box downscale of 1-bpp printer rows to 4-bpp preview rows
+ */
+
+#include "PreviewScaler.hpp"
+#include <cstring>
+
+PreviewScaler::PreviewScaler()
+{
+    begin(FACTOR * GROUPS);
+}
+
+void PreviewScaler::begin(uint16_t width_bytes, bool ink_lit)
+{
+    uint16_t available = width_bytes / FACTOR;
+    if (available > GROUPS) {
+        first_byte_ = (uint16_t)((available - GROUPS) / 2 * FACTOR);
+        groups_ = GROUPS;
+    } else {
+        first_byte_ = 0;
+        groups_ = (uint8_t)available;
+    }
+    out_offset_ = (uint8_t)((GROUPS - groups_) * 2);
+    rows_ = 0;
+    ink_lit_ = ink_lit;
+    memset(plane0_, 0, sizeof(plane0_));
+    memset(plane1_, 0, sizeof(plane1_));
+
+    // Ink dots in a cell, 0..9, spread over the 16 levels
+    for (uint8_t i = 0; i < 64; i++) {
+        uint8_t count = (uint8_t)(__builtin_popcount(i & 7) + 2 * __builtin_popcount(i >> 3));
+        uint8_t gray = (uint8_t)((count * 15 + 4) / 9);
+        level_[i] = ink_lit ? gray : (uint8_t)(15 - gray);
+    }
+}
+
+bool PreviewScaler::addRow(const uint8_t* row, uint8_t* out)
+{
+    const uint8_t* p = row + first_byte_;
+    for (uint8_t g = 0; g < groups_; g++, p += 3) {
+        // Adds 0 or 1 to each of the 24 two-bit column counts (at most 3)
+        uint32_t w = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+        uint32_t carry = plane0_[g] & w;
+        plane0_[g] ^= w;
+        plane1_[g] |= carry;
+    }
+    if (++rows_ < FACTOR) {
+        return false;
+    }
+    emit(out);
+    return true;
+}
+
+bool PreviewScaler::flush(uint8_t* out)
+{
+    if (rows_ == 0) {
+        return false;
+    }
+    emit(out);
+    return true;
+}
+
+void PreviewScaler::emit(uint8_t* out)
+{
+    uint8_t paper = ink_lit_ ? 0x00 : 0xFF;
+    memset(out, paper, out_offset_);
+    memset(out + out_offset_ + groups_ * 4, paper, ROW_BYTES - out_offset_ - groups_ * 4);
+
+    uint8_t* q = out + out_offset_;
+    for (uint8_t g = 0; g < groups_; g++) {
+        uint32_t s0 = plane0_[g];
+        uint32_t s1 = plane1_[g];
+        // Pixel i covers dot columns 3i..3i+2, bits 23-3i..21-3i
+        for (int shift = 21; shift >= 0; shift -= 6) {
+            uint8_t even = level_[(((s1 >> shift) & 7) << 3) | ((s0 >> shift) & 7)];
+            uint8_t odd = level_[(((s1 >> (shift - 3)) & 7) << 3) | ((s0 >> (shift - 3)) & 7)];
+            *q++ = (uint8_t)((even << 4) | odd);
+        }
+        plane0_[g] = 0;
+        plane1_[g] = 0;
+    }
+    rows_ = 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * PrintPreview.cpp
+ * Live preview of the sticker being printed, on the SSD1327
+ */
+
+#include "PrintPreview.hpp"
+#include "esp_timer.h"
+
+PrintPreview::PrintPreview(SSD1327& oled, const Config& config)
+    : oled_(oled)
+    , config_(config)
+    , lines_(0)
+    , unpushed_(0)
+    , stats_()
+{
+}
+
+void PrintPreview::begin(uint16_t width_bytes, uint16_t height)
+{
+    scaler_.begin(width_bytes, config_.ink_lit);
+    lines_ = 0;
+    unpushed_ = 0;
+    stats_.stickers++;
+    
+    oled_.clear(config_.ink_lit ? 0 : 15);
+    oled_.setStartLine(0);
+    push(false);
+    ESP_LOGD(TAG, "Previewing %ux%u as %u lines", (unsigned)(width_bytes * 8), (unsigned)height,
+             (unsigned)PreviewScaler::previewRows(height));
+}
+
+void PrintPreview::row(const uint8_t* data)
+{
+    int64_t t0 = esp_timer_get_time();
+    if (scaler_.addRow(data, line_buf_)) {
+        addLine();
+        if (unpushed_ >= config_.push_lines) {
+            push(false);
+        }
+    }
+    stats_.rows++;
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    stats_.busy_us += us;
+    if (us > stats_.max_row_us) {
+        stats_.max_row_us = us;
+    }
+}
+
+void PrintPreview::end(bool ok)
+{
+    if (scaler_.flush(line_buf_)) {
+        addLine();
+    }
+    push(true);
+    if (!ok) {
+        ESP_LOGD(TAG, "Sticker cut, preview stops at line %u", (unsigned)lines_);
+    }
+}
+
+void PrintPreview::addLine()
+{
+    oled_.drawRows((int16_t)(lines_ % SSD1327::HEIGHT), 1, line_buf_);
+    lines_++;
+    if (lines_ > (uint32_t)SSD1327::HEIGHT) {
+        // The newest line at the bottom
+        oled_.setStartLine((uint8_t)(lines_ % SSD1327::HEIGHT));
+    }
+    unpushed_++;
+    stats_.lines++;
+}
+
+void PrintPreview::push(bool wait)
+{
+    if (!wait && oled_.isFlushing()) {
+        stats_.skipped++;
+        return;
+    }
+    oled_.display();
+    stats_.pushes++;
+    unpushed_ = 0;
+}
+
+void PrintPreview::logStats() const
+{
+    ESP_LOGI(TAG, "Preview: %u stickers, %u rows -> %u lines, %u pushes (%u put off)",
+             (unsigned)stats_.stickers, (unsigned)stats_.rows, (unsigned)stats_.lines,
+             (unsigned)stats_.pushes, (unsigned)stats_.skipped);
+    ESP_LOGI(TAG, "  decode task: %u us in all, %u us worst row", (unsigned)stats_.busy_us,
+             (unsigned)stats_.max_row_us);
+}
@@ -0,0 +1,226 @@
+/*
+ * PrintProfile.cpp
+ * Heating profiles for raster bands and the print throughput model
+ */
+
+#include "PrintProfile.hpp"
+#include <cmath>
+#include <cstring>
+
+uint32_t PrintProfile::blackDots(const uint8_t* row, uint16_t width_bytes)
+{
+    // A word at a time; rows are 48 bytes on the 58 mm head
+    uint32_t black = 0;
+    uint16_t i = 0;
+    for (; i + 4 <= width_bytes; i += 4) {
+        uint32_t word;
+        memcpy(&word, row + i, 4);
+        black += (uint32_t)__builtin_popcount(word);
+    }
+    for (; i < width_bytes; i++) {
+        black += (uint32_t)__builtin_popcount(row[i]);
+    }
+    return black;
+}
+
+bool PrintProfile::isBlank(const uint8_t* row, uint16_t width_bytes)
+{
+    uint32_t any = 0;
+    uint16_t i = 0;
+    for (; i + 4 <= width_bytes; i += 4) {
+        uint32_t word;
+        memcpy(&word, row + i, 4);
+        any |= word;
+    }
+    for (; i < width_bytes; i++) {
+        any |= row[i];
+    }
+    return any == 0;
+}
+
+void BandLayout::plan(const bool* blank, uint16_t band_rows, uint16_t width_bytes)
+{
+    const uint32_t edge_min = EscPos::FEED_DOTS_LEN / width_bytes + 1;
+    const uint32_t inner_min = (EscPos::FEED_DOTS_LEN + EscPos::RASTER_HEADER_LEN) / width_bytes + 1;
+    span_count = 0;
+    rows = band_rows;
+    lead = 0;
+    trail = 0;
+    blank_rows = 0;
+
+    uint16_t r = 0;
+    while (r < band_rows) {
+        uint16_t end = r + 1;
+        while (end < band_rows && blank[end] == blank[r]) {
+            end++;
+        }
+        uint16_t run = end - r;
+        bool edge = r == 0 || end == band_rows;
+        if (blank[r] && run >= (edge ? edge_min : inner_min)) {
+            if (r == 0) {
+                lead = run;
+            } else if (end == band_rows) {
+                trail = run;
+            }
+            blank_rows += run;
+        } else if (span_count > 0 && spans[span_count - 1].first + spans[span_count - 1].rows == r) {
+            // A short blank run stays in the block, joining both sides
+            spans[span_count - 1].rows += run;
+        } else {
+            spans[span_count++] = {r, run};
+        }
+        r = end;
+    }
+}
+
+ThroughputModel::ThroughputModel(const Config& config, const PrintProfile* fixed)
+    : config_(config)
+    , fixed_(fixed)
+    , current_(&PrintProfiles::POWER_ON)
+    , result_()
+    , byte_us_(10e6 / config.baud)
+    , cpu_us_(0)
+    , wire_free_us_(0)
+    , head_free_us_(0)
+    , band_width_(0)
+    , band_fill_(0)
+    , band_black_()
+    , queued_start_()
+    , queued_bytes_()
+    , queued_count_(0)
+{
+    if (config_.band_rows == 0) {
+        config_.band_rows = 1;
+    } else if (config_.band_rows > MAX_BAND_ROWS) {
+        config_.band_rows = MAX_BAND_ROWS;
+    }
+}
+
+void ThroughputModel::addRow(const uint8_t* row, uint16_t width_bytes)
+{
+    band_width_ = width_bytes;
+    band_blank_[band_fill_] = PrintProfile::isBlank(row, width_bytes);
+    band_black_[band_fill_] = band_blank_[band_fill_] ? 0 : PrintProfile::blackDots(row, width_bytes);
+    band_fill_++;
+    if (band_fill_ == config_.band_rows) {
+        flushBand();
+    }
+}
+
+ThroughputModel::Result ThroughputModel::finish()
+{
+    flushBand();
+    result_.total_us = (int64_t)head_free_us_;
+    return result_;
+}
+
+// As ThermalPrinter::holdUs()
+double ThroughputModel::holdUs(uint32_t bytes)
+{
+    size_t started = 0;
+    while (started < queued_count_ && queued_start_[started] <= cpu_us_) {
+        started++;
+    }
+    uint32_t queued = 0;
+    for (size_t i = started; i < queued_count_; i++) {
+        queued_start_[i - started] = queued_start_[i];
+        queued_bytes_[i - started] = queued_bytes_[i];
+        queued += queued_bytes_[i];
+    }
+    queued_count_ -= started;
+
+    double hold = head_free_us_ - config_.max_ahead_us - cpu_us_;
+    for (size_t i = 0; i < queued_count_ && queued + bytes > config_.buffer_bytes; i++) {
+        queued -= queued_bytes_[i];
+        hold = queued_start_[i] - cpu_us_ > hold ? queued_start_[i] - cpu_us_ : hold;
+    }
+    return hold;
+}
+
+void ThroughputModel::flushBand()
+{
+    if (band_fill_ == 0) {
+        return;
+    }
+    uint32_t densest = 0;
+    for (uint16_t r = 0; r < band_fill_; r++) {
+        densest = band_black_[r] > densest ? band_black_[r] : densest;
+    }
+    const PrintProfile& profile = fixed_ ? *fixed_ : PrintProfiles::select(densest);
+    BandLayout layout;
+    layout.plan(band_blank_, band_fill_, band_width_);
+    uint32_t prefix = 0;
+    if (layout.span_count > 0 && &profile != current_) {
+        prefix = PrintProfile::COMMAND_LEN;
+        current_ = &profile;
+        result_.profile_changes++;
+    }
+    uint32_t bytes = prefix + layout.bytes(band_width_);
+    uint32_t head_us = 0;
+    for (uint16_t r = 0; r < band_fill_; r++) {
+        head_us += profile.lineUs(band_black_[r], config_.motor_us);
+        uint32_t load = profile.load(band_black_[r], config_.motor_us);
+        result_.peak_load = load > result_.peak_load ? load : result_.peak_load;
+    }
+
+    // pace(): hold the write while the head is more than max_ahead behind
+    // or the printer's buffer has no room, sleeping whole ticks
+    double hold = holdUs(bytes);
+    if (hold > 0) {
+        cpu_us_ += std::ceil(hold / config_.tick_us) * config_.tick_us;
+    }
+    // The UART sends back to back. The printer starts each feed and
+    // GS v 0 block once all of it has arrived and the one before is done,
+    // so a leading feed runs while the rows behind it are still on the
+    // wire. A fed blank row takes one motor step, as it would printed.
+    double wire_us = bytes * byte_us_;
+    double sent = wire_free_us_ > cpu_us_ ? wire_free_us_ : cpu_us_;
+    wire_free_us_ = sent + wire_us;
+    uint32_t end = 0;
+    auto run = [&](uint32_t run_bytes, uint16_t first, uint16_t rows) {
+        end += run_bytes;
+        double arrived = sent + end * byte_us_;
+        double start = head_free_us_ > arrived ? head_free_us_ : arrived;
+        head_free_us_ = start;
+        for (uint16_t r = first; r < first + rows; r++) {
+            head_free_us_ += profile.lineUs(band_black_[r], config_.motor_us);
+        }
+        if (queued_count_ == MAX_QUEUED) {
+            queued_start_[MAX_QUEUED - 1] = start;
+            queued_bytes_[MAX_QUEUED - 1] += run_bytes;
+        } else {
+            queued_start_[queued_count_] = start;
+            queued_bytes_[queued_count_++] = run_bytes;
+        }
+    };
+    if (prefix > 0) {
+        run(prefix, 0, 0);
+    }
+    if (layout.lead > 0) {
+        run(EscPos::FEED_DOTS_LEN, 0, layout.lead);
+    }
+    for (uint8_t s = 0; s < layout.span_count; s++) {
+        const BandLayout::Span& span = layout.spans[s];
+        if (s > 0) {
+            uint16_t gap = layout.spans[s - 1].first + layout.spans[s - 1].rows;
+            run(EscPos::FEED_DOTS_LEN, gap, span.first - gap);
+        }
+        run(EscPos::RASTER_HEADER_LEN + (uint32_t)span.rows * band_width_, span.first, span.rows);
+    }
+    if (layout.trail > 0) {
+        run(EscPos::FEED_DOTS_LEN, band_fill_ - layout.trail, layout.trail);
+    }
+    // uart_write_bytes() returns once the tail fits in the TX ring
+    double ring_us = config_.tx_ring_bytes * byte_us_;
+    if (wire_free_us_ - ring_us > cpu_us_) {
+        cpu_us_ = wire_free_us_ - ring_us;
+    }
+
+    result_.rows += band_fill_;
+    result_.bands += layout.span_count;
+    result_.blank_rows += layout.blank_rows;
+    result_.bytes += bytes;
+    result_.wire_us += (int64_t)wire_us;
+    result_.head_us += head_us;
+    band_fill_ = 0;
+}
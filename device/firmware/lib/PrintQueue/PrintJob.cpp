@@ -0,0 +1,178 @@
+/*
+ * PrintJob.cpp
+ * Sequence of printer operations submitted to PrintQueue as one unit
+ */
+
+#include "PrintJob.hpp"
+#include "ThermalPrinter.hpp"
+#include <cstring>
+
+PrintJob::PrintJob()
+    : steps_()
+    , step_count_(0)
+    , text_()
+    , text_used_(0)
+    , owned_()
+    , owned_count_(0)
+    , arena_()
+    , done_(nullptr)
+    , done_ctx_(nullptr)
+    , overflowed_(false)
+{
+}
+
+PrintJob::~PrintJob()
+{
+    clear();
+}
+
+void PrintJob::clear()
+{
+    // Newest first, so a source goes before anything it was built from
+    while (owned_count_ > 0) {
+        Owned& owned = owned_[--owned_count_];
+        owned.destroy(owned.ptr);
+    }
+    arena_.reset();
+    step_count_ = 0;
+    text_used_ = 0;
+    done_ = nullptr;
+    done_ctx_ = nullptr;
+    overflowed_ = false;
+}
+
+PrintJob::Step* PrintJob::addStep(StepType type)
+{
+    if (step_count_ == MAX_STEPS) {
+        overflowed_ = true;
+        return nullptr;
+    }
+    Step* step = &steps_[step_count_++];
+    *step = Step{type, 0, 0, 0, nullptr, nullptr, nullptr, nullptr};
+    return step;
+}
+
+PrintJob& PrintJob::addText(const char* text, bool newline)
+{
+    size_t len = strlen(text);
+    size_t need = len + (newline ? 1 : 0) + 1;
+    if (need > TEXT_BYTES - text_used_) {
+        overflowed_ = true;
+        return *this;
+    }
+    Step* step = addStep(StepType::Text);
+    if (!step) {
+        return *this;
+    }
+    char* out = text_ + text_used_;
+    memcpy(out, text, len);
+    if (newline) {
+        out[len++] = '\n';
+    }
+    out[len] = '\0';
+    step->text = (uint16_t)text_used_;
+    text_used_ += need;
+    return *this;
+}
+
+PrintJob& PrintJob::reset()
+{
+    addStep(StepType::Reset);
+    return *this;
+}
+
+PrintJob& PrintJob::text(const char* text)
+{
+    return addText(text, false);
+}
+
+PrintJob& PrintJob::line(const char* text)
+{
+    return addText(text, true);
+}
+
+PrintJob& PrintJob::feed(uint8_t lines)
+{
+    Step* step = addStep(StepType::Feed);
+    if (step) {
+        step->arg = lines;
+    }
+    return *this;
+}
+
+PrintJob& PrintJob::cut()
+{
+    addStep(StepType::Cut);
+    return *this;
+}
+
+PrintJob& PrintJob::raster(RasterSource* source, uint16_t width_bytes, Progress progress, void* ctx)
+{
+    Step* step = addStep(StepType::Raster);
+    if (step) {
+        step->source = source;
+        step->width_bytes = width_bytes;
+        step->progress = progress;
+        step->progress_ctx = ctx;
+    }
+    return *this;
+}
+
+PrintJob& PrintJob::profile(const PrintProfile* profile)
+{
+    Step* step = addStep(StepType::Profile);
+    if (step) {
+        step->profile = profile;
+    }
+    return *this;
+}
+
+bool PrintJob::run(ThermalPrinter& printer)
+{
+    // The whole job is staged into as few UART writes as the raster
+    // bands allow; a text-only receipt goes out in one
+    const PrintProfile* profile = printer.getProfile();
+    printer.beginBatch();
+    bool ok = runSteps(printer);
+    printer.endBatch();
+    printer.setProfile(profile);
+    return ok;
+}
+
+bool PrintJob::runSteps(ThermalPrinter& printer)
+{
+    for (size_t i = 0; i < step_count_; i++) {
+        const Step& step = steps_[i];
+        switch (step.type) {
+        case StepType::Reset:
+            printer.reset();
+            break;
+        case StepType::Text:
+            printer.printText(text_ + step.text);
+            break;
+        case StepType::Feed:
+            printer.feedLines(step.arg);
+            break;
+        case StepType::Cut:
+            printer.cutPaper();
+            break;
+        case StepType::Profile:
+            printer.setProfile(step.profile);
+            break;
+        case StepType::Raster:
+            if (!step.source
+                || !printer.printRaster(*step.source, step.width_bytes, step.progress, step.progress_ctx)) {
+                return false;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+void PrintJob::complete(uint32_t job_id, bool ok)
+{
+    if (done_) {
+        done_(job_id, ok, done_ctx_);
+    }
+}
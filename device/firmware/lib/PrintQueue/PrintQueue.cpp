@@ -0,0 +1,147 @@
+/*
+ * PrintQueue.cpp
+ * Asynchronous print job queue drained by a printer-owned FreeRTOS task
+ */
+
+#include "PrintQueue.hpp"
+#include "MemoryBudget.hpp"
+#include "Trace.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+PrintQueue::PrintQueue(ThermalPrinter& printer, UBaseType_t depth)
+    : printer_(printer)
+    , depth_(depth > MAX_DEPTH ? MAX_DEPTH : depth)
+    , job_count_(depth_ + 2)
+    , arena_block_(nullptr)
+    , job_queue_(nullptr)
+    , queue_buffer_()
+    , task_handle_(nullptr)
+    , next_id_(1)
+{
+    for (std::atomic<bool>& taken : taken_) {
+        taken = false;
+    }
+}
+
+PrintQueue::~PrintQueue()
+{
+    if (task_handle_) {
+        vTaskDelete(task_handle_);
+    }
+    if (job_queue_) {
+        Entry entry;
+        while (xQueueReceive(job_queue_, &entry, 0) == pdTRUE) {
+            release(entry.job);
+        }
+        vQueueDelete(job_queue_);
+    }
+    // Sources live in the arenas: destroy them before the block goes
+    for (PrintJob& job : jobs_) {
+        job.clear();
+    }
+    heap_caps_free(arena_block_);
+}
+
+bool PrintQueue::begin(const TaskSpec& task)
+{
+    // Sources are read on the printer task, one row at a time: internal RAM
+    arena_block_ = (uint8_t*)MemoryBudget::reserve("print jobs", job_count_ * PrintJob::ARENA_BYTES, false);
+    if (!arena_block_) {
+        return false;
+    }
+    for (size_t i = 0; i < job_count_; i++) {
+        jobs_[i].arena().init(arena_block_ + i * PrintJob::ARENA_BYTES, PrintJob::ARENA_BYTES);
+    }
+    
+    job_queue_ = xQueueCreateStatic(depth_, sizeof(Entry), queue_storage_, &queue_buffer_);
+    if (!job_queue_) {
+        ESP_LOGE(TAG, "Failed to create job queue");
+        return false;
+    }
+    
+    task_handle_ = task_storage_.start(taskEntry, this, task);
+    if (!task_handle_) {
+        ESP_LOGE(TAG, "Failed to create printer task");
+        vQueueDelete(job_queue_);
+        job_queue_ = nullptr;
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "Printer task started (depth=%u, %u jobs)", (unsigned)depth_, (unsigned)job_count_);
+    return true;
+}
+
+PrintJob* PrintQueue::acquire()
+{
+    if (!job_queue_) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < job_count_; i++) {
+        bool taken = false;
+        if (taken_[i].compare_exchange_strong(taken, true)) {
+            return &jobs_[i];
+        }
+    }
+    ESP_LOGW(TAG, "Every job is in use");
+    return nullptr;
+}
+
+void PrintQueue::release(PrintJob* job)
+{
+    job->clear();
+    taken_[job - jobs_] = false;
+}
+
+uint32_t PrintQueue::submit(PrintJob* job)
+{
+    if (!job) {
+        return 0;
+    }
+    if (job->overflowed()) {
+        ESP_LOGW(TAG, "Job over its step, text or arena limits, rejected");
+        release(job);
+        return 0;
+    }
+    
+    Entry entry = { next_id_.fetch_add(1), job };
+    if (xQueueSend(job_queue_, &entry, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Queue full, job rejected");
+        release(job);
+        return 0;
+    }
+    
+    TRACE_INSTANT("job_submit", (int32_t)entry.id);
+    TRACE_COUNTER("print_queue", pending());
+    return entry.id;
+}
+
+UBaseType_t PrintQueue::pending() const
+{
+    return job_queue_ ? uxQueueMessagesWaiting(job_queue_) : 0;
+}
+
+void PrintQueue::taskEntry(void* arg)
+{
+    static_cast<PrintQueue*>(arg)->task();
+}
+
+void PrintQueue::task()
+{
+    Entry entry;
+    
+    while (xQueueReceive(job_queue_, &entry, portMAX_DELAY)) {
+        ESP_LOGI(TAG, "Job %u started (%u queued)", (unsigned)entry.id, (unsigned)pending());
+        TRACE_BEGIN("print_job", (int32_t)entry.id);
+        
+        bool ok = entry.job->run(printer_);
+        // Completion fires when the driver reports the TX FIFO empty,
+        // not after a guessed delay
+        ok = printer_.waitTxDone() && ok;
+        TRACE_END("print_job");
+        
+        ESP_LOGI(TAG, "Job %u %s", (unsigned)entry.id, ok ? "done" : "failed");
+        entry.job->complete(entry.id, ok);
+        release(entry.job);
+    }
+}
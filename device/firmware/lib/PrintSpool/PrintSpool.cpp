@@ -0,0 +1,555 @@
+/*
+ * PrintSpool.cpp
+ * Log-structured print spool on a raw flash partition
+ */
+
+#include "PrintSpool.hpp"
+#include "Trace.hpp"
+#include "esp_log.h"
+#include <cstddef>
+#include <cstring>
+
+PrintSpool::PrintSpool()
+    : partition_(nullptr)
+    , sectors_(0)
+    , head_(0)
+    , next_seq_(1)
+    , lock_(nullptr)
+    , lock_storage_()
+    , entries_()
+    , count_(0)
+    , stats_()
+    , marks_(nullptr)
+    , marks_buffer_()
+    , task_handle_(nullptr)
+    , marks_dropped_(0)
+    , open_(false)
+    , open_seq_(0)
+    , open_first_(0)
+    , open_sectors_(0)
+    , open_len_(0)
+    , open_crc_(0)
+    , page_fill_(0)
+{
+}
+
+PrintSpool::~PrintSpool()
+{
+    if (task_handle_) {
+        vTaskDelete(task_handle_);
+    }
+    if (marks_) {
+        vQueueDelete(marks_);
+    }
+    if (lock_) {
+        vSemaphoreDelete(lock_);
+    }
+}
+
+bool PrintSpool::begin(const char* label, const TaskSpec& task)
+{
+    partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!partition_) {
+        ESP_LOGE(TAG, "No \"%s\" partition (see partitions.csv)", label);
+        return false;
+    }
+    size_t sectors = partition_->size / SECTOR_SIZE;
+    if (sectors < 4 || sectors > UINT16_MAX) {
+        ESP_LOGE(TAG, "Unusable partition size: %u bytes", (unsigned)partition_->size);
+        partition_ = nullptr;
+        return false;
+    }
+    sectors_ = (uint16_t)sectors;
+    
+    lock_ = xSemaphoreCreateMutexStatic(&lock_storage_);
+    scan();
+    
+    marks_ = xQueueCreateStatic(MARK_QUEUE_DEPTH, sizeof(Mark), marks_storage_, &marks_buffer_);
+    if (!marks_) {
+        ESP_LOGE(TAG, "Failed to create mark queue");
+        return false;
+    }
+    task_handle_ = task_storage_.start(taskEntry, this, task);
+    if (!task_handle_) {
+        ESP_LOGE(TAG, "Failed to create spool task");
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "%u KB in %u sectors, %u pending, %u discarded, head at sector %u",
+             (unsigned)(capacity() / 1024), (unsigned)sectors_, (unsigned)count_,
+             (unsigned)stats_.discarded, (unsigned)head_);
+    return true;
+}
+
+void PrintSpool::scan()
+{
+    // Every record starts on a sector boundary, so reading one header per
+    // sector finds them all. The newest committed record ends at the head;
+    // unprinted ones are indexed oldest first.
+    count_ = 0;
+    head_ = 0;
+    uint32_t max_seq = 0;
+    uint32_t head_seq = 0;
+    
+    for (uint16_t s = 0; s < sectors_; s++) {
+        RecordHeader h;
+        if (esp_partition_read(partition_, (size_t)s * SECTOR_SIZE, &h, sizeof(h)) != ESP_OK) {
+            continue;
+        }
+        if (h.magic != MAGIC || crc32(0, &h.magic, 8) != h.header_crc) {
+            continue;
+        }
+        if (h.seq > max_seq) {
+            max_seq = h.seq;
+        }
+        if (h.commit_crc != crc32(0, &h.length, 8)) {
+            // Cut off before commit; its sectors are reused from the head
+            stats_.discarded++;
+            continue;
+        }
+        
+        Entry entry = {h.seq, h.length, s, sectorsFor(h.length), countMarks(h.progress), h.done == 0};
+        if (h.seq > head_seq) {
+            head_seq = h.seq;
+            head_ = (uint16_t)((s + entry.sectors) % sectors_);
+        }
+        if (entry.done) {
+            continue;
+        }
+        if (!verify(entry, h.data_crc)) {
+            ESP_LOGW(TAG, "Record %u fails its CRC, dropped", (unsigned)h.seq);
+            stats_.discarded++;
+            continue;
+        }
+        if (count_ == MAX_RECORDS) {
+            ESP_LOGW(TAG, "Index full, record %u not resumed", (unsigned)h.seq);
+            continue;
+        }
+        
+        // Insertion by sequence number: the ring may have wrapped
+        size_t i = count_++;
+        while (i > 0 && entries_[i - 1].seq > entry.seq) {
+            entries_[i] = entries_[i - 1];
+            i--;
+        }
+        entries_[i] = entry;
+    }
+    next_seq_ = max_seq + 1;
+}
+
+bool PrintSpool::verify(const Entry& entry, uint32_t crc) const
+{
+    Record record = {entry.seq, entry.length, payloadOffset(entry.first_sector, 0), 0};
+    uint8_t buf[PAGE_SIZE];
+    uint32_t actual = 0;
+    for (uint32_t pos = 0; pos < entry.length; pos += sizeof(buf)) {
+        size_t n = entry.length - pos < sizeof(buf) ? entry.length - pos : sizeof(buf);
+        if (!read(record, pos, buf, n)) {
+            return false;
+        }
+        actual = crc32(actual, buf, n);
+    }
+    return actual == crc;
+}
+
+uint32_t PrintSpool::payloadOffset(uint16_t first_sector, uint32_t pos) const
+{
+    return (uint32_t)(((size_t)first_sector * SECTOR_SIZE + HEADER_SIZE + pos) % capacity());
+}
+
+uint16_t PrintSpool::sectorsFor(uint32_t length) const
+{
+    return (uint16_t)((HEADER_SIZE + length + SECTOR_SIZE - 1) / SECTOR_SIZE);
+}
+
+// Lock held. Sectors from the oldest unprinted record up to the head.
+uint16_t PrintSpool::usedSectors() const
+{
+    if (count_ == 0) {
+        return 0;
+    }
+    return (uint16_t)((head_ + sectors_ - entries_[0].first_sector) % sectors_);
+}
+
+size_t PrintSpool::freeBytes() const
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    size_t used = usedSectors() + open_sectors_ + 1;
+    xSemaphoreGive(lock_);
+    return used < sectors_ ? (sectors_ - used) * SECTOR_SIZE : 0;
+}
+
+PrintSpool::Stats PrintSpool::getStats() const
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    Stats stats = stats_;
+    xSemaphoreGive(lock_);
+    stats.marks_dropped = marks_dropped_.load();
+    return stats;
+}
+
+bool PrintSpool::takeSector(uint16_t sector)
+{
+    // One sector always stays free, so a full ring can't look empty
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool room = usedSectors() + open_sectors_ + 1 < sectors_;
+    xSemaphoreGive(lock_);
+    if (!room) {
+        ESP_LOGW(TAG, "Spool full");
+        return false;
+    }
+    
+    TRACE_SCOPE("spool_erase", sector);
+    esp_err_t err = esp_partition_erase_range(partition_, (size_t)sector * SECTOR_SIZE, SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erase of sector %u failed: %s", (unsigned)sector, esp_err_to_name(err));
+        return false;
+    }
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    stats_.erases++;
+    xSemaphoreGive(lock_);
+    open_sectors_++;
+    return true;
+}
+
+bool PrintSpool::program(uint32_t offset, const void* data, size_t len)
+{
+    esp_err_t err = esp_partition_write(partition_, offset, data, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write at 0x%x failed: %s", (unsigned)offset, esp_err_to_name(err));
+        return false;
+    }
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    stats_.programs++;
+    xSemaphoreGive(lock_);
+    return true;
+}
+
+bool PrintSpool::open()
+{
+    if (!partition_ || open_) {
+        return false;
+    }
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool index_full = count_ == MAX_RECORDS;
+    uint16_t first = head_;
+    xSemaphoreGive(lock_);
+    if (index_full) {
+        ESP_LOGW(TAG, "Too many unprinted records");
+        return false;
+    }
+    
+    open_first_ = first;
+    open_sectors_ = 0;
+    open_len_ = 0;
+    open_crc_ = 0;
+    page_fill_ = 0;
+    open_seq_ = next_seq_++;
+    if (!takeSector(open_first_)) {
+        return false;
+    }
+    
+    uint32_t header[3] = {MAGIC, open_seq_, 0};
+    header[2] = crc32(0, header, 8);
+    if (!program((uint32_t)open_first_ * SECTOR_SIZE, header, sizeof(header))) {
+        open_sectors_ = 0;
+        return false;
+    }
+    open_ = true;
+    return true;
+}
+
+bool PrintSpool::write(const uint8_t* data, size_t len)
+{
+    if (!open_) {
+        return false;
+    }
+    
+    // Collect whole flash pages so each one is programmed once
+    while (len > 0) {
+        uint32_t page_start = payloadOffset(open_first_, open_len_ - page_fill_);
+        size_t page_room = PAGE_SIZE - page_start % PAGE_SIZE;
+        size_t n = page_room - page_fill_;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(page_buf_ + page_fill_, data, n);
+        open_crc_ = crc32(open_crc_, data, n);
+        page_fill_ += n;
+        open_len_ += n;
+        data += n;
+        len -= n;
+        if (page_fill_ == page_room && !flushPage()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PrintSpool::flushPage()
+{
+    if (page_fill_ == 0) {
+        return true;
+    }
+    uint32_t start = payloadOffset(open_first_, open_len_ - page_fill_);
+    if (start % SECTOR_SIZE == 0 && !takeSector((uint16_t)(start / SECTOR_SIZE))) {
+        return false;
+    }
+    if (!program(start, page_buf_, page_fill_)) {
+        return false;
+    }
+    page_fill_ = 0;
+    return true;
+}
+
+uint32_t PrintSpool::commit()
+{
+    if (!open_) {
+        return 0;
+    }
+    
+    // The commit block goes last: until it is on flash the record doesn't exist
+    uint32_t block[3] = {open_len_, open_crc_, 0};
+    block[2] = crc32(0, block, 8);
+    if (!flushPage()
+        || !program((uint32_t)open_first_ * SECTOR_SIZE + offsetof(RecordHeader, length),
+                    block, sizeof(block))) {
+        abort();
+        return 0;
+    }
+    
+    Entry entry = {open_seq_, open_len_, open_first_, sectorsFor(open_len_), 0, false};
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    entries_[count_++] = entry;
+    head_ = (uint16_t)((open_first_ + entry.sectors) % sectors_);
+    stats_.records++;
+    stats_.bytes += open_len_;
+    xSemaphoreGive(lock_);
+    
+    open_ = false;
+    open_sectors_ = 0;
+    ESP_LOGI(TAG, "Record %u: %u bytes in %u sectors", (unsigned)open_seq_,
+             (unsigned)open_len_, (unsigned)entry.sectors);
+    return open_seq_;
+}
+
+void PrintSpool::abort()
+{
+    // Whatever was written stays uncommitted and is erased on reuse
+    open_ = false;
+    open_sectors_ = 0;
+    page_fill_ = 0;
+}
+
+size_t PrintSpool::pending(Record* out, size_t max) const
+{
+    size_t n = 0;
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    for (size_t i = 0; i < count_ && n < max; i++) {
+        const Entry& entry = entries_[i];
+        if (!entry.done) {
+            out[n++] = {entry.seq, entry.length, payloadOffset(entry.first_sector, 0),
+                        (uint32_t)entry.marks * MARK_ROWS};
+        }
+    }
+    xSemaphoreGive(lock_);
+    return n;
+}
+
+bool PrintSpool::find(uint32_t id, Record* out) const
+{
+    bool found = false;
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    for (size_t i = 0; i < count_ && !found; i++) {
+        const Entry& entry = entries_[i];
+        if (entry.seq == id && !entry.done) {
+            *out = {entry.seq, entry.length, payloadOffset(entry.first_sector, 0),
+                    (uint32_t)entry.marks * MARK_ROWS};
+            found = true;
+        }
+    }
+    xSemaphoreGive(lock_);
+    return found;
+}
+
+bool PrintSpool::read(const Record& record, uint32_t pos, uint8_t* buf, size_t len) const
+{
+    size_t offset = (record.offset + pos) % capacity();
+    size_t first = capacity() - offset < len ? capacity() - offset : len;
+    if (esp_partition_read(partition_, offset, buf, first) != ESP_OK) {
+        return false;
+    }
+    return first == len || esp_partition_read(partition_, 0, buf + first, len - first) == ESP_OK;
+}
+
+bool PrintSpool::markPrinted(uint32_t id, uint32_t rows)
+{
+    Mark mark = {id, rows == UINT32_MAX ? UINT32_MAX - 1 : rows};
+    if (!marks_ || xQueueSend(marks_, &mark, 0) != pdTRUE) {
+        marks_dropped_.fetch_add(1);
+        return false;
+    }
+    return true;
+}
+
+bool PrintSpool::markDone(uint32_t id)
+{
+    Mark mark = {id, UINT32_MAX};
+    if (!marks_ || xQueueSend(marks_, &mark, 0) != pdTRUE) {
+        marks_dropped_.fetch_add(1);
+        return false;
+    }
+    return true;
+}
+
+void PrintSpool::taskEntry(void* arg)
+{
+    static_cast<PrintSpool*>(arg)->task();
+}
+
+void PrintSpool::task()
+{
+    Mark mark;
+    while (true) {
+        if (xQueueReceive(marks_, &mark, portMAX_DELAY) == pdTRUE) {
+            applyMark(mark);
+        }
+    }
+}
+
+void PrintSpool::applyMark(const Mark& mark)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    Entry* entry = nullptr;
+    for (size_t i = 0; i < count_; i++) {
+        if (entries_[i].seq == mark.seq) {
+            entry = &entries_[i];
+            break;
+        }
+    }
+    bool skip = !entry || entry->done;
+    uint16_t first = skip ? 0 : entry->first_sector;
+    uint16_t marks = skip ? 0 : entry->marks;
+    xSemaphoreGive(lock_);
+    if (skip) {
+        return;
+    }
+    uint32_t base = (uint32_t)first * SECTOR_SIZE;
+    
+    if (mark.rows == UINT32_MAX) {
+        uint32_t zero = 0;
+        if (!program(base + offsetof(RecordHeader, done), &zero, sizeof(zero))) {
+            return;
+        }
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        entry->done = true;
+        stats_.marks++;
+        prune();
+        xSemaphoreGive(lock_);
+        return;
+    }
+    
+    // Thermometer code: clear the bits for the new marks, lowest first
+    uint32_t target = mark.rows / MARK_ROWS;
+    if (target > PROGRESS_BYTES * 8) {
+        target = PROGRESS_BYTES * 8;
+    }
+    if (target <= marks) {
+        return;
+    }
+    size_t from = marks / 8;
+    size_t to = (target + 7) / 8;
+    uint8_t bytes[PROGRESS_BYTES];
+    for (size_t i = from; i < to; i++) {
+        bytes[i - from] = i < target / 8 ? 0x00 : (uint8_t)(0xFF << (target % 8));
+    }
+    if (!program(base + offsetof(RecordHeader, progress) + from, bytes, to - from)) {
+        return;
+    }
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    entry->marks = (uint16_t)target;
+    stats_.marks++;
+    xSemaphoreGive(lock_);
+}
+
+// Lock held. Printed records at the tail free their sectors.
+void PrintSpool::prune()
+{
+    size_t drop = 0;
+    while (drop < count_ && entries_[drop].done) {
+        drop++;
+    }
+    if (drop == 0) {
+        return;
+    }
+    memmove(entries_, entries_ + drop, (count_ - drop) * sizeof(Entry));
+    count_ -= drop;
+}
+
+uint16_t PrintSpool::countMarks(const uint8_t* progress)
+{
+    uint16_t marks = 0;
+    for (size_t i = 0; i < PROGRESS_BYTES; i++) {
+        uint8_t b = progress[i];
+        if (b != 0) {
+            while (!(b & 1)) {
+                marks++;
+                b >>= 1;
+            }
+            break;
+        }
+        marks += 8;
+    }
+    return marks;
+}
+
+// CRC-32 (IEEE, as zlib), one nibble at a time to keep the table small
+uint32_t PrintSpool::crc32(uint32_t crc, const void* data, size_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+SpoolSource::SpoolSource(const PrintSpool& spool, const PrintSpool::Record& record)
+    : record_(record)
+    , reader_(spool, record_)
+    , decoder_()
+{
+}
+
+bool SpoolSource::begin()
+{
+    if (!decoder_.begin(reader_)) {
+        return false;
+    }
+    uint8_t row[RasterDecoder::MAX_WIDTH_BYTES];
+    for (uint32_t r = 0; r < record_.resume_row; r++) {
+        if (!decoder_.readRow(row)) {
+            return !decoder_.failed();
+        }
+    }
+    return true;
+}
+
+size_t SpoolReader::read(uint8_t* buf, size_t max)
+{
+    size_t n = record_.length - pos_;
+    if (n > max) {
+        n = max;
+    }
+    if (n == 0 || !spool_.read(record_, pos_, buf, n)) {
+        return 0;
+    }
+    pos_ += n;
+    return n;
+}
@@ -0,0 +1,132 @@
+/*
+ * RasterDecoder.cpp
+ * Streaming decoder for the PVR1 compressed raster format
+ */
+
+#include "RasterDecoder.hpp"
+#include <cstring>
+
+RasterDecoder::RasterDecoder()
+    : source_(nullptr)
+    , width_bytes_(0)
+    , height_(0)
+    , row_(0)
+    , repeat_left_(0)
+    , failed_(false)
+    , in_pos_(0)
+    , in_len_(0)
+{
+}
+
+bool RasterDecoder::begin(ByteSource& source)
+{
+    source_ = &source;
+    width_bytes_ = 0;
+    height_ = 0;
+    row_ = 0;
+    repeat_left_ = 0;
+    failed_ = true;
+    in_pos_ = 0;
+    in_len_ = 0;
+    memset(prev_, 0, sizeof(prev_));
+
+    uint8_t header[8];
+    for (uint8_t& b : header) {
+        if (!readByte(&b)) {
+            return false;
+        }
+    }
+    if (memcmp(header, "PVR1", 4) != 0) {
+        return false;
+    }
+
+    width_bytes_ = header[4] | (header[5] << 8);
+    height_ = header[6] | (header[7] << 8);
+    if (width_bytes_ == 0 || width_bytes_ > MAX_WIDTH_BYTES) {
+        return false;
+    }
+
+    failed_ = false;
+    return true;
+}
+
+bool RasterDecoder::readByte(uint8_t* b)
+{
+    if (in_pos_ == in_len_) {
+        in_len_ = source_->read(in_buf_, sizeof(in_buf_));
+        in_pos_ = 0;
+        if (in_len_ == 0) {
+            return false;
+        }
+    }
+    *b = in_buf_[in_pos_++];
+    return true;
+}
+
+bool RasterDecoder::decodeLiteral()
+{
+    // PackBits: n < 128 -> n+1 literal bytes, n > 128 -> repeat next byte
+    // 257-n times, n == 128 -> no-op. Runs may not cross the row end.
+    uint16_t x = 0;
+    while (x < width_bytes_) {
+        uint8_t n;
+        if (!readByte(&n)) {
+            return false;
+        }
+        if (n < 128) {
+            uint16_t count = n + 1;
+            if (x + count > width_bytes_) {
+                return false;
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                if (!readByte(&prev_[x++])) {
+                    return false;
+                }
+            }
+        } else if (n > 128) {
+            uint16_t count = 257 - n;
+            uint8_t value;
+            if (x + count > width_bytes_ || !readByte(&value)) {
+                return false;
+            }
+            memset(prev_ + x, value, count);
+            x += count;
+        }
+    }
+    return true;
+}
+
+bool RasterDecoder::readRow(uint8_t* row)
+{
+    if (failed_ || !source_ || row_ >= height_) {
+        return false;
+    }
+
+    if (repeat_left_ == 0) {
+        uint8_t op;
+        if (!readByte(&op)) {
+            failed_ = true;
+            return false;
+        }
+        if (op == OP_LITERAL) {
+            if (!decodeLiteral()) {
+                failed_ = true;
+                return false;
+            }
+            repeat_left_ = 1;
+        } else if (op & OP_REPEAT) {
+            repeat_left_ = (op & 0x7F) + 1;
+        } else if (op & OP_BLANK) {
+            memset(prev_, 0, width_bytes_);
+            repeat_left_ = (op & 0x3F) + 1;
+        } else {
+            failed_ = true;  // Reserved opcode
+            return false;
+        }
+    }
+
+    memcpy(row, prev_, width_bytes_);
+    repeat_left_--;
+    row_++;
+    return true;
+}
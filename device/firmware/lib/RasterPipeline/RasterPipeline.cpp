@@ -0,0 +1,767 @@
+/*
+ * RasterPipeline.cpp
+ * Streaming gray/RGB/RGBA -> 1-bpp printer rows (resize, pixelate, dither)
+ */
+
+#include "RasterPipeline.hpp"
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RASTER_SIMD 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RASTER_SIMD 1
+#else
+#define RASTER_SIMD 0
+#endif
+
+namespace {
+
+// Pillow's fixed-point resampling precision (Resample.c)
+constexpr int PRECISION_BITS = 32 - 8 - 2;
+constexpr double LANCZOS_SUPPORT = 3.0;
+
+double sinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x = x * M_PI;
+    return sin(x) / x;
+}
+
+double lanczos(double x)
+{
+    if (-3.0 <= x && x < 3.0) {
+        return sinc(x) * sinc(x / 3);
+    }
+    return 0.0;
+}
+
+double filterScale(uint16_t in_size, uint16_t out_size)
+{
+    double scale = (double)in_size / out_size;
+    return scale < 1.0 ? 1.0 : scale;
+}
+
+uint16_t kernelSize(uint16_t in_size, uint16_t out_size)
+{
+    double support = LANCZOS_SUPPORT * filterScale(in_size, out_size);
+    return (uint16_t)((int)ceil(support) * 2 + 1);
+}
+
+// Taps for output sample `xx`, as Pillow's precompute_coeffs() and
+// normalize_coeffs_8bpc() compute them. `work` holds ksize doubles.
+void computeTaps(uint16_t in_size, uint16_t out_size, int xx, double* work,
+                 int32_t* coeffs, int* first, int* count)
+{
+    double scale = (double)in_size / out_size;
+    double filterscale = scale < 1.0 ? 1.0 : scale;
+    double support = LANCZOS_SUPPORT * filterscale;
+    double center = (xx + 0.5) * scale;
+    double ss = 1.0 / filterscale;
+
+    int xmin = (int)(center - support + 0.5);
+    if (xmin < 0) {
+        xmin = 0;
+    }
+    int xmax = (int)(center + support + 0.5);
+    if (xmax > in_size) {
+        xmax = in_size;
+    }
+    xmax -= xmin;
+
+    double ww = 0.0;
+    for (int x = 0; x < xmax; x++) {
+        double w = lanczos((x + xmin - center + 0.5) * ss);
+        work[x] = w;
+        ww += w;
+    }
+    for (int x = 0; x < xmax; x++) {
+        double k = ww != 0.0 ? work[x] / ww : work[x];
+        coeffs[x] = k < 0 ? (int32_t)(-0.5 + k * (1 << PRECISION_BITS))
+                          : (int32_t)(0.5 + k * (1 << PRECISION_BITS));
+    }
+
+    *first = xmin;
+    *count = xmax;
+}
+
+inline uint8_t clip8(int32_t acc)
+{
+    int32_t v = acc >> PRECISION_BITS;
+    return v < 0 ? 0 : v > 255 ? 255 : (uint8_t)v;
+}
+
+#if RASTER_SIMD
+// Eight 32-bit lanes: one AVX2 register, two NEON q registers. The math
+// uses GCC/Clang vector extensions, which lower to either; widening and
+// narrowing use the intrinsics, which the generic conversions don't.
+typedef int32_t Lanes __attribute__((vector_size(32)));
+typedef uint32_t Words __attribute__((vector_size(32)));
+
+// Widen 8 pixels to 32 bits
+inline Lanes loadPixels(const uint8_t* p)
+{
+#if defined(__AVX2__)
+    return (Lanes)_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+#else
+    uint16x8_t wide = vmovl_u8(vld1_u8(p));
+    uint32x4_t lo = vmovl_u16(vget_low_u16(wide));
+    uint32x4_t hi = vmovl_u16(vget_high_u16(wide));
+    Lanes v;
+    memcpy(&v, &lo, sizeof(lo));
+    memcpy((uint8_t*)&v + sizeof(lo), &hi, sizeof(hi));
+    return v;
+#endif
+}
+
+inline Lanes loadLanes(const int32_t* p)
+{
+    Lanes v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline int32_t sumLanes(Lanes v)
+{
+    return v[0] + v[1] + v[2] + v[3] + v[4] + v[5] + v[6] + v[7];
+}
+
+// clip8() of 8 sums: the saturating narrows do the clamping
+inline void storeClipped(Lanes acc, uint8_t* out)
+{
+    Lanes v = acc >> PRECISION_BITS;
+#if defined(__AVX2__)
+    __m256i w = (__m256i)v;
+    __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1));
+    _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(words, words));
+#else
+    int32x4_t lo;
+    int32x4_t hi;
+    memcpy(&lo, &v, sizeof(lo));
+    memcpy(&hi, (const uint8_t*)&v + sizeof(lo), sizeof(hi));
+    vst1_u8(out, vqmovn_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi))));
+#endif
+}
+#endif
+
+// SIMD loads read up to this many bytes past the last pixel used
+constexpr size_t ROW_PAD = 8;
+
+size_t padTo(size_t n, size_t multiple)
+{
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+// Pillow's ImagingAlphaComposite() over an opaque white background
+// (7 fractional bits, rounded division by 255)
+inline uint8_t overWhite(uint8_t c, uint8_t a)
+{
+    uint32_t t = ((uint32_t)c * a + 255u * (255u - a)) * 128u + 0x4000u;
+    return (uint8_t)(((t >> 8) + t) >> 15);
+}
+
+// Pillow's rgb2l(): ITU-R 601-2 luma in 16-bit fixed point
+inline uint8_t luma(const uint8_t* rgb)
+{
+    return (uint8_t)((rgb[0] * 19595u + rgb[1] * 38470u + rgb[2] * 7471u + 0x8000u) >> 16);
+}
+
+// Standard 8x8 Bayer index matrix (0..63)
+const uint8_t BAYER8[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+// Pillow's NEAREST resize (ImagingScaleAffine): sample at pixel centers,
+// stepping the source position by accumulation like the C code does.
+void nearestMap(uint16_t in_size, uint16_t out_size, uint16_t* map)
+{
+    double scale = (double)in_size / out_size;
+    double pos = scale * 0.5;
+    for (uint16_t i = 0; i < out_size; i++) {
+        int v = pos < 0.0 ? -1 : (int)pos;
+        map[i] = (uint16_t)(v < 0 ? 0 : v >= in_size ? in_size - 1 : v);
+        pos += scale;
+    }
+}
+
+template <typename T>
+T* allocate(Arena* arena, size_t count, size_t* total)
+{
+    T* p = Arena::allocateFrom<T>(arena, count);
+    if (p) {
+        *total += count * sizeof(T);
+    }
+    return p;
+}
+
+}  // namespace
+
+RasterPipeline::RasterPipeline()
+    : source_(nullptr)
+    , config_{}
+    , out_width_(0)
+    , out_height_(0)
+    , out_row_(0)
+    , memory_used_(0)
+    , arena_(nullptr)
+    , buffers_arena_(nullptr)
+    , resized_width_(0)
+    , resized_height_(0)
+    , x_map_(nullptr)
+    , y_map_(nullptr)
+    , pixel_bytes_(1)
+    , col_count_(0)
+    , cols_(nullptr)
+    , row_bytes_(0)
+    , need_horizontal_(false)
+    , need_vertical_(false)
+    , h_ksize_(0)
+    , h_stride_(0)
+    , v_ksize_(0)
+    , h_coeffs_(nullptr)
+    , h_bounds_(nullptr)
+    , v_coeffs_(nullptr)
+    , v_work_(nullptr)
+    , ring_(nullptr)
+    , ring_next_(0)
+    , resized_row_(nullptr)
+    , resized_index_(-1)
+    , source_row_(nullptr)
+    , in_row_(nullptr)
+    , errors_(nullptr)
+    , gray_row_(nullptr)
+    , dots_(nullptr)
+    , dither_row_(nullptr)
+{
+}
+
+RasterPipeline::~RasterPipeline()
+{
+    end();
+}
+
+uint16_t RasterPipeline::scaledHeight(uint16_t width, uint16_t height, uint16_t target_width)
+{
+    // max(1, int(round(h * (target / w)))) - Python rounds half to even
+    double h = nearbyint((double)height * ((double)target_width / width));
+    return h < 1.0 ? 1 : (uint16_t)h;
+}
+
+template <>
+void RasterPipeline::ditherRow<RasterPipeline::Dither::FloydSteinberg>(const uint8_t* gray, uint8_t* dots)
+{
+    // Pillow's tobilevel(): Floyd-Steinberg with 7/3/5/1 weights kept in
+    // 1/16 units. A single error row plus three carries replaces the
+    // usual two-row buffer.
+    int l = 0;
+    int l0 = 0;
+    int l1 = 0;
+    uint16_t x;
+
+    for (x = 0; x < out_width_; x++) {
+        l = gray[x] + (l + errors_[x + 1]) / 16;
+        l = l <= 0 ? 0 : l < 256 ? l : 255;
+
+        int out = l > 128 ? 255 : 0;
+        dots[x] = out == 0;
+
+        l -= out;
+        int l2 = l;
+        int d2 = l + l;
+        l += d2;
+        errors_[x] = (int16_t)(l + l0);
+        l += d2;
+        l0 = l + l1;
+        l1 = l2;
+        l += d2;
+    }
+    errors_[x] = (int16_t)l0;
+}
+
+template <>
+void RasterPipeline::ditherRow<RasterPipeline::Dither::Ordered>(const uint8_t* gray, uint8_t* dots)
+{
+    // Black below 4 * m + 2 (2..254): 0 is always black, 255 never, and
+    // mid gray gets every other dot
+    const uint8_t* m = BAYER8[out_row_ & 7];
+    uint8_t threshold[8];
+    for (int i = 0; i < 8; i++) {
+        threshold[i] = (uint8_t)(4 * m[i] + 2);
+    }
+    for (uint16_t x = 0; x < out_width_; x++) {
+        dots[x] = gray[x] < threshold[x & 7];
+    }
+}
+
+template <>
+void RasterPipeline::ditherRow<RasterPipeline::Dither::Atkinson>(const uint8_t* gray, uint8_t* dots)
+{
+    // 1/8 of the error each to x+1, x+2 on this row, x-1, x, x+1 on the
+    // next and x on the one after. Rows are out_width + 3 long: one slot
+    // left of x = 0, two right of the end.
+    size_t stride = (size_t)out_width_ + 3;
+    int16_t* cur = errors_ + (size_t)(out_row_ % 3) * stride + 1;
+    int16_t* next = errors_ + (size_t)((out_row_ + 1) % 3) * stride + 1;
+    int16_t* after = errors_ + (size_t)((out_row_ + 2) % 3) * stride + 1;
+
+    for (uint16_t x = 0; x < out_width_; x++) {
+        int l = gray[x] + cur[x];
+        l = l <= 0 ? 0 : l < 256 ? l : 255;
+
+        int out = l > 128 ? 255 : 0;
+        dots[x] = out == 0;
+
+        int16_t e = (int16_t)((l - out) / 8);
+        cur[x + 1] += e;
+        cur[x + 2] += e;
+        next[x - 1] += e;
+        next[x] += e;
+        next[x + 1] += e;
+        after[x] += e;
+    }
+    // This row's slot comes back as the one after next
+    memset(cur - 1, 0, stride * sizeof(int16_t));
+}
+
+bool RasterPipeline::begin(GraySource& source, const Config& config)
+{
+    end();
+    uint8_t channels = config.channels == 0 ? 1 : config.channels;
+    if (config.in_width == 0 || config.in_height == 0 || config.out_width == 0
+        || (channels != 1 && channels != 3 && channels != 4)) {
+        return false;
+    }
+
+    source_ = &source;
+    config_ = config;
+    config_.channels = channels;
+    out_row_ = 0;
+    resized_index_ = -1;
+    ring_next_ = 0;
+    memory_used_ = 0;
+    buffers_arena_ = arena_;
+    pixel_bytes_ = channels == 1 ? 1 : 4;
+
+    uint16_t small_w = 0;
+    uint16_t small_h = 0;
+
+    if (config.resample == Resample::Nearest) {
+        if (config.out_height == 0) {
+            return false;
+        }
+        resized_width_ = config.in_width;
+        resized_height_ = config.in_height;
+        out_width_ = config.out_width;
+        out_height_ = config.out_height;
+        need_horizontal_ = false;
+        need_vertical_ = false;
+    } else {
+        // resize_to_width() returns the image untouched when widths match
+        need_horizontal_ = config.in_width != config.out_width;
+        resized_width_ = config.out_width;
+        resized_height_ = need_horizontal_
+            ? scaledHeight(config.in_width, config.in_height, config.out_width)
+            : config.in_height;
+        need_vertical_ = need_horizontal_ && resized_height_ != config.in_height;
+        out_width_ = resized_width_;
+        out_height_ = resized_height_;
+
+        if (config.pixelate_width > 0 && config.pixelate_width < resized_width_) {
+            small_w = config.pixelate_width;
+            small_h = scaledHeight(resized_width_, resized_height_, small_w);
+        }
+    }
+
+    // Each kernel is its own instantiation; rows call it through one pointer
+    size_t error_count;
+    switch (config.dither) {
+    case Dither::FloydSteinberg:
+        dither_row_ = &RasterPipeline::ditherRow<Dither::FloydSteinberg>;
+        error_count = (size_t)out_width_ + 1;
+        break;
+    case Dither::Ordered:
+        dither_row_ = &RasterPipeline::ditherRow<Dither::Ordered>;
+        error_count = 0;
+        break;
+    case Dither::Atkinson:
+        dither_row_ = &RasterPipeline::ditherRow<Dither::Atkinson>;
+        error_count = ((size_t)out_width_ + 3) * 3;
+        break;
+    default:
+        end();
+        return false;
+    }
+
+    x_map_ = allocate<uint16_t>(buffers_arena_, out_width_, &memory_used_);
+    y_map_ = allocate<uint16_t>(buffers_arena_, out_height_, &memory_used_);
+    in_row_ = allocate<uint8_t>(buffers_arena_, (size_t)config.in_width * pixel_bytes_ + ROW_PAD, &memory_used_);
+    source_row_ = channels == 1
+        ? in_row_
+        : allocate<uint8_t>(buffers_arena_, (size_t)config.in_width * channels, &memory_used_);
+    gray_row_ = allocate<uint8_t>(buffers_arena_, out_width_, &memory_used_);
+    dots_ = allocate<uint8_t>(buffers_arena_, padTo(out_width_, 8), &memory_used_);
+    if (error_count) {
+        errors_ = allocate<int16_t>(buffers_arena_, error_count, &memory_used_);
+    }
+    if (!x_map_ || !y_map_ || !in_row_ || !source_row_ || !gray_row_ || !dots_ || (error_count && !errors_)) {
+        end();
+        return false;
+    }
+
+    if (config.resample == Resample::Nearest) {
+        nearestMap(resized_width_, out_width_, x_map_);
+        nearestMap(resized_height_, out_height_, y_map_);
+    } else if (small_w > 0) {
+        // pixelate(): NEAREST down to small_w, then NEAREST back up.
+        // Compose both steps into one output -> resized map per axis.
+        uint16_t* down = Arena::allocateFrom<uint16_t>(buffers_arena_, small_w > small_h ? small_w : small_h);
+        if (!down) {
+            end();
+            return false;
+        }
+        nearestMap(small_w, out_width_, x_map_);
+        nearestMap(resized_width_, small_w, down);
+        for (uint16_t x = 0; x < out_width_; x++) {
+            x_map_[x] = down[x_map_[x]];
+        }
+        nearestMap(small_h, out_height_, y_map_);
+        nearestMap(resized_height_, small_h, down);
+        for (uint16_t y = 0; y < out_height_; y++) {
+            y_map_[y] = down[y_map_[y]];
+        }
+        Arena::release(buffers_arena_, down);
+    } else {
+        for (uint16_t x = 0; x < out_width_; x++) {
+            x_map_[x] = x;
+        }
+        for (uint16_t y = 0; y < out_height_; y++) {
+            y_map_[y] = y;
+        }
+    }
+
+    col_count_ = resized_width_;
+    if (need_horizontal_) {
+        // x_map_ never decreases: list the resized columns it samples
+        // once each and point it at that list instead
+        cols_ = allocate<uint16_t>(buffers_arena_, out_width_, &memory_used_);
+        if (!cols_) {
+            end();
+            return false;
+        }
+        col_count_ = 0;
+        for (uint16_t x = 0; x < out_width_; x++) {
+            if (col_count_ == 0 || cols_[col_count_ - 1] != x_map_[x]) {
+                cols_[col_count_++] = x_map_[x];
+            }
+            x_map_[x] = col_count_ - 1;
+        }
+
+        h_ksize_ = kernelSize(config.in_width, resized_width_);
+#if RASTER_SIMD
+        // Gray: 8 taps per step. Color: 2 pixels per step, each tap
+        // repeated for R, G, B and the unused byte. Padding taps are 0.
+        h_stride_ = (uint16_t)(pixel_bytes_ == 1 ? padTo(h_ksize_, 8) : padTo(h_ksize_, 2) * 4);
+#else
+        h_stride_ = h_ksize_;
+#endif
+        row_bytes_ = padTo((size_t)col_count_ * pixel_bytes_, ROW_PAD);
+        h_coeffs_ = allocate<int32_t>(buffers_arena_, (size_t)col_count_ * h_stride_, &memory_used_);
+        h_bounds_ = allocate<uint16_t>(buffers_arena_, (size_t)col_count_ * 2, &memory_used_);
+        resized_row_ = allocate<uint8_t>(buffers_arena_, row_bytes_, &memory_used_);
+        double* work = Arena::allocateFrom<double>(buffers_arena_, h_ksize_);
+        int32_t* taps = Arena::allocateFrom<int32_t>(buffers_arena_, h_ksize_);
+        if (!h_coeffs_ || !h_bounds_ || !resized_row_ || !work || !taps) {
+            Arena::release(buffers_arena_, taps);
+            Arena::release(buffers_arena_, work);
+            end();
+            return false;
+        }
+#if RASTER_SIMD
+        int repeat = pixel_bytes_;
+#else
+        int repeat = 1;
+#endif
+        for (uint16_t c = 0; c < col_count_; c++) {
+            int first;
+            int count;
+            computeTaps(config.in_width, resized_width_, cols_[c], work, taps, &first, &count);
+            int32_t* k = h_coeffs_ + (size_t)c * h_stride_;
+            for (int x = 0; x < count * repeat; x++) {
+                k[x] = taps[x / repeat];
+            }
+            h_bounds_[c * 2] = (uint16_t)first;
+            h_bounds_[c * 2 + 1] = (uint16_t)count;
+        }
+        Arena::release(buffers_arena_, taps);
+        Arena::release(buffers_arena_, work);
+    }
+
+    if (need_vertical_) {
+        // Vertical taps are rebuilt per output row; only the ring of
+        // horizontally resized rows they read from stays resident
+        v_ksize_ = kernelSize(config.in_height, resized_height_);
+        v_coeffs_ = allocate<int32_t>(buffers_arena_, v_ksize_, &memory_used_);
+        v_work_ = allocate<double>(buffers_arena_, v_ksize_, &memory_used_);
+        ring_ = allocate<uint8_t>(buffers_arena_, (size_t)v_ksize_ * row_bytes_, &memory_used_);
+        if (!v_coeffs_ || !v_work_ || !ring_) {
+            end();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RasterPipeline::end()
+{
+    if (source_row_ != in_row_) {
+        Arena::release(buffers_arena_, source_row_);
+    }
+    Arena::release(buffers_arena_, x_map_);
+    Arena::release(buffers_arena_, y_map_);
+    Arena::release(buffers_arena_, cols_);
+    Arena::release(buffers_arena_, h_coeffs_);
+    Arena::release(buffers_arena_, h_bounds_);
+    Arena::release(buffers_arena_, v_coeffs_);
+    Arena::release(buffers_arena_, v_work_);
+    Arena::release(buffers_arena_, ring_);
+    Arena::release(buffers_arena_, resized_row_);
+    Arena::release(buffers_arena_, in_row_);
+    Arena::release(buffers_arena_, errors_);
+    Arena::release(buffers_arena_, gray_row_);
+    Arena::release(buffers_arena_, dots_);
+    x_map_ = nullptr;
+    y_map_ = nullptr;
+    cols_ = nullptr;
+    h_coeffs_ = nullptr;
+    h_bounds_ = nullptr;
+    v_coeffs_ = nullptr;
+    v_work_ = nullptr;
+    ring_ = nullptr;
+    resized_row_ = nullptr;
+    source_row_ = nullptr;
+    in_row_ = nullptr;
+    errors_ = nullptr;
+    gray_row_ = nullptr;
+    dots_ = nullptr;
+    dither_row_ = nullptr;
+    source_ = nullptr;
+    memory_used_ = 0;
+}
+
+bool RasterPipeline::pullInputRow(int32_t y)
+{
+    // Rows arrive strictly in order; skip any the output never samples
+    while (ring_next_ <= y) {
+        if (!source_->readRow(source_row_)) {
+            return false;
+        }
+        if (config_.channels != 1 && (need_vertical_ || ring_next_ == y)) {
+            unpackSourceRow();
+        }
+        if (need_vertical_) {
+            uint8_t* slot = ring_ + (size_t)(ring_next_ % v_ksize_) * row_bytes_;
+            resampleHorizontal(in_row_, slot);
+        }
+        ring_next_++;
+    }
+    return true;
+}
+
+void RasterPipeline::unpackSourceRow()
+{
+    const uint8_t* src = source_row_;
+    uint8_t* dst = in_row_;
+    if (config_.channels == 3) {
+        for (uint16_t x = 0; x < config_.in_width; x++, src += 3, dst += 4) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = 0;
+        }
+    } else {
+        // pipeline.py composites the RGBA image over white first
+        uint16_t x = 0;
+#if RASTER_SIMD
+        // overWhite() on 8 pixels at a time, each a little-endian word
+        for (; x + 8 <= config_.in_width; x += 8, src += 32, dst += 32) {
+            Words px;
+            memcpy(&px, src, sizeof(px));
+            Words a = px >> 24;
+            Words white = 255u * (255u - a) * 128u + 0x4000u;
+            Words out = {};
+            for (int ch = 0; ch < 3; ch++) {
+                Words t = ((px >> (8 * ch)) & 0xFFu) * a * 128u + white;
+                out |= (((t >> 8) + t) >> 15) << (8 * ch);
+            }
+            memcpy(dst, &out, sizeof(out));
+        }
+#endif
+        for (; x < config_.in_width; x++, src += 4, dst += 4) {
+            dst[0] = overWhite(src[0], src[3]);
+            dst[1] = overWhite(src[1], src[3]);
+            dst[2] = overWhite(src[2], src[3]);
+            dst[3] = 0;
+        }
+    }
+}
+
+const uint8_t* RasterPipeline::resizedRow(int32_t y)
+{
+    if (y == resized_index_) {
+        return need_horizontal_ ? resized_row_ : in_row_;
+    }
+
+    if (need_vertical_) {
+        if (!resampleVertical(y, resized_row_)) {
+            return nullptr;
+        }
+    } else {
+        if (!pullInputRow(y)) {
+            return nullptr;
+        }
+        if (need_horizontal_) {
+            resampleHorizontal(in_row_, resized_row_);
+        }
+    }
+
+    resized_index_ = y;
+    return need_horizontal_ ? resized_row_ : in_row_;
+}
+
+void RasterPipeline::resampleHorizontal(const uint8_t* in, uint8_t* out) const
+{
+    if (pixel_bytes_ == 1) {
+        for (uint16_t c = 0; c < col_count_; c++) {
+            const int32_t* k = h_coeffs_ + (size_t)c * h_stride_;
+            const uint8_t* src = in + h_bounds_[c * 2];
+            uint16_t count = h_bounds_[c * 2 + 1];
+#if RASTER_SIMD
+            Lanes acc = {};
+            for (uint16_t x = 0; x < count; x += 8) {
+                acc += loadPixels(src + x) * loadLanes(k + x);
+            }
+            out[c] = clip8((1 << (PRECISION_BITS - 1)) + sumLanes(acc));
+#else
+            int32_t acc = 1 << (PRECISION_BITS - 1);
+            for (uint16_t x = 0; x < count; x++) {
+                acc += src[x] * k[x];
+            }
+            out[c] = clip8(acc);
+#endif
+        }
+        return;
+    }
+
+    for (uint16_t c = 0; c < col_count_; c++) {
+        const int32_t* k = h_coeffs_ + (size_t)c * h_stride_;
+        const uint8_t* src = in + (size_t)h_bounds_[c * 2] * 4;
+        uint16_t count = h_bounds_[c * 2 + 1];
+        uint8_t* px = out + (size_t)c * 4;
+#if RASTER_SIMD
+        Lanes acc = {};
+        for (uint16_t x = 0; x < count; x += 2) {
+            acc += loadPixels(src + x * 4) * loadLanes(k + x * 4);
+        }
+        for (int ch = 0; ch < 3; ch++) {
+            px[ch] = clip8((1 << (PRECISION_BITS - 1)) + acc[ch] + acc[ch + 4]);
+        }
+#else
+        int32_t acc[3] = {1 << (PRECISION_BITS - 1), 1 << (PRECISION_BITS - 1), 1 << (PRECISION_BITS - 1)};
+        for (uint16_t x = 0; x < count; x++) {
+            for (int ch = 0; ch < 3; ch++) {
+                acc[ch] += src[x * 4 + ch] * k[x];
+            }
+        }
+        for (int ch = 0; ch < 3; ch++) {
+            px[ch] = clip8(acc[ch]);
+        }
+#endif
+        px[3] = 0;
+    }
+}
+
+bool RasterPipeline::resampleVertical(int32_t y, uint8_t* out)
+{
+    int first;
+    int count;
+    computeTaps(config_.in_height, resized_height_, y, v_work_, v_coeffs_, &first, &count);
+
+    if (!pullInputRow(first + count - 1)) {
+        return false;
+    }
+
+    size_t width = (size_t)col_count_ * pixel_bytes_;
+#if RASTER_SIMD
+    // Eight bytes of the row per step; ring slots are padded to match
+    for (size_t b = 0; b < width; b += 8) {
+        Lanes acc = {};
+        for (int i = 0; i < count; i++) {
+            const uint8_t* row = ring_ + (size_t)((first + i) % v_ksize_) * row_bytes_;
+            acc += loadPixels(row + b) * v_coeffs_[i];
+        }
+        storeClipped(acc + (1 << (PRECISION_BITS - 1)), out + b);
+    }
+#else
+    for (size_t b = 0; b < width; b++) {
+        int32_t acc = 1 << (PRECISION_BITS - 1);
+        for (int i = 0; i < count; i++) {
+            const uint8_t* row = ring_ + (size_t)((first + i) % v_ksize_) * row_bytes_;
+            acc += row[b] * v_coeffs_[i];
+        }
+        out[b] = clip8(acc);
+    }
+#endif
+    return true;
+}
+
+void RasterPipeline::packDots(const uint8_t* dots, uint8_t* packed) const
+{
+    // Eight 0/1 dots per 64-bit load; the multiply gathers bit 0 of each
+    // byte into the top byte with the first dot in the MSB (little-endian
+    // loads, as on every target)
+    uint16_t bytes = widthBytes();
+    for (uint16_t i = 0; i < bytes; i++) {
+        uint64_t word;
+        memcpy(&word, dots + (size_t)i * 8, sizeof(word));
+        packed[i] = (uint8_t)((word * 0x8040201008040201ull) >> 56);
+    }
+}
+
+bool RasterPipeline::readRow(uint8_t* row)
+{
+    if (!source_ || out_row_ >= out_height_) {
+        return false;
+    }
+
+    const uint8_t* resized = resizedRow(y_map_[out_row_]);
+    if (!resized) {
+        return false;
+    }
+
+    if (pixel_bytes_ == 1) {
+        for (uint16_t x = 0; x < out_width_; x++) {
+            gray_row_[x] = resized[x_map_[x]];
+        }
+    } else {
+        // convert("L") after the resize, as to_1bit_dither() does
+        for (uint16_t x = 0; x < out_width_; x++) {
+            gray_row_[x] = luma(resized + (size_t)x_map_[x] * 4);
+        }
+    }
+    (this->*dither_row_)(gray_row_, dots_);
+    packDots(dots_, row);
+    out_row_++;
+    return true;
+}
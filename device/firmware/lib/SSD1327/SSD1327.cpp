@@ -0,0 +1,399 @@
+/*
+ * SSD1327.cpp
+ * SSD1327 128x128 16-level grayscale OLED driver over I2CManager
+ */
+
+#include "SSD1327.hpp"
+#include "esp_timer.h"
+#include <cstring>
+#include <new>
+
+// I2C control bytes: Co = 0, D/C# selects command or GDDRAM data stream
+static constexpr uint8_t CONTROL_COMMAND = 0x00;
+static constexpr uint8_t CONTROL_DATA = 0x40;
+
+static constexpr uint8_t CMD_SET_COLUMN = 0x15;
+static constexpr uint8_t CMD_SET_ROW = 0x75;
+static constexpr uint8_t CMD_START_LINE = 0xA1;
+
+// 128x128 module init (horizontal addressing, COM split, left pixel in the
+// high nibble)
+static const uint8_t INIT_SEQUENCE[] = {
+    0xFD, 0x12,         // Unlock commands
+    0xAE,               // Display off
+    0xA8, 0x7F,         // Multiplex ratio 128
+    0xA1, 0x00,         // Start line
+    0xA2, 0x00,         // Display offset
+    0xA0, 0x51,         // Remap: column, COM, COM split odd/even
+    0xAB, 0x01,         // Internal VDD regulator
+    0x81, 0x70,         // Contrast
+    0xB1, 0x55,         // Phase lengths
+    0xB6, 0x01,         // Second precharge period
+    0xB9,               // Linear grayscale table
+    0xBC, 0x08,         // Precharge voltage
+    0xBE, 0x07,         // VCOMH
+    0xD5, 0x62,         // Function selection B
+    0xA4,               // Normal display
+};
+
+static inline uint16_t rectArea(uint8_t col0, uint8_t row0, uint8_t col1, uint8_t row1)
+{
+    return (uint16_t)(col1 - col0 + 1) * (row1 - row0 + 1);
+}
+
+SSD1327::SSD1327(I2CManager& i2c, uint8_t address)
+    : i2c_(i2c)
+    , address_(address)
+    , buffer_(nullptr)
+    , dirty_count_(0)
+    , stats_()
+    , start_line_(0)
+    , start_line_dirty_(false)
+    , pending_(0)
+    , flush_error_(false)
+    , flush_start_us_(0)
+    , idle_sem_(nullptr)
+{
+}
+
+SSD1327::~SSD1327()
+{
+    delete[] buffer_;
+}
+
+bool SSD1327::begin()
+{
+    if (!buffer_) {
+        buffer_ = new (std::nothrow) uint8_t[BUFFER_SIZE];
+        if (!buffer_) {
+            ESP_LOGE(TAG, "Framebuffer allocation failed");
+            return false;
+        }
+    }
+    if (!idle_sem_) {
+        idle_sem_ = xSemaphoreCreateBinaryStatic(&idle_storage_);
+    }
+    
+    if (!sendCommands(INIT_SEQUENCE, sizeof(INIT_SEQUENCE))) {
+        ESP_LOGE(TAG, "Panel init failed at 0x%02x", address_);
+        return false;
+    }
+    start_line_ = 0;
+    start_line_dirty_ = false;
+    
+    clear(0);
+    if (!display()) {
+        return false;
+    }
+    setPower(true);
+    ESP_LOGI(TAG, "SSD1327 ready at 0x%02x", address_);
+    return true;
+}
+
+void SSD1327::setContrast(uint8_t contrast)
+{
+    uint8_t cmd[] = {0x81, contrast};
+    sendCommands(cmd, sizeof(cmd));
+}
+
+void SSD1327::setPower(bool on)
+{
+    uint8_t cmd = on ? 0xAF : 0xAE;
+    sendCommands(&cmd, 1);
+}
+
+void SSD1327::clear(uint8_t gray)
+{
+    if (!buffer_) {
+        return;
+    }
+    gray &= 0x0F;
+    memset(buffer_, (gray << 4) | gray, BUFFER_SIZE);
+    dirty_count_ = 0;
+    markDirty(0, 0, WIDTH - 1, HEIGHT - 1);
+}
+
+void SSD1327::setPixel(int16_t x, int16_t y, uint8_t gray)
+{
+    if (!buffer_ || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+        return;
+    }
+    uint8_t* p = &buffer_[y * (WIDTH / 2) + x / 2];
+    uint8_t v = (x & 1) ? ((*p & 0xF0) | (gray & 0x0F))
+                        : ((*p & 0x0F) | (gray << 4));
+    if (v != *p) {
+        *p = v;
+        markDirty(x, y, x, y);
+    }
+}
+
+uint8_t SSD1327::getPixel(int16_t x, int16_t y) const
+{
+    if (!buffer_ || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+        return 0;
+    }
+    uint8_t b = buffer_[y * (WIDTH / 2) + x / 2];
+    return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+void SSD1327::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t gray)
+{
+    int16_t x0 = x < 0 ? 0 : x;
+    int16_t y0 = y < 0 ? 0 : y;
+    int16_t x1 = x + w > WIDTH ? WIDTH - 1 : x + w - 1;
+    int16_t y1 = y + h > HEIGHT ? HEIGHT - 1 : y + h - 1;
+    if (!buffer_ || x0 > x1 || y0 > y1) {
+        return;
+    }
+    
+    gray &= 0x0F;
+    const uint8_t pair = (gray << 4) | gray;
+    for (int16_t row = y0; row <= y1; row++) {
+        uint8_t* line = &buffer_[row * (WIDTH / 2)];
+        int16_t col = x0;
+        if (col & 1) {
+            line[col / 2] = (line[col / 2] & 0xF0) | gray;
+            col++;
+        }
+        // Whole byte pairs in the middle
+        int16_t pairs_end = (x1 + 1) & ~1;
+        if (pairs_end > col) {
+            memset(&line[col / 2], pair, (pairs_end - col) / 2);
+            col = pairs_end;
+        }
+        if (col <= x1) {
+            line[col / 2] = (line[col / 2] & 0x0F) | (gray << 4);
+        }
+    }
+    markDirty(x0, y0, x1, y1);
+}
+
+void SSD1327::drawBitmap(int16_t x, int16_t y, int16_t w, int16_t h,
+                         const uint8_t* bits, uint8_t fg, int16_t bg)
+{
+    if (!buffer_ || w <= 0 || h <= 0) {
+        return;
+    }
+    const int16_t stride = (w + 7) / 8;
+    int16_t x0 = WIDTH, y0 = HEIGHT, x1 = -1, y1 = -1;
+    
+    for (int16_t j = 0; j < h; j++) {
+        int16_t py = y + j;
+        if (py < 0 || py >= HEIGHT) {
+            continue;
+        }
+        const uint8_t* row = bits + j * stride;
+        uint8_t* line = &buffer_[py * (WIDTH / 2)];
+        for (int16_t i = 0; i < w; i++) {
+            int16_t px = x + i;
+            if (px < 0 || px >= WIDTH) {
+                continue;
+            }
+            bool set = row[i >> 3] & (0x80 >> (i & 7));
+            if (!set && bg < 0) {
+                continue;
+            }
+            uint8_t gray = (set ? fg : (uint8_t)bg) & 0x0F;
+            uint8_t* p = &line[px / 2];
+            *p = (px & 1) ? ((*p & 0xF0) | gray) : ((*p & 0x0F) | (gray << 4));
+            
+            if (px < x0) x0 = px;
+            if (px > x1) x1 = px;
+            if (py < y0) y0 = py;
+            if (py > y1) y1 = py;
+        }
+    }
+    if (x1 >= 0) {
+        markDirty(x0, y0, x1, y1);
+    }
+}
+
+void SSD1327::drawRows(int16_t y, int16_t h, const uint8_t* rows)
+{
+    int16_t y0 = y < 0 ? 0 : y;
+    int16_t y1 = y + h > HEIGHT ? HEIGHT - 1 : y + h - 1;
+    if (!buffer_ || y0 > y1) {
+        return;
+    }
+    memcpy(&buffer_[y0 * (WIDTH / 2)], rows + (y0 - y) * (WIDTH / 2), (size_t)(y1 - y0 + 1) * (WIDTH / 2));
+    markDirty(0, y0, WIDTH - 1, y1);
+}
+
+void SSD1327::setStartLine(uint8_t line)
+{
+    line &= HEIGHT - 1;
+    if (line != start_line_) {
+        start_line_ = line;
+        start_line_dirty_ = true;
+    }
+}
+
+bool SSD1327::display()
+{
+    if (!buffer_) {
+        return false;
+    }
+    
+    // One flush in flight at a time: its window commands live in
+    // window_cmds_ and the rows it sends are still being read
+    while (pending_.load() > 0) {
+        xSemaphoreTake(idle_sem_, pdMS_TO_TICKS(100));
+    }
+    xSemaphoreTake(idle_sem_, 0);   // Drop a give nobody waited for
+    
+    if (flush_error_.exchange(false)) {
+        dirty_count_ = 0;
+        markDirty(0, 0, WIDTH - 1, HEIGHT - 1);
+        start_line_dirty_ = true;
+    }
+    if (dirty_count_ == 0 && !start_line_dirty_) {
+        return true;
+    }
+    
+    // Hold one reference while queueing so completion can't fire early
+    pending_.fetch_add(1);
+    stats_.flushes++;
+    flush_start_us_ = esp_timer_get_time();
+    bool ok = true;
+    for (uint8_t i = 0; i < dirty_count_ && ok; i++) {
+        ok = queueWindow(i, dirty_[i]);
+        if (ok) {
+            stats_.windows++;
+        }
+    }
+    dirty_count_ = 0;
+    // Scrolls once the rows it brings into view are written
+    if (ok && start_line_dirty_) {
+        start_cmd_[0] = CMD_START_LINE;
+        start_cmd_[1] = start_line_;
+        ok = queueWrite(CONTROL_COMMAND, start_cmd_, sizeof(start_cmd_));
+        start_line_dirty_ = false;
+    }
+    if (!ok) {
+        flush_error_.store(true);
+    }
+    transferDone(ESP_OK, this);
+    return ok;
+}
+
+void SSD1327::markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    Rect r = {(uint8_t)(x0 / 2), (uint8_t)y0, (uint8_t)(x1 / 2), (uint8_t)y1};
+    addDirty(r);
+}
+
+void SSD1327::addDirty(Rect r)
+{
+    // Absorb every window this one overlaps or touches
+    for (uint8_t i = 0; i < dirty_count_; ) {
+        const Rect& d = dirty_[i];
+        if (r.col0 <= d.col1 + 1 && d.col0 <= r.col1 + 1
+            && r.row0 <= d.row1 + 1 && d.row0 <= r.row1 + 1) {
+            r.col0 = d.col0 < r.col0 ? d.col0 : r.col0;
+            r.row0 = d.row0 < r.row0 ? d.row0 : r.row0;
+            r.col1 = d.col1 > r.col1 ? d.col1 : r.col1;
+            r.row1 = d.row1 > r.row1 ? d.row1 : r.row1;
+            dirty_[i] = dirty_[--dirty_count_];
+            i = 0;      // The grown window may now touch earlier ones
+            continue;
+        }
+        i++;
+    }
+    
+    if (dirty_count_ == MAX_DIRTY) {
+        // Out of slots: merge with the window whose union wastes least
+        uint8_t best = 0;
+        int32_t best_waste = INT32_MAX;
+        for (uint8_t i = 0; i < dirty_count_; i++) {
+            const Rect& d = dirty_[i];
+            uint8_t c0 = d.col0 < r.col0 ? d.col0 : r.col0;
+            uint8_t r0 = d.row0 < r.row0 ? d.row0 : r.row0;
+            uint8_t c1 = d.col1 > r.col1 ? d.col1 : r.col1;
+            uint8_t r1 = d.row1 > r.row1 ? d.row1 : r.row1;
+            int32_t waste = rectArea(c0, r0, c1, r1)
+                          - rectArea(d.col0, d.row0, d.col1, d.row1)
+                          - rectArea(r.col0, r.row0, r.col1, r.row1);
+            if (waste < best_waste) {
+                best_waste = waste;
+                best = i;
+            }
+        }
+        const Rect d = dirty_[best];
+        dirty_[best] = dirty_[--dirty_count_];
+        r.col0 = d.col0 < r.col0 ? d.col0 : r.col0;
+        r.row0 = d.row0 < r.row0 ? d.row0 : r.row0;
+        r.col1 = d.col1 > r.col1 ? d.col1 : r.col1;
+        r.row1 = d.row1 > r.row1 ? d.row1 : r.row1;
+        addDirty(r);
+        return;
+    }
+    
+    dirty_[dirty_count_++] = r;
+}
+
+bool SSD1327::sendCommands(const uint8_t* cmds, size_t len)
+{
+    return i2c_.write(address_, CONTROL_COMMAND, cmds, len);
+}
+
+bool SSD1327::queueWrite(uint8_t control, const uint8_t* data, size_t len)
+{
+    I2CManager::Transaction txn = {};
+    txn.address = address_;
+    txn.flags = I2CManager::Transaction::PREFIX | I2CManager::Transaction::COALESCE;
+    txn.prefix = control;
+    txn.data = data;
+    txn.len = len;
+    txn.done = transferDone;
+    txn.ctx = this;
+    
+    pending_.fetch_add(1);
+    if (!i2c_.submit(txn)) {
+        pending_.fetch_sub(1);
+        return false;
+    }
+    return true;
+}
+
+bool SSD1327::queueWindow(uint8_t slot, const Rect& r)
+{
+    uint8_t* cmds = window_cmds_[slot];
+    cmds[0] = CMD_SET_COLUMN;
+    cmds[1] = r.col0;
+    cmds[2] = r.col1;
+    cmds[3] = CMD_SET_ROW;
+    cmds[4] = r.row0;
+    cmds[5] = r.row1;
+    if (!queueWrite(CONTROL_COMMAND, cmds, sizeof(window_cmds_[0]))) {
+        return false;
+    }
+    
+    // Rows go straight from the framebuffer. Full-width windows are one
+    // contiguous block; narrower ones are one write per row, which the
+    // bus task joins back into a single data stream.
+    const size_t row_bytes = r.col1 - r.col0 + 1;
+    if (row_bytes == WIDTH / 2) {
+        size_t len = row_bytes * (r.row1 - r.row0 + 1);
+        stats_.data_bytes += len;
+        return queueWrite(CONTROL_DATA, &buffer_[r.row0 * (WIDTH / 2)], len);
+    }
+    for (uint16_t row = r.row0; row <= r.row1; row++) {
+        if (!queueWrite(CONTROL_DATA, &buffer_[row * (WIDTH / 2) + r.col0], row_bytes)) {
+            return false;
+        }
+        stats_.data_bytes += row_bytes;
+    }
+    return true;
+}
+
+void SSD1327::transferDone(esp_err_t result, void* ctx)
+{
+    SSD1327* self = static_cast<SSD1327*>(ctx);
+    if (result != ESP_OK) {
+        self->flush_error_.store(true);
+    }
+    if (self->pending_.fetch_sub(1) == 1) {
+        self->stats_.last_flush_us = (uint32_t)(esp_timer_get_time() - self->flush_start_us_);
+        xSemaphoreGive(self->idle_sem_);
+    }
+}
@@ -0,0 +1,614 @@
+/*
+ * StickerCache.cpp
+ * Recently printed stickers, kept on the device for instant reprints
+ */
+
+#include "StickerCache.hpp"
+#include "MemoryBudget.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <cstring>
+
+constexpr StickerCache::Config StickerCache::DEFAULT_CONFIG;
+
+StickerCache::Source::Source(StickerCache& cache)
+    : cache_(cache)
+    , slot_(NONE)
+    , decoder_()
+{
+}
+
+StickerCache::Source::~Source()
+{
+    if (slot_ != NONE) {
+        cache_.unpin(slot_);
+    }
+}
+
+bool StickerCache::Source::open(uint64_t key)
+{
+    if (slot_ != NONE) {
+        return false;
+    }
+    StickerCache& cache = cache_;
+    xSemaphoreTake(cache.lock_, portMAX_DELAY);
+    cache.metrics_.lookups++;
+    int16_t slot = cache.find(key);
+    if (slot == NONE) {
+        cache.metrics_.misses++;
+        xSemaphoreGive(cache.lock_);
+        return false;
+    }
+    Entry& e = cache.entries_[slot];
+    cache.touch(slot);
+    cache.last_key_ = key;
+    e.pins++;
+    if (e.ram) {
+        cache.metrics_.ram_hits++;
+        ram_.emplace(e.ram, e.length);
+    } else {
+        cache.metrics_.flash_hits++;
+        flash_.emplace(*cache.spool_, e.flash, KEY_SIZE);
+    }
+    xSemaphoreGive(cache.lock_);
+    
+    // Pinned from here: the source unpins when it goes away
+    slot_ = slot;
+    if (decoder_.begin(ram_ ? (ByteSource&)*ram_ : (ByteSource&)*flash_)) {
+        return true;
+    }
+    ESP_LOGW(TAG, "Cached sticker %016llx is corrupt, dropped", (unsigned long long)key);
+    cache.unpin(slot_);
+    slot_ = NONE;
+    ram_.reset();
+    flash_.reset();
+    xSemaphoreTake(cache.lock_, portMAX_DELAY);
+    if (e.used && e.key == key && e.pins == 0) {
+        cache.drop(slot);
+        cache.metrics_.evictions++;
+    }
+    xSemaphoreGive(cache.lock_);
+    return false;
+}
+
+uint64_t StickerCache::key(const char* text)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    bool space = false;
+    bool any = false;
+    for (const char* p = text; *p; p++) {
+        char c = *p;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            space = true;
+            continue;
+        }
+        if (space && any) {
+            hash = (hash ^ (uint8_t)' ') * 0x100000001b3ULL;
+        }
+        space = false;
+        any = true;
+        if (c >= 'A' && c <= 'Z') {
+            c = (char)(c - 'A' + 'a');
+        }
+        hash = (hash ^ (uint8_t)c) * 0x100000001b3ULL;
+    }
+    // 0 means "no sticker" to lastKey() callers
+    return hash ? hash : 1;
+}
+
+StickerCache::StickerCache(PrintSpool* spool)
+    : spool_(spool)
+    , config_(DEFAULT_CONFIG)
+    , psram_(false)
+    , ram_block_(nullptr)
+    , lock_(nullptr)
+    , lock_storage_()
+    , entries_()
+    , newest_(NONE)
+    , oldest_(NONE)
+    , last_key_(0)
+    , ram_bytes_(0)
+    , flash_bytes_(0)
+    , flash_entries_(0)
+    , metrics_()
+{
+}
+
+StickerCache::~StickerCache()
+{
+    heap_caps_free(ram_block_);
+    if (lock_) {
+        vSemaphoreDelete(lock_);
+    }
+}
+
+bool StickerCache::begin(const Config& config)
+{
+    config_ = config;
+    psram_ = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+    if (!psram_ && config_.ram_budget > INTERNAL_RAM_BUDGET) {
+        config_.ram_budget = INTERNAL_RAM_BUDGET;
+    }
+    if (!spool_) {
+        config_.flash_budget = 0;
+    }
+    lock_ = xSemaphoreCreateMutexStatic(&lock_storage_);
+    
+    // The whole RAM tier, once: put() packs entries into it
+    ram_block_ = (uint8_t*)MemoryBudget::reserve("sticker cache", config_.ram_budget, true);
+    if (!ram_block_) {
+        ESP_LOGE(TAG, "No RAM tier, stickers cached on flash only");
+        config_.ram_budget = 0;
+    }
+    
+    if (spool_) {
+        // Oldest first, so the LRU order is rebuilt newest at the head. A
+        // key stored twice (its old copy's done mark was lost) keeps the
+        // newer copy.
+        PrintSpool::Record records[PrintSpool::MAX_RECORDS];
+        size_t count = spool_->pending(records, PrintSpool::MAX_RECORDS);
+        for (size_t i = 0; i < count; i++) {
+            const PrintSpool::Record& record = records[i];
+            uint64_t key = 0;
+            if (record.length <= KEY_SIZE || !spool_->read(record, 0, (uint8_t*)&key, KEY_SIZE)
+                || key == 0) {
+                spool_->markDone(record.id);
+                continue;
+            }
+            int16_t old = find(key);
+            if (old != NONE) {
+                drop(old);
+            }
+            int16_t slot = allocSlot();
+            if (slot == NONE) {
+                spool_->markDone(record.id);
+                continue;
+            }
+            Entry& e = entries_[slot];
+            e.key = key;
+            e.ram = nullptr;
+            e.length = record.length - KEY_SIZE;
+            e.flash = record;
+            e.pins = 0;
+            e.used = true;
+            link(slot);
+            flash_bytes_ += e.length;
+            flash_entries_++;
+        }
+        trimFlash(0);
+    }
+    
+    ESP_LOGI(TAG, "RAM %u KB (%s), flash %u KB, %u stickers restored from flash",
+             (unsigned)(config_.ram_budget / 1024), psram_ ? "PSRAM" : "internal",
+             (unsigned)(config_.flash_budget / 1024), (unsigned)flash_entries_);
+    return ram_block_ != nullptr;
+}
+
+bool StickerCache::put(uint64_t key, const uint8_t* data, size_t len)
+{
+    MemoryByteSource source(data, len);
+    return put(key, source, len);
+}
+
+bool StickerCache::put(uint64_t key, ByteSource& data, size_t len)
+{
+    if (key == 0 || len == 0 || len > config_.ram_budget || len > UINT32_MAX) {
+        ESP_LOGW(TAG, "Sticker of %u bytes not cached", (unsigned)len);
+        return false;
+    }
+    
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    int16_t slot = find(key);
+    if (slot != NONE && entries_[slot].pins) {
+        // Same prompt, same sticker, and it's being read right now
+        touch(slot);
+        last_key_ = key;
+        xSemaphoreGive(lock_);
+        return true;
+    }
+    if (slot != NONE) {
+        drop(slot);
+    }
+    xSemaphoreGive(lock_);
+    
+    // Make room, then claim a slot and its bytes: pinned and out of the
+    // LRU order, nothing else touches them while the data comes in
+    trimRam(len);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    slot = allocSlot();
+    uint8_t* buf = slot != NONE ? allocRam(len) : nullptr;
+    if (!buf) {
+        xSemaphoreGive(lock_);
+        ESP_LOGW(TAG, "No room for a %u-byte sticker while reprints hold the rest", (unsigned)len);
+        return false;
+    }
+    Entry& e = entries_[slot];
+    e.key = key;
+    e.ram = buf;
+    e.length = (uint32_t)len;
+    e.flash = {};
+    e.pins = 1;
+    e.used = true;
+    e.newer = NONE;
+    e.older = NONE;
+    ram_bytes_ += len;
+    xSemaphoreGive(lock_);
+    
+    size_t got = 0;
+    while (got < len) {
+        size_t n = data.read(buf + got, len - got);
+        if (n == 0) {
+            break;
+        }
+        got += n;
+    }
+    
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    if (got < len) {
+        // Never linked, so not drop()
+        e.ram = nullptr;
+        e.used = false;
+        e.key = 0;
+        ram_bytes_ -= len;
+        xSemaphoreGive(lock_);
+        ESP_LOGW(TAG, "Sticker source ended after %u of %u bytes", (unsigned)got, (unsigned)len);
+        return false;
+    }
+    e.pins = 0;
+    link(slot);
+    last_key_ = key;
+    metrics_.inserts++;
+    xSemaphoreGive(lock_);
+    return true;
+}
+
+bool StickerCache::contains(uint64_t key) const
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool found = find(key) != NONE;
+    xSemaphoreGive(lock_);
+    return found;
+}
+
+uint64_t StickerCache::lastKey() const
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    uint64_t key = last_key_;
+    xSemaphoreGive(lock_);
+    return key;
+}
+
+StickerCache::Metrics StickerCache::getMetrics() const
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    Metrics m = metrics_;
+    m.ram_entries = 0;
+    for (const Entry& e : entries_) {
+        if (e.used && e.ram) {
+            m.ram_entries++;
+        }
+    }
+    m.flash_entries = (uint32_t)flash_entries_;
+    m.ram_bytes = ram_bytes_;
+    m.flash_bytes = flash_bytes_;
+    xSemaphoreGive(lock_);
+    m.ram_budget = config_.ram_budget;
+    m.flash_budget = config_.flash_budget;
+    m.index_bytes = sizeof(*this);
+    m.psram = psram_;
+    return m;
+}
+
+void StickerCache::logMetrics() const
+{
+    Metrics m = getMetrics();
+    unsigned hit_pct = m.lookups ? (unsigned)((m.ram_hits + m.flash_hits) * 100 / m.lookups) : 0;
+    ESP_LOGI(TAG, "Lookups %u: %u%% hit (%u RAM, %u flash), %u miss",
+             (unsigned)m.lookups, hit_pct, (unsigned)m.ram_hits, (unsigned)m.flash_hits,
+             (unsigned)m.misses);
+    ESP_LOGI(TAG, "RAM %u entries, %u/%u KB (%s); flash %u entries, %u/%u KB; index %u B",
+             (unsigned)m.ram_entries, (unsigned)(m.ram_bytes / 1024),
+             (unsigned)(m.ram_budget / 1024), m.psram ? "PSRAM" : "internal",
+             (unsigned)m.flash_entries, (unsigned)(m.flash_bytes / 1024),
+             (unsigned)(m.flash_budget / 1024), (unsigned)m.index_bytes);
+    ESP_LOGI(TAG, "%u inserts, %u spills, %u spill failures, %u evictions, %u compactions",
+             (unsigned)m.inserts, (unsigned)m.spills, (unsigned)m.spill_failures,
+             (unsigned)m.evictions, (unsigned)m.compactions);
+}
+
+int16_t StickerCache::find(uint64_t key) const
+{
+    for (int16_t s = newest_; s != NONE; s = entries_[s].older) {
+        if (entries_[s].key == key) {
+            return s;
+        }
+    }
+    return NONE;
+}
+
+int16_t StickerCache::allocSlot()
+{
+    for (size_t s = 0; s < MAX_ENTRIES; s++) {
+        if (!entries_[s].used) {
+            return (int16_t)s;
+        }
+    }
+    // Out of slots: the oldest flash-only record, as trimFlash() would
+    // take it next anyway, else the least recently used entry
+    int16_t victim = NONE;
+    for (int16_t s = oldest_; s != NONE; s = entries_[s].newer) {
+        const Entry& e = entries_[s];
+        if (e.pins == 0 && !e.ram && (victim == NONE || e.flash.id < entries_[victim].flash.id)) {
+            victim = s;
+        }
+    }
+    for (int16_t s = oldest_; s != NONE && victim == NONE; s = entries_[s].newer) {
+        if (entries_[s].pins == 0) {
+            victim = s;
+        }
+    }
+    if (victim != NONE) {
+        drop(victim);
+        metrics_.evictions++;
+    }
+    return victim;
+}
+
+void StickerCache::link(int16_t slot)
+{
+    Entry& e = entries_[slot];
+    e.newer = NONE;
+    e.older = newest_;
+    if (newest_ != NONE) {
+        entries_[newest_].newer = slot;
+    }
+    newest_ = slot;
+    if (oldest_ == NONE) {
+        oldest_ = slot;
+    }
+}
+
+void StickerCache::unlink(int16_t slot)
+{
+    Entry& e = entries_[slot];
+    if (e.newer != NONE) {
+        entries_[e.newer].older = e.older;
+    } else {
+        newest_ = e.older;
+    }
+    if (e.older != NONE) {
+        entries_[e.older].newer = e.newer;
+    } else {
+        oldest_ = e.newer;
+    }
+    e.newer = NONE;
+    e.older = NONE;
+}
+
+void StickerCache::touch(int16_t slot)
+{
+    if (slot != newest_) {
+        unlink(slot);
+        link(slot);
+    }
+}
+
+void StickerCache::dropRam(int16_t slot)
+{
+    Entry& e = entries_[slot];
+    if (e.ram) {
+        e.ram = nullptr;
+        ram_bytes_ -= e.length;
+    }
+}
+
+void StickerCache::dropFlash(int16_t slot)
+{
+    Entry& e = entries_[slot];
+    if (e.flash.id) {
+        // Its sectors come back once every older record is done too
+        spool_->markDone(e.flash.id);
+        e.flash = {};
+        flash_bytes_ -= e.length;
+        flash_entries_--;
+    }
+}
+
+void StickerCache::drop(int16_t slot)
+{
+    dropRam(slot);
+    dropFlash(slot);
+    unlink(slot);
+    entries_[slot].used = false;
+    entries_[slot].key = 0;
+}
+
+void StickerCache::trimFlash(size_t incoming)
+{
+    // Oldest record first, not least recently used: the spool only gets
+    // sectors back from the tail of its ring, so anything else leaves
+    // done records stuck behind a live one. MAX_FLASH_RECORDS leaves the
+    // spool's index room for done marks still in its queue.
+    size_t records = incoming ? 1 : 0;
+    while (flash_entries_ > 0
+           && (flash_bytes_ + incoming > config_.flash_budget
+               || flash_entries_ + records > MAX_FLASH_RECORDS)) {
+        int16_t victim = NONE;
+        for (int16_t s = oldest_; s != NONE; s = entries_[s].newer) {
+            if (entries_[s].flash.id && entries_[s].pins == 0
+                && (victim == NONE || entries_[s].flash.id < entries_[victim].flash.id)) {
+                victim = s;
+            }
+        }
+        if (victim == NONE) {
+            return;
+        }
+        dropFlash(victim);
+        if (!entries_[victim].ram) {
+            drop(victim);
+            metrics_.evictions++;
+        }
+    }
+}
+
+void StickerCache::unpin(int16_t slot)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    entries_[slot].pins--;
+    xSemaphoreGive(lock_);
+}
+
+void StickerCache::trimRam(size_t incoming)
+{
+    while (true) {
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        if (ram_bytes_ + incoming <= config_.ram_budget) {
+            xSemaphoreGive(lock_);
+            return;
+        }
+        int16_t victim = NONE;
+        for (int16_t s = oldest_; s != NONE; s = entries_[s].newer) {
+            if (entries_[s].ram && entries_[s].pins == 0) {
+                victim = s;
+                break;
+            }
+        }
+        if (victim == NONE) {
+            // All pinned; put() finds no room until the reprints finish
+            xSemaphoreGive(lock_);
+            return;
+        }
+        
+        Entry& e = entries_[victim];
+        if (e.flash.id || !spool_ || e.length > config_.flash_budget) {
+            dropRam(victim);
+            if (!e.flash.id) {
+                drop(victim);
+                metrics_.evictions++;
+            }
+            xSemaphoreGive(lock_);
+            continue;
+        }
+        
+        // Spill: pinned so the buffer stays put while flash is written
+        trimFlash(e.length + KEY_SIZE);
+        e.pins++;
+        uint64_t key = e.key;
+        const uint8_t* data = e.ram;
+        size_t len = e.length;
+        xSemaphoreGive(lock_);
+        
+        PrintSpool::Record record = {};
+        bool ok = spill(key, data, len, &record);
+        
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        e.pins--;
+        if (ok) {
+            e.flash = record;
+            flash_bytes_ += len;
+            flash_entries_++;
+            metrics_.spills++;
+        } else {
+            metrics_.spill_failures++;
+        }
+        // A reprint that opened it meanwhile reads the RAM copy; the next
+        // trim takes it once that's done
+        if (e.pins == 0) {
+            dropRam(victim);
+            if (!e.flash.id) {
+                drop(victim);
+                metrics_.evictions++;
+            }
+        }
+        xSemaphoreGive(lock_);
+    }
+}
+
+bool StickerCache::spill(uint64_t key, const uint8_t* data, size_t len, PrintSpool::Record* record)
+{
+    // Done marks for the records trimFlash() just let go are applied by
+    // the spool task; give it a moment to free their sectors
+    size_t need = KEY_SIZE + len + PrintSpool::HEADER_SIZE + PrintSpool::SECTOR_SIZE;
+    bool opened = false;
+    for (int attempt = 0; attempt < SPILL_ATTEMPTS && !opened; attempt++) {
+        if (attempt > 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        opened = spool_->freeBytes() >= need && spool_->open();
+    }
+    if (!opened) {
+        return false;
+    }
+    if (!spool_->write((const uint8_t*)&key, KEY_SIZE) || !spool_->write(data, len)) {
+        spool_->abort();
+        return false;
+    }
+    uint32_t id = spool_->commit();
+    if (id == 0) {
+        return false;
+    }
+    return spool_->find(id, record);
+}
+
+uint8_t* StickerCache::allocRam(size_t len)
+{
+    uint8_t* buf = findGap(len);
+    if (!buf && ram_bytes_ + len <= config_.ram_budget) {
+        // The room is there, split between entries
+        compactRam();
+        buf = findGap(len);
+    }
+    return buf;
+}
+
+size_t StickerCache::ramOrder(int16_t* order) const
+{
+    // Insertion sort: a few dozen entries at most
+    size_t n = 0;
+    for (size_t s = 0; s < MAX_ENTRIES; s++) {
+        const uint8_t* ram = entries_[s].used ? entries_[s].ram : nullptr;
+        if (!ram) {
+            continue;
+        }
+        size_t i = n++;
+        while (i > 0 && entries_[order[i - 1]].ram > ram) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = (int16_t)s;
+    }
+    return n;
+}
+
+uint8_t* StickerCache::findGap(size_t len) const
+{
+    int16_t order[MAX_ENTRIES];
+    size_t count = ramOrder(order);
+    uint8_t* start = ram_block_;
+    for (size_t i = 0; i < count; i++) {
+        const Entry& e = entries_[order[i]];
+        if ((size_t)(e.ram - start) >= len) {
+            return start;
+        }
+        start = e.ram + e.length;
+    }
+    return (size_t)(ram_block_ + config_.ram_budget - start) >= len ? start : nullptr;
+}
+
+void StickerCache::compactRam()
+{
+    // Slide every unpinned entry down against the one before it; pinned
+    // ones are being read (or spilled) and stay where they are
+    int16_t order[MAX_ENTRIES];
+    size_t count = ramOrder(order);
+    uint8_t* end = ram_block_;
+    for (size_t i = 0; i < count; i++) {
+        Entry& e = entries_[order[i]];
+        if (!e.pins && e.ram != end) {
+            memmove(end, e.ram, e.length);
+            e.ram = end;
+        }
+        end = e.ram + e.length;
+    }
+    metrics_.compactions++;
+}
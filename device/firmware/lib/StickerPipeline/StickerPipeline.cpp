@@ -0,0 +1,405 @@
+/*
+ * StickerPipeline.cpp
+ * Download -> decode -> print stages for one sticker, overlapped
+ */
+
+#include "StickerPipeline.hpp"
+#include "Trace.hpp"
+#include "esp_log.h"
+#include <cstring>
+
+// Decode task: the PVR1 bytes of the current sticker
+class StickerPipeline::StreamReader : public ByteSource {
+public:
+    explicit StreamReader(StickerPipeline& pipeline)
+        : pipeline_(pipeline)
+    {
+    }
+    
+    size_t read(uint8_t* buf, size_t max) override { return pipeline_.readStream(buf, max); }
+
+private:
+    StickerPipeline& pipeline_;
+};
+
+// Printer task: the rows the decode task posted, as the job's raster
+class StickerPipeline::RowReader : public RasterSource {
+public:
+    RowReader(StickerPipeline& pipeline, uint16_t width_bytes, uint16_t height)
+        : pipeline_(pipeline)
+        , width_bytes_(width_bytes)
+        , height_(height)
+        , row_(0)
+        , ended_(false)
+        , complete_(false)
+    {
+    }
+    
+    ~RowReader() override
+    {
+        pipeline_.reader_done_ = true;
+        pipeline_.release(1);
+    }
+    
+    StickerPipeline& pipeline() const { return pipeline_; }
+    bool complete() const { return complete_; }
+    
+    // The sticker's rows, any caption rows, then END_OK or END_FAILED
+    bool readRow(uint8_t* row) override
+    {
+        if (ended_) {
+            return false;
+        }
+        size_t n = xMessageBufferReceive(pipeline_.rows_, row, width_bytes_,
+                                         pdMS_TO_TICKS(pipeline_.config_.row_timeout_ms));
+        if (n == width_bytes_) {
+            row_++;
+            return true;
+        }
+        if (n == 0) {
+            ESP_LOGW(TAG, "No rows for %u ms, sticker cut at row %u",
+                     (unsigned)pipeline_.config_.row_timeout_ms, (unsigned)row_);
+        } else if (n == 1 && row[0] == END_OK && row_ >= height_) {
+            complete_ = true;
+        }
+        ended_ = true;
+        return false;
+    }
+
+private:
+    StickerPipeline& pipeline_;
+    uint16_t width_bytes_;
+    uint16_t height_;
+    uint16_t row_;
+    bool ended_;
+    bool complete_;
+};
+
+StickerPipeline::StickerPipeline(PrintQueue& queue, const Config& config)
+    : queue_(queue)
+    , config_(config)
+    , callback_(nullptr)
+    , observer_(nullptr)
+    , stream_(nullptr)
+    , rows_(nullptr)
+    , start_sem_(nullptr)
+    , idle_sem_(nullptr)
+    , task_handle_(nullptr)
+    , stream_buffer_()
+    , rows_buffer_()
+    , start_storage_()
+    , idle_storage_()
+    , closed_(false)
+    , aborted_(false)
+    , rejected_(false)
+    , reader_done_(false)
+    , holders_(0)
+    , width_bytes_(0)
+    , stream_peak_(0)
+    , row_peak_(0)
+    , network_waits_(0)
+    , decode_waits_(0)
+    , stickers_(0)
+    , failed_(0)
+{
+    caption_[0] = '\0';
+}
+
+StickerPipeline::~StickerPipeline()
+{
+    if (task_handle_) {
+        vTaskDelete(task_handle_);
+    }
+    if (stream_) {
+        vStreamBufferDelete(stream_);
+    }
+    if (rows_) {
+        vMessageBufferDelete(rows_);
+    }
+    if (start_sem_) {
+        vSemaphoreDelete(start_sem_);
+    }
+    if (idle_sem_) {
+        vSemaphoreDelete(idle_sem_);
+    }
+}
+
+bool StickerPipeline::begin(const TaskSpec& task)
+{
+    stream_ = xStreamBufferCreateStatic(sizeof(stream_storage_), 1, stream_storage_, &stream_buffer_);
+    rows_ = xMessageBufferCreateStatic(sizeof(rows_storage_), rows_storage_, &rows_buffer_);
+    start_sem_ = xSemaphoreCreateBinaryStatic(&start_storage_);
+    idle_sem_ = xSemaphoreCreateBinaryStatic(&idle_storage_);
+    if (!stream_ || !rows_ || !start_sem_ || !idle_sem_) {
+        ESP_LOGE(TAG, "Failed to create pipeline buffers");
+        return false;
+    }
+    xSemaphoreGive(idle_sem_);
+    
+    task_handle_ = task_storage_.start(taskEntry, this, task);
+    if (!task_handle_) {
+        ESP_LOGE(TAG, "Failed to create decode task");
+        return false;
+    }
+    ESP_LOGI(TAG, "Decode task started (stream %u B, %u rows)", (unsigned)STREAM_BYTES, (unsigned)ROW_SLOTS);
+    return true;
+}
+
+bool StickerPipeline::open(TickType_t ticks)
+{
+    if (!task_handle_ || xSemaphoreTake(idle_sem_, ticks) != pdTRUE) {
+        return false;
+    }
+    caption_[0] = '\0';
+    closed_ = false;
+    aborted_ = false;
+    rejected_ = false;
+    reader_done_ = false;
+    holders_ = 2;
+    xSemaphoreGive(start_sem_);
+    return true;
+}
+
+bool StickerPipeline::write(const uint8_t* data, size_t len, TickType_t ticks)
+{
+    if (closed_ || rejected_) {
+        return false;
+    }
+    if (xStreamBufferSpacesAvailable(stream_) < len) {
+        network_waits_++;
+    }
+    while (len > 0) {
+        size_t n = xStreamBufferSend(stream_, data, len, ticks);
+        if (n == 0 || rejected_) {
+            return false;
+        }
+        data += n;
+        len -= n;
+        
+        size_t queued = xStreamBufferBytesAvailable(stream_);
+        if (queued > stream_peak_) {
+            stream_peak_ = queued;
+        }
+        TRACE_COUNTER("pipeline_stream", queued);
+    }
+    return true;
+}
+
+void StickerPipeline::close(bool ok, const char* caption)
+{
+    if (!ok) {
+        aborted_ = true;
+    } else if (caption) {
+        // A caption cut short ends on a whole character
+        size_t len = strnlen(caption, CaptionRenderer::MAX_BYTES);
+        while (len > 0 && ((uint8_t)caption[len] & 0xC0) == 0x80) {
+            len--;
+        }
+        memcpy(caption_, caption, len);
+        caption_[len] = '\0';
+    }
+    closed_ = true;
+}
+
+size_t StickerPipeline::readStream(uint8_t* buf, size_t max)
+{
+    // Polls so a close() with nothing left to send ends the stream
+    for (;;) {
+        if (aborted_) {
+            return 0;
+        }
+        size_t n = xStreamBufferReceive(stream_, buf, max, POLL_TICKS);
+        if (n > 0) {
+            return n;
+        }
+        if (closed_ && xStreamBufferIsEmpty(stream_)) {
+            return 0;
+        }
+    }
+}
+
+bool StickerPipeline::sendRow(const uint8_t* data, size_t len)
+{
+    if (xMessageBufferSpacesAvailable(rows_) < len + LENGTH_BYTES) {
+        decode_waits_++;
+    }
+    while (xMessageBufferSend(rows_, data, len, POLL_TICKS) != len) {
+        if (reader_done_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StickerPipeline::taskEntry(void* arg)
+{
+    static_cast<StickerPipeline*>(arg)->task();
+}
+
+void StickerPipeline::task()
+{
+    while (xSemaphoreTake(start_sem_, portMAX_DELAY) == pdTRUE) {
+        bool ok = decode();
+        if (!ok) {
+            rejected_ = true;
+        }
+        // Discard what is left of the download, which also frees a writer
+        // blocked on a full stream, until the network side closes
+        while (readStream(row_buf_, sizeof(row_buf_)) > 0) {
+        }
+        // Now the caption is known; the job ends after it
+        if (ok && (aborted_ || sendCaption())) {
+            sendRow(&END_OK, 1);
+        }
+        release(1);
+    }
+}
+
+bool StickerPipeline::decode()
+{
+    StreamReader bytes(*this);
+    if (!decoder_.begin(bytes) || decoder_.widthBytes() < 2) {
+        ESP_LOGE(TAG, "Not a PVR1 raster, sticker dropped");
+        finish(0, false);
+        release(1);     // No print stage
+        return false;
+    }
+    uint16_t width_bytes = decoder_.widthBytes();
+    uint16_t height = decoder_.height();
+    width_bytes_ = width_bytes;
+    
+    // Queue the job before decoding: the printer starts on the first rows.
+    // The reader lives in the job's arena and lets go of the print stage
+    // when the job is cleared.
+    PrintJob* job = queue_.acquire();
+    RowReader* rows = job ? job->make<RowReader>(*this, width_bytes, height) : nullptr;
+    if (rows) {
+        job->reset()
+            .raster(rows, width_bytes)
+            .feed(3)
+            .cut();
+        job->onDone(onJobDone, rows);
+    } else if (job) {
+        queue_.release(job);
+    }
+    if (!rows || queue_.submit(job) == 0) {
+        ESP_LOGW(TAG, "Printer busy, sticker dropped");
+        if (!rows) {
+            release(1);     // No reader to let go of the print stage
+        }
+        finish(0, false);
+        return false;
+    }
+    ESP_LOGI(TAG, "Printing %ux%u sticker as it downloads", (unsigned)(width_bytes * 8), (unsigned)height);
+    
+    if (observer_) {
+        observer_->begin(width_bytes, height);
+    }
+    
+    TRACE_SCOPE("decode");
+    bool ok = true;
+    while (ok && decoder_.readRow(row_buf_)) {
+        if (!sendRow(row_buf_, width_bytes)) {
+            ok = false;     // The job stopped reading
+            break;
+        }
+        if (observer_) {
+            observer_->row(row_buf_);
+        }
+        size_t queued = queuedRows(width_bytes);
+        if (queued > row_peak_) {
+            row_peak_ = queued;
+        }
+        TRACE_COUNTER("pipeline_rows", queued);
+    }
+    if (ok && decoder_.failed()) {
+        ESP_LOGW(TAG, "Stream ended early, sticker cut");
+        sendRow(&END_FAILED, 1);
+        ok = false;
+    }
+    if (observer_) {
+        observer_->end(ok);
+    }
+    return ok;
+}
+
+bool StickerPipeline::sendCaption()
+{
+    uint16_t width_bytes = width_bytes_;
+    uint16_t rows = caption_renderer_.begin(caption_, width_bytes);
+    if (rows == 0) {
+        return true;
+    }
+    TRACE_SCOPE("caption");
+    while (caption_renderer_.readRow(row_buf_)) {
+        if (!sendRow(row_buf_, width_bytes)) {
+            return false;
+        }
+    }
+    ESP_LOGI(TAG, "Caption: %u lines, %u rows", (unsigned)caption_renderer_.lines(), (unsigned)rows);
+    return true;
+}
+
+void StickerPipeline::release(int stages)
+{
+    if (holders_.fetch_sub(stages) == stages) {
+        // Neither stage touches the buffers any more
+        xStreamBufferReset(stream_);
+        xMessageBufferReset(rows_);
+        xSemaphoreGive(idle_sem_);
+    }
+}
+
+void StickerPipeline::finish(uint32_t job_id, bool ok)
+{
+    stickers_++;
+    if (!ok) {
+        failed_++;
+    }
+    if (callback_) {
+        callback_(job_id, ok);
+    }
+}
+
+void StickerPipeline::onJobDone(uint32_t job_id, bool ok, void* ctx)
+{
+    RowReader* rows = static_cast<RowReader*>(ctx);
+    rows->pipeline().finish(job_id, ok && rows->complete());
+}
+
+size_t StickerPipeline::queuedRows(uint16_t width_bytes) const
+{
+    return (ROW_BUFFER_BYTES - xMessageBufferSpacesAvailable(rows_)) / (width_bytes + LENGTH_BYTES);
+}
+
+StickerPipeline::Depths StickerPipeline::getDepths() const
+{
+    Depths depths = {};
+    depths.stream_bytes = stream_ ? xStreamBufferBytesAvailable(stream_) : 0;
+    depths.stream_capacity = STREAM_BYTES;
+    depths.stream_peak = stream_peak_;
+    // Rows narrower than the widest raster fit more of them
+    uint16_t width_bytes = width_bytes_;
+    depths.rows = width_bytes && rows_ ? queuedRows(width_bytes) : 0;
+    depths.row_capacity = width_bytes ? ROW_BUFFER_BYTES / (width_bytes + LENGTH_BYTES) : ROW_SLOTS;
+    depths.row_peak = row_peak_;
+    depths.network_waits = network_waits_;
+    depths.decode_waits = decode_waits_;
+    depths.print_jobs = queue_.pending();
+    depths.stickers = stickers_;
+    depths.failed = failed_;
+    return depths;
+}
+
+void StickerPipeline::logDepths() const
+{
+    Depths d = getDepths();
+    ESP_LOGI(TAG, "Stickers: %u (%u failed)", (unsigned)d.stickers, (unsigned)d.failed);
+    ESP_LOGI(TAG, "  network -> decode: %u / %u bytes, peak %u, writer waited %u times",
+             (unsigned)d.stream_bytes, (unsigned)d.stream_capacity, (unsigned)d.stream_peak,
+             (unsigned)d.network_waits);
+    ESP_LOGI(TAG, "  decode -> printer: %u / %u rows, peak %u, decoder waited %u times",
+             (unsigned)d.rows, (unsigned)d.row_capacity, (unsigned)d.row_peak,
+             (unsigned)d.decode_waits);
+    ESP_LOGI(TAG, "  print queue: %u jobs waiting", (unsigned)d.print_jobs);
+}
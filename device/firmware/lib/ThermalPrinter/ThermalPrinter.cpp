@@ -4,16 +4,40 @@
  */
 
 #include "ThermalPrinter.hpp"
+#include "Trace.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
+#include "nvs.h"
 #include <cstring>
 
 ThermalPrinter::ThermalPrinter(uart_port_t port, int tx_pin, int rx_pin, int baud_rate)
     : uart_port_(port)
     , tx_pin_(tx_pin)
     , rx_pin_(rx_pin)
-    , baud_rate_(baud_rate)
+    , baud_rate_(baud_rate == AUTO_BAUD ? FALLBACK_BAUD : baud_rate)
+    , inverse_(0)
+    , auto_baud_(baud_rate == AUTO_BAUD)
     , initialized_(false)
+    , band_rows_(DEFAULT_BAND_ROWS)
+    , blank_feeds_(true)
+    , raster_stats_{}
+    , timing_(DEFAULT_TIMING)
+    , status_supported_(false)
+    , wire_free_at_us_(0)
+    , head_free_at_us_(0)
+    , batching_(false)
+    , raster_pending_(false)
+    , raster_start_us_(0)
+    , progress_(nullptr)
+    , progress_ctx_(nullptr)
+    , profile_(nullptr)
+    , active_profile_(&PrintProfiles::POWER_ON)
+    , queued_()
+    , queued_count_(0)
+    , queued_bytes_(0)
+    , tx_len_(0)
+    , tx_piece_count_(0)
 {
 }
 
@@ -32,10 +56,13 @@ bool ThermalPrinter::begin()
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .rx_flow_ctrl_thresh = 0,
         .source_clk = UART_SCLK_DEFAULT,
     };
     
-    esp_err_t err = uart_driver_install(uart_port_, UART_BUF_SIZE * 2, 0, 0, nullptr, 0);
+    // A TX ring buffer lets uart_write_bytes return as soon as data is queued,
+    // so the next raster band can be filled while the previous one drains.
+    esp_err_t err = uart_driver_install(uart_port_, UART_BUF_SIZE * 2, UART_BUF_SIZE, 0, nullptr, 0);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "UART driver install failed: %s", esp_err_to_name(err));
         return false;
@@ -56,7 +83,18 @@ bool ThermalPrinter::begin()
     }
     
     initialized_ = true;
-    ESP_LOGI(TAG, "Initialized: TX=%d, RX=%d, Baud=%d", tx_pin_, rx_pin_, baud_rate_);
+    if (auto_baud_) {
+        status_supported_ = findLink();
+    }
+    ESP_LOGI(TAG, "Initialized: TX=%d, RX=%d, Baud=%d%s", tx_pin_, rx_pin_, baud_rate_,
+             inverse_ ? ", inverted" : "");
+    
+    // Probe for status replies; without them pacing relies on the model only
+    uint8_t status;
+    if (!auto_baud_) {
+        status_supported_ = rx_pin_ >= 0 && queryStatus(&status);
+    }
+    ESP_LOGI(TAG, "Status replies: %s", status_supported_ ? "yes" : "no (timing model only)");
     
     // Initialize printer
     reset();
@@ -64,21 +102,298 @@ bool ThermalPrinter::begin()
     return true;
 }
 
+bool ThermalPrinter::setLink(uint32_t baud, uint32_t inverse)
+{
+    // Nothing may still be going out at the old settings
+    uart_wait_tx_done(uart_port_, portMAX_DELAY);
+    if (uart_set_baudrate(uart_port_, baud) != ESP_OK
+        || uart_set_line_inverse(uart_port_, inverse) != ESP_OK) {
+        return false;
+    }
+    baud_rate_ = (int)baud;
+    inverse_ = inverse;
+    return true;
+}
+
+bool ThermalPrinter::findLink()
+{
+    int64_t start_us = esp_timer_get_time();
+    uint8_t status;
+    
+    // Last boot's settings cost one status query to confirm
+    uint32_t saved_baud = 0;
+    uint32_t saved_inverse = 0;
+    bool saved = loadLink(&saved_baud, &saved_inverse);
+    if (saved && setLink(saved_baud, saved_inverse) && (rx_pin_ < 0 || queryStatus(&status))) {
+        ESP_LOGI(TAG, "Saved link: %u baud%s", (unsigned)saved_baud, saved_inverse ? ", inverted" : "");
+        return rx_pin_ >= 0;
+    }
+    if (rx_pin_ < 0) {
+        ESP_LOGW(TAG, "Auto baud needs the printer TX on an RX pin; using %d baud", FALLBACK_BAUD);
+        setLink(FALLBACK_BAUD, 0);
+        return false;
+    }
+    
+    // Fastest rate first: raster throughput scales with it. Bytes sent at
+    // wrong settings are line noise to the printer; the ESC @ that
+    // begin() sends next clears anything it made of them.
+    const uint32_t polarities[] = {0, INVERTED};
+    for (uint32_t baud : BAUDS) {
+        for (uint32_t inverse : polarities) {
+            if (setLink(baud, inverse) && queryStatus(&status)) {
+                ESP_LOGI(TAG, "Probe found %u baud%s in %lld ms", (unsigned)baud,
+                         inverse ? ", inverted" : "", (long long)((esp_timer_get_time() - start_us) / 1000));
+                saveLink();
+                return true;
+            }
+        }
+    }
+    
+    // Printer off or TX not wired: keep what worked last time, if anything
+    ESP_LOGW(TAG, "No printer reply at any baud rate; using %u baud",
+             saved ? (unsigned)saved_baud : (unsigned)FALLBACK_BAUD);
+    if (saved) {
+        setLink(saved_baud, saved_inverse);
+    } else {
+        setLink(FALLBACK_BAUD, 0);
+    }
+    return false;
+}
+
+bool ThermalPrinter::loadLink(uint32_t* baud, uint32_t* inverse)
+{
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    bool ok = nvs_get_u32(handle, "baud", baud) == ESP_OK
+              && nvs_get_u32(handle, "inverse", inverse) == ESP_OK;
+    nvs_close(handle);
+    return ok && *baud > 0;
+}
+
+void ThermalPrinter::saveLink()
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS open failed: %s (link not saved)", esp_err_to_name(err));
+        return;
+    }
+    err = nvs_set_u32(handle, "baud", (uint32_t)baud_rate_);
+    if (err == ESP_OK) {
+        err = nvs_set_u32(handle, "inverse", inverse_);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS write failed: %s (link not saved)", esp_err_to_name(err));
+    }
+}
+
+void ThermalPrinter::forgetLink()
+{
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    nvs_erase_key(handle, "baud");
+    nvs_erase_key(handle, "inverse");
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
 void ThermalPrinter::reset()
 {
-    // ESC @ - Initialize printer
-    const uint8_t init_cmd[] = {0x1B, 0x40};
-    sendCommand(init_cmd, sizeof(init_cmd));
-    vTaskDelay(pdMS_TO_TICKS(100));
+    // ESC @ puts the heating settings back to their power-on values
+    sendCommand(EscPos::INIT, timing_.reset_us);
+    active_profile_ = &PrintProfiles::POWER_ON;
+}
+
+bool ThermalPrinter::queryStatus(uint8_t* status)
+{
+    if (!initialized_) {
+        return false;
+    }
+    
+    // DLE EOT 1 - Transmit printer status (real-time). Goes out directly,
+    // never staged: the reply is wanted now.
+    uart_flush_input(uart_port_);
+    int64_t issued_us = esp_timer_get_time();
+    uart_write_bytes(uart_port_, (const char*)EscPos::STATUS.data(), EscPos::STATUS.size());
+    const Piece query = {(uint16_t)EscPos::STATUS.size(), 0};
+    account(issued_us, &query, 1);
+    
+    // The query sits behind whatever is still queued for transmission
+    int64_t wire_us = wire_free_at_us_ - esp_timer_get_time();
+    uint32_t timeout_ms = STATUS_TIMEOUT_MS + (wire_us > 0 ? (uint32_t)(wire_us / 1000) : 0);
+    
+    uint8_t reply;
+    if (uart_read_bytes(uart_port_, &reply, 1, pdMS_TO_TICKS(timeout_ms)) != 1) {
+        return false;
+    }
+    // Bits 1 and 4 are fixed high, bits 0 and 7 fixed low in every status byte
+    if ((reply & 0x93) != 0x12) {
+        return false;
+    }
+    *status = reply;
+    return true;
+}
+
+void ThermalPrinter::account(int64_t issued_us, const Piece* pieces, size_t count)
+{
+    // 8N1 framing: 10 bit times per byte. Counted from when the write was
+    // issued: a write larger than the TX ring only returns once its tail
+    // is queued, by which time most of it is already on the wire.
+    if (wire_free_at_us_ < issued_us) {
+        wire_free_at_us_ = issued_us;
+    }
+    int64_t sent_us = wire_free_at_us_;
+    uint16_t begin = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t bytes = pieces[i].end - begin;
+        begin = pieces[i].end;
+        wire_free_at_us_ = sent_us + (int64_t)pieces[i].end * 10000000 / baud_rate_;
+        
+        // The printer starts on a command once its bytes have arrived
+        int64_t start_us = head_free_at_us_ > wire_free_at_us_ ? head_free_at_us_ : wire_free_at_us_;
+        head_free_at_us_ = start_us + pieces[i].head_us;
+        
+        // Until then its bytes sit in the input buffer. A full list folds
+        // into the newest entry, which only starts later.
+        if (queued_count_ == MAX_QUEUED) {
+            queued_[MAX_QUEUED - 1].start_us = start_us;
+            queued_[MAX_QUEUED - 1].bytes += bytes;
+        } else {
+            queued_[queued_count_++] = {start_us, bytes};
+        }
+        queued_bytes_ += bytes;
+    }
+}
+
+int64_t ThermalPrinter::holdUs(size_t len)
+{
+    int64_t now = esp_timer_get_time();
+    size_t started = 0;
+    while (started < queued_count_ && queued_[started].start_us <= now) {
+        queued_bytes_ -= queued_[started++].bytes;
+    }
+    memmove(queued_, queued_ + started, (queued_count_ - started) * sizeof(Queued));
+    queued_count_ -= started;
+    
+    // Hold while the head is too far behind...
+    int64_t hold = head_free_at_us_ - timing_.max_ahead_us - now;
+    
+    // ...or until enough queued bytes have left the buffer for this write
+    uint32_t room_needed = queued_bytes_;
+    for (size_t i = 0; i < queued_count_ && room_needed + len > timing_.buffer_bytes; i++) {
+        room_needed -= queued_[i].bytes;
+        hold = queued_[i].start_us - now > hold ? queued_[i].start_us - now : hold;
+    }
+    return hold;
+}
+
+void ThermalPrinter::pace(size_t len)
+{
+    // Send immediately while the printer's input buffer can absorb the work
+    int64_t excess = holdUs(len);
+    if (excess <= 0) {
+        return;
+    }
+    
+    if (status_supported_) {
+        // Don't stream into a printer that reports itself offline
+        // (paper feeding, cover open, paper end)
+        uint8_t status;
+        int64_t limit = esp_timer_get_time() + OFFLINE_WAIT_LIMIT_US;
+        while (queryStatus(&status) && (status & STATUS_OFFLINE) && esp_timer_get_time() < limit) {
+            vTaskDelay(pdMS_TO_TICKS(STATUS_POLL_MS));
+        }
+        excess = holdUs(len);
+        if (excess <= 0) {
+            return;
+        }
+    }
+    
+    // Sleep exactly until the modeled head has caught up or made room
+    TRACE_SCOPE("pace_wait", (int32_t)excess);
+    TickType_t ticks = (TickType_t)((excess + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+    vTaskDelay(ticks);
 }
 
-void ThermalPrinter::sendCommand(const uint8_t* cmd, size_t len)
+void ThermalPrinter::sendCommand(const uint8_t* cmd, size_t len, uint32_t head_us)
 {
     if (!initialized_) {
         ESP_LOGW(TAG, "Printer not initialized");
         return;
     }
-    uart_write_bytes(uart_port_, (const char*)cmd, len);
+    if (!batching_) {
+        write(cmd, len, head_us);
+        return;
+    }
+    
+    if (tx_len_ + len > TX_BUF_SIZE) {
+        flush();
+    }
+    if (len > TX_BUF_SIZE) {
+        // Long text: nothing staged is left in front of it
+        write(cmd, len, head_us);
+        return;
+    }
+    memcpy(tx_buf_ + tx_len_, cmd, len);
+    stage(len, head_us);
+}
+
+void ThermalPrinter::write(const uint8_t* data, size_t len, uint32_t head_us)
+{
+    const Piece piece = {(uint16_t)len, head_us};
+    write(data, len, &piece, 1);
+}
+
+void ThermalPrinter::write(const uint8_t* data, size_t len, const Piece* pieces, size_t count)
+{
+    TRACE_SCOPE("esc_cmd", (int32_t)len);
+    pace(len);
+    int64_t issued_us = esp_timer_get_time();
+    uart_write_bytes(uart_port_, (const char*)data, len);
+    account(issued_us, pieces, count);
+}
+
+void ThermalPrinter::stage(size_t len, uint32_t head_us)
+{
+    tx_len_ += len;
+    if (tx_piece_count_ == MAX_PIECES) {
+        tx_pieces_[MAX_PIECES - 1].end = (uint16_t)tx_len_;
+        tx_pieces_[MAX_PIECES - 1].head_us += head_us;
+    } else {
+        tx_pieces_[tx_piece_count_++] = {(uint16_t)tx_len_, head_us};
+    }
+}
+
+void ThermalPrinter::flush()
+{
+    if (tx_len_ == 0) {
+        return;
+    }
+    write(tx_buf_, tx_len_, tx_pieces_, tx_piece_count_);
+    tx_len_ = 0;
+    tx_piece_count_ = 0;
+}
+
+void ThermalPrinter::beginBatch()
+{
+    batching_ = true;
+}
+
+void ThermalPrinter::endBatch()
+{
+    batching_ = false;
+    flush();
+    if (raster_pending_) {
+        finishRaster();
+    }
 }
 
 void ThermalPrinter::sendText(const char* text)
@@ -87,7 +402,15 @@ void ThermalPrinter::sendText(const char* text)
         ESP_LOGW(TAG, "Printer not initialized");
         return;
     }
-    uart_write_bytes(uart_port_, text, strlen(text));
+    
+    // Each line feed prints one text line
+    uint32_t lines = 0;
+    for (const char* p = text; *p; p++) {
+        if (*p == '\n') {
+            lines++;
+        }
+    }
+    sendCommand((const uint8_t*)text, strlen(text), lines * timing_.line_dots * timing_.dot_line_us);
 }
 
 void ThermalPrinter::printText(const char* text)
@@ -103,16 +426,205 @@ void ThermalPrinter::printLine(const char* text)
 
 void ThermalPrinter::feedLines(uint8_t lines)
 {
-    // ESC d n - Feed n lines
-    const uint8_t feed_cmd[] = {0x1B, 0x64, lines};
-    sendCommand(feed_cmd, sizeof(feed_cmd));
-    vTaskDelay(pdMS_TO_TICKS(100));
+    sendCommand(EscPos::feed(lines), (uint32_t)lines * timing_.line_dots * timing_.feed_dot_us);
 }
 
 void ThermalPrinter::cutPaper()
 {
-    // GS V m - Partial cut (if supported)
-    const uint8_t cut_cmd[] = {0x1D, 0x56, 0x01};
-    sendCommand(cut_cmd, sizeof(cut_cmd));
-    vTaskDelay(pdMS_TO_TICKS(500));
+    // Partial cut (if supported)
+    sendCommand(EscPos::PARTIAL_CUT, timing_.cut_us);
+}
+
+void ThermalPrinter::reportProgress()
+{
+    if (!progress_) {
+        return;
+    }
+    // Whatever the modeled head hasn't reached yet would be lost with the
+    // printer's buffer on a reset, feed and cut work queued behind the
+    // raster included. Counted at the fastest line rate, so never short.
+    int64_t behind_us = head_free_at_us_ - esp_timer_get_time();
+    uint32_t behind = behind_us > 0
+        ? (uint32_t)((behind_us + timing_.feed_dot_us - 1) / timing_.feed_dot_us) : 0;
+    progress_(raster_stats_.rows > behind ? raster_stats_.rows - behind : 0, progress_ctx_);
+}
+
+bool ThermalPrinter::waitTxDone(TickType_t timeout)
+{
+    if (!initialized_) {
+        return false;
+    }
+    TRACE_SCOPE("tx_drain");
+    return uart_wait_tx_done(uart_port_, timeout) == ESP_OK;
+}
+
+void ThermalPrinter::setBandRows(uint16_t rows)
+{
+    if (rows == 0) {
+        rows = 1;
+    } else if (rows > MAX_BAND_ROWS) {
+        rows = MAX_BAND_ROWS;
+    }
+    band_rows_ = rows;
+}
+
+bool ThermalPrinter::printRaster(RasterSource& source, uint16_t width_bytes,
+                                 RasterProgress progress, void* ctx)
+{
+    if (!initialized_) {
+        ESP_LOGW(TAG, "Printer not initialized");
+        return false;
+    }
+    if (width_bytes == 0 || width_bytes > MAX_WIDTH_BYTES) {
+        ESP_LOGE(TAG, "Invalid raster width: %u bytes", width_bytes);
+        return false;
+    }
+    if (raster_pending_) {
+        flush();
+        finishRaster();
+    }
+    
+    raster_stats_ = {};
+    raster_start_us_ = esp_timer_get_time();
+    progress_ = progress;
+    progress_ctx_ = ctx;
+    bool more = true;
+    
+    while (more) {
+        // Fill one band from the source, behind whatever is staged
+        size_t band_max = BAND_RESERVE + (size_t)band_rows_ * width_bytes;
+        if (tx_len_ + band_max > TX_BUF_SIZE) {
+            flush();
+        }
+        uint8_t* pixels = tx_buf_ + tx_len_ + BAND_RESERVE;
+        uint16_t rows = 0;
+        while (rows < band_rows_) {
+            if (!source.readRow(pixels + rows * width_bytes)) {
+                more = false;
+                break;
+            }
+            rows++;
+        }
+        if (rows == 0) {
+            break;
+        }
+        TRACE_SCOPE("band", rows);
+        
+        // Heating profile from the densest row, so every line of the band
+        // stays within the load limit. Blank rows are told apart first:
+        // an OR over the row is far cheaper than counting its dots.
+        bool blank[MAX_BAND_ROWS];
+        uint16_t black[MAX_BAND_ROWS];
+        uint32_t densest = 0;
+        for (uint16_t r = 0; r < rows; r++) {
+            const uint8_t* row = pixels + r * width_bytes;
+            blank[r] = blank_feeds_ && PrintProfile::isBlank(row, width_bytes);
+            black[r] = blank[r] ? 0 : (uint16_t)PrintProfile::blackDots(row, width_bytes);
+            densest = black[r] > densest ? black[r] : densest;
+        }
+        const PrintProfile& profile = profile_ ? *profile_ : PrintProfiles::select(densest);
+        // A fed blank row takes one motor step, as it would printed
+        uint32_t line_us[MAX_BAND_ROWS];
+        uint32_t head_us = 0;
+        for (uint16_t r = 0; r < rows; r++) {
+            line_us[r] = profile.lineUs(black[r], timing_.feed_dot_us);
+            head_us += line_us[r];
+        }
+        auto runUs = [&](uint16_t first, uint16_t count) {
+            uint32_t us = 0;
+            for (uint16_t r = first; r < first + count; r++) {
+                us += line_us[r];
+            }
+            return us;
+        };
+        BandLayout layout;
+        layout.plan(blank, rows, width_bytes);
+        
+        // The band is rebuilt in place from its start, every piece at or
+        // left of the rows it came from. A changed profile goes in front:
+        // ESC 7 can't be sent inside a GS v 0 block, and a band that is
+        // only fed doesn't need it.
+        size_t band_start = tx_len_;
+        size_t prefix = 0;
+        if (layout.span_count > 0 && &profile != active_profile_) {
+            const EscPos::Seq<PrintProfile::COMMAND_LEN> cmd = profile.command();
+            memcpy(tx_buf_ + tx_len_, cmd.data(), cmd.size());
+            stage(cmd.size(), 0);
+            prefix = cmd.size();
+            active_profile_ = &profile;
+            raster_stats_.profile_changes++;
+        }
+        if (layout.lead > 0) {
+            stageFeed(layout.lead, runUs(0, layout.lead));
+        }
+        for (uint8_t s = 0; s < layout.span_count; s++) {
+            const BandLayout::Span& span = layout.spans[s];
+            if (s > 0) {
+                uint16_t gap = layout.spans[s - 1].first + layout.spans[s - 1].rows;
+                stageFeed(span.first - gap, runUs(gap, span.first - gap));
+            }
+            // GS v 0 header in front of its rows, so header and data go
+            // out in one write: a status query from pace() must never land
+            // between them, where the printer would take it for pixel data.
+            const EscPos::Seq<EscPos::RASTER_HEADER_LEN> header = EscPos::rasterHeader(width_bytes, span.rows);
+            size_t span_bytes = (size_t)span.rows * width_bytes;
+            memcpy(tx_buf_ + tx_len_, header.data(), header.size());
+            memmove(tx_buf_ + tx_len_ + header.size(), pixels + span.first * width_bytes, span_bytes);
+            stage(header.size() + span_bytes, runUs(span.first, span.rows));
+        }
+        if (layout.trail > 0) {
+            stageFeed(layout.trail, runUs(rows - layout.trail, layout.trail));
+        }
+        size_t len = tx_len_ - band_start;
+        
+        raster_stats_.rows += rows;
+        raster_stats_.bands += layout.span_count;
+        raster_stats_.bytes += len;
+        raster_stats_.blank_rows += layout.blank_rows;
+        raster_stats_.feeds += layout.feeds();
+        raster_stats_.bytes_saved += EscPos::RASTER_HEADER_LEN + (uint32_t)rows * width_bytes - (len - prefix);
+        raster_stats_.head_us += head_us;
+        
+        // Blocks only while the TX ring is full, so the UART never idles
+        if (more || !batching_) {
+            flush();
+            reportProgress();
+        }
+    }
+    
+    raster_pending_ = true;
+    if (!batching_) {
+        finishRaster();
+    }
+    return true;
+}
+
+void ThermalPrinter::finishRaster()
+{
+    raster_pending_ = false;
+    uart_wait_tx_done(uart_port_, portMAX_DELAY);
+    raster_stats_.elapsed_us = esp_timer_get_time() - raster_start_us_;
+    reportProgress();
+    progress_ = nullptr;
+    
+    // 10 bits per byte on the wire (start, 8 data, stop)
+    raster_stats_.saved_us = (int64_t)raster_stats_.bytes_saved * 10000000 / baud_rate_;
+    
+    ESP_LOGI(TAG, "Raster: %u rows, %u bands of %u rows, %u bytes in %lld ms "
+             "(head %lld ms, %u profile changes)",
+             (unsigned)raster_stats_.rows, (unsigned)raster_stats_.bands, band_rows_,
+             (unsigned)raster_stats_.bytes, (long long)(raster_stats_.elapsed_us / 1000),
+             (long long)(raster_stats_.head_us / 1000), (unsigned)raster_stats_.profile_changes);
+    if (raster_stats_.blank_rows > 0) {
+        ESP_LOGI(TAG, "Raster: %u blank rows in %u feeds, %u bytes / %lld ms of wire time saved",
+                 (unsigned)raster_stats_.blank_rows, (unsigned)raster_stats_.feeds,
+                 (unsigned)raster_stats_.bytes_saved, (long long)(raster_stats_.saved_us / 1000));
+    }
+}
+
+void ThermalPrinter::stageFeed(uint16_t dots, uint32_t head_us)
+{
+    const EscPos::Seq<EscPos::FEED_DOTS_LEN> feed = EscPos::feedDots((uint8_t)dots);
+    memcpy(tx_buf_ + tx_len_, feed.data(), feed.size());
+    stage(feed.size(), head_us);
 }
@@ -0,0 +1,159 @@
+/*
+ * Trace.cpp
+ * Lightweight span/instant/counter tracing into a lock-free ring
+ */
+
+#include "Trace.hpp"
+
+#if PEGAVOX_TRACE
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include <cstdio>
+
+static_assert((PEGAVOX_TRACE_EVENTS & (PEGAVOX_TRACE_EVENTS - 1)) == 0,
+              "PEGAVOX_TRACE_EVENTS must be a power of two");
+
+namespace {
+
+struct Event {
+    std::atomic<uint32_t> seq;  // Index + 1 once the slot is complete
+    uint32_t ts_us;             // esp_timer time, low 32 bits
+    const char* name;
+    void* task;                 // nullptr = ISR
+    int32_t arg;
+    Trace::Type type;
+};
+
+Event events[PEGAVOX_TRACE_EVENTS];
+std::atomic<uint32_t> head(0);
+std::atomic<bool> enabled(true);
+
+const char TYPE_PHASE[] = {'B', 'E', 'i', 'C'};
+
+}  // namespace
+
+void IRAM_ATTR Trace::record(Type type, const char* name, int32_t arg)
+{
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    
+    // Claiming a slot is the only shared write: tasks on both cores and
+    // ISRs never wait on each other
+    uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Event& e = events[index & (PEGAVOX_TRACE_EVENTS - 1)];
+    e.seq.store(0, std::memory_order_relaxed);
+    e.ts_us = (uint32_t)esp_timer_get_time();
+    e.name = name;
+    e.task = xPortInIsrContext() ? nullptr : xTaskGetCurrentTaskHandle();
+    e.arg = arg;
+    e.type = type;
+    e.seq.store(index + 1, std::memory_order_release);
+}
+
+void Trace::setEnabled(bool on)
+{
+    enabled.store(on);
+}
+
+uint32_t Trace::overwritten()
+{
+    uint32_t n = head.load();
+    return n > PEGAVOX_TRACE_EVENTS ? n - PEGAVOX_TRACE_EVENTS : 0;
+}
+
+void Trace::dump()
+{
+    bool was_enabled = enabled.exchange(false);
+    uint32_t end = head.load(std::memory_order_acquire);
+    uint32_t start = end > PEGAVOX_TRACE_EVENTS ? end - PEGAVOX_TRACE_EVENTS : 0;
+    
+    // Timestamps are 32-bit: unwrap relative to the newest event
+    uint32_t newest = (uint32_t)esp_timer_get_time();
+    int64_t base = esp_timer_get_time() - newest;
+    
+    printf("\n=== TRACE BEGIN ===\n{\"traceEvents\":[\n");
+    printf("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"PegaVox\"}}");
+    printf(",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"ISR\"}}");
+    
+    // Thread names: the firmware never deletes tasks, so handles stay valid
+    void* named[16];
+    size_t named_count = 0;
+    
+    for (uint32_t i = start; i < end; i++) {
+        Event& e = events[i & (PEGAVOX_TRACE_EVENTS - 1)];
+        if (e.seq.load(std::memory_order_acquire) != i + 1) {
+            continue;   // Overwritten or still being written
+        }
+        Event copy;
+        copy.ts_us = e.ts_us;
+        copy.name = e.name;
+        copy.task = e.task;
+        copy.arg = e.arg;
+        copy.type = e.type;
+        if (e.seq.load(std::memory_order_acquire) != i + 1) {
+            continue;
+        }
+        
+        uintptr_t tid = (uintptr_t)copy.task;
+        if (copy.task) {
+            bool known = false;
+            for (size_t k = 0; k < named_count && !known; k++) {
+                known = named[k] == copy.task;
+            }
+            if (!known && named_count < 16) {
+                named[named_count++] = copy.task;
+                printf(",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%lu,"
+                       "\"args\":{\"name\":\"%s\"}}",
+                       (unsigned long)tid, pcTaskGetName((TaskHandle_t)copy.task));
+            }
+        }
+        
+        int64_t ts = base + copy.ts_us;
+        if (copy.ts_us > newest) {
+            ts -= (int64_t)1 << 32;
+        }
+        printf(",\n{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":1,\"tid\":%lu,\"ts\":%lld",
+               TYPE_PHASE[(int)copy.type], copy.name, (unsigned long)tid, (long long)ts);
+        if (copy.type == Type::Counter) {
+            printf(",\"args\":{\"value\":%ld}}", (long)copy.arg);
+        } else if (copy.type == Type::Instant) {
+            printf(",\"s\":\"t\",\"args\":{\"arg\":%ld}}", (long)copy.arg);
+        } else if (copy.type == Type::Begin && copy.arg) {
+            printf(",\"args\":{\"arg\":%ld}}", (long)copy.arg);
+        } else {
+            printf("}");
+        }
+    }
+    printf("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten\":%lu}}\n=== TRACE END ===\n",
+           (unsigned long)overwritten());
+    
+    enabled.store(was_enabled);
+}
+
+#else
+
+#include <cstdio>
+
+void Trace::record(Type, const char*, int32_t)
+{
+}
+
+void Trace::setEnabled(bool)
+{
+}
+
+uint32_t Trace::overwritten()
+{
+    return 0;
+}
+
+void Trace::dump()
+{
+    printf("Tracing disabled (build with -DPEGAVOX_TRACE=1)\n");
+}
+
+#endif
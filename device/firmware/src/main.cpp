@@ -3,19 +3,61 @@
  * ESP32-S3 Thermal Printer + Button + I2C Test (C++)
  * 
  * Features:
- * - Print "Hello world" when button (GPIO 12) is pressed
- * - I2C bus initialized for future OLED display (GPIO 41/42)
- * - Button debouncing (50ms)
+ * - Print "Hello world" when button (GPIO 12) is clicked; with secrets.hpp
+ *   (Wi-Fi and backend), a click starts a voice recording and the next one
+ *   ends it: the audio streams to the backend and the sticker streams
+ *   back into the printer (AudioUploader, BackendClient)
+ * - Print jobs run on a dedicated printer task (button never blocks)
+ * - SSD1327 OLED on the I2C bus (GPIO 41/42) shows a ready indicator
+ *   and a live preview of the sticker as it prints (PrintPreview)
+ * - Button edges timestamped in the ISR, 50 ms debounce, gestures
+ * - Long press logs the button edge-to-callback latency histogram
  * - I2C device scanner for verification
+ * - Stickers spooled to flash resume after a reset where they stopped
+ * - Double press reprints the last sticker from the local cache
+ * - Core-pinned tasks (TaskLayout.hpp); downloaded stickers print while
+ *   they download (StickerPipeline)
+ * - No heap after boot outside Wi-Fi and the HTTP client: print jobs
+ *   come from PrintQueue's pool, their sources from per-job arenas, and
+ *   the reprint cache fills one block reserved at boot; the memory budget
+ *   is logged at boot and on long press (MemoryBudget)
  */
 
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "nvs_flash.h"
+#include "AudioCapture.hpp"
+#include "AudioUploader.hpp"
+#include "BackendClient.hpp"
 #include "ThermalPrinter.hpp"
+#include "PrintQueue.hpp"
+#include "PrintSpool.hpp"
+#include "StickerCache.hpp"
+#include "StickerPipeline.hpp"
+#include "TaskLayout.hpp"
 #include "Button.hpp"
 #include "I2CManager.hpp"
+#include "MemoryBudget.hpp"
+#include "SSD1327.hpp"
+#include "PrintPreview.hpp"
+#include "Trace.hpp"
+#include <atomic>
+#include <cstring>
+#include <optional>
+
+// Wi-Fi and backend settings: copy secrets_example.hpp to secrets.hpp.
+// Without it the device runs offline (test print, spool, reprints).
+#if __has_include("../secrets.hpp")
+#include "../secrets.hpp"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#define PEGAVOX_NETWORK 1
+#else
+#define PEGAVOX_NETWORK 0
+#endif
 
 // Pin definitions
 #define PRINTER_TX_PIN      GPIO_NUM_17
@@ -29,25 +71,264 @@
 
 static const char *TAG = "PegaVox";
 
-// Global objects
-static ThermalPrinter* printer = nullptr;
-static I2CManager* i2c_manager = nullptr;
+// Global objects: static storage, constructed in place by app_main and
+// left empty when their hardware is missing, so none of them (nor their
+// task stacks and queues) come from the heap
+static std::optional<ThermalPrinter> printer;
+static std::optional<PrintQueue> print_queue;
+static std::optional<PrintSpool> spool;
+static std::optional<PrintSpool> cache_spool;
+static std::optional<StickerCache> sticker_cache;
+static std::optional<StickerPipeline> sticker_pipeline;
+static std::optional<I2CManager> i2c_manager;
+static std::optional<SSD1327> oled;
+static std::optional<PrintPreview> preview;
+static std::optional<Button> button;
+static TaskStorage<TaskLayout::BUTTON.stack> button_task_storage;
+static std::optional<AudioCapture> mic;
+static std::optional<AudioUploader> uploader;
+static std::optional<BackendClient> backend;
+static std::atomic<bool> wifi_up(false);
+
+// Streamed sticker teed into the spool; its record is done once the
+// pipeline's job is
+static std::atomic<uint32_t> streamed_record(0);
+
+// Checked at build time; MemoryBudget::log() lists them at run time
+static constexpr size_t STATIC_BYTES = sizeof(printer) + sizeof(print_queue) + sizeof(spool)
+                                       + sizeof(cache_spool) + sizeof(sticker_cache)
+                                       + sizeof(sticker_pipeline) + sizeof(i2c_manager) + sizeof(oled)
+                                       + sizeof(preview) + sizeof(button) + sizeof(button_task_storage)
+                                       + sizeof(mic) + sizeof(uploader) + sizeof(backend);
+static constexpr size_t STATIC_BUDGET = 80 * 1024;
+static_assert(STATIC_BYTES <= STATIC_BUDGET, "Static objects are over budget");
 
-// Button press handler
-void onButtonPress()
+static void reprintLast();
+static void toggleRecording();
+
+// Button event handler (runs on the button task, must not block)
+void onButtonEvent(Button::Event event, void* ctx)
 {
-    ESP_LOGI(TAG, "Button pressed! Printing...");
+    if (event == Button::Event::LongPress) {
+        static_cast<Button*>(ctx)->logLatency();
+        if (sticker_cache) {
+            sticker_cache->logMetrics();
+        }
+        if (sticker_pipeline) {
+            sticker_pipeline->logDepths();
+        }
+        if (preview) {
+            preview->logStats();
+        }
+        MemoryBudget::log();
+        Trace::dump();   // Chrome trace JSON when built with PEGAVOX_TRACE=1
+        return;
+    }
+    if (event == Button::Event::DoublePress) {
+        reprintLast();
+        return;
+    }
+    // Click waits out the double-press window, so a double press
+    // doesn't also queue a test print
+    if (event != Button::Event::Click) {
+        return;
+    }
+    if (uploader) {
+        toggleRecording();
+        return;
+    }
+    ESP_LOGI(TAG, "Button pressed! Queueing print job...");
+    TRACE_SCOPE("job_build");
     
-    printer->reset();
-    printer->printLine("Hello world");
-    printer->printLine("PegaVox Test Print");
-    printer->printLine("C++ Edition");
-    printer->feedLines(3);
-    printer->cutPaper();
+    PrintJob* job = print_queue->acquire();
+    if (!job) {
+        ESP_LOGW(TAG, "Printer busy, press ignored");
+        return;
+    }
+    job->reset()
+        .line("Hello world")
+        .line("PegaVox Test Print")
+        .line("C++ Edition")
+        .feed(3)
+        .cut();
+    job->onDone([](uint32_t job_id, bool ok, void*) {
+        ESP_LOGI(TAG, "Print job %u %s", (unsigned)job_id, ok ? "complete!" : "failed");
+    });
+    
+    if (print_queue->submit(job) == 0) {
+        ESP_LOGW(TAG, "Printer busy, press ignored");
+    }
+}
+
+// Printer task: rows of a spooled sticker printed so far
+static void onSpooledRows(uint32_t rows, void* ctx)
+{
+    const SpoolSource* source = static_cast<const SpoolSource*>(ctx);
+    spool->markPrinted(source->record().id, source->firstRow() + rows);
+}
+
+static void onSpooledDone(uint32_t, bool ok, void* ctx)
+{
+    if (ok) {
+        spool->markDone(static_cast<const SpoolSource*>(ctx)->record().id);
+    }
+}
+
+// Queue a spooled sticker from the first row not printed yet. The spool
+// hears how far the head got and drops the record once the job is done.
+static bool submitSpooled(const PrintSpool::Record& record)
+{
+    PrintJob* job = print_queue->acquire();
+    SpoolSource* source = job ? job->make<SpoolSource>(*spool, record) : nullptr;
+    if (!source) {
+        if (job) {
+            print_queue->release(job);
+        }
+        return false;
+    }
+    if (!source->begin()) {
+        ESP_LOGE(TAG, "Spooled job %u is not a valid raster, dropped", (unsigned)record.id);
+        print_queue->release(job);
+        spool->markDone(record.id);
+        return false;
+    }
     
-    ESP_LOGI(TAG, "Print complete!");
+    job->reset()
+        .raster(source, source->widthBytes(), onSpooledRows, source)
+        .feed(3)
+        .cut();
+    job->onDone(onSpooledDone, source);
+    return print_queue->submit(job) != 0;
+}
+
+// Print a cached sticker. Lookup and submit don't touch flash, so this is
+// safe on the button task.
+static bool printCached(uint64_t key)
+{
+    if (!sticker_cache) {
+        return false;
+    }
+    PrintJob* job = print_queue->acquire();
+    StickerCache::Source* source = job ? job->make<StickerCache::Source>(*sticker_cache) : nullptr;
+    if (!source || !source->open(key)) {
+        if (job) {
+            print_queue->release(job);
+        }
+        return false;
+    }
+    job->reset()
+        .raster(source, source->widthBytes())
+        .feed(3)
+        .cut();
+    return print_queue->submit(job) != 0;
+}
+
+static void reprintLast()
+{
+    uint64_t key = sticker_cache ? sticker_cache->lastKey() : 0;
+    if (key == 0) {
+        ESP_LOGW(TAG, "Nothing to reprint yet");
+        return;
+    }
+    ESP_LOGI(TAG, "Reprinting sticker %016llx from cache", (unsigned long long)key);
+    if (!printCached(key)) {
+        ESP_LOGW(TAG, "Reprint failed (evicted or printer busy)");
+    }
 }
 
+// Click with the network up: the first starts a recording, streamed to
+// the backend as it is made, the next ends it. stop() waits out the
+// reader's current DMA batch (15 ms) at most.
+static void toggleRecording()
+{
+    if (mic->isRunning()) {
+        mic->stop();
+        ESP_LOGI(TAG, "Recording stopped, waiting for the sticker");
+        return;
+    }
+    if (!wifi_up) {
+        ESP_LOGW(TAG, "Wi-Fi not connected, press ignored");
+        return;
+    }
+    if (!mic->start()) {
+        ESP_LOGW(TAG, "Microphone failed to start");
+        return;
+    }
+    if (!uploader->startUpload()) {
+        mic->stop();
+        ESP_LOGW(TAG, "Previous sticker still on its way, press ignored");
+        return;
+    }
+    ESP_LOGI(TAG, "Recording... click again to finish");
+}
+
+#if PEGAVOX_NETWORK
+// Job whose sticker the network task is downloading; names its cache entry
+static char fetching_job[64];
+
+// Network task, as BackendClient's SpooledCallback: a streamed sticker is
+// on the spool, its last rows still printing. Cache it under its job id
+// (the backend doesn't return the prompt) for double-press reprints; the
+// pipeline's job marks the record done.
+static void onStickerStreamed(const PrintSpool::Record& record)
+{
+    streamed_record = record.id;
+    if (sticker_cache) {
+        SpoolReader bytes(*spool, record);
+        sticker_cache->put(StickerCache::key(fetching_job), bytes, record.length);
+    }
+}
+
+// Network task, once the recording is posted: download the job's sticker
+// into the pipeline on the same task, printing as it arrives
+static void onRecordingUploaded(bool ok, const char* job_id)
+{
+    if (!ok) {
+        ESP_LOGW(TAG, "Upload failed, no sticker");
+        return;
+    }
+    snprintf(fetching_job, sizeof(fetching_job), "%s", job_id);
+    if (!backend->fetchSticker(job_id, *sticker_pipeline)) {
+        ESP_LOGW(TAG, "Sticker for job %s failed: %s", job_id, backend->lastError());
+    }
+}
+
+// Station mode; connects again by itself after a drop
+static void onWifiEvent(void* arg, esp_event_base_t base, int32_t id, void* data)
+{
+    (void)arg;
+    (void)data;
+    if (base == WIFI_EVENT && (id == WIFI_EVENT_STA_START || id == WIFI_EVENT_STA_DISCONNECTED)) {
+        wifi_up = false;
+        esp_wifi_connect();
+    } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        wifi_up = true;
+        ESP_LOGI(TAG, "Wi-Fi connected");
+    }
+}
+
+static bool startWifi()
+{
+    if (esp_netif_init() != ESP_OK || esp_event_loop_create_default() != ESP_OK) {
+        return false;
+    }
+    esp_netif_create_default_wifi_sta();
+    wifi_init_config_t init = WIFI_INIT_CONFIG_DEFAULT();
+    if (esp_wifi_init(&init) != ESP_OK) {
+        return false;
+    }
+    esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, onWifiEvent, nullptr);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, onWifiEvent, nullptr);
+    
+    wifi_config_t config = {};
+    strncpy((char*)config.sta.ssid, WIFI_SSID, sizeof(config.sta.ssid));
+    strncpy((char*)config.sta.password, WIFI_PASSWORD, sizeof(config.sta.password));
+    esp_wifi_set_mode(WIFI_MODE_STA);
+    esp_wifi_set_config(WIFI_IF_STA, &config);
+    return esp_wifi_start() == ESP_OK;
+}
+#endif
+
 // Button task wrapper
 void button_task(void* arg)
 {
@@ -62,10 +343,20 @@ extern "C" void app_main(void)
     ESP_LOGI(TAG, "Phase 2: Printer + Button + I2C");
     ESP_LOGI(TAG, "===========================================");
     
+    // ===== Initialize NVS (printer link settings) =====
+    esp_err_t nvs_err = nvs_flash_init();
+    if (nvs_err == ESP_ERR_NVS_NO_FREE_PAGES || nvs_err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        nvs_flash_erase();
+        nvs_err = nvs_flash_init();
+    }
+    if (nvs_err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS init failed: %s (printer will probe every boot)", esp_err_to_name(nvs_err));
+    }
+    
     // ===== Initialize I2C Bus =====
     ESP_LOGI(TAG, "Initializing I2C bus for OLED display...");
-    i2c_manager = new I2CManager(OLED_SDA_PIN, OLED_SCL_PIN, 400000);
-    if (!i2c_manager->begin()) {
+    i2c_manager.emplace(OLED_SDA_PIN, OLED_SCL_PIN, 400000);
+    if (!i2c_manager->begin(TaskLayout::I2C_BUS)) {
         ESP_LOGE(TAG, "Failed to initialize I2C bus");
         // Continue anyway—printer will still work
     } else {
@@ -74,38 +365,136 @@ extern "C" void app_main(void)
         // Scan for I2C devices (OLED should be at 0x3C)
         vTaskDelay(pdMS_TO_TICKS(100));
         i2c_manager->scan();
+        
+        oled.emplace(*i2c_manager);
+        if (!oled->begin()) {
+            ESP_LOGW(TAG, "OLED not responding, continuing without display");
+            oled.reset();
+        }
     }
     
     // ===== Initialize Thermal Printer =====
     ESP_LOGI(TAG, "Initializing thermal printer (UART)...");
-    printer = new ThermalPrinter(UART_NUM_1, PRINTER_TX_PIN, PRINTER_RX_PIN, 9600);
+    // Baud rate and polarity are probed on first boot and saved in NVS
+    printer.emplace(UART_NUM_1, PRINTER_TX_PIN, PRINTER_RX_PIN, ThermalPrinter::AUTO_BAUD);
     if (!printer->begin()) {
         ESP_LOGE(TAG, "Failed to initialize printer");
         return;
     }
     
+    print_queue.emplace(*printer, 4);
+    if (!print_queue->begin(TaskLayout::PRINTER)) {
+        ESP_LOGE(TAG, "Failed to start print queue");
+        return;
+    }
+    
+    // ===== Resume Spooled Jobs =====
+    spool.emplace();
+    if (!spool->begin()) {
+        ESP_LOGW(TAG, "Print spool unavailable, jobs won't survive a reset");
+        spool.reset();
+    } else {
+        PrintSpool::Record records[4];
+        size_t count = spool->pending(records, 4);
+        for (size_t i = 0; i < count; i++) {
+            ESP_LOGI(TAG, "Resuming spooled job %u at row %u",
+                     (unsigned)records[i].id, (unsigned)records[i].resume_row);
+            submitSpooled(records[i]);
+        }
+    }
+    
+    // ===== Sticker Cache =====
+    cache_spool.emplace();
+    if (!cache_spool->begin("cache", TaskLayout::CACHE)) {
+        ESP_LOGW(TAG, "No cache partition, reprints kept in RAM only");
+        cache_spool.reset();
+    }
+    sticker_cache.emplace(cache_spool ? &*cache_spool : nullptr);
+    sticker_cache->begin();
+    
+    // ===== Download -> Decode -> Print Pipeline =====
+    sticker_pipeline.emplace(*print_queue);
+    sticker_pipeline->setCallback([](uint32_t, bool ok) {
+        uint32_t id = streamed_record.exchange(0);
+        if (id != 0 && ok) {
+            spool->markDone(id);
+        }
+    });
+    if (oled) {
+        preview.emplace(*oled);
+        sticker_pipeline->setObserver(&*preview);
+    }
+    if (!sticker_pipeline->begin(TaskLayout::DECODE)) {
+        ESP_LOGW(TAG, "Sticker pipeline unavailable, stickers print from the spool only");
+        sticker_pipeline.reset();
+        preview.reset();
+    }
+    
+    // ===== Voice -> Backend -> Sticker =====
+#if PEGAVOX_NETWORK
+    if (sticker_pipeline && startWifi()) {
+        mic.emplace(MIC_BCLK_PIN, MIC_WS_PIN, MIC_DATA_PIN, 16000);
+        uploader.emplace(*mic, BACKEND_URL, DEVICE_TOKEN);
+        backend.emplace(BACKEND_URL, DEVICE_TOKEN);
+        uploader->setCallback(onRecordingUploaded);
+        backend->setSpool(spool ? &*spool : nullptr, onStickerStreamed);
+        if (!mic->begin(TaskLayout::AUDIO_READER) || !backend->begin()
+            || !uploader->begin(TaskLayout::NETWORK)) {
+            ESP_LOGE(TAG, "Microphone or network setup failed, clicks print a test page");
+            uploader.reset();
+            backend.reset();
+            mic.reset();
+        }
+    } else {
+        ESP_LOGW(TAG, "Wi-Fi or pipeline unavailable, clicks print a test page");
+    }
+#else
+    ESP_LOGI(TAG, "No secrets.hpp: offline, clicks print a test page");
+#endif
+    
     // ===== Initialize Button =====
     ESP_LOGI(TAG, "Initializing button (GPIO %d)...", BUTTON_PIN);
-    Button* button = new Button(BUTTON_PIN, 50);
+    button.emplace(BUTTON_PIN, 50);
     if (!button->begin()) {
         ESP_LOGE(TAG, "Failed to initialize button");
         return;
     }
     
     // Set button callback
-    button->setCallback(onButtonPress);
+    button->setCallback(onButtonEvent, &*button);
     
     // ===== Start Button Task =====
-    xTaskCreate(button_task, "button_task", 2048, button, 10, nullptr);
+    if (!button_task_storage.start(button_task, &*button, TaskLayout::BUTTON)) {
+        ESP_LOGE(TAG, "Failed to start button task");
+        return;
+    }
+    
+    // ===== Memory Budget =====
+    // Everything is allocated; from here only Wi-Fi and the HTTP client
+    // use the heap
+    MemoryBudget::addArena("print job", &print_queue->jobArena());
+    MemoryBudget::addStatic("printer", sizeof(printer));
+    MemoryBudget::addStatic("print_queue", sizeof(print_queue));
+    MemoryBudget::addStatic("spools", sizeof(spool) + sizeof(cache_spool));
+    MemoryBudget::addStatic("sticker_cache", sizeof(sticker_cache));
+    MemoryBudget::addStatic("pipeline", sizeof(sticker_pipeline));
+    MemoryBudget::addStatic("i2c + oled", sizeof(i2c_manager) + sizeof(oled) + sizeof(preview));
+    MemoryBudget::addStatic("button", sizeof(button) + sizeof(button_task_storage));
+    MemoryBudget::addStatic("voice", sizeof(mic) + sizeof(uploader) + sizeof(backend));
+    MemoryBudget::bootDone();
+    MemoryBudget::log();
     
     // ===== Initialization Complete =====
+    if (oled) {
+        oled->fillRect(120, 0, 8, 8, 15);   // Ready indicator
+        oled->display();
+    }
+    
     ESP_LOGI(TAG, "===========================================");
     ESP_LOGI(TAG, "Initialization complete!");
     ESP_LOGI(TAG, "Ready to accept button presses...");
     ESP_LOGI(TAG, "===========================================");
     
-    // Keep app_main alive (FreeRTOS scheduler handles everything else)
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-    }
+    // Everything runs on the tasks in TaskLayout from here; returning
+    // deletes the main task and frees its stack
 }
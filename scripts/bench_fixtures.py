@@ -0,0 +1,144 @@
+# bench_fixtures.py
+#
+# Reference outputs of pipeline.py's own functions, written as files for
+# the firmware's host benches to compare against.
+#
+# Usage:
+#   python bench_fixtures.py gray [--out DIR] [--printer-width 384] [--pixelate-width 96]
+#   python bench_fixtures.py pcm [--out DIR] [--rate 16000]
+#
+# gray: synthetic grayscale images through pipeline.py's step 6, one run
+# per image in DIR (default output/fixtures):
+#   <run>.source.pgm          the image, as the device's gray stream
+#   <run>.final.gray.bin      pixelate_small_gray(), as pipeline.py writes it
+#   <run>.final.bitmap.bin    resize_to_width -> pixelate -> to_1bit_dither
+#                             -> pack_1bit_rows
+# build/raster_pipeline_bench DIR/<run> ... then checks RasterPipeline on
+# both gray entry points (Lanczos from the source, Nearest from the small
+# image) against the bitmap. Runs pipeline.py saved for real stickers work
+# the same way, minus the .source.pgm.
+#
+# pcm: synthetic recordings (speech-like bursts over a noise floor, with
+# short and long pauses, long tails, no voice, a partial last frame and
+# levels around the threshold) through trim_silence_pcm16() with
+# pipeline.py's defaults:
+#   <run>.pcm                 16-bit little-endian mono
+#   <run>.trimmed.pcm         what trim_silence_pcm16() returns
+# build/trim_bench DIR/*.pcm compares SilenceTrimmer with it.
+#
+# Needs pipeline.py's imports.
+
+import argparse
+from pathlib import Path
+
+import numpy as np
+from PIL import Image
+
+from pipeline import (
+    DEFAULT_PRINTER_WIDTH,
+    pack_1bit_rows,
+    pixelate,
+    pixelate_small_gray,
+    resize_to_width,
+    to_1bit_dither,
+    trim_silence_pcm16,
+)
+
+DEFAULT_OUT = Path(__file__).resolve().parent / "output" / "fixtures"
+
+
+def gray_images():
+    """(name, L image): soft blobs, waves and noise, as a sticker might be."""
+    rng = np.random.default_rng(4)
+
+    def blobs(w, h):
+        yy, xx = np.mgrid[0:h, 0:w].astype(np.float32)
+        img = np.full((h, w), 128, dtype=np.float32)
+        for _ in range(6):
+            cx, cy, r = rng.uniform(0, w), rng.uniform(0, h), rng.uniform(w / 10, w / 3)
+            img += rng.uniform(-200, 200) * np.exp(-((xx - cx) ** 2 + (yy - cy) ** 2) / (2 * r * r))
+        img += 40 * np.sin(xx / rng.uniform(5, 40)) + rng.normal(0, 12, (h, w))
+        return Image.fromarray(np.clip(img, 0, 255).astype(np.uint8), "L")
+
+    yield "gray_1024", blobs(1024, 1024)
+    yield "gray_700x500", blobs(700, 500)
+    yield "gray_384x300", blobs(384, 300)       # No resize
+    yield "gray_200x150", blobs(200, 150)       # Upscale
+    yield "gray_noise_512", Image.fromarray(rng.integers(0, 256, (512, 512), dtype=np.uint8), "L")
+
+
+def write_gray(out: Path, printer_width: int, pixelate_width: int):
+    out.mkdir(parents=True, exist_ok=True)
+    for name, source in gray_images():
+        w, h = source.size
+        with open(out / f"{name}.source.pgm", "wb") as f:
+            f.write(f"P5\n{w} {h}\n255\n".encode() + source.tobytes())
+
+        # pipeline.py's step 6 from the composite on: gray in RGB stays gray
+        img = resize_to_width(source.convert("RGB"), printer_width)
+        gray, gray_w, gray_h = pixelate_small_gray(img, pixelate_width)
+        (out / f"{name}.final.gray.bin").write_bytes(gray)
+        if pixelate_width and pixelate_width > 0:
+            img = pixelate(img, pixelate_width)
+        bitmap, bw, bh, bpr = pack_1bit_rows(to_1bit_dither(img))
+        (out / f"{name}.final.bitmap.bin").write_bytes(bitmap)
+        print(f"{out / name}: {w}x{h} -> {gray_w}x{gray_h} gray, {bw}x{bh} bitmap")
+
+
+def recordings(rate: int):
+    """(name, int16 PCM): bursts of a voice-like tone over -60 dBFS noise."""
+    rng = np.random.default_rng(11)
+
+    def noise(seconds):
+        return rng.normal(0, 32768 * 10 ** (-60 / 20), int(seconds * rate))
+
+    def burst(seconds, db=-18.0):
+        t = np.arange(int(seconds * rate)) / rate
+        f0 = rng.uniform(180, 300)
+        tone = sum(np.sin(2 * np.pi * f0 * k * t + rng.uniform(0, 6)) / k for k in range(1, 6))
+        envelope = np.minimum(1, np.minimum(t, t[-1] - t) / 0.03) * (0.6 + 0.4 * np.sin(2 * np.pi * 4 * t))
+        signal = tone * envelope
+        return signal / np.sqrt(np.mean(signal ** 2)) * 32768 * 10 ** (db / 20) + noise(seconds)
+
+    def pcm(*parts):
+        return np.clip(np.round(np.concatenate(parts)), -32768, 32767).astype(np.int16)
+
+    yield "short_pauses", pcm(noise(0.5), burst(0.8), noise(0.2), burst(0.6), noise(0.25), burst(0.9), noise(0.4))
+    yield "long_pause", pcm(noise(0.3), burst(0.7), noise(2.0), burst(0.8), noise(0.3))
+    yield "long_tail", pcm(noise(0.2), burst(1.2), noise(4.0))
+    yield "voice_at_start", pcm(burst(1.0), noise(0.5))
+    yield "partial_frame", pcm(noise(0.4), burst(1.5))[: int(1.9 * rate) - 123]
+    yield "no_voice_short", pcm(noise(0.4))
+    yield "no_voice_long", pcm(noise(3.0))
+    yield "near_threshold", pcm(*[burst(0.4, db) for db in np.linspace(-42, -28, 15)])
+
+
+def write_pcm(out: Path, rate: int):
+    out.mkdir(parents=True, exist_ok=True)
+    for name, pcm in recordings(rate):
+        trimmed = trim_silence_pcm16(pcm, rate)
+        (out / f"{name}.pcm").write_bytes(pcm.astype("<i2").tobytes())
+        (out / f"{name}.trimmed.pcm").write_bytes(trimmed.astype("<i2").tobytes())
+        print(f"{out / name}: {pcm.size / rate * 1000:.0f} ms -> {trimmed.size / rate * 1000:.0f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Reference files for the firmware host benches")
+    sub = parser.add_subparsers(dest="kind", required=True)
+    gray = sub.add_parser("gray", help="Gray stream -> printer bitmap (raster_pipeline_bench)")
+    gray.add_argument("--out", type=Path, default=DEFAULT_OUT)
+    gray.add_argument("--printer-width", type=int, default=DEFAULT_PRINTER_WIDTH)
+    gray.add_argument("--pixelate-width", type=int, default=96, help="As pipeline.py; 0 disables")
+    pcm = sub.add_parser("pcm", help="Recording -> trim_silence_pcm16() (trim_bench)")
+    pcm.add_argument("--out", type=Path, default=DEFAULT_OUT)
+    pcm.add_argument("--rate", type=int, default=16000)
+    args = parser.parse_args()
+
+    if args.kind == "gray":
+        write_gray(args.out, args.printer_width, args.pixelate_width)
+    elif args.kind == "pcm":
+        write_pcm(args.out, args.rate)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,163 @@
+# font_atlas.py
+#
+# Generate the caption font atlas (device/firmware/lib/CaptionRenderer/FontAtlas.cpp)
+# from a TrueType font.
+#
+# Usage:
+#   python font_atlas.py                       (DejaVu Sans Bold, 24-dot cell)
+#   python font_atlas.py --font Other.ttf --size 20 --out FontAtlas.cpp
+#
+# Every glyph is drawn once with Pillow, without anti-aliasing, in a cell
+# HEIGHT dots tall with the baseline at BASELINE. Blank rows above and
+# below the ink are cropped; the rows left are packed MSB first, one byte
+# per 8 columns, into one flash array. The glyph table is sorted by code
+# point so the firmware can binary search it.
+#
+# The character set is printable ASCII plus what Spanish captions need
+# (accents, ñ, ü, ¡ ¿, « », curly quotes, dashes, …, €, °) and U+FFFD
+# for anything else. The output is committed, so the firmware build needs
+# neither Pillow nor the font; rerun this after changing either. HEIGHT
+# in include/FontAtlas.hpp must match --height.
+#
+# Requires:
+#   pip install -U pillow
+
+import argparse
+import sys
+from pathlib import Path
+
+from PIL import Image, ImageDraw, ImageFont
+
+DEFAULT_FONT = "/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf"
+DEFAULT_OUT = (Path(__file__).resolve().parent.parent / "device" / "firmware" / "lib"
+               / "CaptionRenderer" / "FontAtlas.cpp")
+
+SPANISH = "¡¿«»°ÁÉÍÓÚÜÑáéíóúüñ‘’“”–—…€"
+REPLACEMENT = "�"
+CHARSET = [chr(c) for c in range(0x20, 0x7F)] + list(SPANISH) + [REPLACEMENT]
+
+MAX_WIDTH = 32      # A glyph row must fit the renderer's 32-bit words
+
+
+def fit_size(font_path, height):
+    """Largest pixel size whose ink, over the whole set, fits `height` rows."""
+    best = None
+    for size in range(8, 4 * height):
+        font = ImageFont.truetype(font_path, size)
+        boxes = [font.getbbox(ch, anchor="ls") for ch in CHARSET]
+        top = min(b[1] for b in boxes)
+        bottom = max(b[3] for b in boxes)
+        if bottom - top > height:
+            break
+        best = size
+    if best is None:
+        sys.exit(f"No size of {font_path} fits {height} rows")
+    return best
+
+
+def render(font, ch, height, baseline):
+    """Glyph as (advance, left, width, top, rows of packed bytes)."""
+    advance = int(round(font.getlength(ch)))
+    x0, _, x1, _ = font.getbbox(ch, anchor="ls")
+    left = min(0, x0)
+    width = max(advance, x1) - left
+    if width > MAX_WIDTH:
+        sys.exit(f"U+{ord(ch):04X} is {width} dots wide, more than {MAX_WIDTH}")
+
+    image = Image.new("1", (max(width, 1), height), 0)
+    draw = ImageDraw.Draw(image)
+    draw.fontmode = "1"
+    draw.text((-left, baseline), ch, font=font, fill=1, anchor="ls")
+
+    stride = (width + 7) // 8
+    rows = []
+    for y in range(height):
+        packed = bytearray(stride)
+        for x in range(width):
+            if image.getpixel((x, y)):
+                packed[x >> 3] |= 0x80 >> (x & 7)
+        rows.append(bytes(packed))
+
+    inked = [y for y, row in enumerate(rows) if any(row)]
+    top = inked[0] if inked else 0
+    bottom = inked[-1] + 1 if inked else 0
+    return advance, left, width, top, rows[top:bottom]
+
+
+def generate(font_path, size, height):
+    font = ImageFont.truetype(font_path, size)
+    boxes = [font.getbbox(ch, anchor="ls") for ch in CHARSET]
+    top = min(b[1] for b in boxes)
+    bottom = max(b[3] for b in boxes)
+    # Center the set's ink in the cell
+    baseline = -top + (height - (bottom - top)) // 2
+
+    glyphs = []
+    bits = bytearray()
+    for ch in sorted(set(CHARSET), key=ord):
+        advance, left, width, top_row, rows = render(font, ch, height, baseline)
+        glyphs.append((ord(ch), len(bits), advance, width, left, top_row, len(rows)))
+        for row in rows:
+            bits += row
+    if len(bits) > 0xFFFF:
+        sys.exit(f"Atlas is {len(bits)} bytes, more than 16-bit offsets reach")
+    return glyphs, bits, baseline
+
+
+def write_cpp(path, font_path, size, height, baseline, glyphs, bits):
+    lines = [
+        "/*",
+        " * FontAtlas.cpp",
+        " * Caption glyphs, generated by scripts/font_atlas.py: do not edit",
+        " *",
+        f" * {Path(font_path).name} at {size} px, {height}-dot cell, baseline at row {baseline},",
+        f" * {len(glyphs)} glyphs, {len(bits)} bytes of bits",
+        " */",
+        "",
+        '#include "FontAtlas.hpp"',
+        "",
+        f"static_assert(FontAtlas::HEIGHT == {height}, \"regenerate with scripts/font_atlas.py --height\");",
+        "",
+        "namespace FontAtlas {",
+        "",
+        "// {codepoint, offset, advance, width, left, top, rows}",
+        "const Glyph GLYPHS[] = {",
+    ]
+    for cp, offset, advance, width, left, top, rows in glyphs:
+        ch = chr(cp)
+        note = f"  // {ch}" if cp > 0x20 and cp != 0x5C else ""
+        lines.append(f"    {{0x{cp:04X}, {offset}, {advance}, {width}, {left}, {top}, {rows}}},{note}")
+    lines += [
+        "};",
+        "",
+        "const uint16_t GLYPH_COUNT = sizeof(GLYPHS) / sizeof(GLYPHS[0]);",
+        "",
+        "const uint8_t BITS[] = {",
+    ]
+    for i in range(0, len(bits), 16):
+        lines.append("    " + ", ".join(f"0x{b:02X}" for b in bits[i:i + 16]) + ",")
+    lines += [
+        "};",
+        "",
+        "}  // namespace FontAtlas",
+        "",
+    ]
+    Path(path).write_text("\n".join(lines), encoding="utf-8")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the caption font atlas")
+    parser.add_argument("--font", default=DEFAULT_FONT, help="TrueType font file")
+    parser.add_argument("--height", type=int, default=24, help="Cell height in dots")
+    parser.add_argument("--size", type=int, default=0, help="Pixel size (default: largest that fits)")
+    parser.add_argument("--out", default=str(DEFAULT_OUT), help="Output .cpp")
+    args = parser.parse_args()
+
+    size = args.size or fit_size(args.font, args.height)
+    glyphs, bits, baseline = generate(args.font, size, args.height)
+    write_cpp(args.out, args.font, size, args.height, baseline, glyphs, bits)
+    print(f"{args.out}: {len(glyphs)} glyphs at {size} px, {len(bits)} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -12,6 +12,8 @@
 #   run1.final.png          (384px wide, 1-bit dithered)
 #   run1.final.bitmap.bin   (raw packed 1-bit rows, MSB first)
 #   run1.final.escpos.bin   (ESC/POS GS v 0 raster command + data)
+#   run1.final.gray.bin     (small 8-bit grayscale for on-device dithering)
+#   run1.final.pvr.bin      (PVR1 compressed raster for transport)
 #
 # Debug outputs (if --debug):
 #   run1.output.wav
@@ -390,6 +392,21 @@ def pixelate(img: Image.Image, target_small_width: int) -> Image.Image:
     return small.resize((w, h), Image.NEAREST)
 
 
+def pixelate_small_gray(img: Image.Image, target_small_width: int) -> Tuple[bytes, int, int]:
+    """
+    Grayscale version of pixelate()'s downscaled image, for devices that
+    upscale + dither on their own (firmware RasterPipeline, Nearest mode).
+    Returns (data, small_width, small_height); rows are 8-bit, 0 = black.
+    """
+    w, h = img.size
+    gray = img.convert("L")
+    if target_small_width <= 0 or target_small_width >= w:
+        return gray.tobytes(), w, h
+    small_h = max(1, int(round(h * (target_small_width / w))))
+    small = gray.resize((target_small_width, small_h), Image.NEAREST)
+    return small.tobytes(), target_small_width, small_h
+
+
 def to_1bit_dither(img: Image.Image) -> Image.Image:
     """
     Convert to 1-bit using Floyd–Steinberg dithering.
@@ -426,6 +443,110 @@ def pack_1bit_rows(img_1bit: Image.Image) -> Tuple[bytes, int, int, int]:
     return bytes(out), w, h, bytes_per_row
 
 
+def _packbits(row: bytes) -> bytes:
+    """PackBits-encode one row (runs never cross the row end)."""
+    out = bytearray()
+    literal = bytearray()
+    i = 0
+    n = len(row)
+    while i < n:
+        j = i + 1
+        while j < n and j - i < 128 and row[j] == row[i]:
+            j += 1
+        run = j - i
+        if run >= 3:
+            if literal:
+                out.append(len(literal) - 1)
+                out += literal
+                literal.clear()
+            out.append(257 - run)
+            out.append(row[i])
+            i = j
+        else:
+            literal.append(row[i])
+            i += 1
+            if len(literal) == 128:
+                out.append(127)
+                out += literal
+                literal.clear()
+    if literal:
+        out.append(len(literal) - 1)
+        out += literal
+    return bytes(out)
+
+
+def encode_pvr_rows(data: bytes, bytes_per_row: int, height: int) -> bytes:
+    """
+    Compress packed 1-bit rows into the PVR1 transport format.
+    Layout: b"PVR1" | bytes_per_row (u16 LE) | height (u16 LE) | opcodes
+      0x00        literal row, PackBits-coded
+      0x40 + n-1  n blank rows (n <= 64)
+      0x80 + n-1  n copies of the previous row (n <= 128)
+    Decoded on the device by RasterDecoder (device/firmware).
+    """
+    out = bytearray(b"PVR1")
+    out += bytes_per_row.to_bytes(2, "little") + height.to_bytes(2, "little")
+
+    blank = bytes(bytes_per_row)
+    prev = blank
+    y = 0
+    while y < height:
+        row = data[y * bytes_per_row:(y + 1) * bytes_per_row]
+        if row == blank:
+            n = 1
+            while n < 64 and y + n < height and data[(y + n) * bytes_per_row:(y + n + 1) * bytes_per_row] == blank:
+                n += 1
+            out.append(0x40 + n - 1)
+            prev = blank
+        elif row == prev:
+            n = 1
+            while n < 128 and y + n < height and data[(y + n) * bytes_per_row:(y + n + 1) * bytes_per_row] == prev:
+                n += 1
+            out.append(0x80 + n - 1)
+        else:
+            n = 1
+            out.append(0x00)
+            out += _packbits(row)
+            prev = row
+        y += n
+    return bytes(out)
+
+
+def decode_pvr_rows(pvr: bytes) -> Tuple[bytes, int, int]:
+    """Inverse of encode_pvr_rows(). Returns (data, bytes_per_row, height)."""
+    if pvr[:4] != b"PVR1":
+        raise ValueError("not a PVR1 stream")
+    bpr = int.from_bytes(pvr[4:6], "little")
+    height = int.from_bytes(pvr[6:8], "little")
+    out = bytearray()
+    prev = bytes(bpr)
+    i = 8
+    while len(out) < bpr * height:
+        op = pvr[i]
+        i += 1
+        if op == 0x00:
+            row = bytearray()
+            while len(row) < bpr:
+                n = pvr[i]
+                i += 1
+                if n < 128:
+                    row += pvr[i:i + n + 1]
+                    i += n + 1
+                elif n > 128:
+                    row += bytes([pvr[i]]) * (257 - n)
+                    i += 1
+            prev = bytes(row)
+            out += prev
+        elif op & 0x80:
+            out += prev * ((op & 0x7F) + 1)
+        elif op & 0x40:
+            prev = bytes(bpr)
+            out += prev * ((op & 0x3F) + 1)
+        else:
+            raise ValueError(f"reserved opcode 0x{op:02x}")
+    return bytes(out), bpr, height
+
+
 def escpos_gs_v_0(data: bytes, bytes_per_row: int, height: int) -> bytes:
     """
     ESC/POS raster bit image command (GS v 0).
@@ -487,6 +608,8 @@ def main():
     out_final_png   = OUTPUT_DIR / f"{run_prefix}.final.png"
     out_bitmap      = OUTPUT_DIR / f"{run_prefix}.final.bitmap.bin"
     out_escpos      = OUTPUT_DIR / f"{run_prefix}.final.escpos.bin"
+    out_gray        = OUTPUT_DIR / f"{run_prefix}.final.gray.bin"
+    out_pvr         = OUTPUT_DIR / f"{run_prefix}.final.pvr.bin"
 
     # 1) record (local)
     wav_bytes, end_recording_ts, pcm16 = record_wav(
@@ -569,6 +692,13 @@ def main():
     # Resize to printer width
     img = resize_to_width(img, args.printer_width)
 
+    # Small grayscale for devices that do the upscale + dither themselves.
+    # Converting to L commutes with NEAREST, so the device output matches
+    # the bitmap below bit for bit.
+    gray, gray_w, gray_h = pixelate_small_gray(img, args.pixelate_width)
+    with open(out_gray, "wb") as f:
+        f.write(gray)
+
     # Optional pixelation pass to force “visible pixels”
     if args.pixelate_width and args.pixelate_width > 0:
         img = pixelate(img, args.pixelate_width)
@@ -584,6 +714,11 @@ def main():
     with open(out_bitmap, "wb") as f:
         f.write(bitmap)
 
+    # Write compressed transport raster
+    pvr = encode_pvr_rows(bitmap, bpr, h)
+    with open(out_pvr, "wb") as f:
+        f.write(pvr)
+
     # Write ESC/POS command stream
     escpos_bytes = escpos_gs_v_0(bitmap, bpr, h)
     with open(out_escpos, "wb") as f:
@@ -596,6 +731,8 @@ def main():
     print(f"Saved: {out_final_png}")
     print(f"Saved: {out_bitmap} (raw packed 1-bit rows)")
     print(f"Saved: {out_escpos} (ESC/POS GS v 0 raster command)")
+    print(f"Saved: {out_pvr} (PVR1, {len(pvr)} bytes = {100 * len(pvr) / len(bitmap):.1f}% of bitmap)")
+    print(f"Saved: {out_gray} ({gray_w}x{gray_h} grayscale, device upscales to {w}x{h})")
 
     elapsed = time.perf_counter() - end_recording_ts
     print(f"Latency (end of recording → final image): {elapsed:.2f}s")
@@ -0,0 +1,68 @@
+# raster_codec_bench.py
+#
+# Compression ratio benchmark for the PVR1 raster transport format.
+#
+# Usage:
+#   python raster_codec_bench.py                      (all runs in scripts/output)
+#   python raster_codec_bench.py a.final.bitmap.bin   (specific bitmaps)
+#
+# For each packed 1-bit bitmap (pack_1bit_rows output) this reports the raw,
+# base64 and PVR1 sizes, checks the round trip and writes <run>.final.pvr.bin
+# next to it so the firmware decoder benchmark can read the same data:
+#   device/firmware/host/bench/raster_decoder_bench.cpp
+
+import argparse
+import base64
+import sys
+import time
+from pathlib import Path
+
+from pipeline import DEFAULT_PRINTER_WIDTH, decode_pvr_rows, encode_pvr_rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="PVR1 compression ratio benchmark")
+    parser.add_argument("bitmaps", nargs="*", type=Path, help="*.final.bitmap.bin files")
+    parser.add_argument("--printer-width", type=int, default=DEFAULT_PRINTER_WIDTH)
+    args = parser.parse_args()
+
+    bitmaps = args.bitmaps or sorted((Path(__file__).resolve().parent / "output").glob("*.final.bitmap.bin"))
+    if not bitmaps:
+        print("No bitmaps found (run pipeline.py first or pass files)", file=sys.stderr)
+        sys.exit(1)
+
+    bpr = (args.printer_width + 7) // 8
+    total_raw = total_b64 = total_pvr = total_pvr_b64 = 0
+
+    print(f"{'file':40s} {'rows':>5s} {'raw':>7s} {'b64':>7s} {'pvr':>7s} {'pvr b64':>7s} {'ratio':>6s} {'enc ms':>7s}")
+    for path in bitmaps:
+        data = path.read_bytes()
+        height = len(data) // bpr
+
+        t0 = time.perf_counter()
+        pvr = encode_pvr_rows(data, bpr, height)
+        enc_ms = (time.perf_counter() - t0) * 1000
+
+        decoded, _, _ = decode_pvr_rows(pvr)
+        if decoded != data[:bpr * height]:
+            print(f"{path.name}: ROUND TRIP MISMATCH", file=sys.stderr)
+            sys.exit(1)
+
+        pvr_path = path.with_name(path.name.replace(".bitmap.bin", ".pvr.bin"))
+        pvr_path.write_bytes(pvr)
+
+        b64 = len(base64.b64encode(data))
+        pvr_b64 = len(base64.b64encode(pvr))
+        total_raw += len(data)
+        total_b64 += b64
+        total_pvr += len(pvr)
+        total_pvr_b64 += pvr_b64
+        print(f"{path.name[:40]:40s} {height:5d} {len(data):7d} {b64:7d} {len(pvr):7d} {pvr_b64:7d} "
+              f"{len(data) / len(pvr):5.1f}x {enc_ms:7.1f}")
+
+    print(f"{'TOTAL':40s} {'':5s} {total_raw:7d} {total_b64:7d} {total_pvr:7d} {total_pvr_b64:7d} "
+          f"{total_raw / total_pvr:5.1f}x")
+
+
+if __name__ == "__main__":
+    main()
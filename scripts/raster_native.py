@@ -0,0 +1,108 @@
+# raster_native.py
+#
+# ctypes binding for the native printer post-processing
+# (device/firmware/host/tools/pegavox_raster.h), a drop-in for the Pillow
+# chain in pipeline.py's step 6:
+#
+#   bitmap, w, h, bpr = postprocess(Image.open(...), printer_width, pixelate_width)
+#   escpos = escpos_gs_v_0(bitmap, bpr, h)
+#
+# gives the same bytes as alpha_composite over white -> resize_to_width ->
+# pixelate -> to_1bit_dither -> pack_1bit_rows, in one native pass.
+# dither="ordered" or "atkinson" picks the other kernels (no Pillow
+# equivalent).
+#
+# Build the library with the firmware's host build:
+#   cd device/firmware/host
+#   cmake -B build && cmake --build build -j --target pegavox_raster
+# or set PEGAVOX_RASTER_LIB to libpegavox_raster.so.
+
+import ctypes
+import os
+from io import BytesIO
+from pathlib import Path
+from typing import Optional, Tuple
+
+from PIL import Image
+
+DITHERS = {"floyd-steinberg": 0, "ordered": 1, "atkinson": 2}
+
+_HOST_BUILD = Path(__file__).resolve().parent.parent / "device" / "firmware" / "host" / "build"
+_lib = None
+
+
+def load_library(path: Optional[str] = None) -> ctypes.CDLL:
+    """Load libpegavox_raster (PEGAVOX_RASTER_LIB, else the default host build)."""
+    global _lib
+    if _lib is not None and path is None:
+        return _lib
+    path = path or os.getenv("PEGAVOX_RASTER_LIB")
+    if path:
+        candidates = [Path(path)]
+    else:
+        candidates = [_HOST_BUILD / "libpegavox_raster.so", _HOST_BUILD / "libpegavox_raster.dylib"]
+    for candidate in candidates:
+        if candidate.exists():
+            break
+    else:
+        raise OSError(f"libpegavox_raster not found ({', '.join(map(str, candidates))}); "
+                      "build it with device/firmware/host or set PEGAVOX_RASTER_LIB")
+    lib = ctypes.CDLL(str(candidate))
+    lib.pegavox_raster_height.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    lib.pegavox_raster_height.restype = ctypes.c_int
+    lib.pegavox_raster_render.argtypes = [
+        ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_size_t,
+        ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_void_p, ctypes.c_size_t,
+    ]
+    lib.pegavox_raster_render.restype = ctypes.c_long
+    lib.pegavox_raster_escpos.argtypes = [
+        ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.c_void_p, ctypes.c_size_t,
+    ]
+    lib.pegavox_raster_escpos.restype = ctypes.c_long
+    lib.pegavox_raster_simd.argtypes = []
+    lib.pegavox_raster_simd.restype = ctypes.c_char_p
+    _lib = lib
+    return lib
+
+
+def simd() -> str:
+    """Resampling path of the loaded library: "avx2", "neon" or "scalar"."""
+    return load_library().pegavox_raster_simd().decode()
+
+
+def postprocess(img: Image.Image, printer_width: int, pixelate_width: int = 0,
+                dither: str = "floyd-steinberg") -> Tuple[bytes, int, int, int]:
+    """
+    Printer bitmap of `img` (any mode; L, RGB and RGBA are passed as is).
+    Returns (data, width, height, bytes_per_row) like pack_1bit_rows().
+    """
+    lib = load_library()
+    if img.mode not in ("L", "RGB", "RGBA"):
+        img = img.convert("RGBA")
+    channels = {"L": 1, "RGB": 3, "RGBA": 4}[img.mode]
+    w, h = img.size
+    rows = lib.pegavox_raster_height(w, h, printer_width)
+    if rows < 0:
+        raise ValueError(f"{w}x{h} image does not fit")
+    bpr = (printer_width + 7) // 8
+    out = ctypes.create_string_buffer(bpr * rows)
+    n = lib.pegavox_raster_render(img.tobytes(), w, h, channels, w * channels,
+                                  printer_width, pixelate_width, DITHERS[dither], out, len(out))
+    if n < 0:
+        raise ValueError("pegavox_raster_render failed")
+    return out.raw, printer_width, rows, bpr
+
+
+def postprocess_png(png_bytes: bytes, printer_width: int, pixelate_width: int = 0,
+                    dither: str = "floyd-steinberg") -> Tuple[bytes, int, int, int]:
+    """postprocess() of a PNG as the image endpoint returns it."""
+    return postprocess(Image.open(BytesIO(png_bytes)), printer_width, pixelate_width, dither)
+
+
+def escpos_gs_v_0(data: bytes, bytes_per_row: int, height: int) -> bytes:
+    """GS v 0 command + data, as escpos_gs_v_0() in pipeline.py."""
+    out = ctypes.create_string_buffer(len(data) + 8)
+    n = load_library().pegavox_raster_escpos(data, bytes_per_row, height, out, len(out))
+    if n < 0:
+        raise ValueError("pegavox_raster_escpos failed")
+    return out.raw
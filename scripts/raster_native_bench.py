@@ -0,0 +1,215 @@
+# raster_native_bench.py
+#
+# Native vs. Python printer post-processing: byte identity and images/s.
+#
+# Usage:
+#   python raster_native_bench.py                       (output/*.generated.png
+#                                                        plus synthetic images)
+#   python raster_native_bench.py a.png b.png --repeat 20
+#
+# For each PNG the Python path (pipeline.py's step 6: alpha_composite ->
+# resize_to_width -> pixelate -> to_1bit_dither -> pack_1bit_rows ->
+# escpos_gs_v_0) and the native one (raster_native.py) run on the same
+# decoded image; the Pillow PNG decode both need is timed on its own. The
+# outputs must match byte for byte, and match the .final.bitmap.bin /
+# .final.escpos.bin files pipeline.py wrote next to a *.generated.png.
+#
+# The ordered and Atkinson kernels have no Pillow equivalent; they are
+# checked against the plain Python reference versions below on the same
+# pixelated gray image.
+#
+# Needs the native library (see raster_native.py) and pipeline.py's imports.
+
+import argparse
+import sys
+import time
+from io import BytesIO
+from pathlib import Path
+
+import numpy as np
+from PIL import Image
+
+import raster_native
+from pipeline import (
+    DEFAULT_PRINTER_WIDTH,
+    escpos_gs_v_0,
+    pack_1bit_rows,
+    pixelate,
+    resize_to_width,
+    to_1bit_dither,
+)
+
+BAYER8 = [
+    [0, 32, 8, 40, 2, 34, 10, 42],
+    [48, 16, 56, 24, 50, 18, 58, 26],
+    [12, 44, 4, 36, 14, 46, 6, 38],
+    [60, 28, 52, 20, 62, 30, 54, 22],
+    [3, 35, 11, 43, 1, 33, 9, 41],
+    [51, 19, 59, 27, 49, 17, 57, 25],
+    [15, 47, 7, 39, 13, 45, 5, 37],
+    [63, 31, 55, 23, 61, 29, 53, 21],
+]
+
+
+def decode(png_bytes: bytes) -> Image.Image:
+    img = Image.open(BytesIO(png_bytes))
+    img.load()
+    return img
+
+
+def python_path(decoded: Image.Image, printer_width: int, pixelate_width: int):
+    """pipeline.py's step 6, unchanged."""
+    img_rgba = decoded.convert("RGBA")
+    white_bg = Image.new("RGBA", img_rgba.size, (255, 255, 255, 255))
+    img = Image.alpha_composite(white_bg, img_rgba).convert("RGB")
+    img = resize_to_width(img, printer_width)
+    if pixelate_width and pixelate_width > 0:
+        img = pixelate(img, pixelate_width)
+    bw = to_1bit_dither(img)
+    bitmap, w, h, bpr = pack_1bit_rows(bw)
+    return bitmap, escpos_gs_v_0(bitmap, bpr, h), img
+
+
+def native_path(decoded: Image.Image, printer_width: int, pixelate_width: int, dither: str = "floyd-steinberg"):
+    bitmap, w, h, bpr = raster_native.postprocess(decoded, printer_width, pixelate_width, dither)
+    return bitmap, raster_native.escpos_gs_v_0(bitmap, bpr, h)
+
+
+def pack_dots(dots: np.ndarray) -> bytes:
+    """Rows of 0/1 (1 = black) packed MSB first, as pack_1bit_rows()."""
+    return np.packbits(dots.astype(np.uint8), axis=1).tobytes()
+
+
+def reference_ordered(gray: np.ndarray) -> bytes:
+    h, w = gray.shape
+    m = np.array(BAYER8, dtype=np.int32)
+    threshold = 4 * m[np.arange(h)[:, None] % 8, np.arange(w)[None, :] % 8] + 2
+    return pack_dots(gray.astype(np.int32) < threshold)
+
+
+def reference_atkinson(gray: np.ndarray) -> bytes:
+    h, w = gray.shape
+    err = [[0] * (w + 3) for _ in range(h + 2)]   # err[y][x + 1]
+    dots = np.zeros((h, w), dtype=np.uint8)
+    for y in range(h):
+        row = gray[y].tolist()
+        cur, nxt, aft = err[y], err[y + 1], err[y + 2]
+        for x in range(w):
+            l = min(max(row[x] + cur[x + 1], 0), 255)
+            out = 255 if l > 128 else 0
+            dots[y, x] = out == 0
+            e = int((l - out) / 8)      # Truncated toward zero, as in C
+            cur[x + 2] += e
+            cur[x + 3] += e
+            nxt[x] += e
+            nxt[x + 1] += e
+            nxt[x + 2] += e
+            aft[x + 1] += e
+    return pack_dots(dots)
+
+
+def synthetic_pngs():
+    """Stand-ins for the image endpoint's output: (name, PNG bytes)."""
+    rng = np.random.default_rng(7)
+
+    def blobs(w, h, channels):
+        yy, xx = np.mgrid[0:h, 0:w].astype(np.float32)
+        img = np.zeros((h, w, channels), dtype=np.float32)
+        for c in range(channels):
+            for _ in range(6):
+                cx, cy, r = rng.uniform(0, w), rng.uniform(0, h), rng.uniform(w / 10, w / 3)
+                img[..., c] += rng.uniform(-200, 200) * np.exp(-((xx - cx) ** 2 + (yy - cy) ** 2) / (2 * r * r))
+            img[..., c] += 128 + 40 * np.sin(xx / rng.uniform(5, 40)) + rng.normal(0, 12, (h, w))
+        return img
+
+    def png(array, mode):
+        buf = BytesIO()
+        Image.fromarray(np.clip(array, 0, 255).astype(np.uint8).squeeze(), mode).save(buf, "PNG")
+        return buf.getvalue()
+
+    # Sticker on a transparent background: hard cut-out plus soft edge
+    rgba = blobs(1024, 1024, 4)
+    yy, xx = np.mgrid[0:1024, 0:1024]
+    dist = np.hypot(xx - 512, yy - 512)
+    rgba[..., 3] = np.clip((420 - dist) * 4, 0, 255)
+    yield "synthetic 1024 RGBA", png(rgba, "RGBA")
+    yield "synthetic 1024x1536 RGB", png(blobs(1024, 1536, 3), "RGB")
+    yield "synthetic 700x500 gray", png(blobs(700, 500, 1), "L")
+    yield "synthetic 384 RGBA (no resize)", png(np.dstack([blobs(384, 300, 3), rgba[:300, 300:684, 3:]]), "RGBA")
+    yield "synthetic 200 RGB (upscale)", png(blobs(200, 150, 3), "RGB")
+
+
+def best_of(repeat: int, fn):
+    best = float("inf")
+    for _ in range(repeat):
+        t0 = time.perf_counter()
+        fn()
+        best = min(best, time.perf_counter() - t0)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Native vs. Python printer post-processing")
+    parser.add_argument("pngs", nargs="*", type=Path, help="PNG files (default: output/*.generated.png)")
+    parser.add_argument("--printer-width", type=int, default=DEFAULT_PRINTER_WIDTH)
+    parser.add_argument("--pixelate-width", type=int, default=96, help="As pipeline.py; 0 disables")
+    parser.add_argument("--repeat", type=int, default=5, help="Timed runs per image (best is kept)")
+    parser.add_argument("--no-synthetic", action="store_true")
+    args = parser.parse_args()
+
+    inputs = [(p.name, p.read_bytes(), p) for p in args.pngs]
+    if not args.pngs:
+        out_dir = Path(__file__).resolve().parent / "output"
+        inputs += [(p.name, p.read_bytes(), p) for p in sorted(out_dir.glob("*.generated.png"))]
+    if not args.no_synthetic:
+        inputs += [(name, data, None) for name, data in synthetic_pngs()]
+    if not inputs:
+        print("No images (pass PNG files or drop --no-synthetic)", file=sys.stderr)
+        sys.exit(1)
+
+    pw, pix = args.printer_width, args.pixelate_width
+    print(f"Native library: {raster_native.load_library()._name} ({raster_native.simd()})")
+    print(f"{'image':32s} {'rows':>5s} {'decode':>7s} {'python':>7s} {'native':>7s} {'speedup':>8s}  check")
+    ok = True
+    total_decode = total_py = total_native = 0.0
+    for name, data, path in inputs:
+        img = decode(data)
+        py_bitmap, py_escpos, pixelated = python_path(img, pw, pix)
+        bitmap, escpos = native_path(img, pw, pix)
+        checks = ["identical" if (bitmap, escpos) == (py_bitmap, py_escpos) else "DIFFERS from python"]
+
+        if path is not None:
+            run = path.name.replace(".generated.png", "")
+            for suffix, produced in ((".final.bitmap.bin", bitmap), (".final.escpos.bin", escpos)):
+                saved = path.with_name(run + suffix)
+                if saved.exists():
+                    checks.append(f"{suffix[7:-4]} {'= saved' if saved.read_bytes() == produced else 'DIFFERS from saved'}")
+
+        gray = np.asarray(pixelated.convert("L"))
+        for kind, reference in (("ordered", reference_ordered), ("atkinson", reference_atkinson)):
+            other, _ = native_path(img, pw, pix, kind)
+            checks.append(f"{kind} {'ok' if other == reference(gray) else 'DIFFERS'}")
+
+        ok = ok and not any("DIFFERS" in c for c in checks)
+        t_decode = best_of(args.repeat, lambda: decode(data))
+        t_py = best_of(args.repeat, lambda: python_path(img, pw, pix))
+        t_native = best_of(args.repeat, lambda: native_path(img, pw, pix))
+        total_decode += t_decode
+        total_py += t_py
+        total_native += t_native
+        rows = len(bitmap) // ((pw + 7) // 8)
+        print(f"{name[:32]:32s} {rows:5d} {t_decode * 1000:5.1f}ms {t_py * 1000:5.1f}ms {t_native * 1000:5.1f}ms "
+              f"{t_py / t_native:7.1f}x  {', '.join(checks)}")
+
+    n = len(inputs)
+    print(f"\nImages/s, post-processing:     python {n / total_py:7.1f}, native {n / total_native:7.1f} "
+          f"({total_py / total_native:.1f}x)")
+    print(f"Images/s, with the PNG decode: python {n / (total_decode + total_py):7.1f}, "
+          f"native {n / (total_decode + total_native):7.1f}")
+    if not ok:
+        print("MISMATCH", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
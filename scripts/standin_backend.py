@@ -0,0 +1,314 @@
+# standin_backend.py
+#
+# Local stand-in for the backend, for testing the device's network code
+# on Linux (device/firmware/host/bench/backend_bench.cpp) without the
+# speech/image pipeline. Standard library only.
+#
+# Usage:
+#   python standin_backend.py                         (synthetic sticker)
+#   python standin_backend.py --bitmap output/a.final.bitmap.bin
+#   python standin_backend.py --delay 3 --rate 128 --verbose
+#   python standin_backend.py --caption "¡Qué gato tan bonito!"
+#
+# Serves the API in docs/backend-device-api-contract.md over HTTP/1.1
+# with keep-alive:
+#   POST /api/v1/audio                    202 {"job_id"}; the job is "done"
+#                                         --delay seconds later
+#   GET  /api/v1/job/{id}[?wait=N]        JSON document, raster_data base64;
+#                                         with wait, held until done or N s
+#   GET  /api/v1/job/{id}/raster?wait=N   204 while processing, then the
+#                                         PVR1 stream, chunked
+# Result bodies are sent in 1460-byte chunks at --rate kbit/s, like a
+# slow Wi-Fi link, so a client that prints while downloading shows it.
+#
+# For failure tests, POST /api/v1/audio?simulate=cut makes a job whose
+# result stops halfway (connection closed, no last chunk) and
+# ?simulate=error one that fails with a message.
+#
+# Without --bitmap the sticker is the noise-dithered gradient of the
+# firmware benches (pipeline_bench.cpp), so they can check it arrived
+# intact. --caption adds a "caption" field to the JSON document, which
+# the device prints under the sticker (the benches then see extra rows).
+
+import argparse
+import base64
+import json
+import threading
+import time
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from urllib.parse import parse_qs, urlsplit
+
+DEFAULT_PRINTER_WIDTH = 384     # As in pipeline.py
+CHUNK_BYTES = 1460              # One TCP segment
+MAX_WAIT_S = 60
+
+
+def noisy_image(width_bytes: int, height: int) -> bytes:
+    """Gradient dithered against a hashed threshold; noisyImage() in the firmware benches."""
+    rows = bytearray(width_bytes * height)
+    width = width_bytes * 8
+    for y in range(height):
+        for x in range(width):
+            h = ((x * 73856093) ^ (y * 19349663)) & 0xFFFFFFFF
+            h ^= h >> 13
+            h = (h * 0x5BD1E995) & 0xFFFFFFFF
+            h ^= h >> 15
+            level = 255 - x * 255 // (width - 1)
+            if (h & 0xFF) < level:
+                rows[y * width_bytes + x // 8] |= 0x80 >> (x & 7)
+    return bytes(rows)
+
+
+def _packbits(row: bytes) -> bytes:
+    """PackBits-encode one row, as _packbits() in pipeline.py."""
+    out = bytearray()
+    literal = bytearray()
+    i = 0
+    n = len(row)
+    while i < n:
+        j = i + 1
+        while j < n and j - i < 128 and row[j] == row[i]:
+            j += 1
+        run = j - i
+        if run >= 3:
+            if literal:
+                out.append(len(literal) - 1)
+                out += literal
+                literal.clear()
+            out.append(257 - run)
+            out.append(row[i])
+            i = j
+        else:
+            literal.append(row[i])
+            i += 1
+            if len(literal) == 128:
+                out.append(127)
+                out += literal
+                literal.clear()
+    if literal:
+        out.append(len(literal) - 1)
+        out += literal
+    return bytes(out)
+
+
+def encode_pvr_rows(data: bytes, bytes_per_row: int, height: int) -> bytes:
+    """PVR1 stream, byte for byte as encode_pvr_rows() in pipeline.py (which needs the OpenAI and audio packages)."""
+    out = bytearray(b"PVR1")
+    out += bytes_per_row.to_bytes(2, "little") + height.to_bytes(2, "little")
+    blank = bytes(bytes_per_row)
+    prev = blank
+    row = lambda k: data[k * bytes_per_row:(k + 1) * bytes_per_row]
+    y = 0
+    while y < height:
+        n = 1
+        if row(y) == blank:
+            while n < 64 and y + n < height and row(y + n) == blank:
+                n += 1
+            out.append(0x40 + n - 1)
+            prev = blank
+        elif row(y) == prev:
+            while n < 128 and y + n < height and row(y + n) == prev:
+                n += 1
+            out.append(0x80 + n - 1)
+        else:
+            out.append(0x00)
+            out += _packbits(row(y))
+            prev = row(y)
+        y += n
+    return bytes(out)
+
+
+class Job:
+    def __init__(self, ready_at: float, simulate: str):
+        self.ready_at = ready_at
+        self.simulate = simulate
+
+
+class Backend:
+    def __init__(self, pvr: bytes, delay: float, rate_kbps: float, verbose: bool, caption: str = ""):
+        self.pvr = pvr
+        self.caption = caption
+        self.delay = delay
+        self.rate_kbps = rate_kbps
+        self.verbose = verbose
+        self.jobs = {}
+        self.lock = threading.Lock()
+        self.connections = 0
+
+    def new_job(self, simulate: str) -> str:
+        job_id = uuid.uuid4().hex[:12]
+        with self.lock:
+            self.jobs[job_id] = Job(time.monotonic() + self.delay, simulate)
+        return job_id
+
+    def job(self, job_id: str):
+        with self.lock:
+            return self.jobs.get(job_id)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"      # Persistent connections
+    server_version = "PegaVoxStandin/1.0"
+    backend: Backend = None
+
+    def setup(self):
+        super().setup()
+        with self.backend.lock:
+            self.backend.connections += 1
+            count = self.backend.connections
+        if self.backend.verbose:
+            print(f"connection {count} from {self.client_address[0]}:{self.client_address[1]}")
+
+    def log_message(self, fmt, *args):
+        if self.backend.verbose:
+            super().log_message(fmt, *args)
+
+    # --- helpers ---
+
+    def _read_body(self) -> bytes:
+        if "chunked" in self.headers.get("Transfer-Encoding", "").lower():
+            body = bytearray()
+            while True:
+                size = int(self.rfile.readline().split(b";")[0].strip() or b"0", 16)
+                if size == 0:
+                    while self.rfile.readline() not in (b"\r\n", b"\n", b""):
+                        pass
+                    return bytes(body)
+                body += self.rfile.read(size)
+                self.rfile.readline()
+        return self.rfile.read(int(self.headers.get("Content-Length", 0)))
+
+    def _json(self, code: int, doc: dict):
+        body = json.dumps(doc).encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def _stream(self, content_type: str, parts, cut: bool):
+        """Chunked body from `parts` (bytes), paced at --rate; `cut` stops halfway and drops the connection."""
+        self.send_response(200)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+        body = b"".join(parts)
+        stop = len(body) // 2 if cut else len(body)
+        byte_s = 8 / (self.backend.rate_kbps * 1000) if self.backend.rate_kbps > 0 else 0
+        due = time.monotonic()
+        for pos in range(0, stop, CHUNK_BYTES):
+            data = body[pos:min(pos + CHUNK_BYTES, stop)]
+            due += len(data) * byte_s
+            pause = due - time.monotonic()
+            if pause > 0:
+                time.sleep(pause)
+            self.wfile.write(b"%x\r\n" % len(data) + data + b"\r\n")
+        if cut:
+            self.close_connection = True
+            return
+        self.wfile.write(b"0\r\n\r\n")
+
+    def _wait(self, job: Job, query: dict):
+        """Long poll: hold the request until the job is ready or `wait` seconds pass."""
+        try:
+            wait = min(float(query.get("wait", ["0"])[0]), MAX_WAIT_S)
+        except ValueError:
+            wait = 0
+        until = min(job.ready_at, time.monotonic() + wait)
+        pause = until - time.monotonic()
+        if pause > 0:
+            time.sleep(pause)
+        return time.monotonic() >= job.ready_at
+
+    # --- endpoints ---
+
+    def do_POST(self):
+        url = urlsplit(self.path)
+        body = self._read_body()
+        if url.path != "/api/v1/audio":
+            self._json(404, {"status": "error", "message": "not found"})
+            return
+        simulate = parse_qs(url.query).get("simulate", ["ok"])[0]
+        job_id = self.backend.new_job(simulate)
+        if self.backend.verbose:
+            print(f"job {job_id}: {len(body)} audio bytes, {simulate}")
+        self._json(202, {"job_id": job_id})
+
+    def do_GET(self):
+        url = urlsplit(self.path)
+        parts = url.path.strip("/").split("/")
+        # api/v1/job/{id}[/raster]
+        if len(parts) not in (4, 5) or parts[:3] != ["api", "v1", "job"] or (len(parts) == 5 and parts[4] != "raster"):
+            self._json(404, {"status": "error", "message": "not found"})
+            return
+        job = self.backend.job(parts[3])
+        if job is None:
+            self._json(404, {"status": "error", "message": "unknown job"})
+            return
+        ready = self._wait(job, parse_qs(url.query))
+        cut = job.simulate == "cut"
+        failed = job.simulate == "error"
+
+        if len(parts) == 5:
+            if not ready:
+                self.send_response(204)
+                self.end_headers()
+            elif failed:
+                self._json(422, {"status": "error", "message": "image generation failed"})
+            else:
+                self._stream("application/x-pvr1", [self.backend.pvr], cut)
+            return
+
+        if not ready:
+            self._json(200, {"status": "processing"})
+        elif failed:
+            self._json(200, {"status": "error", "message": "image generation failed"})
+        else:
+            # raster_format ahead of raster_data, for clients that parse as it arrives
+            head = b'{"status": "done", "raster_format": "pvr1", '
+            if self.backend.caption:
+                # Non-ASCII goes as \uXXXX escapes, which the device decodes
+                head += b'"caption": ' + json.dumps(self.backend.caption).encode() + b', '
+            head += b'"raster_data": "'
+            self._stream("application/json", [head, base64.b64encode(self.backend.pvr), b'"}'], cut)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stand-in PegaVox backend for device network tests")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8089)
+    parser.add_argument("--bitmap", type=Path, help="*.final.bitmap.bin to serve instead of the synthetic sticker")
+    parser.add_argument("--printer-width", type=int, default=DEFAULT_PRINTER_WIDTH)
+    parser.add_argument("--rows", type=int, default=480, help="Synthetic sticker height")
+    parser.add_argument("--delay", type=float, default=1.5, help="Seconds a job is processing")
+    parser.add_argument("--rate", type=float, default=256, help="Result download rate in kbit/s (0 = unlimited)")
+    parser.add_argument("--idle-timeout", type=float, default=30, help="Close kept connections idle this long")
+    parser.add_argument("--caption", default="", help="Caption printed under the sticker (JSON result only)")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    bpr = (args.printer_width + 7) // 8
+    if args.bitmap:
+        data = args.bitmap.read_bytes()
+        height = len(data) // bpr
+    else:
+        height = args.rows
+        data = noisy_image(bpr, height)
+    pvr = encode_pvr_rows(data, bpr, height)
+
+    Handler.backend = Backend(pvr, args.delay, args.rate, args.verbose, args.caption)
+    Handler.timeout = args.idle_timeout
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+    print(f"Stand-in backend on http://{args.host}:{server.server_port}: {height} rows, "
+          f"PVR1 {len(pvr)} bytes, {args.delay:g} s per job, {args.rate:g} kbit/s", flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,58 @@
+# trace_extract.py
+#
+# Pull Chrome trace JSON dumps out of a firmware serial log.
+#
+# Usage:
+#   pio device monitor | tee monitor.log     (long-press the button to dump)
+#   python trace_extract.py monitor.log      (writes monitor.trace1.json, ...)
+#
+# The firmware prints each Trace::dump() between "=== TRACE BEGIN ===" and
+# "=== TRACE END ===" lines (build with -DPEGAVOX_TRACE=1). Open the output
+# in ui.perfetto.dev or chrome://tracing.
+
+import argparse
+import json
+import re
+import sys
+from pathlib import Path
+
+BEGIN = "=== TRACE BEGIN ==="
+END = "=== TRACE END ==="
+# ESP-IDF log lines from other tasks can interleave with the dump
+LOG_LINE = re.compile(r"^(\x1b\[[0-9;]*m)?[IWEDV] \(\d+\) ")
+
+
+def extract(text):
+    dumps = []
+    current = None
+    for line in text.splitlines():
+        line = line.rstrip("\r")
+        if line.strip() == BEGIN:
+            current = []
+        elif line.strip() == END and current is not None:
+            dumps.append(json.loads("\n".join(current)))
+            current = None
+        elif current is not None and not LOG_LINE.match(line):
+            current.append(line)
+    return dumps
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Extract firmware trace dumps")
+    parser.add_argument("log", type=Path, help="Serial monitor log")
+    args = parser.parse_args()
+
+    dumps = extract(args.log.read_text(errors="replace"))
+    if not dumps:
+        print("No trace dumps found (is the firmware built with PEGAVOX_TRACE=1?)", file=sys.stderr)
+        sys.exit(1)
+
+    for i, trace in enumerate(dumps, 1):
+        out = args.log.with_suffix(f".trace{i}.json")
+        out.write_text(json.dumps(trace))
+        events = [e for e in trace["traceEvents"] if e["ph"] != "M"]
+        print(f"{out}: {len(events)} events, {trace['otherData']['overwritten']} overwritten")
+
+
+if __name__ == "__main__":
+    main()